@@ -0,0 +1,2 @@
+-- AlterEnum
+ALTER TYPE "RemoteCommandType" ADD VALUE 'LOG_UPLOAD';
@@ -0,0 +1,27 @@
+-- CreateTable
+CREATE TABLE "DoorStatsInterval" (
+    "id" TEXT NOT NULL,
+    "deviceId" TEXT NOT NULL,
+    "startAt" TIMESTAMP(3) NOT NULL,
+    "durationSeconds" INTEGER NOT NULL,
+    "opens" INTEGER NOT NULL,
+    "openSeconds" INTEGER NOT NULL,
+    "longestOpenSeconds" INTEGER NOT NULL,
+    "openWhileCompressorSeconds" INTEGER NOT NULL,
+    "droppedEvents" INTEGER NOT NULL,
+    "receivedAt" TIMESTAMP(3) NOT NULL DEFAULT CURRENT_TIMESTAMP,
+
+    CONSTRAINT "DoorStatsInterval_pkey" PRIMARY KEY ("id")
+);
+
+-- CreateIndex
+CREATE INDEX "DoorStatsInterval_deviceId_idx" ON "DoorStatsInterval"("deviceId");
+
+-- CreateIndex
+CREATE INDEX "DoorStatsInterval_startAt_idx" ON "DoorStatsInterval"("startAt");
+
+-- CreateIndex
+CREATE UNIQUE INDEX "DoorStatsInterval_deviceId_startAt_key" ON "DoorStatsInterval"("deviceId", "startAt");
+
+-- AddForeignKey
+ALTER TABLE "DoorStatsInterval" ADD CONSTRAINT "DoorStatsInterval_deviceId_fkey" FOREIGN KEY ("deviceId") REFERENCES "Device"("id") ON DELETE CASCADE ON UPDATE CASCADE;
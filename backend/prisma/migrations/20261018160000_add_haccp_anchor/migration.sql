@@ -0,0 +1,19 @@
+-- CreateTable
+CREATE TABLE "HaccpAnchor" (
+    "id" TEXT NOT NULL,
+    "deviceId" TEXT NOT NULL,
+    "seq" BIGINT NOT NULL,
+    "headHash" TEXT NOT NULL,
+    "receivedAt" TIMESTAMP(3) NOT NULL DEFAULT CURRENT_TIMESTAMP,
+
+    CONSTRAINT "HaccpAnchor_pkey" PRIMARY KEY ("id")
+);
+
+-- CreateIndex
+CREATE INDEX "HaccpAnchor_deviceId_idx" ON "HaccpAnchor"("deviceId");
+
+-- CreateIndex
+CREATE UNIQUE INDEX "HaccpAnchor_deviceId_seq_key" ON "HaccpAnchor"("deviceId", "seq");
+
+-- AddForeignKey
+ALTER TABLE "HaccpAnchor" ADD CONSTRAINT "HaccpAnchor_deviceId_fkey" FOREIGN KEY ("deviceId") REFERENCES "Device"("id") ON DELETE CASCADE ON UPDATE CASCADE;
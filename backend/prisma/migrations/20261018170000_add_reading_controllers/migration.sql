@@ -0,0 +1,2 @@
+-- AlterTable
+ALTER TABLE "SensorReading" ADD COLUMN     "controllers" JSONB;
@@ -12,6 +12,8 @@ import {
   getControllerTypeById,
   getCommandsForDevice,
 } from '../../config/controllerTypes';
+import { storeDoorStatsIntervals } from '../../services/doorEventService';
+import { storeHaccpAnchor } from '../../services/haccpAnchorService';
 
 const router = Router();
 
@@ -21,7 +23,7 @@ const deviceSchema = z.object({
   firmwareVersion: z.string().optional(),
 });
 
-const REMOTE_COMMAND_TYPES = ['RESTART', 'WIFI_SCAN', 'WIFI_CONNECT', 'FIRMWARE_UPDATE'] as const;
+const REMOTE_COMMAND_TYPES = ['RESTART', 'WIFI_SCAN', 'WIFI_CONNECT', 'FIRMWARE_UPDATE', 'SENSOR_CAL', 'LOG_CONFIG', 'LOG_UPLOAD'] as const;
 const remoteCommandSchema = z.object({
   command: z.enum(REMOTE_COMMAND_TYPES),
   payload: z.record(z.unknown()).optional(),
@@ -118,6 +120,9 @@ router.post(
         sensor_1_fault,
         sensor_2_fault,
         evaporator_fault,
+        door_stats,
+        haccp_seq,
+        haccp_head,
       } = req.body || {};
       const uptimeSeconds = typeof uptime === 'number' ? Math.round(uptime) : 0;
       const freeHeap = typeof free_heap === 'number' ? free_heap : 0;
@@ -161,6 +166,11 @@ router.post(
         },
       });
 
+      // Door-analytics van het toestel: het wist enkel wat hier bevestigd wordt.
+      const doorStatsStored = await storeDoorStatsIntervals(req.deviceId, door_stats);
+      // HACCP hash-chain anchor: toestel schuift pas op na deze bevestiging.
+      const haccpAnchorStored = await storeHaccpAnchor(req.deviceId, haccp_seq, haccp_head);
+
       // Heartbeat-driven alerting voor stroomstatus
       // ----------------------------------------------------------------------
       // Sinds carrier v1.1 stuurt het device heartbeats terwijl het op batterij
@@ -242,6 +252,8 @@ router.post(
         success: true,
         status: 'ONLINE',
         commands: commandsToReturn,
+        door_stats_stored: doorStatsStored,
+        ...(haccpAnchorStored !== null ? { haccp_anchor_stored: haccpAnchorStored } : {}),
       });
     } catch (error) {
       next(error);
@@ -569,7 +581,7 @@ router.patch(
 
 /**
  * POST /devices/:id/remote-commands
- * Create remote management command (RESTART, WIFI_SCAN, WIFI_CONNECT, FIRMWARE_UPDATE)
+ * Create remote management command (RESTART, WIFI_SCAN, WIFI_CONNECT, FIRMWARE_UPDATE, SENSOR_CAL, LOG_CONFIG, LOG_UPLOAD)
  */
 router.post(
   '/:id/remote-commands',
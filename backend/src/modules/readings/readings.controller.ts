@@ -31,6 +31,24 @@ const readingSchema = z.object({
   // weigert met 400.
   batteryLevel: z.number().min(0).max(100).nullable().optional(),
   batteryCharging: z.boolean().nullable().optional(),
+  // RS485-regelaars op de bus (firmware controller_poll.cpp, max 4 slaves):
+  // enkel verse waarden, per slave getagd. Ontbrekende punten = niet gelezen.
+  controllers: z
+    .array(
+      z.object({
+        slave: z.number().int().min(1).max(247),
+        profile: z.string().max(32),
+        temp: z.number().optional(),
+        setpoint: z.number().optional(),
+        evap_temp: z.number().optional(),
+        compressor: z.number().optional(),
+        defrost: z.number().optional(),
+        alarm: z.number().optional(),
+        power: z.number().optional(),
+      })
+    )
+    .max(4)
+    .optional(),
 });
 
 /**
@@ -89,6 +107,7 @@ router.post(
           doorStatus: data.doorStatus ?? null,
           batteryLevel: data.batteryLevel ?? null,
           batteryCharging: data.batteryCharging ?? null,
+          controllers: data.controllers?.length ? data.controllers : undefined,
           recordedAt: new Date(),
         },
         include: {
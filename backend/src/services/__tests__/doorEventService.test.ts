@@ -5,6 +5,7 @@
 import {
   validateDoorEventPayload,
   validateDoorEventBatchPayload,
+  parseDoorStatsRow,
 } from '../doorEventService';
 
 function assert(cond: boolean, msg: string) {
@@ -64,4 +65,16 @@ try {
   console.log('  ✓ validateDoorEventBatchPayload: empty events throws');
 }
 
+// parseDoorStatsRow (heartbeat door_stats)
+const row = parseDoorStatsRow([1700000000, 900, 3, 42, 20, 10, 0]);
+assert(row !== null && row.startUnixS === 1700000000 && row.opens === 3 && row.dropped === 0, 'valid row');
+console.log('  ✓ parseDoorStatsRow: valid row');
+
+assert(parseDoorStatsRow([1700000000, 900, 3, 42, 20, 10]) === null, 'short row');
+assert(parseDoorStatsRow([0, 900, 3, 42, 20, 10, 0]) === null, 'start 0');
+assert(parseDoorStatsRow([1700000000, 900, -1, 42, 20, 10, 0]) === null, 'negative');
+assert(parseDoorStatsRow([1700000000, 900, '3', 42, 20, 10, 0]) === null, 'string');
+assert(parseDoorStatsRow({ opens: 3 }) === null, 'object');
+console.log('  ✓ parseDoorStatsRow: malformed rows rejected');
+
 console.log('\nAll tests passed.');
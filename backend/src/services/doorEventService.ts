@@ -273,3 +273,96 @@ export function validateDoorEventBatchPayload(body: unknown): { device_id: strin
   }
   return { device_id: b.device_id as string, events: result };
 }
+
+/**
+ * Door-analytics uit de heartbeat: rijen [startUnixS, durationS, opens, openS,
+ * longestS, openWhileCompS, droppedEvents] (firmware door_analytics.cpp).
+ * Idempotent op (deviceId, startAt); enkel nieuwe intervallen tellen mee in
+ * DoorStatsDaily. Returnt het aantal verwerkte rijen vanaf het begin: het
+ * toestel wist er precies zoveel. Bij een DB-fout stopt de verwerking, zodat
+ * de rest bij de volgende heartbeat opnieuw komt.
+ */
+export interface DoorStatsRow {
+  startUnixS: number;
+  durationS: number;
+  opens: number;
+  openS: number;
+  longestS: number;
+  openWhileCompS: number;
+  dropped: number;
+}
+
+/** Eén door_stats-rij [start_s, dur_s, opens, open_s, longest_s, open_comp_s, dropped], of null. */
+export function parseDoorStatsRow(row: unknown): DoorStatsRow | null {
+  const valid =
+    Array.isArray(row) &&
+    row.length === 7 &&
+    row.every((v) => typeof v === 'number' && Number.isFinite(v) && v >= 0) &&
+    row[0] > 0;
+  if (!valid) return null;
+  const [startUnixS, durationS, opens, openS, longestS, openWhileCompS, dropped] = row as number[];
+  return { startUnixS, durationS, opens, openS, longestS, openWhileCompS, dropped };
+}
+
+export async function storeDoorStatsIntervals(deviceId: string, rows: unknown): Promise<number> {
+  if (!Array.isArray(rows) || rows.length === 0) return 0;
+
+  const device = await prisma.device.findUnique({
+    where: { id: deviceId },
+    include: { coldCell: { include: { location: true } } },
+  });
+  const timezone = device?.coldCell?.location?.timezone ?? 'Europe/Brussels';
+
+  let processed = 0;
+  for (const row of rows) {
+    const parsed = parseDoorStatsRow(row);
+    if (!parsed) {
+      // Toestel kan een foute rij niet herstellen: overslaan en toch acken.
+      logger.warn('Ongeldige door_stats-rij genegeerd', { deviceId, row });
+      processed++;
+      continue;
+    }
+    const { startUnixS, durationS, opens, openS, longestS, openWhileCompS, dropped } = parsed;
+    const startAt = new Date(startUnixS * 1000);
+    const date = new Date(startAt.toLocaleDateString('en-CA', { timeZone: timezone }));
+    try {
+      await prisma.$transaction([
+        prisma.doorStatsInterval.create({
+          data: {
+            deviceId,
+            startAt,
+            durationSeconds: Math.round(durationS),
+            opens: Math.round(opens),
+            openSeconds: Math.round(openS),
+            longestOpenSeconds: Math.round(longestS),
+            openWhileCompressorSeconds: Math.round(openWhileCompS),
+            droppedEvents: Math.round(dropped),
+          },
+        }),
+        prisma.doorStatsDaily.upsert({
+          where: { deviceId_date: { deviceId, date } },
+          create: {
+            deviceId,
+            date,
+            opens: Math.round(opens),
+            closes: Math.round(opens),
+            totalOpenSeconds: Math.round(openS),
+          },
+          update: {
+            opens: { increment: Math.round(opens) },
+            closes: { increment: Math.round(opens) },
+            totalOpenSeconds: { increment: Math.round(openS) },
+          },
+        }),
+      ]);
+    } catch (error: any) {
+      if (error?.code !== 'P2002') {
+        logger.error('door_stats opslaan mislukt', { deviceId, error: error?.message });
+        break;
+      }
+      // Al opgeslagen (vorige ack ging verloren): niet dubbel tellen.
+    }
+    processed++;
+  }
+  return processed;
+}
@@ -0,0 +1,60 @@
+/**
+ * HACCP-log anchors: de kop van de hash-chain die het toestel periodiek in de
+ * heartbeat meestuurt (haccp_seq, haccp_head; firmware haccp_log.cpp). Pas als
+ * de anchor hier bewaard is, bevestigt de heartbeat-response hem en schuift
+ * het toestel op naar de volgende.
+ */
+
+import { prisma } from '../config/database';
+import { logger } from '../utils/logger';
+
+export interface HaccpAnchorPayload {
+  seq: number;
+  headHash: string;
+}
+
+/** haccp_seq (uint32) + haccp_head (64 hex) uit de heartbeat, anders null. */
+export function parseHaccpAnchor(seq: unknown, head: unknown): HaccpAnchorPayload | null {
+  if (typeof seq !== 'number' || !Number.isInteger(seq) || seq < 0 || seq > 0xffffffff) return null;
+  if (typeof head !== 'string' || !/^[0-9a-f]{64}$/.test(head)) return null;
+  return { seq, headHash: head };
+}
+
+/**
+ * Anchor bewaren (idempotent op deviceId + seq). Returnt de seq die de
+ * heartbeat als "haccp_anchor_stored" terugstuurt, of null (niets/fout).
+ * Een andere hash voor een al geankerde seq wordt gelogd en niet
+ * overschreven: de eerste anchor is het referentiepunt.
+ */
+export async function storeHaccpAnchor(
+  deviceId: string,
+  seq: unknown,
+  head: unknown
+): Promise<number | null> {
+  const anchor = parseHaccpAnchor(seq, head);
+  if (!anchor) return null;
+  try {
+    const existing = await prisma.haccpAnchor.findUnique({
+      where: { deviceId_seq: { deviceId, seq: BigInt(anchor.seq) } },
+    });
+    if (existing) {
+      if (existing.headHash !== anchor.headHash) {
+        logger.error('HACCP-anchor wijkt af van eerder geankerde hash', {
+          deviceId,
+          seq: anchor.seq,
+          stored: existing.headHash,
+          received: anchor.headHash,
+        });
+      }
+      return anchor.seq;
+    }
+    await prisma.haccpAnchor.create({
+      data: { deviceId, seq: BigInt(anchor.seq), headHash: anchor.headHash },
+    });
+    return anchor.seq;
+  } catch (error: any) {
+    if (error?.code === 'P2002') return anchor.seq;  // gelijktijdige heartbeat
+    logger.error('HACCP-anchor opslaan mislukt', { deviceId, error: error?.message });
+    return null;
+  }
+}
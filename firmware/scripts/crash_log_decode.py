@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""Pak een LOG_UPLOAD-resultaat uit (crash-log van het toestel).
+
+Gebruik:
+    python3 crash_log_decode.py result.json        (of via stdin)
+    python3 crash_log_decode.py result.json | python3 log_detokenize.py
+
+Invoer: het payload-object van het remote command ({which, boot, reset,
+raw_bytes, encoding, data}) of een object dat het onder "payload" of
+"result" bevat. Uitvoer: de logtekst zoals de drain-taak ze schreef;
+tokenized regels ($...) gaan ongewijzigd door naar log_detokenize.py.
+LZSS-formaat: zie firmware/src/crash_log.cpp.
+"""
+import base64
+import json
+import sys
+
+
+def lzss_decompress(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        flags = data[i]
+        i += 1
+        for bit in range(8):
+            if i >= len(data):
+                break
+            if flags & (1 << bit):
+                off = ((data[i] << 4) | (data[i + 1] >> 4)) + 1
+                length = (data[i + 1] & 0x0F) + 3
+                i += 2
+                for _ in range(length):
+                    out.append(out[-off])
+            else:
+                out.append(data[i])
+                i += 1
+    return bytes(out)
+
+
+def main(argv):
+    if argv and argv[0] in ("-h", "--help"):
+        print(__doc__)
+        return 0
+    raw = open(argv[0], encoding="utf-8").read() if argv else sys.stdin.read()
+    doc = json.loads(raw)
+    for key in ("payload", "result"):
+        if isinstance(doc.get(key), dict):
+            doc = doc[key]
+    if "data" not in doc:
+        print(f"geen log in resultaat: {doc}", file=sys.stderr)
+        return 1
+    if doc.get("encoding") != "lzss-base64":
+        print(f"onbekende encoding: {doc.get('encoding')}", file=sys.stderr)
+        return 1
+    text = lzss_decompress(base64.b64decode(doc["data"]))
+    if len(text) != doc.get("raw_bytes", len(text)):
+        print(f"lengte {len(text)} != raw_bytes {doc['raw_bytes']}", file=sys.stderr)
+    print(f"# {doc.get('which')} boot {doc.get('boot')}, reset {doc.get('reset') or '-'}, "
+          f"{len(text)} bytes", file=sys.stderr)
+    sys.stdout.write(text.decode("utf-8", "replace"))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""Verifieer een HACCP-log dump (/haccp.old en/of /haccp.log uit SPIFFS).
+
+Gebruik:
+    python3 haccp_verify.py haccp.old haccp.log [--anchor=SEQ:HEXDIGEST]
+
+Herberekent de keten d[n] = SHA256(d[n-1] || record[n]) over de segmenten
+(in volgorde), controleert dat elk segment aansluit op het vorige en dat
+seq-nummers doorlopen, en vergelijkt optioneel met een anchor uit de
+heartbeat (haccp_seq / haccp_head). Formaat: zie firmware/src/haccp_log.h.
+"""
+import hashlib
+import struct
+import sys
+
+HEADER = struct.Struct("<IHHI32s")
+RECORD_SIZE = 32
+MAGIC = 0x31504348
+KINDS = {0: "READING", 1: "BOOT", 2: "BUFFER_CLEAR", 3: "CHAIN_RESET"}
+
+
+def main(argv):
+    anchor = None
+    files = []
+    for a in argv:
+        if a.startswith("--anchor="):
+            seq, digest = a.split("=", 1)[1].split(":")
+            anchor = (int(seq), digest.lower())
+        else:
+            files.append(a)
+    if not files:
+        print(__doc__)
+        return 2
+
+    head = None
+    next_seq = None
+    digests = {}
+    ok = True
+    for path in files:
+        data = open(path, "rb").read()
+        magic, version, rec_size, first_seq, prev = HEADER.unpack_from(data, 0)
+        if magic != MAGIC or rec_size != RECORD_SIZE:
+            print(f"{path}: ongeldige header")
+            return 1
+        if head is not None and prev != head:
+            print(f"{path}: sluit niet aan op vorig segment")
+            ok = False
+        head = prev
+        next_seq = first_seq if next_seq is None else next_seq
+        off = HEADER.size
+        count = 0
+        while off + RECORD_SIZE <= len(data):
+            rec = data[off:off + RECORD_SIZE]
+            seq, unix_s, uptime_s, kind = struct.unpack_from("<IIIB", rec)
+            if seq != next_seq:
+                print(f"{path}: seq {seq} verwacht {next_seq}")
+                ok = False
+            if kind == 3:
+                print(f"{path}: CHAIN_RESET bij seq {seq} (vorig segment onleesbaar)")
+            head = hashlib.sha256(head + rec).digest()
+            digests[seq] = head.hex()
+            next_seq = seq + 1
+            off += RECORD_SIZE
+            count += 1
+        if off != len(data):
+            print(f"{path}: {len(data) - off} byte(s) onvolledig record achteraan (genegeerd)")
+        print(f"{path}: {count} record(s), laatste seq {next_seq - 1}")
+
+    if anchor is not None:
+        seq, digest = anchor
+        if digests.get(seq) != digest:
+            print(f"anchor seq {seq}: MISMATCH")
+            ok = False
+        else:
+            print(f"anchor seq {seq}: OK")
+    print("keten OK" if ok else "keten NIET OK")
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+"""Decodeer tokenized logs (firmware gebouwd met -DLOG_TOKENIZED=1).
+
+Gebruik:
+    python3 log_detokenize.py [--src=DIR] [bestand ...]     (anders stdin)
+    python3 log_detokenize.py [--src=DIR] --serial=/dev/ttyACM0 [--baud=115200]
+    python3 log_detokenize.py [--src=DIR] --dump            (token-tabel)
+
+Regels "$<base64>" worden gedecodeerd, al de rest (tekstlogs, boot-ROM)
+gaat ongewijzigd door. Frame: [level | tag << 2][varint ms][token u32 LE]
+[args]; integers zigzag-varint, float32 LE, strings lengtebyte (bit 7 =
+afgekapt). Het token is FNV-1a 32 van de format-string; de tabel wordt
+opgebouwd uit de LOG_D/I/W/E-aanroepen in de bron (standaard ../src), dus
+gebruik de checkout van de geflashte versie. Formaat: firmware/src/logger.h.
+"""
+import base64
+import os
+import re
+import struct
+import sys
+
+LEVELS = ["DEBUG", "INFO", "WARN", "ERROR"]
+# Zelfde volgorde/namen als kTagNames in logger.cpp.
+TAGS = ["APP", "SENSOR", "Modbus", "SIM7670", "VBUS", "POWER", "NET"]
+
+CALL_RE = re.compile(r'\bLOG_[DIWE]\s*\(\s*LOG_TAG_\w+\s*,\s*((?:"(?:[^"\\\n]|\\.)*"\s*)+)')
+LITERAL_RE = re.compile(r'"((?:[^"\\\n]|\\.)*)"')
+SPEC_RE = re.compile(r'%([-+ #0]*)(\d+|\*)?(?:\.(\d+|\*))?(hh|h|ll|l|z|j|t|L)?([diouxXeEfFgGcsp%])')
+ESCAPES = {"n": "\n", "r": "\r", "t": "\t", "0": "\0", "\\": "\\", '"': '"', "'": "'"}
+
+
+def fnv1a(data):
+    h = 2166136261
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def unescape(lit):
+    out = []
+    i = 0
+    while i < len(lit):
+        c = lit[i]
+        if c == "\\" and i + 1 < len(lit):
+            nxt = lit[i + 1]
+            if nxt == "x":
+                m = re.match(r"[0-9a-fA-F]+", lit[i + 2:])
+                out.append(chr(int(m.group(0), 16)))
+                i += 2 + len(m.group(0))
+                continue
+            out.append(ESCAPES.get(nxt, nxt))
+            i += 2
+            continue
+        out.append(c)
+        i += 1
+    return "".join(out)
+
+
+def build_table(src_dir):
+    table = {}
+    for root, _, names in os.walk(src_dir):
+        for name in sorted(names):
+            if not name.endswith((".cpp", ".h")):
+                continue
+            path = os.path.join(root, name)
+            text = open(path, encoding="utf-8").read()
+            for m in CALL_RE.finditer(text):
+                fmt = "".join(unescape(x) for x in LITERAL_RE.findall(m.group(1)))
+                token = fnv1a(fmt.encode("utf-8"))
+                line = text.count("\n", 0, m.start()) + 1
+                prev = table.get(token)
+                if prev and prev[0] != fmt:
+                    print(f"token-collisie 0x{token:08x}: {prev[1]} en {name}:{line}", file=sys.stderr)
+                table[token] = (fmt, f"{name}:{line}")
+    return table
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def byte(self):
+        b = self.data[self.pos]
+        self.pos += 1
+        return b
+
+    def varint(self):
+        v = 0
+        shift = 0
+        while True:
+            b = self.byte()
+            v |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                return v
+
+    def sint(self):
+        v = self.varint()
+        return (v >> 1) ^ -(v & 1)
+
+    def float32(self):
+        v = struct.unpack_from("<f", self.data, self.pos)[0]
+        self.pos += 4
+        return v
+
+    def string(self):
+        n = self.byte()
+        s = self.data[self.pos:self.pos + (n & 0x7F)].decode("utf-8", "replace")
+        self.pos += n & 0x7F
+        return s + ("..." if n & 0x80 else "")
+
+
+def render(fmt, r):
+    def one(m):
+        flags, width, prec, _, conv = m.groups()
+        if conv == "%":
+            return "%"
+        spec = "%" + flags + (width or "") + ("." + prec if prec else "")
+        if conv in "di":
+            return (spec + "d") % r.sint()
+        if conv in "ouxX":
+            v = r.sint()
+            if v < 0:
+                v &= 0xFFFFFFFF if v >= -(1 << 31) else 0xFFFFFFFFFFFFFFFF
+            return (spec + ("d" if conv == "u" else conv)) % v
+        if conv == "c":
+            return (spec + "c") % chr(r.sint() & 0xFF)
+        if conv in "eEfFgG":
+            return (spec + conv) % r.float32()
+        if conv == "s":
+            return (spec + "s") % r.string()
+        return "0x%x" % r.varint()  # %p
+
+    return SPEC_RE.sub(one, fmt)
+
+
+def decode_line(line, table):
+    start = line.find("$")
+    if start < 0:
+        return line
+    try:
+        frame = base64.b64decode(line[start + 1:].strip(), validate=True)
+        r = Reader(frame)
+        head = r.byte()
+        ms = r.varint()
+        token = struct.unpack_from("<I", frame, r.pos)[0]
+        r.pos += 4
+    except (ValueError, IndexError, struct.error):
+        return line
+    level = LEVELS[head & 0x3]
+    tag = head >> 2
+    prefix = f"[{ms:08d}] [{level}] " + (f"[{TAGS[tag] if tag < len(TAGS) else tag}] " if tag else "")
+    entry = table.get(token)
+    if entry is None:
+        return prefix + f"<onbekend token 0x{token:08x}: {frame[r.pos:].hex()}>"
+    try:
+        return prefix + render(entry[0], r)
+    except (IndexError, struct.error, TypeError, ValueError):
+        return prefix + f"<args onleesbaar voor {entry[1]} \"{entry[0]}\">"
+
+
+def main(argv):
+    src = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "src")
+    serial_port = None
+    baud = 115200
+    dump = False
+    files = []
+    for a in argv:
+        if a.startswith("--src="):
+            src = a.split("=", 1)[1]
+        elif a.startswith("--serial="):
+            serial_port = a.split("=", 1)[1]
+        elif a.startswith("--baud="):
+            baud = int(a.split("=", 1)[1])
+        elif a == "--dump":
+            dump = True
+        elif a in ("-h", "--help"):
+            print(__doc__)
+            return 0
+        else:
+            files.append(a)
+
+    table = build_table(src)
+    if dump:
+        for token, (fmt, where) in sorted(table.items(), key=lambda kv: kv[1][1]):
+            print(f"0x{token:08x}  {where:<28} {fmt!r}")
+        return 0
+
+    if serial_port:
+        import serial  # pyserial
+        port = serial.Serial(serial_port, baud, timeout=1)
+        while True:
+            raw = port.readline()
+            if raw:
+                print(decode_line(raw.decode("utf-8", "replace").rstrip("\r\n"), table), flush=True)
+
+    streams = [open(p, encoding="utf-8", errors="replace") for p in files] or [sys.stdin]
+    for stream in streams:
+        for line in stream:
+            print(decode_line(line.rstrip("\r\n"), table))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
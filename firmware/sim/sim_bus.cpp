@@ -0,0 +1,66 @@
+#include "sim_bus.h"
+#include <algorithm>
+#include <string.h>
+
+SimBus::SimBus(const SimLinkConfig& c) : cfg(c), rng(c.seed ? c.seed : 1) {}
+
+uint32_t SimBus::charTimeUs() const {
+  return cfg.baud ? ((uint32_t)cfg.bitsPerChar * 1000000UL + cfg.baud - 1) / cfg.baud : 0;
+}
+
+double SimBus::uniform() {
+  // xorshift32: reproduceerbaar per seed, geen afhankelijkheid van libc rand().
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return (rng & 0xFFFFFF) / (double)0x1000000;
+}
+
+uint32_t SimBus::below(uint32_t n) {
+  return n ? (uint32_t)(uniform() * n) : 0;
+}
+
+void SimBus::applyNoise(uint8_t* data, size_t len) {
+  if (cfg.byteErrorRate <= 0.0) return;
+  for (size_t i = 0; i < len; i++) {
+    if (uniform() < cfg.byteErrorRate) data[i] ^= (uint8_t)(1u << below(8));
+  }
+}
+
+SimReply SimBus::exchange(const uint8_t* req, size_t len) {
+  uint8_t onWire[SIM_MAX_FRAME];
+  if (len > sizeof(onWire)) len = sizeof(onWire);
+  memcpy(onWire, req, len);
+  applyNoise(onWire, len);
+
+  SimReply reply;
+  for (SimSlave* s : slaves) {
+    SimReply r;
+    if (s->handle(onWire, len, r) && r.len > 0) {
+      reply = r;
+      break;
+    }
+  }
+  if (reply.len == 0) return reply;
+
+  if (uniform() < cfg.dropRate) {
+    reply.len = 0;
+    return reply;
+  }
+  if (reply.len > 1 && uniform() < cfg.truncateRate) {
+    reply.len = 1 + below((uint32_t)reply.len - 1);
+    reply.truncated = true;
+  }
+  applyNoise(reply.data, reply.len);
+  return reply;
+}
+
+uint32_t SimLatency::percentile(int p) const {
+  if (samples.empty()) return 0;
+  std::vector<uint32_t> sorted(samples);
+  std::sort(sorted.begin(), sorted.end());
+  size_t idx = (sorted.size() * (size_t)p + 99) / 100;
+  if (idx > 0) idx--;
+  if (idx >= sorted.size()) idx = sorted.size() - 1;
+  return sorted[idx];
+}
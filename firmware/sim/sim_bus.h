@@ -0,0 +1,88 @@
+#ifndef SIM_BUS_H
+#define SIM_BUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Virtuele RS485-lijn met gesimuleerde tijd (µs). Frames kosten
+ * len · karaktertijd op de lijn; slaves antwoorden na hun eigen vertraging.
+ * Storingen per link: bitflips per byte (ruis), weggevallen antwoorden en
+ * afgebroken frames (partial). Deterministisch per seed.
+ */
+
+#define SIM_MAX_FRAME 256
+
+struct SimLinkConfig {
+  uint32_t baud = 9600;
+  uint8_t  bitsPerChar = 11;     // Modbus RTU 8E1/8N2, Carel 8N2
+  double   byteErrorRate = 0.0;  // kans per byte op één bitflip (beide richtingen)
+  double   dropRate = 0.0;       // kans dat een antwoord volledig wegvalt
+  double   truncateRate = 0.0;   // kans op een afgebroken antwoord
+  uint32_t seed = 1;
+};
+
+/** Antwoord van een virtuele slave. */
+struct SimReply {
+  uint8_t  data[SIM_MAX_FRAME];
+  size_t   len = 0;              // 0 = geen antwoord
+  uint32_t delayUs = 0;          // einde request → eerste byte
+  bool     truncated = false;
+};
+
+class SimSlave {
+public:
+  virtual ~SimSlave() {}
+  /** Request (mogelijk verminkt) afhandelen; false = geen antwoord. */
+  virtual bool handle(const uint8_t* req, size_t len, SimReply& reply) = 0;
+};
+
+class SimBus {
+public:
+  explicit SimBus(const SimLinkConfig& cfg);
+
+  const SimLinkConfig& config() const { return cfg; }
+  uint64_t now() const { return nowUs; }
+  void     advance(uint64_t us) { nowUs += us; }
+  uint64_t lastActivity() const { return lastActivityUs; }
+  void     markActivity() { lastActivityUs = nowUs; }
+  /** Lijn bezet tot t (bv. een te laat antwoord dat nog binnenkomt). */
+  void     holdUntil(uint64_t t) { if (t > lastActivityUs) lastActivityUs = t; }
+
+  uint32_t charTimeUs() const;
+  uint32_t frameTimeUs(size_t len) const { return (uint32_t)len * charTimeUs(); }
+
+  void attach(SimSlave* slave) { slaves.push_back(slave); }
+
+  /**
+   * Request op de lijn (met ruis), eerste slave die antwoordt wint. Het
+   * antwoord krijgt de storingen van de link (drop, truncate, ruis).
+   */
+  SimReply exchange(const uint8_t* req, size_t len);
+
+  double uniform();             // [0, 1)
+  uint32_t below(uint32_t n);   // [0, n)
+
+private:
+  SimLinkConfig cfg;
+  uint64_t nowUs = 0;
+  uint64_t lastActivityUs = 0;
+  uint32_t rng;
+  std::vector<SimSlave*> slaves;
+
+  void applyNoise(uint8_t* data, size_t len);
+};
+
+/** Latency-verzameling met percentielen. */
+class SimLatency {
+public:
+  void add(uint32_t us) { samples.push_back(us); }
+  size_t count() const { return samples.size(); }
+  uint32_t percentile(int p) const;
+
+private:
+  std::vector<uint32_t> samples;
+};
+
+#endif /* SIM_BUS_H */
@@ -0,0 +1,243 @@
+/**
+ * ColdMonitor RS485-simulator: virtuele Modbus- en Carel-slaves tegen de
+ * host-build van de drivercodecs. Rapporteert per scenario transacties/s,
+ * timeout- en CRC-rates en latency-percentielen (gesimuleerde tijd).
+ *
+ *   sim [--txns N] [--seed S] [--baud B]
+ */
+
+#include "sim_bus.h"
+#include "sim_master.h"
+#include "sim_slaves.h"
+#include "controller_profiles.h"
+#include "modbus_slave_map.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+struct Options {
+  uint32_t txns = 2000;
+  uint32_t seed = 1;
+  uint32_t baud = 9600;
+};
+
+Options opt;
+
+void header() {
+  printf("%-34s %6s %8s %7s %7s %7s %7s %8s %8s %8s\n", "scenario", "txns", "txn/s", "ok%", "tmo%",
+         "crc%", "other%", "p50 ms", "p95 ms", "p99 ms");
+}
+
+void report(const char* name, const SimStats& s) {
+  printf("%-34s %6u %8.1f %7.2f %7.2f %7.2f %7.2f %8.1f %8.1f %8.1f\n", name, s.txns, s.tps(),
+         100.0 * s.rate(s.ok), 100.0 * s.rate(s.timeouts), 100.0 * s.rate(s.crc), 100.0 * s.rate(s.other),
+         s.latency.percentile(50) / 1000.0, s.latency.percentile(95) / 1000.0,
+         s.latency.percentile(99) / 1000.0);
+}
+
+SimLinkConfig link() {
+  SimLinkConfig c;
+  c.baud = opt.baud;
+  c.seed = opt.seed;
+  return c;
+}
+
+/* ------------------------------- Modbus RTU ------------------------------- */
+
+struct ModbusScenario {
+  const char* name;
+  double   byteErrorRate;
+  double   dropRate;
+  double   truncateRate;
+  uint32_t delayUs;
+  uint32_t jitterUs;
+  uint8_t  answerAs;     // verkeerd slave-ID
+  uint16_t addr;         // startadres (buiten de map → exception)
+  uint16_t qty;
+};
+
+void runModbusScenario(const ModbusScenario& sc) {
+  SimLinkConfig c = link();
+  c.byteErrorRate = sc.byteErrorRate;
+  c.dropRate = sc.dropRate;
+  c.truncateRate = sc.truncateRate;
+  SimBus bus(c);
+  SimModbusController slave(bus, 1);
+  slave.timing.delayUs = sc.delayUs;
+  slave.timing.jitterUs = sc.jitterUs;
+  slave.answerAs = sc.answerAs;
+  for (uint16_t i = 0; i < SIM_MODBUS_REGS; i++) slave.holding[i] = i;
+  bus.attach(&slave);
+
+  SimModbusMaster master(bus);
+  SimStats stats;
+  for (uint32_t i = 0; i < opt.txns; i++) {
+    master.transact(1, MODBUS_READ_HOLDING_REGISTERS, sc.addr, sc.qty, &stats);
+  }
+  report(sc.name, stats);
+}
+
+uint8_t readFc(ControllerSpace space) {
+  switch (space) {
+    case SPACE_INPUT:    return MODBUS_READ_INPUT_REGISTERS;
+    case SPACE_COIL:     return MODBUS_READ_COILS;
+    case SPACE_DISCRETE: return MODBUS_READ_DISCRETE_INPUTS;
+    default:             return MODBUS_READ_HOLDING_REGISTERS;
+  }
+}
+
+/** Volledige pollcyclus per profiel: geplande blokken vs één read per punt. */
+void runProfileCycles() {
+  static const char* kTypes[] = { "DIXELL_XR60C", "ELIWELL_IC901", "CAREL_IR33", "" };
+  for (const char* type : kTypes) {
+    const ControllerProfile& p = findControllerProfile(type);
+    uint32_t due = 0;
+    for (uint8_t i = 0; i < p.count; i++) {
+      if (p.points[i].pollS) due |= 1UL << i;
+    }
+
+    for (int planned = 1; planned >= 0; planned--) {
+      SimBus bus(link());
+      SimModbusController slave(bus, 1);
+      bus.attach(&slave);
+      SimModbusMaster master(bus);
+      SimStats txns;
+      SimLatency cycle;
+      const uint32_t cycles = opt.txns / 10 ? opt.txns / 10 : 1;
+      for (uint32_t n = 0; n < cycles; n++) {
+        const uint64_t start = bus.now();
+        if (planned) {
+          ControllerPollBlock blocks[CONTROLLER_MAX_BLOCKS];
+          const int nb = planControllerPoll(p, due, blocks, CONTROLLER_MAX_BLOCKS);
+          for (int b = 0; b < nb; b++) {
+            master.transact(1, readFc(blocks[b].space), blocks[b].start, blocks[b].count, &txns);
+          }
+        } else {
+          for (uint8_t i = 0; i < p.count; i++) {
+            if (!(due & (1UL << i))) continue;
+            const ControllerPoint& pt = p.points[i];
+            master.transact(1, readFc(pt.space), pt.addr, controllerPointWidth(pt), &txns);
+          }
+        }
+        cycle.add((uint32_t)(bus.now() - start));
+      }
+      char name[64];
+      snprintf(name, sizeof(name), "cycle %s (%s)", p.id, planned ? "planned" : "per point");
+      report(name, txns);
+      printf("%-34s cycle p50 %.1f ms, p99 %.1f ms, %.1f txn/cycle\n", "", cycle.percentile(50) / 1000.0,
+             cycle.percentile(99) / 1000.0, (double)txns.txns / cycles);
+    }
+  }
+}
+
+/** Slave-mode (BMS-gateway): volledige map in één FC03. */
+void runGateway() {
+  SimBus bus(link());
+  SimGatewaySlave gw(bus, 10);
+  gw.timing.delayUs = 2000;
+  gw.image[MBS_REG_CHANNEL_COUNT] = 2;
+  bus.attach(&gw);
+  SimModbusMaster master(bus);
+  SimStats stats;
+  for (uint32_t i = 0; i < opt.txns; i++) {
+    master.transact(10, MODBUS_READ_HOLDING_REGISTERS, 0, MBS_REG_COUNT, &stats);
+  }
+  report("gateway full map (FC03 x26)", stats);
+}
+
+/* ------------------------------- Carel PJEZ ------------------------------- */
+
+/**
+ * readDefrostParams: drie ReadI's. De legacy rxMode() hield DE nog 80 ms
+ * actief; een PJEZ die sneller antwoordt, valt (deels) in dat venster. De
+ * huidige engine laat DE los bij TX-complete en stuurt de drie als één
+ * batch (één bus-venster).
+ */
+void runCarel(const char* name, uint32_t delayUs, uint32_t jitterUs, bool legacy, double byteErrorRate) {
+  SimLinkConfig c = link();
+  c.baud = CAREL_BAUD;
+  c.bitsPerChar = CAREL_BITS_PER_CHAR;
+  c.byteErrorRate = byteErrorRate;
+  SimBus bus(c);
+  SimCarelController pjez(bus, 1);
+  pjez.timing.delayUs = delayUs;
+  pjez.timing.jitterUs = jitterUs;
+  pjez.integers[1] = 235;
+  pjez.integers[4] = 0;
+  pjez.integers[5] = 8;
+  pjez.integers[6] = 30;
+  bus.attach(&pjez);
+
+  SimCarelMaster master(bus, 1);
+  if (legacy) {
+    master.blindUs = 80000;
+    master.deSetupUs = 100;
+    master.gapUs = 0;
+  }
+  SimStats stats;
+  SimLatency window;
+  static const uint16_t kVars[3] = { 4, 5, 6 };
+  SimCarelResult res[3];
+  const uint32_t rounds = opt.txns / 10 ? opt.txns / 10 : 1;
+  for (uint32_t n = 0; n < rounds; n++) {
+    const uint64_t start = bus.now();
+    master.readBatch(kVars, 3, res, &stats);
+    window.add((uint32_t)(bus.now() - start));
+  }
+  report(name, stats);
+  printf("%-34s defrost params p50 %.1f ms, p99 %.1f ms\n", "", window.percentile(50) / 1000.0,
+         window.percentile(99) / 1000.0);
+}
+
+bool parseArgs(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    const bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--txns") && hasValue) opt.txns = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--seed") && hasValue) opt.seed = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--baud") && hasValue) opt.baud = strtoul(argv[++i], nullptr, 10);
+    else {
+      fprintf(stderr, "gebruik: %s [--txns N] [--seed S] [--baud B]\n", argv[0]);
+      return false;
+    }
+  }
+  return opt.txns > 0 && opt.baud > 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (!parseArgs(argc, argv)) return 2;
+  printf("ColdMonitor RS485 simulator: %u txns/scenario, Modbus %u baud, seed %u\n\n", opt.txns, opt.baud,
+         opt.seed);
+
+  static const ModbusScenario kScenarios[] = {
+    // name                            noise   drop  trunc  delay   jitter  as  addr qty
+    { "modbus clean (FC03 x2)",         0.0,   0.0,  0.0,   20000,  5000,   0,  0,   2 },
+    { "modbus clean (FC03 x26)",        0.0,   0.0,  0.0,   20000,  5000,   0,  0,   26 },
+    { "modbus noise 0.2%/byte",         0.002, 0.0,  0.0,   20000,  5000,   0,  0,   26 },
+    { "modbus slow slave (250-450ms)",  0.0,   0.0,  0.0,   250000, 200000, 0,  0,   2 },
+    { "modbus wrong slave id",          0.0,   0.0,  0.0,   20000,  5000,   2,  0,   2 },
+    { "modbus partial frames 5%",       0.0,   0.0,  0.05,  20000,  5000,   0,  0,   26 },
+    { "modbus dropped replies 5%",      0.0,   0.05, 0.0,   20000,  5000,   0,  0,   2 },
+    { "modbus exception (addr 500)",    0.0,   0.0,  0.0,   20000,  5000,   0,  500, 26 },
+  };
+
+  header();
+  for (const ModbusScenario& sc : kScenarios) runModbusScenario(sc);
+  printf("\n");
+  header();
+  runProfileCycles();
+  printf("\n");
+  header();
+  runGateway();
+  printf("\n");
+  header();
+  runCarel("carel PJEZ 100ms, legacy 80ms DE", 100000, 10000, true, 0.0);
+  runCarel("carel PJEZ 20ms, legacy 80ms DE", 20000, 10000, true, 0.0);
+  runCarel("carel PJEZ 100ms, batch", 100000, 10000, false, 0.0);
+  runCarel("carel PJEZ 20ms, batch", 20000, 10000, false, 0.0);
+  runCarel("carel PJEZ 100ms, noise 0.5%/byte", 100000, 10000, false, 0.005);
+  return 0;
+}
@@ -0,0 +1,157 @@
+#include "sim_master.h"
+
+double SimStats::tps() const {
+  const uint64_t span = endUs > startUs ? endUs - startUs : 0;
+  return span ? txns * 1e6 / (double)span : 0.0;
+}
+
+namespace {
+
+void begin(SimStats* stats, SimBus& bus) {
+  if (stats && stats->txns == 0) stats->startUs = bus.now();
+}
+
+} // namespace
+
+/* ------------------------------- Modbus RTU ------------------------------- */
+
+SimModbusResult SimModbusMaster::transact(uint8_t slave, uint8_t fc, uint16_t addr, uint16_t qty,
+                                          SimStats* stats) {
+  SimModbusResult res;
+  uint8_t frame[MODBUS_RTU_MAX_FRAME];
+  const size_t len = modbusBuildRequest(frame, slave, fc, addr, qty);
+  const uint32_t baud = bus.config().baud;
+
+  // waitInterFrameGap(): t3.5 stilte sinds de laatste byte op de lijn.
+  const uint64_t gapEnd = bus.lastActivity() + modbusT35Us(baud);
+  if (bus.now() < gapEnd) bus.advance(gapEnd - bus.now());
+  begin(stats, bus);
+  const uint64_t txStart = bus.now();
+  bus.advance(bus.frameTimeUs(len));
+  bus.markActivity();
+  const uint64_t txEnd = bus.now();
+
+  const SimReply r = bus.exchange(frame, len);
+  const uint64_t deadline = txEnd + (uint64_t)timeoutMs * 1000;
+  const uint64_t rxEnd = txEnd + r.delayUs + bus.frameTimeUs(r.len);
+
+  if (r.len == 0 || txEnd + r.delayUs >= deadline) {
+    bus.advance(deadline - txEnd);
+    if (r.len) bus.holdUntil(rxEnd);   // te laat antwoord bezet de lijn nog
+    res.status = MODBUS_ERR_TIMEOUT;
+  } else {
+    // Verwachte lengte: de RX-FIFO-drempel wekt de worker bij de laatste
+    // byte. Een exception (korter) meldt de UART pas na t1.5 stilte. Korter
+    // frame zonder exception: de worker wacht tolerant door tot de deadline.
+    const size_t expected = modbusExpectedResponseLength(fc, qty);
+    const bool exception = r.len >= 5 && (r.data[1] & 0x80);
+    uint64_t done = rxEnd > deadline ? rxEnd : deadline;
+    if (expected != 0 && r.len >= expected) done = rxEnd;
+    else if (exception) done = rxEnd + modbusT15Us(baud);
+    bus.advance(done - txEnd);
+    bus.holdUntil(rxEnd);
+    res.status = modbusParseResponse(r.data, r.len, slave, fc, qty, &res.exception);
+    if (res.status == MODBUS_OK && (fc == MODBUS_READ_HOLDING_REGISTERS || fc == MODBUS_READ_INPUT_REGISTERS)) {
+      res.regCount = modbusExtractRegisters(r.data, r.len, res.regs, MODBUS_RTU_MAX_REGS);
+    }
+  }
+  res.latencyUs = (uint32_t)(bus.now() - txStart);
+
+  if (stats) {
+    stats->txns++;
+    if (res.status == MODBUS_OK) stats->ok++;
+    else if (res.status == MODBUS_ERR_TIMEOUT) stats->timeouts++;
+    else if (res.status == MODBUS_ERR_CRC) stats->crc++;
+    else stats->other++;
+    stats->latency.add(res.latencyUs);
+    stats->endUs = bus.now();
+  }
+  return res;
+}
+
+/* ------------------------------- Carel PJEZ ------------------------------- */
+
+SimCarelResult SimCarelMaster::exchange(const uint8_t* req, size_t len, size_t expected, SimStats* stats) {
+  SimCarelResult res;
+  const uint64_t gapEnd = bus.lastActivity() + gapUs;
+  if (bus.now() < gapEnd) bus.advance(gapEnd - bus.now());
+  begin(stats, bus);
+  const uint64_t txStart = bus.now();
+  bus.advance(deSetupUs + bus.frameTimeUs(len));
+  bus.markActivity();
+  const uint64_t txEnd = bus.now();
+
+  const SimReply r = bus.exchange(req, len);
+  const uint64_t rxOpen = txEnd + blindUs;
+  const uint64_t deadline = rxOpen + (uint64_t)timeoutMs * 1000;
+  const uint32_t ct = bus.charTimeUs();
+
+  // Bytes waarvan de startbit vóór rxOpen valt, ziet de ontvanger niet
+  // (DE nog actief); bytes na de deadline worden niet meer gelezen.
+  uint8_t rx[CAREL_MAX_FRAME];
+  size_t n = 0;
+  uint64_t lastByteEnd = 0;
+  for (size_t i = 0; i < r.len && n < expected; i++) {
+    const uint64_t start = txEnd + r.delayUs + (uint64_t)i * ct;
+    if (start < rxOpen) continue;
+    if (start + ct > deadline) break;
+    rx[n++] = r.data[i];
+    lastByteEnd = start + ct;
+  }
+  if (r.len) bus.holdUntil(txEnd + r.delayUs + bus.frameTimeUs(r.len));
+  res.rxBytes = (uint8_t)n;
+
+  if (n < expected) {
+    bus.advance(deadline - txEnd);
+    res.status = CAREL_ERR_TIMEOUT;
+  } else {
+    bus.advance(lastByteEnd - txEnd);
+    if (expected == 1) {
+      res.status = carelParseWriteAck(rx[0]);
+      // Onbekend byte: CarelProtocol leest door tot de timeout.
+      if (res.status == CAREL_ERR_UNKNOWN) bus.advance(deadline - bus.now());
+    } else {
+      res.status = carelParseReadResponse(rx, n, &res.value);
+    }
+  }
+  res.latencyUs = (uint32_t)(bus.now() - txStart);
+
+  if (stats) {
+    stats->txns++;
+    if (res.status == CAREL_OK) stats->ok++;
+    else if (res.status == CAREL_ERR_TIMEOUT) stats->timeouts++;
+    else if (res.status == CAREL_ERR_CRC) stats->crc++;
+    else stats->other++;
+    stats->latency.add(res.latencyUs);
+    stats->endUs = bus.now();
+  }
+  return res;
+}
+
+SimCarelResult SimCarelMaster::readInteger(uint16_t var, SimStats* stats) {
+  uint8_t msg[CAREL_READ_REQUEST_LEN];
+  const size_t len = carelBuildRead(msg, addr, var);
+  return exchange(msg, len, CAREL_READ_RESPONSE_LEN, stats);
+}
+
+SimCarelResult SimCarelMaster::writeDigital(uint16_t var, uint8_t value, SimStats* stats) {
+  uint8_t msg[CAREL_WRITE_D_REQUEST_LEN];
+  const size_t len = carelBuildWriteDigital(msg, addr, var, value);
+  return exchange(msg, len, 1, stats);
+}
+
+uint8_t SimCarelMaster::readBatch(const uint16_t* vars, uint8_t count, SimCarelResult* out, SimStats* stats) {
+  uint8_t ok = 0;
+  bool silent = false;
+  for (uint8_t i = 0; i < count; i++) {
+    if (silent) {
+      out[i] = SimCarelResult();
+      continue;
+    }
+    out[i] = readInteger(vars[i], stats);
+    if (out[i].status == CAREL_OK) ok++;
+    // Geen enkel byte ontvangen: regelaar weg, rest overslaan.
+    silent = out[i].rxBytes == 0;
+  }
+  return ok;
+}
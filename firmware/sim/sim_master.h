@@ -0,0 +1,84 @@
+#ifndef SIM_MASTER_H
+#define SIM_MASTER_H
+
+#include "sim_bus.h"
+#include "modbus_rtu.h"
+#include "carel_frame.h"
+
+/**
+ * Host-masters met dezelfde codec en hetzelfde tijdsgedrag als de firmware:
+ *  - SimModbusMaster volgt RS485Modbus::execute + rs485BusReceive: t3.5
+ *    stilte vóór TX, antwoord compleet zodra de verwachte lengte binnen is
+ *    (RX-FIFO-drempel), een exception pas bij de UART RX-timeout (t1.5),
+ *    anders wachten tot de deadline (timeoutMs).
+ *  - SimCarelMaster volgt CarelProtocol::execute: 3.5 karakters stilte vóór
+ *    elk item (rs485BusWaitIdle), DE los bij TX-complete, antwoord compleet
+ *    zodra de verwachte lengte binnen is. readBatch() = één bus-venster; na
+ *    een item zonder enig byte worden de rest overgeslagen. Legacy-gedrag:
+ *    blindUs (delay(80)) waarin bytes verloren gaan, deSetupUs, gapUs = 0.
+ * Alle tijden zijn gesimuleerde µs op de SimBus.
+ */
+
+struct SimStats {
+  uint32_t txns = 0;
+  uint32_t ok = 0;
+  uint32_t timeouts = 0;
+  uint32_t crc = 0;
+  uint32_t other = 0;            // exception, verkeerd slave-ID, short, NAK...
+  uint64_t startUs = 0;
+  uint64_t endUs = 0;
+  SimLatency latency;            // TX-start → resultaat
+
+  double tps() const;
+  double rate(uint32_t n) const { return txns ? (double)n / txns : 0.0; }
+};
+
+struct SimModbusResult {
+  ModbusStatus status = MODBUS_ERR_BUS;
+  uint8_t  exception = 0;
+  uint16_t regs[MODBUS_RTU_MAX_REGS];
+  uint16_t regCount = 0;
+  uint32_t latencyUs = 0;
+};
+
+class SimModbusMaster {
+public:
+  explicit SimModbusMaster(SimBus& bus) : bus(bus) {}
+
+  uint32_t timeoutMs = MODBUS_RX_DEADLINE_MS;
+
+  /** FC01..06; qty = aantal of schrijfwaarde, zoals ModbusTxn. */
+  SimModbusResult transact(uint8_t slave, uint8_t fc, uint16_t addr, uint16_t qty, SimStats* stats = nullptr);
+
+private:
+  SimBus& bus;
+};
+
+struct SimCarelResult {
+  CarelStatus status = CAREL_ERR_TIMEOUT;
+  int16_t  value = 0;
+  uint32_t latencyUs = 0;
+  uint8_t  rxBytes = 0;          // ontvangen bytes (0 = regelaar stil)
+};
+
+class SimCarelMaster {
+public:
+  SimCarelMaster(SimBus& bus, uint8_t addr) : bus(bus), addr(addr) {}
+
+  uint32_t blindUs = 0;          // DE na TX-complete (legacy: 80000)
+  uint32_t deSetupUs = 0;        // legacy txMode(): 100
+  uint32_t gapUs = carelCharTimeUs(CAREL_BAUD) * 7 / 2;     // stilte vóór TX
+  uint32_t timeoutMs = 500;      // RESPONSE_TIMEOUT_MS
+
+  SimCarelResult readInteger(uint16_t var, SimStats* stats = nullptr);
+  SimCarelResult writeDigital(uint16_t var, uint8_t value, SimStats* stats = nullptr);
+  /** Batch zoals CarelRequest; returnt het aantal geslaagde reads. */
+  uint8_t readBatch(const uint16_t* vars, uint8_t count, SimCarelResult* out, SimStats* stats = nullptr);
+
+private:
+  SimBus& bus;
+  uint8_t addr;
+  SimCarelResult exchange(const uint8_t* req, size_t len, size_t expected, SimStats* stats);
+};
+
+#endif /* SIM_MASTER_H */
@@ -0,0 +1,159 @@
+#include "sim_slaves.h"
+#include "modbus_rtu.h"
+#include "modbus_slave_map.h"
+#include "carel_frame.h"
+
+namespace {
+
+uint32_t delayOf(SimBus& bus, const SimTiming& t) {
+  return t.delayUs + (t.jitterUs ? bus.below(t.jitterUs) : 0);
+}
+
+size_t finish(uint8_t* out, size_t len) {
+  const uint16_t crc = modbusCrc16(out, len);
+  out[len] = crc & 0xFF;
+  out[len + 1] = (crc >> 8) & 0xFF;
+  return len + 2;
+}
+
+} // namespace
+
+/* ----------------------------- Modbus-regelaar ----------------------------- */
+
+SimModbusController::SimModbusController(SimBus& b, uint8_t a, uint16_t n)
+    : addr(a), regCount(n > SIM_MODBUS_REGS ? SIM_MODBUS_REGS : n), bus(b) {}
+
+size_t SimModbusController::exception(SimReply& reply, uint8_t fc, uint8_t code) {
+  reply.data[0] = answerAs ? answerAs : addr;
+  reply.data[1] = fc | 0x80;
+  reply.data[2] = code;
+  return finish(reply.data, 3);
+}
+
+bool SimModbusController::handle(const uint8_t* req, size_t len, SimReply& reply) {
+  if (len < 8 || req[0] != addr) return false;
+  if (modbusCrc16(req, len - 2) != (uint16_t)(req[len - 2] | (req[len - 1] << 8))) return false;
+  requests++;
+  reply.delayUs = delayOf(bus, timing);
+
+  const uint8_t fc = req[1];
+  const uint16_t start = (uint16_t)((req[2] << 8) | req[3]);
+  const uint16_t qty = (uint16_t)((req[4] << 8) | req[5]);
+  uint8_t* out = reply.data;
+  out[0] = answerAs ? answerAs : addr;
+  out[1] = fc;
+
+  switch (fc) {
+    case MODBUS_READ_HOLDING_REGISTERS:
+    case MODBUS_READ_INPUT_REGISTERS:
+      if (qty == 0 || qty > MODBUS_RTU_MAX_REGS) {
+        reply.len = exception(reply, fc, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+      } else if ((uint32_t)start + qty > regCount) {
+        reply.len = exception(reply, fc, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS);
+      } else {
+        out[2] = (uint8_t)(qty * 2);
+        for (uint16_t i = 0; i < qty; i++) {
+          out[3 + i * 2] = holding[start + i] >> 8;
+          out[4 + i * 2] = holding[start + i] & 0xFF;
+        }
+        reply.len = finish(out, 3 + (size_t)qty * 2);
+      }
+      return true;
+    case MODBUS_READ_COILS:
+    case MODBUS_READ_DISCRETE_INPUTS:
+      if (qty == 0 || qty > MODBUS_RTU_MAX_BITS) {
+        reply.len = exception(reply, fc, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+      } else if ((uint32_t)start + qty > regCount) {
+        reply.len = exception(reply, fc, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS);
+      } else {
+        const uint8_t bytes = (uint8_t)((qty + 7) / 8);
+        out[2] = bytes;
+        for (uint8_t b = 0; b < bytes; b++) out[3 + b] = 0;
+        for (uint16_t i = 0; i < qty; i++) {
+          if (coils[start + i]) out[3 + i / 8] |= (uint8_t)(1 << (i % 8));
+        }
+        reply.len = finish(out, 3 + bytes);
+      }
+      return true;
+    case MODBUS_WRITE_SINGLE_COIL:
+    case MODBUS_WRITE_SINGLE_REGISTER:
+      if (start >= regCount) {
+        reply.len = exception(reply, fc, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS);
+        return true;
+      }
+      if (fc == MODBUS_WRITE_SINGLE_COIL) {
+        coils[start] = qty == 0xFF00;
+      } else {
+        holding[start] = qty;
+      }
+      for (uint8_t i = 2; i < 6; i++) out[i] = req[i];  // echo
+      reply.len = finish(out, 6);
+      return true;
+    case MODBUS_WRITE_MULTIPLE_REGISTERS:
+      if (len < 9 || len < 9 + (size_t)req[6] || qty == 0 || req[6] != qty * 2) {
+        reply.len = exception(reply, fc, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+      } else if ((uint32_t)start + qty > regCount) {
+        reply.len = exception(reply, fc, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS);
+      } else {
+        for (uint16_t i = 0; i < qty; i++) holding[start + i] = (uint16_t)((req[7 + i * 2] << 8) | req[8 + i * 2]);
+        for (uint8_t i = 2; i < 6; i++) out[i] = req[i];
+        reply.len = finish(out, 6);
+      }
+      return true;
+    default:
+      reply.len = exception(reply, fc, MODBUS_EXCEPTION_ILLEGAL_FUNCTION);
+      return true;
+  }
+}
+
+/* ------------------------- Gateway (eigen slave-mode) ---------------------- */
+
+SimGatewaySlave::SimGatewaySlave(SimBus& b, uint8_t a) : addr(a), bus(b) {
+  image[MBS_REG_VERSION] = MBS_MAP_VERSION;
+}
+
+bool SimGatewaySlave::handle(const uint8_t* req, size_t len, SimReply& reply) {
+  reply.len = modbusSlaveHandle(req, len, addr, image, MBS_REG_COUNT, reply.data, sizeof(reply.data));
+  if (reply.len == 0) return false;
+  reply.delayUs = delayOf(bus, timing);
+  return true;
+}
+
+/* ------------------------------ Carel PJEZ -------------------------------- */
+
+SimCarelController::SimCarelController(SimBus& b, uint8_t a) : addr(a), bus(b) {}
+
+bool SimCarelController::handle(const uint8_t* req, size_t len, SimReply& reply) {
+  if (len < CAREL_READ_REQUEST_LEN || req[0] != CAREL_ENQ || req[1] != addr) return false;
+  if (carelChecksum(req, len - 1) != req[len - 1]) return false;  // PJEZ zwijgt bij fout
+  reply.delayUs = delayOf(bus, timing);
+  const uint16_t var = (uint16_t)((req[4] << 8) | req[5]);
+
+  if (req[2] == CAREL_OP_READ) {
+    auto it = integers.find(var);
+    if (it == integers.end()) {
+      reply.data[0] = CAREL_NAK;
+      reply.len = 1;
+      return true;
+    }
+    reply.data[0] = 0x02;
+    reply.data[1] = addr;
+    reply.data[2] = ((uint16_t)it->second >> 8) & 0xFF;
+    reply.data[3] = (uint16_t)it->second & 0xFF;
+    reply.data[4] = carelChecksum(reply.data, 4);
+    reply.len = CAREL_READ_RESPONSE_LEN;
+    return true;
+  }
+  if (req[2] == CAREL_OP_WRITE && req[3] == CAREL_TYPE_DIGITAL && len >= CAREL_WRITE_D_REQUEST_LEN) {
+    digitals[var] = req[6];
+    reply.data[0] = CAREL_ACK;
+  } else if (req[2] == CAREL_OP_WRITE && req[3] == CAREL_TYPE_INTEGER && len >= CAREL_WRITE_I_REQUEST_LEN &&
+             integers.count(var)) {
+    integers[var] = (int16_t)((req[6] << 8) | req[7]);
+    reply.data[0] = CAREL_ACK;
+  } else {
+    reply.data[0] = CAREL_NAK;
+  }
+  reply.len = 1;
+  return true;
+}
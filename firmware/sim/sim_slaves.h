@@ -0,0 +1,72 @@
+#ifndef SIM_SLAVES_H
+#define SIM_SLAVES_H
+
+#include "sim_bus.h"
+#include <map>
+
+/**
+ * Virtuele slaves voor de simulator:
+ *  - SimModbusController: regelaar met holding/input registers en coils
+ *    (FC01..06, FC16), exceptions buiten de map, instelbare vertraging en
+ *    een verkeerd ingesteld slave-adres (antwoordt met answerAs).
+ *  - SimGatewaySlave: onze eigen slave-mode (modbus_slave_map) op een
+ *    vast register-image.
+ *  - SimCarelController: Carel PJEZ (1200 8N2) met integer/digitale vars.
+ */
+
+#define SIM_MODBUS_REGS 512    // dekt de profielen (Eliwell vanaf 0x0100)
+
+struct SimTiming {
+  uint32_t delayUs = 20000;      // einde request → eerste antwoordbyte
+  uint32_t jitterUs = 0;         // + [0, jitter)
+};
+
+class SimModbusController : public SimSlave {
+public:
+  SimModbusController(SimBus& bus, uint8_t addr, uint16_t regCount = SIM_MODBUS_REGS);
+
+  uint8_t   addr;
+  uint8_t   answerAs = 0;        // ≠ 0: antwoordt met dit adres (verkeerd slave-ID)
+  uint16_t  regCount;
+  SimTiming timing;
+  uint16_t  holding[SIM_MODBUS_REGS] = {};
+  bool      coils[SIM_MODBUS_REGS] = {};
+  uint32_t  requests = 0;
+
+  bool handle(const uint8_t* req, size_t len, SimReply& reply) override;
+
+private:
+  SimBus& bus;
+  size_t exception(SimReply& reply, uint8_t fc, uint8_t code);
+};
+
+class SimGatewaySlave : public SimSlave {
+public:
+  SimGatewaySlave(SimBus& bus, uint8_t addr);
+
+  uint8_t   addr;
+  SimTiming timing;
+  uint16_t  image[64] = {};      // MBS_REG_COUNT registers gebruikt
+
+  bool handle(const uint8_t* req, size_t len, SimReply& reply) override;
+
+private:
+  SimBus& bus;
+};
+
+class SimCarelController : public SimSlave {
+public:
+  SimCarelController(SimBus& bus, uint8_t addr);
+
+  uint8_t   addr;
+  SimTiming timing;
+  std::map<uint16_t, int16_t> integers;
+  std::map<uint16_t, uint8_t> digitals;
+
+  bool handle(const uint8_t* req, size_t len, SimReply& reply) override;
+
+private:
+  SimBus& bus;
+};
+
+#endif /* SIM_SLAVES_H */
@@ -0,0 +1,189 @@
+#include "alarm_engine.h"
+#include "sensors_pt1000.h"
+#include "door_analytics.h"
+#include "relay_control.h"
+#include "time_utils.h"
+#include "logger.h"
+#include <Preferences.h>
+
+extern Logger logger;
+
+namespace {
+
+const char* const kNamespace = "alarms";
+
+struct AlarmRule {
+  bool     active;
+  uint32_t condSinceMs;   // 0 = conditie niet waar
+  uint32_t clearSinceMs;  // 0 = conditie (nog) waar
+  uint32_t raisedUnixS;   // 0 als klok niet gesynct bij activatie
+};
+
+AlarmRule s_rules[ALARM_COUNT];
+uint8_t   s_mask = 0;
+float     s_minTempC = -25.0f;
+float     s_maxTempC = -15.0f;
+bool      s_relayByAlarm = false;
+bool      s_evaluated = false;   // relais pas na de eerste evaluatie (boot: uit)
+
+void persist() {
+  Preferences prefs;
+  if (!prefs.begin(kNamespace, false)) return;
+  prefs.putUChar("mask", s_mask);
+  prefs.putFloat("min", s_minTempC);
+  prefs.putFloat("max", s_maxTempC);
+  uint32_t since[ALARM_COUNT];
+  for (uint8_t i = 0; i < ALARM_COUNT; i++) since[i] = s_rules[i].raisedUnixS;
+  prefs.putBytes("since", since, sizeof(since));
+  prefs.end();
+}
+
+void driveRelay() {
+  if (s_mask && !getRelayState()) {
+    setRelay(true);
+    s_relayByAlarm = true;
+  } else if (!s_mask && s_relayByAlarm) {
+    // Enkel terug uit als wij het relais aanzetten (RELAY_ON remote blijft staan).
+    setRelay(false);
+    s_relayByAlarm = false;
+  }
+}
+
+// Debounced regel: activeren na delayMs conditie, clearen na clearMs zonder.
+bool process(AlarmId id, bool cond, uint32_t delayMs, uint32_t clearMs, uint32_t now) {
+  AlarmRule& r = s_rules[id];
+  if (cond) {
+    r.clearSinceMs = 0;
+    if (r.condSinceMs == 0) r.condSinceMs = now ? now : 1;
+    if (!r.active && (now - r.condSinceMs) >= delayMs) {
+      r.active = true;
+      r.raisedUnixS = (uint32_t)(getUnixTimeMs() / 1000);
+      return true;
+    }
+  } else {
+    r.condSinceMs = 0;
+    if (r.active) {
+      if (r.clearSinceMs == 0) r.clearSinceMs = now ? now : 1;
+      if ((now - r.clearSinceMs) >= clearMs) {
+        r.active = false;
+        r.raisedUnixS = 0;
+        r.clearSinceMs = 0;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+void initAlarmEngine() {
+  Preferences prefs;
+  if (prefs.begin(kNamespace, true)) {
+    s_mask = prefs.getUChar("mask", 0);
+    s_minTempC = prefs.getFloat("min", s_minTempC);
+    s_maxTempC = prefs.getFloat("max", s_maxTempC);
+    uint32_t since[ALARM_COUNT] = {};
+    if (prefs.getBytesLength("since") == sizeof(since)) prefs.getBytes("since", since, sizeof(since));
+    prefs.end();
+    for (uint8_t i = 0; i < ALARM_COUNT; i++) {
+      s_rules[i].active = (s_mask >> i) & 1;
+      s_rules[i].raisedUnixS = since[i];
+    }
+  }
+  if (s_mask) {
+    String names;
+    for (uint8_t i = 0; i < ALARM_COUNT; i++) {
+      if (s_rules[i].active) names += String(names.length() ? "," : "") + alarmName((AlarmId)i);
+    }
+    // Relais blijft uit (relay_control.h) tot de eerste evaluatie de
+    // alarmen op actuele waarden bevestigt.
+    logger.warn("[ALARM] actief na reboot: " + names + " (relais volgt na eerste evaluatie)");
+  }
+}
+
+void alarmEngineSetThresholds(float minTempC, float maxTempC) {
+  if (isnan(minTempC) || isnan(maxTempC) || minTempC >= maxTempC) return;
+  if (minTempC == s_minTempC && maxTempC == s_maxTempC) return;
+  s_minTempC = minTempC;
+  s_maxTempC = maxTempC;
+  persist();
+  logger.info("[ALARM] drempels " + String(minTempC, 1) + ".." + String(maxTempC, 1) + "°C");
+}
+
+bool alarmEngineEvaluate() {
+  const uint32_t now = millis();
+  bool changed = false;
+
+  const int8_t room = sensorIndexForRole(SENSOR_ROLE_ROOM);
+  const float t = room >= 0 ? getCachedTempC((uint8_t)room) : NAN;
+
+  // Zonder geldige temperatuur blijven de temp-regels in hun toestand;
+  // SENSOR_FAULT dekt dat geval.
+  if (!isnan(t)) {
+    const bool highCond = s_rules[ALARM_TEMP_HIGH].active
+                              ? (t > s_maxTempC - ALARM_TEMP_HYSTERESIS_C)
+                              : (t > s_maxTempC);
+    const bool lowCond = s_rules[ALARM_TEMP_LOW].active
+                             ? (t < s_minTempC + ALARM_TEMP_HYSTERESIS_C)
+                             : (t < s_minTempC);
+    changed |= process(ALARM_TEMP_HIGH, highCond, ALARM_TEMP_DELAY_MS, ALARM_CLEAR_DELAY_MS, now);
+    changed |= process(ALARM_TEMP_LOW, lowCond, ALARM_TEMP_DELAY_MS, ALARM_CLEAR_DELAY_MS, now);
+  }
+
+  // Vertraging zit al in door_analytics (deviceDoorAlarmDelaySec).
+  changed |= process(ALARM_DOOR_AJAR, doorAjar(), 0, 0, now);
+
+  const bool faultCond = room < 0 || sensorFaultClass((uint8_t)room) != SENSOR_FAULT_NONE;
+  changed |= process(ALARM_SENSOR_FAULT, faultCond, ALARM_SENSOR_FAULT_DELAY_MS,
+                     ALARM_CLEAR_DELAY_MS, now);
+
+  const bool firstRun = !s_evaluated;
+  s_evaluated = true;
+  if (!changed) {
+    if (firstRun) driveRelay();  // herstelde alarmen nog steeds actief
+    return false;
+  }
+
+  uint8_t mask = 0;
+  for (uint8_t i = 0; i < ALARM_COUNT; i++) {
+    if (s_rules[i].active) mask |= (uint8_t)(1u << i);
+  }
+  const uint8_t raised = mask & ~s_mask;
+  const uint8_t cleared = s_mask & ~mask;
+  s_mask = mask;
+  for (uint8_t i = 0; i < ALARM_COUNT; i++) {
+    if (raised & (1u << i)) {
+      logger.warn(String("[ALARM] ") + alarmName((AlarmId)i) + " ACTIEF" +
+                  (isnan(t) ? String("") : " (ruimte " + String(t, 1) + "°C)"));
+    } else if (cleared & (1u << i)) {
+      logger.info(String("[ALARM] ") + alarmName((AlarmId)i) + " opgeheven");
+    }
+  }
+  driveRelay();
+  persist();
+  return true;
+}
+
+uint8_t activeAlarmMask() {
+  return s_mask;
+}
+
+const char* alarmName(AlarmId id) {
+  switch (id) {
+    case ALARM_TEMP_HIGH:    return "TEMP_HIGH";
+    case ALARM_TEMP_LOW:     return "TEMP_LOW";
+    case ALARM_DOOR_AJAR:    return "DOOR_AJAR";
+    case ALARM_SENSOR_FAULT: return "SENSOR_FAULT";
+    default:                 return "?";
+  }
+}
+
+void writeAlarmJson(JsonDocument& doc) {
+  doc["alarms"] = s_mask;
+  if (!s_mask) return;
+  JsonObject since = doc.createNestedObject("alarm_since");
+  for (uint8_t i = 0; i < ALARM_COUNT; i++) {
+    if (s_rules[i].active) since[alarmName((AlarmId)i)] = s_rules[i].raisedUnixS;
+  }
+}
@@ -0,0 +1,56 @@
+#ifndef ALARM_ENGINE_H
+#define ALARM_ENGINE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/**
+ * Lokale alarm-engine, onafhankelijk van de cloud. Evalueert elke
+ * sensorTask-iteratie (~200 ms) op gecachte waarden (geen SPI):
+ *
+ *   TEMP_HIGH     ruimte > maxTemp       (clear < maxTemp - hysterese)
+ *   TEMP_LOW      ruimte < minTemp       (clear > minTemp + hysterese)
+ *   DOOR_AJAR     deur langer open dan deviceDoorAlarmDelaySec (door_analytics)
+ *   SENSOR_FAULT  ruimte-voeler in foutklasse (sensors_pt1000)
+ *
+ * Elke regel heeft een activatie- en een clear-vertraging. Bij een wissel:
+ * relais aan/uit (enkel als het relais door de engine werd aangezet), log,
+ * en alarmEngineEvaluate() returnt true zodat de aanroeper meteen een reading
+ * buffert en een upload forceert — ook offline (relais + buffer werken lokaal).
+ *
+ * Actieve alarmen en drempels staan in NVS ("alarms"): na een reboot werkt
+ * de engine zonder eerst de cloud te halen. Het relais blijft bij boot uit
+ * (relay_control.h) en volgt de alarmen vanaf de eerste evaluatie.
+ */
+
+enum AlarmId : uint8_t {
+  ALARM_TEMP_HIGH    = 0,
+  ALARM_TEMP_LOW     = 1,
+  ALARM_DOOR_AJAR    = 2,
+  ALARM_SENSOR_FAULT = 3,
+  ALARM_COUNT
+};
+
+#define ALARM_TEMP_HYSTERESIS_C    0.5f
+#define ALARM_TEMP_DELAY_MS        (5UL * 60UL * 1000UL)
+#define ALARM_SENSOR_FAULT_DELAY_MS 60000UL
+#define ALARM_CLEAR_DELAY_MS       30000UL
+
+/** Laadt drempels + actieve alarmen uit NVS; het relais blijft uit tot alarmEngineEvaluate(). */
+void initAlarmEngine();
+
+/** Drempels uit de device-settings; persisteert enkel bij wijziging. */
+void alarmEngineSetThresholds(float minTempC, float maxTempC);
+
+/** Eén evaluatieronde. Returnt true als de set actieve alarmen wijzigde. */
+bool alarmEngineEvaluate();
+
+/** Bitmasker (1 << AlarmId) van actieve alarmen. */
+uint8_t activeAlarmMask();
+
+const char* alarmName(AlarmId id);
+
+/** Heartbeat/reading: "alarms" (mask) + "alarm_since" (Unix s per actief alarm). */
+void writeAlarmJson(JsonDocument& doc);
+
+#endif /* ALARM_ENGINE_H */
@@ -1,10 +1,19 @@
 #include "api_client.h"
 #include "board_pins.h"
 #include "door_events.h"
+#include "door_analytics.h"
+#include "alarm_engine.h"
+#include "upload_priority.h"
+#include "haccp_log.h"
+#include "crash_log.h"
+#include "modbus_scheduler.h"
+#include "controller_discovery.h"
+#include "rs485_bus.h"
+#include "modbus_slave.h"
 #include "logger.h"
 #include "config.h"
 #include "sensors_pt1000.h"
-#include "door_contact.h"
+#include "sensor_calibration.h"
 #include "relay_control.h"
 #include "vbus_external.h"
 #include "watchdog_tpl5010.h"
@@ -13,11 +22,28 @@
 
 extern Logger logger;
 extern ConfigManager config;
+extern DoorEventManager doorEventManager;
 
 #if defined(BOARD_LILYGO_T_SIM7670G_S3)
 extern volatile bool g_carrierHttpBusy;
 #endif
 
+namespace {
+
+// Heartbeat-doc in het slechtste geval: alle deur-records, alarmen, slaves
+// en een discovery-rapport tegelijk. Sensor-keys worden gekopieerd (String).
+constexpr size_t kHeartbeatDocSize =
+    JSON_OBJECT_SIZE(48)                                                  // vaste velden + diagnose-objecten
+    + PT1000_COUNT * (JSON_OBJECT_SIZE(7) + 7 * 32)                       // sensor_<n>_* / <name>_*
+    + JSON_ARRAY_SIZE(DOOR_ANALYTICS_RECORDS) + DOOR_ANALYTICS_RECORDS * JSON_ARRAY_SIZE(7)
+    + JSON_OBJECT_SIZE(ALARM_COUNT)                                       // alarm_since
+    + JSON_ARRAY_SIZE(CONTROLLER_MAX_SLAVES) + CONTROLLER_MAX_SLAVES * JSON_OBJECT_SIZE(10)
+    + JSON_OBJECT_SIZE(6) + JSON_OBJECT_SIZE(3)                           // rs485, crash_log
+    + JSON_OBJECT_SIZE(5) + JSON_ARRAY_SIZE(4) + 4 * JSON_OBJECT_SIZE(6)  // discovery (top-4)
+    + 256;                                                                // mac, ip, ssid, haccp_head
+
+} // namespace
+
 namespace {
 void configureHttpTimeouts(HTTPClient& client) {
 #if defined(BOARD_LILYGO_T_SIM7670G_S3)
@@ -121,7 +147,7 @@ bool APIClient::uploadReading(String jsonData) {
   bool success = (httpCode == 200 || httpCode == 201);
   
   if (success) {
-    logger.debug("Upload successful: " + String(httpCode));
+    LOG_D(LOG_TAG_NET, "Upload successful: %d", httpCode);
   } else {
     const char* errMsg = nullptr;
     if (httpCode == -1) errMsg = "connection refused / DNS failed";
@@ -141,7 +167,7 @@ bool APIClient::uploadReading(String jsonData) {
     }
     String response = http.getString();
     if (response.length() > 0) {
-      logger.debug("Response: " + response);
+      LOG_D(LOG_TAG_NET, "Response: %s", response.c_str());
     }
   }
   
@@ -207,7 +233,7 @@ bool APIClient::apiHandshakeOrHeartbeat(bool connectedToWifi, int rssi, const St
   http.addHeader("x-device-key", apiKey);
   configureHttpTimeouts(http);
   
-  DynamicJsonDocument doc(1024);  // ruimte voor legacy + semantische sensor-velden
+  DynamicJsonDocument doc(kHeartbeatDocSize);
   doc["deviceId"] = WiFi.macAddress();
   doc["firmwareVersion"] = FIRMWARE_VERSION;
   doc["ip"] = ip.length() > 0 ? ip : WiFi.localIP().toString();
@@ -216,40 +242,47 @@ bool APIClient::apiHandshakeOrHeartbeat(bool connectedToWifi, int rssi, const St
   doc["connected_to_wifi"] = connectedToWifi;
   doc["wifi_ssid"] = WiFi.SSID();
   doc["free_heap"] = ESP.getFreeHeap();
+  doc["log_dropped"] = logger.dropped();
   if (batteryPercent >= 0) doc["battery_percent"] = batteryPercent;
   // Altijd doorsturen (ook false), anders ziet de backend bij USB-uit nooit
   // een update en blijft 'Netvoeding (USB)' op 'Geen data' staan.
   doc["on_mains"] = onMains;
+  doc["relay_state"] = getRelayState();
+  doc["ext_power"] = isExternalPowerPresent();
 
-  // Carrier-PCB v1.1 telemetrie
-  // PT1000 #1 = ruimte (koelcel-ambient), PT1000 #2 = verdamper (evaporator).
-  // Zowel index-velden (legacy) als semantische aliassen meegestuurd zodat
+  // Carrier-PCB v1.1 telemetrie: per PT1000-kanaal sensor_<n>_temp/_fault
+  // (legacy index-velden) + <name>_temp/_fault (room_*, evaporator_*), zodat
   // de backend geen migratie nodig heeft om beide te tonen.
-  // Geen SPI tijdens HTTP: sensorTask buffert s_lastTempC; parallel SPI +
-  // WiFi veroorzaakte spinlock-panics op de carrier.
-  float tRoom = getCachedTempC(PT1000_IDX_ROOM);
-  float tEvap = getCachedTempC(PT1000_IDX_EVAPORATOR);
-  if (isnan(tRoom)) {
-    doc["sensor_1_temp"] = (const char*)nullptr;
-    doc["room_temp"]     = (const char*)nullptr;
-  } else {
-    doc["sensor_1_temp"] = tRoom;
-    doc["room_temp"]     = tRoom;
+  // Geen SPI tijdens HTTP: sensorTask buffert de laatste meting; parallel
+  // SPI + WiFi veroorzaakte spinlock-panics op de carrier.
+  writeSensorsHeartbeatJson(doc);
+  doc["cal_version"] = sensorCalVersion();
+  const DoorSnapshot door  = doorEventManager.snapshot();
+  doc["door_open"]         = door.open;
+  doc["door_seq"]          = door.seq;
+  doc["door_open_ms"]      = door.open ? (millis() - door.openedAtMs) : 0;
+  doc["door_queue"]        = doorEventManager.getQueueCount();
+  doc["door_queue_hwm"]    = doorEventManager.highWater();
+  doc["door_dropped_full"] = doorEventManager.droppedFull();
+  doc["door_dropped_rate"] = doorEventManager.droppedRate();
+  const int doorStatsSent  = writeDoorAnalyticsJson(doc);
+  writeAlarmJson(doc);
+  writeUploadPriorityJson(doc);
+  writeModbusSchedulerJson(doc);
+  writeRS485BusJson(doc);
+  writeCrashLogJson(doc);
+  const bool discoverySent = writeControllerDiscoveryJson(doc);
+  writeModbusSlaveJson(doc);
+  const bool haccpAnchored = writeHaccpAnchorJson(doc);
+  const uint32_t haccpSeq = haccpAnchored ? doc["haccp_seq"].as<uint32_t>() : 0;
+  // Basisvelden staan vooraan en halen het altijd; bij overflow vallen enkel
+  // statistieken weg. Wat niet zeker volledig mee was, niet acken (volgende
+  // heartbeat stuurt het opnieuw); door_stats telt zelf de volledige rijen.
+  const bool overflowed = doc.overflowed();
+  if (overflowed) {
+    logger.warn(String("Heartbeat-doc vol (") + doc.memoryUsage() + "/" + doc.capacity() +
+                " B), statistieken afgekapt");
   }
-  if (isnan(tEvap)) {
-    doc["sensor_2_temp"]    = (const char*)nullptr;
-    doc["evaporator_temp"]  = (const char*)nullptr;
-  } else {
-    doc["sensor_2_temp"]    = tEvap;
-    doc["evaporator_temp"]  = tEvap;
-  }
-  doc["sensor_1_fault"]    = getCachedFault(PT1000_IDX_ROOM);
-  doc["sensor_2_fault"]    = getCachedFault(PT1000_IDX_EVAPORATOR);
-  doc["room_fault"]        = doc["sensor_1_fault"];
-  doc["evaporator_fault"]  = doc["sensor_2_fault"];
-  doc["door_open"]         = isDoorOpen();
-  doc["relay_state"]       = getRelayState();
-  doc["ext_power"]         = isExternalPowerPresent();
 
   String jsonData;
   serializeJson(doc, jsonData);
@@ -260,10 +293,26 @@ bool APIClient::apiHandshakeOrHeartbeat(bool connectedToWifi, int rssi, const St
   lastHttpEndMs = millis();
   
   bool success = (httpCode == 200 || httpCode == 201);
+  if (success) {
+    if (!overflowed) {
+      if (discoverySent) controllerDiscoveryAck();
+      modbusSchedulerAck();
+    }
+  }
   
   if (success && responseBody.length() > 0) {
     DynamicJsonDocument respDoc(1024);
     if (!deserializeJson(respDoc, responseBody)) {
+      // door_stats pas wissen als de backend ze opgeslagen heeft (oudere
+      // backends sturen dit veld niet: dan blijven ze staan).
+      if (respDoc.containsKey("door_stats_stored")) doorAnalyticsBackendConfirmed();
+      const int doorStored = respDoc["door_stats_stored"] | 0;
+      doorAnalyticsAck(doorStored < doorStatsSent ? doorStored : doorStatsSent);
+      // HACCP-anchor enkel als de backend precies deze seq bewaard heeft.
+      if (haccpAnchored && !overflowed && respDoc.containsKey("haccp_anchor_stored") &&
+          respDoc["haccp_anchor_stored"].as<uint32_t>() == haccpSeq) {
+        haccpAnchorAck(haccpSeq);
+      }
       JsonArray commands = respDoc["commands"].as<JsonArray>();
       if (!commands.isNull()) {
         for (JsonObject cmd : commands) {
@@ -319,12 +368,58 @@ bool APIClient::apiHandshakeOrHeartbeat(bool connectedToWifi, int rssi, const St
             } else {
               reportRemoteCommandResultLocked(cmdId, "FAILED", "{\"error\":\"missing ssid\"}");
             }
+          } else if (strcmp(cmdType, "LOG_CONFIG") == 0) {
+            // payload: { level: "DEBUG"|"INFO"|"WARN"|"ERROR", tags: "SENSOR,Modbus" | "ALL" }
+            // Runtime (tot reboot). Onder LOG_COMPILE_LEVEL bestaat er niets
+            // meer om aan te zetten.
+            if (!payload.isNull()) {
+              const char* lvl = payload["level"] | "";
+              if (strcasecmp(lvl, "DEBUG") == 0) logger.setLevel(LOG_DEBUG);
+              else if (strcasecmp(lvl, "INFO") == 0) logger.setLevel(LOG_INFO);
+              else if (strcasecmp(lvl, "WARN") == 0) logger.setLevel(LOG_WARN);
+              else if (strcasecmp(lvl, "ERROR") == 0) logger.setLevel(LOG_ERROR);
+              if (payload.containsKey("tags")) logger.setTagMask(logTagMaskFromNames(payload["tags"] | "ALL"));
+            }
+            char result[96];
+            snprintf(result, sizeof(result), "{\"level\":%d,\"tag_mask\":%lu,\"compile_level\":%d}",
+                     (int)logger.getLevel(), (unsigned long)logger.getTagMask(), LOG_COMPILE_LEVEL);
+            reportRemoteCommandResultLocked(cmdId, "EXECUTED", result);
+          } else if (strcmp(cmdType, "LOG_UPLOAD") == 0) {
+            // payload: { which: "previous" (standaard, log vóór de laatste reset) | "current" }
+            const char* which = payload.isNull() ? "previous" : (payload["which"] | "previous");
+            String result;
+            const bool ok = crashLogUploadJson(strcmp(which, "current") != 0, result);
+            reportRemoteCommandResultLocked(cmdId, ok ? "EXECUTED" : "FAILED", result.c_str());
           } else if (strcmp(cmdType, "RELAY_ON") == 0) {
             setRelay(true);
             reportRemoteCommandResultLocked(cmdId, "EXECUTED", "{\"relay_state\":true}");
           } else if (strcmp(cmdType, "RELAY_OFF") == 0) {
             setRelay(false);
             reportRemoteCommandResultLocked(cmdId, "EXECUTED", "{\"relay_state\":false}");
+          } else if (strcmp(cmdType, "SENSOR_CAL") == 0 && !payload.isNull()) {
+            // payload: { channel: 0 | "room", action: "point" | "reset", refC: 0.0 }
+            int channel = -1;
+            if (payload["channel"].is<const char*>()) {
+              const char* name = payload["channel"];
+              for (uint8_t i = 0; i < sensorChannelCount(); i++) {
+                if (strcmp(sensorChannel(i).name, name) == 0) channel = i;
+              }
+            } else {
+              channel = payload["channel"] | -1;
+            }
+            const char* action = payload["action"] | "point";
+            String result;
+            bool ok = false;
+            if (channel < 0 || channel >= (int)sensorChannelCount()) {
+              result = "{\"error\":\"invalid channel\"}";
+            } else if (strcmp(action, "reset") == 0) {
+              ok = resetSensorCalibration((uint8_t)channel, result);
+            } else if (payload["refC"].isNull()) {
+              result = "{\"error\":\"missing refC\"}";
+            } else {
+              ok = captureCalibrationPoint((uint8_t)channel, payload["refC"].as<float>(), result);
+            }
+            reportRemoteCommandResultLocked(cmdId, ok ? "EXECUTED" : "FAILED", result.c_str());
           } else if (strcmp(cmdType, "FIRMWARE_UPDATE") == 0 && !payload.isNull()) {
             const char* url = payload["url"];
             if (url) {
@@ -352,7 +447,7 @@ bool APIClient::apiHandshakeOrHeartbeat(bool connectedToWifi, int rssi, const St
   xSemaphoreGive(httpMutex);
   
   if (success) {
-    logger.debug("Heartbeat OK: " + String(httpCode));
+    LOG_D(LOG_TAG_NET, "Heartbeat OK: %d", httpCode);
   } else {
     const char* errMsg = nullptr;
     if (httpCode == -1) errMsg = "connection refused / DNS failed";
@@ -527,7 +622,7 @@ bool APIClient::completeCommand(const String& commandId, bool success, const Dyn
   
   String url = apiUrl + "/devices/commands/" + commandId + "/complete";
   
-  DynamicJsonDocument doc(512);
+  DynamicJsonDocument doc(result.memoryUsage() + 128);  // result wordt volledig gekopieerd
   doc["result"] = result;
   if (!success) {
     doc["error"] = "Command execution failed";
@@ -0,0 +1,70 @@
+#include "carel_frame.h"
+
+uint8_t carelChecksum(const uint8_t* data, size_t len) {
+  uint8_t crc = 0;
+  for (size_t i = 0; i < len; i++) crc ^= data[i];
+  return crc;
+}
+
+namespace {
+
+size_t header(uint8_t* out, uint8_t addr, uint8_t op, uint8_t type, uint16_t var) {
+  out[0] = CAREL_ENQ;
+  out[1] = addr;
+  out[2] = op;
+  out[3] = type;
+  out[4] = (var >> 8) & 0xFF;
+  out[5] = var & 0xFF;
+  return 6;
+}
+
+} // namespace
+
+size_t carelBuildRead(uint8_t* out, uint8_t addr, uint16_t var) {
+  size_t n = header(out, addr, CAREL_OP_READ, CAREL_TYPE_INTEGER, var);
+  out[n] = carelChecksum(out, n);
+  return n + 1;
+}
+
+size_t carelBuildWriteDigital(uint8_t* out, uint8_t addr, uint16_t var, uint8_t value) {
+  size_t n = header(out, addr, CAREL_OP_WRITE, CAREL_TYPE_DIGITAL, var);
+  out[n++] = value;
+  out[n] = carelChecksum(out, n);
+  return n + 1;
+}
+
+size_t carelBuildWriteInteger(uint8_t* out, uint8_t addr, uint16_t var, int16_t value) {
+  size_t n = header(out, addr, CAREL_OP_WRITE, CAREL_TYPE_INTEGER, var);
+  out[n++] = ((uint16_t)value >> 8) & 0xFF;
+  out[n++] = (uint16_t)value & 0xFF;
+  out[n] = carelChecksum(out, n);
+  return n + 1;
+}
+
+CarelStatus carelParseReadResponse(const uint8_t* frame, size_t len, int16_t* value) {
+  if (len < CAREL_READ_RESPONSE_LEN) return CAREL_ERR_TIMEOUT;
+  if (carelChecksum(frame, 4) != frame[4]) return CAREL_ERR_CRC;
+  if (value) *value = (int16_t)((frame[2] << 8) | frame[3]);
+  return CAREL_OK;
+}
+
+CarelStatus carelParseWriteAck(uint8_t b) {
+  if (b == CAREL_ACK || b == 0x00) return CAREL_OK;  // 0x00: sommige PJEZ-varianten
+  if (b == CAREL_NAK) return CAREL_ERR_NAK;
+  return CAREL_ERR_UNKNOWN;
+}
+
+uint32_t carelCharTimeUs(uint32_t baud) {
+  return baud ? ((uint32_t)CAREL_BITS_PER_CHAR * 1000000UL + baud - 1) / baud : 0;
+}
+
+const char* carelStatusName(CarelStatus st) {
+  switch (st) {
+    case CAREL_OK:          return "ok";
+    case CAREL_ERR_TIMEOUT: return "timeout";
+    case CAREL_ERR_CRC:     return "CRC";
+    case CAREL_ERR_NAK:     return "NAK";
+    case CAREL_ERR_UNKNOWN: return "onbekend antwoord";
+    default:                return "?";
+  }
+}
@@ -0,0 +1,61 @@
+#ifndef CAREL_FRAME_H
+#define CAREL_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Carel PJEZ supervisie-protocol: framing zonder I/O (1200 baud, 8N2).
+ *
+ *   request  : ENQ, adres, 'R'/'W', 'D'/'I', var hi, var lo, [waarde], XOR
+ *   read-antw: 2 kopbytes (niet gecontroleerd, variëren per PJEZ-firmware),
+ *              waarde hi, waarde lo, XOR over de eerste 4
+ *   write-antw: één byte ACK (sommige varianten 0x00) of NAK
+ *
+ * Geen Arduino-afhankelijkheden: CarelProtocol en de host-simulator
+ * (firmware/sim) delen deze codec.
+ */
+
+#define CAREL_ENQ               0x05
+#define CAREL_ACK               0x06
+#define CAREL_NAK               0x15
+#define CAREL_OP_READ           0x52  // 'R'
+#define CAREL_OP_WRITE          0x57  // 'W'
+#define CAREL_TYPE_DIGITAL      0x44  // 'D'
+#define CAREL_TYPE_INTEGER      0x49  // 'I'
+
+#define CAREL_READ_REQUEST_LEN   7
+#define CAREL_WRITE_D_REQUEST_LEN 8
+#define CAREL_WRITE_I_REQUEST_LEN 9
+#define CAREL_READ_RESPONSE_LEN  5
+#define CAREL_MAX_FRAME          9
+
+#define CAREL_BAUD               1200
+#define CAREL_BITS_PER_CHAR      11    // 8N2: start + 8 + 2 stop
+
+enum CarelStatus : uint8_t {
+  CAREL_OK = 0,
+  CAREL_ERR_TIMEOUT,     // geen (volledig) antwoord binnen de timeout
+  CAREL_ERR_CRC,
+  CAREL_ERR_NAK,
+  CAREL_ERR_UNKNOWN,     // onverwacht antwoordbyte op een write
+};
+
+uint8_t carelChecksum(const uint8_t* data, size_t len);
+
+size_t carelBuildRead(uint8_t* out, uint8_t addr, uint16_t var);
+size_t carelBuildWriteDigital(uint8_t* out, uint8_t addr, uint16_t var, uint8_t value);
+size_t carelBuildWriteInteger(uint8_t* out, uint8_t addr, uint16_t var, int16_t value);
+
+/** Read-antwoord valideren; value = int16 (x10 voor temperaturen). */
+CarelStatus carelParseReadResponse(const uint8_t* frame, size_t len, int16_t* value);
+
+/** Eén antwoordbyte op een write. */
+CarelStatus carelParseWriteAck(uint8_t b);
+
+/** µs per karakter (8N2) bij deze baud. */
+uint32_t carelCharTimeUs(uint32_t baud);
+
+const char* carelStatusName(CarelStatus st);
+
+#endif /* CAREL_FRAME_H */
@@ -1,14 +1,14 @@
 #include "carel_protocol.h"
+#include "carel_frame.h"
+#include "rs485_bus.h"
 #include "logger.h"
-#include <HardwareSerial.h>
 
 extern Logger logger;
 
 #define RESPONSE_TIMEOUT_MS 500
-#define CAREL_DEBUG 1  // Zet op 0 om debug uit te zetten
+#define CAREL_DEBUG 0  // Zet op 1 om standaard TX/RX-hexdumps te loggen
 
-static void logHex(const char* prefix, uint8_t* data, int len) {
-#if CAREL_DEBUG
+static void logHex(const char* prefix, const uint8_t* data, int len) {
   String s = String(prefix);
   for (int i = 0; i < len; i++) {
     if (data[i] < 16) s += "0";
@@ -16,177 +16,204 @@ static void logHex(const char* prefix, uint8_t* data, int len) {
     s += " ";
   }
   logger.info(s);
-#endif
 }
 
-CarelProtocol::CarelProtocol() : serial(nullptr), dePin(0), address(1), initialized(false) {}
+static const char* opName(CarelOp op) {
+  switch (op) {
+    case CAREL_REQ_WRITE_D: return "WriteD";
+    case CAREL_REQ_WRITE_I: return "WriteI";
+    default:                return "ReadI";
+  }
+}
+
+CarelProtocol::CarelProtocol() : address(1), initialized(false), debug(CAREL_DEBUG) {}
 
-uint8_t CarelProtocol::carelCRC(uint8_t* data, int len) {
-  uint8_t crc = 0;
-  for (int i = 0; i < len; i++) crc ^= data[i];
-  return crc;
+bool CarelProtocol::init(uint8_t rxPin, uint8_t txPin, uint8_t de) {
+  // Carel: 1200 baud, 8 databits, no parity, 2 stopbits; de bus zet dit per
+  // job. DE-polariteit is die van de transceiver (rs485BusInit), niet van
+  // het protocol.
+  if (!rs485BusInit(rxPin, txPin, de, de)) return false;
+  initialized = true;
+  logger.info("Carel protocol initialized (1200 8N2)");
+  return true;
 }
 
-void CarelProtocol::txMode() {
-  // Sommige RS485-modules: actief-laag (LOW = zenden)
-  digitalWrite(dePin, LOW);
-  delayMicroseconds(100);
+void CarelProtocol::runJob(void* arg) {
+  CarelRequest* req = static_cast<CarelRequest*>(arg);
+  const uint32_t startUs = micros();
+  req->engine->execute(*req);
+  req->busUs = micros() - startUs;
+  // Waiter na de callback: transact() mag req (op zijn stack) pas
+  // vrijgeven als de worker er niets meer mee doet.
+  const TaskHandle_t waiter = req->waiter;
+  if (req->callback) req->callback(*req, req->ctx);
+  if (waiter) xTaskNotifyGive(waiter);
 }
 
-void CarelProtocol::rxMode() {
-  if (serial) {
-    serial->flush();
-  }
-  // 7 bytes @ 1200 baud ≈ 65ms. Wacht tot transmissie volledig weg is (voorkom eigen echo).
-  delay(80);
-  // Sommige RS485-modules: actief-laag (HIGH = ontvangen)
-  digitalWrite(dePin, HIGH);
+bool CarelProtocol::enqueue(CarelRequest* req, RS485Ticket* ticket) {
+  if (!req || !initialized || req->count == 0 || req->count > CAREL_BATCH_MAX) return false;
+  req->engine = this;
+  RS485Job job = {};
+  job.owner = RS485_OWNER_CAREL;
+  job.priority = req->priority;
+  job.run = runJob;
+  job.arg = req;
+  // Per item: stilte (3.5 karakters) + request (max frame) + antwoord-deadline.
+  const uint32_t itemUs = (uint32_t)(CAREL_MAX_FRAME * 2 + 7) * carelCharTimeUs(CAREL_BAUD) / 2;
+  job.boundMs = req->count * (RESPONSE_TIMEOUT_MS + (itemUs + 999) / 1000);
+  return rs485BusSubmit(job, ticket);
 }
 
-void CarelProtocol::flushRx() {
-  if (serial) {
-    while (serial->available()) serial->read();
+bool CarelProtocol::submit(CarelRequest* req) {
+  return enqueue(req, nullptr);
+}
+
+uint8_t CarelProtocol::transact(CarelRequest& req) {
+  req.waiter = xTaskGetCurrentTaskHandle();
+  ulTaskNotifyTake(pdTRUE, 0);  // oude notificatie wissen
+  RS485Ticket ticket;
+  // Begrensd: queue vóór het request + count × (stilte + TX + RESPONSE_TIMEOUT_MS).
+  if (!enqueue(&req, &ticket) || !rs485BusAwait(ticket)) {
+    req.okCount = 0;
+    for (uint8_t i = 0; i < req.count && i < CAREL_BATCH_MAX; i++) req.items[i].status = CAREL_ERR_TIMEOUT;
+    return 0;
   }
+  return req.okCount;
 }
 
-bool CarelProtocol::init(uint8_t rxPin, uint8_t txPin, uint8_t de) {
-  dePin = de;
-  pinMode(dePin, OUTPUT);
-  digitalWrite(dePin, HIGH);  // Start in ontvangstmodus (actief-laag module)
+void CarelProtocol::execute(CarelRequest& req) {
+  const uint8_t addr = req.addr ? req.addr : address;
+  // Eén bus-venster: lijn één keer omschakelen, dan de items back-to-back.
+  rs485BusUseLine(CAREL_BAUD, SERIAL_8N2);
+  const uint32_t gapUs = carelCharTimeUs(CAREL_BAUD) * 7 / 2;
+  req.okCount = 0;
+  bool silent = false;
 
-  serial = &Serial2;
-  // Carel: 1200 baud, 8 databits, no parity, 2 stopbits
-  serial->begin(1200, SERIAL_8N2, rxPin, txPin);
-  initialized = true;
-  logger.info("Carel protocol initialized (1200 8N2)");
-  return true;
-}
+  for (uint8_t i = 0; i < req.count; i++) {
+    CarelItem& item = req.items[i];
+    // Geen enkel byte op het vorige item: regelaar weg of bekabeling. De rest
+    // niet meer proberen, anders houdt de batch de bus count × 500 ms bezet.
+    if (silent) {
+      item.status = CAREL_ERR_TIMEOUT;
+      continue;
+    }
+    uint8_t msg[CAREL_MAX_FRAME];
+    size_t len;
+    size_t expect;
+    switch (item.op) {
+      case CAREL_REQ_WRITE_D:
+        len = carelBuildWriteDigital(msg, addr, item.var, (uint8_t)item.value);
+        expect = 1;
+        break;
+      case CAREL_REQ_WRITE_I:
+        len = carelBuildWriteInteger(msg, addr, item.var, item.value);
+        expect = 1;
+        break;
+      default:
+        len = carelBuildRead(msg, addr, item.var);
+        expect = CAREL_READ_RESPONSE_LEN;
+        break;
+    }
+    if (debug) logHex((String("Carel TX (") + opName(item.op) + " var " + item.var + "): ").c_str(), msg, len);
 
-bool CarelProtocol::writeDigital(int varIndex, uint8_t value) {
-  if (!serial || !initialized) return false;
-  uint8_t msg[8];
-  msg[0] = 0x05;
-  msg[1] = address;
-  msg[2] = 0x57;  // 'W'
-  msg[3] = 0x44;  // 'D'
-  msg[4] = (varIndex >> 8) & 0xFF;
-  msg[5] = varIndex & 0xFF;
-  msg[6] = value;
-  msg[7] = carelCRC(msg, 7);
-
-  logger.info("Carel TX (WriteD var " + String(varIndex) + "):");
-  logHex("  ", msg, 8);
-  flushRx();
-  txMode();
-  serial->write(msg, 8);
-  serial->flush();
-  rxMode();
-
-  unsigned long t = millis();
-  while (millis() - t < RESPONSE_TIMEOUT_MS) {
-    if (serial->available()) {
-      uint8_t r = serial->read();
-      if (r == 0x06) {
-        logger.info("Carel RX: ACK (OK)");
-        return true;
-      }
-      if (r == 0x00) {
-        logger.info("Carel RX: 0x00 (OK, sommige PJEZ-varianten)");
-        return true;
-      }
-      if (r == 0x15) {
-        logger.warn("Carel RX: NAK (fout)");
-        return false;
+    // Stilte t.o.v. vorig busverkeer (bv. Modbus) en, binnen de batch, het
+    // vorige antwoord: de receive keert terug zodra dat volledig is, zonder
+    // de RX-timeout af te wachten.
+    rs485BusWaitIdle(gapUs);
+    // flush() in de bus wacht tot het laatste stopbit buiten is; DE gaat
+    // meteen los. Het oude vaste delay(80) miste snelle PJEZ-antwoorden.
+    rs485BusTransmit(msg, len);
+
+    uint8_t rx[CAREL_MAX_FRAME];
+    size_t n = 0;
+    item.status = CAREL_ERR_TIMEOUT;
+    const uint32_t deadline = millis() + RESPONSE_TIMEOUT_MS;
+    while (n < sizeof(rx)) {
+      const int32_t remaining = (int32_t)(deadline - millis());
+      if (remaining <= 0) break;
+      const size_t got = rs485BusReceive(rx + n, sizeof(rx) - n, expect, (uint32_t)remaining, false);
+      if (got == 0) break;
+      n += got;
+      if (expect != 1) break;
+      // Write: onbekende bytes overslaan tot ACK/NAK (of deadline).
+      const CarelStatus st = carelParseWriteAck(rx[n - 1]);
+      if (st == CAREL_OK || st == CAREL_ERR_NAK) {
+        item.status = st;
+        break;
       }
-      logger.info("Carel RX: onbekend byte 0x" + String(r, HEX));
+      item.status = CAREL_ERR_UNKNOWN;
     }
-  }
-  logger.warn("Carel RX: TIMEOUT - geen antwoord (check A/B bekabeling)");
-  return false;
-}
+    if (debug && n > 0) logHex("Carel RX: ", rx, n);
 
-bool CarelProtocol::writeInteger(int varIndex, int value) {
-  if (!serial || !initialized) return false;
-  uint8_t msg[9];
-  msg[0] = 0x05;
-  msg[1] = address;
-  msg[2] = 0x57;
-  msg[3] = 0x49;  // 'I'
-  msg[4] = (varIndex >> 8) & 0xFF;
-  msg[5] = varIndex & 0xFF;
-  msg[6] = (value >> 8) & 0xFF;
-  msg[7] = value & 0xFF;
-  msg[8] = carelCRC(msg, 8);
-
-  logger.info("Carel TX (WriteI var " + String(varIndex) + "=" + String(value) + "):");
-  logHex("  ", msg, 9);
-  flushRx();
-  txMode();
-  serial->write(msg, 9);
-  serial->flush();
-  rxMode();
-
-  unsigned long t = millis();
-  while (millis() - t < RESPONSE_TIMEOUT_MS) {
-    if (serial->available()) {
-      uint8_t r = serial->read();
-      if (r == 0x06) {
-        logger.info("Carel RX: ACK (OK)");
-        return true;
-      }
-      if (r == 0x00) {
-        logger.info("Carel RX: 0x00 (OK, sommige PJEZ-varianten)");
-        return true;
-      }
-      if (r == 0x15) {
-        logger.warn("Carel RX: NAK (fout)");
-        return false;
+    if (expect != 1) {
+      int16_t raw = 0;
+      if (n >= CAREL_READ_RESPONSE_LEN) {
+        item.status = carelParseReadResponse(rx, n, &raw);
+        if (item.status == CAREL_OK) item.value = raw;
       }
-      logger.info("Carel RX: onbekend byte 0x" + String(r, HEX));
     }
+    if (item.status == CAREL_OK) req.okCount++;
+    silent = n == 0;
   }
-  logger.warn("Carel RX: TIMEOUT - geen antwoord (check A/B bekabeling)");
-  return false;
 }
 
-int CarelProtocol::readInteger(int varIndex) {
-  if (!serial || !initialized) return INT_MIN;
-  uint8_t msg[7];
-  msg[0] = 0x05;
-  msg[1] = address;
-  msg[2] = 0x52;  // 'R'
-  msg[3] = 0x49;  // 'I'
-  msg[4] = (varIndex >> 8) & 0xFF;
-  msg[5] = varIndex & 0xFF;
-  msg[6] = carelCRC(msg, 6);
-
-  logger.info("Carel TX (ReadI var " + String(varIndex) + "):");
-  logHex("  ", msg, 7);
-  flushRx();
-  txMode();
-  serial->write(msg, 7);
-  serial->flush();
-  rxMode();
-
-  uint8_t response[5];
-  int received = 0;
-  unsigned long t = millis();
-  while (millis() - t < RESPONSE_TIMEOUT_MS && received < 5) {
-    if (serial->available()) {
-      response[received++] = serial->read();
+void CarelProtocol::logResult(const CarelRequest& req) const {
+  for (uint8_t i = 0; i < req.count; i++) {
+    const CarelItem& item = req.items[i];
+    if (item.status == CAREL_OK) {
+      if (debug) logger.info("Carel: " + String(opName(item.op)) + " var " + String(item.var) + " = " + String(item.value));
+      continue;
     }
+    logger.warn("Carel " + String(opName(item.op)) + " var " + String(item.var) + ": " + carelStatusName(item.status) +
+                (item.status == CAREL_ERR_TIMEOUT ? " (check A/B bekabeling)" : ""));
+  }
+  if (debug) {
+    logger.info("Carel: " + String(req.okCount) + "/" + String(req.count) + " OK in " + String(req.busUs / 1000) + " ms");
   }
-  if (received < 5) {
-    logger.warn("Carel RX: TIMEOUT - " + String(received) + " bytes (verwacht 5). Check A/B bekabeling.");
-    return INT_MIN;
+}
+
+bool CarelProtocol::writeOne(CarelOp op, int varIndex, int value) {
+  if (!initialized) return false;
+  CarelRequest req = {};
+  req.count = 1;
+  req.priority = true;
+  req.items[0].op = op;
+  req.items[0].var = (uint16_t)varIndex;
+  req.items[0].value = (int16_t)value;
+  const bool ok = transact(req) == 1;
+  logResult(req);
+  return ok;
+}
+
+bool CarelProtocol::writeDigital(int varIndex, uint8_t value) {
+  return writeOne(CAREL_REQ_WRITE_D, varIndex, value);
+}
+
+bool CarelProtocol::writeInteger(int varIndex, int value) {
+  return writeOne(CAREL_REQ_WRITE_I, varIndex, value);
+}
+
+uint8_t CarelProtocol::readIntegers(const uint16_t* vars, int* out, uint8_t count) {
+  if (!initialized || !vars || !out || count == 0 || count > CAREL_BATCH_MAX) return 0;
+  CarelRequest req = {};
+  req.count = count;
+  req.priority = true;
+  for (uint8_t i = 0; i < count; i++) {
+    req.items[i].op = CAREL_REQ_READ_I;
+    req.items[i].var = vars[i];
   }
-  logHex("Carel RX: ", response, 5);
-  if (carelCRC(response, 4) != response[4]) {
-    logger.warn("Carel RX: CRC fout");
-    return INT_MIN;
+  const uint8_t ok = transact(req);
+  for (uint8_t i = 0; i < count; i++) {
+    out[i] = req.items[i].status == CAREL_OK ? (int)req.items[i].value : INT_MIN;
   }
-  int val = (int16_t)((response[2] << 8) | response[3]);
-  logger.info("Carel: var " + String(varIndex) + " = " + String(val));
+  logResult(req);
+  return ok;
+}
+
+int CarelProtocol::readInteger(int varIndex) {
+  const uint16_t var = (uint16_t)varIndex;
+  int val = INT_MIN;
+  readIntegers(&var, &val, 1);
   return val;
 }
 
@@ -205,10 +232,14 @@ bool CarelProtocol::stopDefrost() {
 }
 
 bool CarelProtocol::readDefrostParams(int& type, int& interval, int& duration) {
-  type = readInteger(CAREL_DEFROST_TYPE);
-  interval = readInteger(CAREL_DEFROST_INTV);
-  duration = readInteger(CAREL_DEFROST_DUR);
-  return type != INT_MIN && interval != INT_MIN && duration != INT_MIN;
+  // Eén batch = één bus-venster i.p.v. drie losse round-trips.
+  static const uint16_t kVars[3] = { CAREL_DEFROST_TYPE, CAREL_DEFROST_INTV, CAREL_DEFROST_DUR };
+  int v[3];
+  const bool ok = readIntegers(kVars, v, 3) == 3;
+  type = v[0];
+  interval = v[1];
+  duration = v[2];
+  return ok;
 }
 
 bool CarelProtocol::setDefrostInterval(int hours) {
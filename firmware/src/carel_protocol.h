@@ -2,10 +2,16 @@
 #define CAREL_PROTOCOL_H
 
 #include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "carel_frame.h"
+#include "rs485_bus.h"
 
 // Carel PJEZ Easy Cool – supervisie protocol
 // 1200 baud, 8N2, half-duplex
-// Pins: RX=16, TX=17, DE=4 (zelfde als Modbus)
+// Pins: RX=16, TX=17, DE=4 (zelfde als Modbus). Elke request is een job op de
+// gedeelde RS485-bus (rs485_bus): Modbus-polls op hetzelfde segment lopen
+// ertussen, de bus schakelt per job naar 1200 8N2 en terug.
 
 #define CAREL_DEFROST_CMD   33   // Digital: 1=start, 0=stop
 #define CAREL_TEMPERATURE    1   // Integer: x10 (235 = 23.5°C)
@@ -13,11 +19,61 @@
 #define CAREL_DEFROST_INTV   5   // Integer: interval (uur)
 #define CAREL_DEFROST_DUR    6   // Integer: max duur (min)
 
+// Transactie-engine: een request bundelt tot CAREL_BATCH_MAX variabelen.
+// PJEZ kent geen multi-read frame; de bus-worker werkt ze af in één
+// bus-venster (lijn één keer naar 1200 8N2, frames back-to-back met enkel
+// de stilte tussen frames). DE gaat los zodra de UART TX-complete meldt.
+#define CAREL_BATCH_MAX     8
+
+enum CarelOp : uint8_t {
+  CAREL_REQ_READ_I = 0,
+  CAREL_REQ_WRITE_D,
+  CAREL_REQ_WRITE_I,
+};
+
+struct CarelItem {
+  CarelOp     op;
+  uint16_t    var;
+  int16_t     value;    // write: waarde; read: resultaat
+  CarelStatus status;
+};
+
+struct CarelRequest;
+class CarelProtocol;
+typedef void (*CarelCallback)(CarelRequest& req, void* ctx);
+
+struct CarelRequest {
+  uint8_t   addr;       // 0 = setAddress()
+  uint8_t   count;
+  CarelItem items[CAREL_BATCH_MAX];
+  bool      priority;   // app-commando: vooraan in de bus-queue
+
+  // Resultaat (gezet door de worker vóór callback/notify)
+  uint8_t   okCount;
+  uint32_t  busUs;      // bezetting van het bus-venster
+
+  // Afhandeling: callback (async, vanuit de bus-worker) en/of wachtende taak.
+  CarelCallback callback;
+  void*     ctx;
+  TaskHandle_t waiter;
+  CarelProtocol* engine;  // intern (submit)
+};
+
 class CarelProtocol {
 public:
   CarelProtocol();
+  /** Sluit aan op de gedeelde bus (zelfde pins als de bus al gebruikt, anders false). */
   bool init(uint8_t rxPin, uint8_t txPin, uint8_t dePin);
   void setAddress(uint8_t addr) { address = addr; }
+  /** TX/RX-hexdumps en per-item resultaat loggen (standaard CAREL_DEBUG). */
+  void setDebug(bool enable) { debug = enable; }
+
+  // Transactie-API, zoals RS485Modbus: submit() async (req moet blijven
+  // bestaan tot de callback liep), transact() blokkeert zonder CPU, hooguit
+  // de queue vóór het request + zijn eigen bovengrens (anders alle items
+  // CAREL_ERR_TIMEOUT). Returnt het aantal geslaagde items.
+  bool submit(CarelRequest* req);
+  uint8_t transact(CarelRequest& req);
 
   // Defrost
   bool startDefrost();
@@ -26,6 +82,8 @@ public:
   // Read
   int readInteger(int varIndex);   // Returns INT_MIN on error
   float readTemperature();         // Returns NAN on error
+  /** Batch: out[i] = waarde of INT_MIN. Returnt het aantal geslaagde reads. */
+  uint8_t readIntegers(const uint16_t* vars, int* out, uint8_t count);
 
   // Write
   bool writeDigital(int varIndex, uint8_t value);
@@ -38,15 +96,15 @@ public:
   bool setDefrostType(int type);
 
 private:
-  HardwareSerial* serial;
-  uint8_t dePin;
   uint8_t address;
   bool initialized;
+  bool debug;
 
-  uint8_t carelCRC(uint8_t* data, int len);
-  void txMode();
-  void rxMode();
-  void flushRx();
+  static void runJob(void* arg);  // bus-worker: batch + callback/notify
+  bool enqueue(CarelRequest* req, RS485Ticket* ticket);
+  void execute(CarelRequest& req);
+  bool writeOne(CarelOp op, int varIndex, int value);
+  void logResult(const CarelRequest& req) const;
 };
 
 #endif
@@ -1,9 +1,12 @@
 #include "config.h"
 #include "board_pins.h"
+#include "rs485_modbus.h"
+#include <esp_rom_crc.h>
 
 ConfigManager::ConfigManager() : loaded(false) {
   // Don't open preferences here - open when needed in load/save
   // This prevents issues with Preferences being opened too early
+  setDefaults();
 }
 
 ConfigManager::~ConfigManager() {
@@ -12,335 +15,314 @@ ConfigManager::~ConfigManager() {
 }
 
 void ConfigManager::setDefaults() {
-  configDoc["deviceSerial"] = DEFAULT_DEVICE_SERIAL;
-  configDoc["readingInterval"] = DEFAULT_READING_INTERVAL;
-  configDoc["uploadInterval"] = DEFAULT_UPLOAD_INTERVAL;
-  configDoc["apiUrl"] = DEFAULT_API_URL;
-  configDoc["apiKey"] = DEFAULT_API_KEY;
-  configDoc["modbusEnabled"] = DEFAULT_MODBUS_ENABLED;
-  configDoc["carelProtocolEnabled"] = DEFAULT_CAREL_PROTOCOL_ENABLED;
-  configDoc["modbusInterval"] = DEFAULT_MODBUS_INTERVAL;
-  configDoc["deepSleepEnabled"] = DEFAULT_DEEP_SLEEP_ENABLED;
-  configDoc["deepSleepDuration"] = DEFAULT_DEEP_SLEEP_DURATION;
-  configDoc["otaPassword"] = DEFAULT_OTA_PASSWORD;
+  // Volledig nullen: ook padding, zodat de CRC over de blob deterministisch is.
+  memset(&data, 0, sizeof(data));
+  strlcpy(data.deviceSerial, DEFAULT_DEVICE_SERIAL, sizeof(data.deviceSerial));
+  strlcpy(data.apiUrl, DEFAULT_API_URL, sizeof(data.apiUrl));
+  strlcpy(data.apiKey, DEFAULT_API_KEY, sizeof(data.apiKey));
+  strlcpy(data.otaPassword, DEFAULT_OTA_PASSWORD, sizeof(data.otaPassword));
+  data.readingInterval = DEFAULT_READING_INTERVAL;
+  data.uploadInterval = DEFAULT_UPLOAD_INTERVAL;
+  data.modbusInterval = DEFAULT_MODBUS_INTERVAL;
+  data.deepSleepDuration = DEFAULT_DEEP_SLEEP_DURATION;
+  data.modbusEnabled = DEFAULT_MODBUS_ENABLED;
+  data.carelProtocolEnabled = DEFAULT_CAREL_PROTOCOL_ENABLED;
+  data.deepSleepEnabled = DEFAULT_DEEP_SLEEP_ENABLED;
+  data.modbusSlaveMode = false;
   
   // SPI defaults (MAX31865 – pins volgens board_pins.h)
-  configDoc["spi"]["csPin"] = BOARD_MAX31865_CS;
-  configDoc["spi"]["rtdNominal"] = 1000;  // PT1000
-  configDoc["spi"]["refResistor"] = 4300;
-  configDoc["spi"]["wires"] = 4;
+  data.spi.csPin = BOARD_MAX31865_CS;
+  data.spi.rtdNominal = 1000;  // PT1000
+  data.spi.refResistor = 4300;
+  data.spi.wires = 4;
   
   // Modbus/RS485 defaults
-  configDoc["modbus"]["rxPin"] = BOARD_RS485_RX;
-  configDoc["modbus"]["txPin"] = BOARD_RS485_TX;
-  configDoc["modbus"]["dePin"] = BOARD_RS485_DE;
-  configDoc["modbus"]["rePin"] = BOARD_RS485_DE;
-  configDoc["modbus"]["baudRate"] = 9600;
-  configDoc["modbus"]["slaveId"] = 1;
-  configDoc["modbus"]["writeEnabled"] = true;  // Ontdooiing vereist schrijven
+  data.modbus.rxPin = BOARD_RS485_RX;
+  data.modbus.txPin = BOARD_RS485_TX;
+  data.modbus.dePin = BOARD_RS485_DE;
+  data.modbus.rePin = BOARD_RS485_DE;
+  data.modbus.baudRate = 9600;
+  data.modbus.serialConfig = rs485FramingFromName("8N1");
+  data.modbus.slaveId = 1;
+  data.modbus.writeEnabled = true;  // Ontdooiing vereist schrijven
+  data.slaveCount = 0;
 }
 
 bool ConfigManager::load() {
+  setDefaults();
+
   // Ensure preferences namespace is open
   if (!preferences.begin(CONFIG_NAMESPACE, false)) {
     Serial.println("ERROR: Failed to open preferences namespace!");
     return false;
   }
-  
-  // Try getString first (simpler and more reliable)
-  String configJson = preferences.getString(CONFIG_KEY, "");
-  
-  if (configJson.length() == 0) {
-    // Try getBytes as fallback
-    size_t len = preferences.getBytesLength(CONFIG_KEY);
-    if (len > 0 && len < 2000) {
-      char* buffer = (char*)malloc(len + 1);
-      if (buffer) {
-        size_t readLen = preferences.getBytes(CONFIG_KEY, (uint8_t*)buffer, len);
-        buffer[readLen] = '\0';
-        configJson = String(buffer);
-        free(buffer);
-      }
-    }
+
+  const uint32_t startUs = micros();
+  bool migrated = false;
+  loaded = loadBlob();
+  if (!loaded) {
+    migrated = migrateLegacyJson();
+    loaded = migrated;
   }
-  
-  if (configJson.length() == 0) {
+  const uint32_t tookUs = micros() - startUs;
+
+  // Sluit NVS meteen; save() opent opnieuw. Twee open Preferences-sessies
+  // tegelijk (coldmonitor + databuffer) gaven op ESP32-S3 TLSF heap-asserts.
+  preferences.end();
+
+  if (!loaded) {
     Serial.println("Config: No saved configuration found");
-    preferences.end();
     return false;
   }
-  
-  Serial.println("Config: Loading from NVS, length: " + String(configJson.length()));
-  Serial.println("Config JSON preview: " + configJson.substring(0, min(150, (int)configJson.length())));
-  
-  DeserializationError error = deserializeJson(configDoc, configJson);
+  Serial.printf("Config: %s in %lu us\n", migrated ? "migrated from legacy JSON" : "loaded from blob",
+                (unsigned long)tookUs);
+  Serial.println("Loaded API URL: " + getAPIUrl());
+  Serial.println("Loaded API Key: " + (strlen(data.apiKey) > 0 ? String(data.apiKey).substring(0, 8) + "..." : String("(leeg)")));
+  if (migrated && !save()) {
+    Serial.println("WARNING: Config blob not written; legacy JSON is used again next boot");
+  }
+  return true;
+}
+
+bool ConfigManager::loadBlob() {
+  const size_t len = preferences.getBytesLength(CONFIG_BLOB_KEY);
+  if (len < sizeof(ConfigBlobHeader) || len > 4096) return false;
+
+  // Eerst in een scratch-buffer valideren: een corrupte blob mag de defaults
+  // niet overschrijven. Een nieuwere (langere) blob levert zijn prefix.
+  uint8_t* buf = (uint8_t*)malloc(len);
+  if (!buf) return false;
+  bool ok = preferences.getBytes(CONFIG_BLOB_KEY, buf, len) == len;
+  ConfigBlobHeader hdr;
+  memcpy(&hdr, buf, sizeof(hdr));
+  ok = ok && hdr.magic == CONFIG_BLOB_MAGIC && hdr.size == len;
+  if (ok && esp_rom_crc32_le(0, buf + sizeof(hdr), len - sizeof(hdr)) != hdr.crc) {
+    Serial.println("Config: blob CRC mismatch");
+    ok = false;
+  }
+  if (ok) {
+    memcpy(&data, buf, len < sizeof(data) ? len : sizeof(data));
+    if (hdr.version != CONFIG_BLOB_VERSION) {
+      Serial.printf("Config: blob v%u (firmware v%u)\n", (unsigned)hdr.version, (unsigned)CONFIG_BLOB_VERSION);
+    }
+    // Strings altijd afgesloten, ook bij een blob van een vreemde versie.
+    data.deviceSerial[sizeof(data.deviceSerial) - 1] = '\0';
+    data.apiUrl[sizeof(data.apiUrl) - 1] = '\0';
+    data.apiKey[sizeof(data.apiKey) - 1] = '\0';
+    data.otaPassword[sizeof(data.otaPassword) - 1] = '\0';
+    if (data.slaveCount > CONFIG_MODBUS_SLAVES_MAX) data.slaveCount = CONFIG_MODBUS_SLAVES_MAX;
+  }
+  free(buf);
+  return ok;
+}
+
+bool ConfigManager::migrateLegacyJson() {
+  String configJson = preferences.getString(CONFIG_KEY, "");
+  if (configJson.length() == 0) return false;
+
+  Serial.println("Config: Migrating legacy JSON, length: " + String(configJson.length()));
+  DynamicJsonDocument doc(CONFIG_JSON_SIZE);
+  DeserializationError error = deserializeJson(doc, configJson);
   if (error) {
     Serial.println("Config: JSON parse error: " + String(error.c_str()));
-    Serial.println("Config JSON: " + configJson);
-    preferences.end();
     return false;
   }
-  
-  loaded = true;
-  Serial.println("Config: Successfully loaded from NVS");
-  
-  // Log loaded values for debugging
-  String apiUrl = configDoc["apiUrl"] | DEFAULT_API_URL;
-  String apiKey = configDoc["apiKey"] | DEFAULT_API_KEY;
-  Serial.println("Loaded API URL: " + apiUrl);
-  Serial.println("Loaded API Key: " + (apiKey.length() > 0 ? String(apiKey.substring(0, 8)) + "..." : "(leeg)"));
-  
-  // Sluit NVS zodra JSON in configDoc staat; save() opent opnieuw. Twee open Preferences-
-  // sessies tegelijk (coldmonitor + databuffer) gaven op ESP32-S3 TLSF heap-asserts.
-  preferences.end();
+  applyJson(doc);
+  return true;
+}
+
+// Legacy JSON-formaat over de huidige waarden leggen (ontbrekende keys
+// behouden hun waarde). Gebruikt door migratie en fromJSON().
+void ConfigManager::applyJson(JsonDocument& doc) {
+  const char* str = doc["deviceSerial"];
+  if (str && *str) strlcpy(data.deviceSerial, str, sizeof(data.deviceSerial));
+  str = doc["apiUrl"];
+  if (str && *str) copyString(data.apiUrl, sizeof(data.apiUrl), String(str), "API URL");
+  str = doc["apiKey"];
+  if (str) copyString(data.apiKey, sizeof(data.apiKey), String(str), "API Key");
+  str = doc["otaPassword"];
+  if (str) strlcpy(data.otaPassword, str, sizeof(data.otaPassword));
+
+  data.readingInterval = doc["readingInterval"] | data.readingInterval;
+  data.uploadInterval = doc["uploadInterval"] | data.uploadInterval;
+  data.modbusInterval = doc["modbusInterval"] | data.modbusInterval;
+  data.deepSleepDuration = doc["deepSleepDuration"] | data.deepSleepDuration;
+  data.modbusEnabled = doc["modbusEnabled"] | data.modbusEnabled;
+  data.carelProtocolEnabled = doc["carelProtocolEnabled"] | data.carelProtocolEnabled;
+  data.deepSleepEnabled = doc["deepSleepEnabled"] | data.deepSleepEnabled;
+
+  JsonObject spi = doc["spi"];
+  data.spi.csPin = spi["csPin"] | data.spi.csPin;
+  data.spi.rtdNominal = spi["rtdNominal"] | data.spi.rtdNominal;
+  data.spi.refResistor = spi["refResistor"] | data.spi.refResistor;
+  data.spi.wires = spi["wires"] | data.spi.wires;
+
+  JsonObject modbus = doc["modbus"];
+  data.modbus.rxPin = modbus["rxPin"] | data.modbus.rxPin;
+  data.modbus.txPin = modbus["txPin"] | data.modbus.txPin;
+  data.modbus.dePin = modbus["dePin"] | data.modbus.dePin;
+  data.modbus.rePin = modbus["rePin"] | data.modbus.rePin;
+  data.modbus.baudRate = modbus["baudRate"] | data.modbus.baudRate;
+  str = modbus["framing"];
+  if (str) data.modbus.serialConfig = rs485FramingFromName(str);
+  data.modbus.slaveId = modbus["slaveId"] | data.modbus.slaveId;
+  data.modbus.writeEnabled = modbus["writeEnabled"] | data.modbus.writeEnabled;
+  str = modbus["mode"];
+  if (str) data.modbusSlaveMode = strcmp(str, "slave") == 0;
+
+  JsonArray slaves = modbus["slaves"].as<JsonArray>();
+  if (!slaves.isNull()) {
+    data.slaveCount = 0;
+    for (JsonObject s : slaves) {
+      if (data.slaveCount >= CONFIG_MODBUS_SLAVES_MAX) break;
+      const int addr = s["addr"] | 0;
+      if (addr < 1 || addr > 247) continue;
+      ModbusSlaveConfig& c = data.slaves[data.slaveCount++];
+      c.addr = (uint8_t)addr;
+      strlcpy(c.type, s["type"] | "", sizeof(c.type));
+      c.pollS = s["pollS"] | 0;
+      c.timeoutMs = s["timeoutMs"] | 0;
+    }
+  }
+}
+
+bool ConfigManager::copyString(char* dst, size_t cap, const String& value, const char* what) {
+  if (value.length() >= cap) {
+    Serial.printf("ERROR: %s too long (%u > %u)\n", what, (unsigned)value.length(), (unsigned)(cap - 1));
+    return false;
+  }
+  strlcpy(dst, value.c_str(), cap);
   return true;
 }
 
 bool ConfigManager::save() {
   // Close any existing preferences session
   preferences.end();
-  delay(10);
   
   // Open preferences namespace in read-write mode
   if (!preferences.begin(CONFIG_NAMESPACE, false)) {
     Serial.println("ERROR: Failed to open preferences namespace for save!");
     return false;
   }
-  
-  String configJson;
-  serializeJson(configDoc, configJson);
-  
-  if (configJson.length() == 0) {
-    Serial.println("ERROR: Config JSON is empty!");
-    preferences.end();
-    return false;
-  }
-  
-  if (configJson.length() > 2000) {
-    Serial.println("ERROR: Config JSON too large: " + String(configJson.length()));
-    preferences.end();
-    return false;
-  }
-  
-  Serial.println("Config: Saving to NVS, length: " + String(configJson.length()));
-  Serial.println("Free heap before save: " + String(ESP.getFreeHeap()));
-  
-  // Use putString (most reliable method for ESP32 Preferences)
-  size_t written = preferences.putString(CONFIG_KEY, configJson);
-  
-  if (written == 0) {
-    Serial.println("ERROR: putString returned 0 - trying alternative method...");
-    // Try removing old key first
-    preferences.remove(CONFIG_KEY);
-    delay(10);
-    written = preferences.putString(CONFIG_KEY, configJson);
-  }
-  
-  if (written > 0) {
-    Serial.println("Config: Successfully saved " + String(written) + " bytes to NVS");
-    
-    // Close and reopen to force commit
-    preferences.end();
-    delay(50); // Give flash time to write
-    
-    // Reopen and verify
-    if (preferences.begin(CONFIG_NAMESPACE, false)) {
-      String verifyJson = preferences.getString(CONFIG_KEY, "");
-      if (verifyJson.length() > 0) {
-        Serial.println("Config: Verification OK - " + String(verifyJson.length()) + " bytes read back");
-        if (verifyJson == configJson) {
-          Serial.println("Config: Content verification OK!");
-        } else {
-          Serial.println("WARNING: Content differs but data was saved");
-        }
-        preferences.end();
-        return true;
-      } else {
-        Serial.println("WARNING: Saved but could not verify (empty read)");
-        preferences.end();
-        return true; // Assume success
-      }
-    } else {
-      Serial.println("WARNING: Could not reopen for verification, but save returned success");
-      return true;
-    }
+
+  data.hdr.magic = CONFIG_BLOB_MAGIC;
+  data.hdr.version = CONFIG_BLOB_VERSION;
+  data.hdr.size = sizeof(ConfigData);
+  data.hdr.crc = esp_rom_crc32_le(0, (const uint8_t*)&data + sizeof(ConfigBlobHeader),
+                                  sizeof(ConfigData) - sizeof(ConfigBlobHeader));
+
+  // putBytes commit meteen (nvs_commit); lengte teruglezen volstaat als check.
+  const size_t written = preferences.putBytes(CONFIG_BLOB_KEY, &data, sizeof(data));
+  const bool ok = written == sizeof(data) && preferences.getBytesLength(CONFIG_BLOB_KEY) == sizeof(data);
+  preferences.end();
+
+  if (ok) {
+    Serial.println("Config: Saved " + String(written) + " bytes to NVS");
   } else {
     Serial.println("ERROR: Failed to save config to NVS!");
     Serial.println("  Free heap: " + String(ESP.getFreeHeap()));
-    Serial.println("  Config length: " + String(configJson.length()));
-    preferences.end();
-    return false;
   }
+  return ok;
 }
 
 void ConfigManager::reset() {
-  preferences.remove(CONFIG_KEY);
+  if (preferences.begin(CONFIG_NAMESPACE, false)) {
+    preferences.remove(CONFIG_BLOB_KEY);
+    preferences.remove(CONFIG_KEY);
+    preferences.end();
+  }
   setDefaults();
   save();
 }
 
-String ConfigManager::getDeviceSerial() {
-  return configDoc["deviceSerial"] | DEFAULT_DEVICE_SERIAL;
-}
-
 void ConfigManager::setDeviceSerial(String serial) {
-  configDoc["deviceSerial"] = serial;
-}
-
-unsigned long ConfigManager::getReadingInterval() {
-  return configDoc["readingInterval"] | DEFAULT_READING_INTERVAL;
-}
-
-void ConfigManager::setReadingInterval(unsigned long interval) {
-  configDoc["readingInterval"] = interval;
-}
-
-unsigned long ConfigManager::getUploadInterval() {
-  return configDoc["uploadInterval"] | DEFAULT_UPLOAD_INTERVAL;
-}
-
-void ConfigManager::setUploadInterval(unsigned long interval) {
-  configDoc["uploadInterval"] = interval;
+  copyString(data.deviceSerial, sizeof(data.deviceSerial), serial, "Device serial");
 }
 
 String ConfigManager::getAPIUrl() {
-  if (configDoc.containsKey("apiUrl")) {
-    String url = configDoc["apiUrl"].as<String>();
-    if (url.length() > 0 && url != DEFAULT_API_URL) {
-      return url;
-    }
-  }
-  return DEFAULT_API_URL;
+  return data.apiUrl[0] ? String(data.apiUrl) : String(DEFAULT_API_URL);
 }
 
 void ConfigManager::setAPIUrl(String url) {
   if (url.length() > 0) {
-    configDoc["apiUrl"] = url;
-    Serial.println("Config: API URL set to: " + url);
+    if (copyString(data.apiUrl, sizeof(data.apiUrl), url, "API URL")) {
+      Serial.println("Config: API URL set to: " + url);
+    }
   } else {
     Serial.println("WARNING: Attempted to set empty API URL!");
   }
 }
 
-String ConfigManager::getAPIKey() {
-  if (configDoc.containsKey("apiKey")) {
-    String key = configDoc["apiKey"].as<String>();
-    return key;
-  }
-  return DEFAULT_API_KEY;
-}
-
 void ConfigManager::setAPIKey(String key) {
   if (key.length() > 0) {
-    configDoc["apiKey"] = key;
-    Serial.println("Config: API Key set (length: " + String(key.length()) + ")");
+    if (copyString(data.apiKey, sizeof(data.apiKey), key, "API Key")) {
+      Serial.println("Config: API Key set (length: " + String(key.length()) + ")");
+    }
   } else {
     Serial.println("WARNING: Attempted to set empty API Key!");
     // Don't set empty key - keep existing value
   }
 }
 
-bool ConfigManager::getCarelProtocolEnabled() {
-  return configDoc["carelProtocolEnabled"] | DEFAULT_CAREL_PROTOCOL_ENABLED;
-}
-
-void ConfigManager::setCarelProtocolEnabled(bool enabled) {
-  configDoc["carelProtocolEnabled"] = enabled;
-}
-
-bool ConfigManager::getModbusEnabled() {
-  return configDoc["modbusEnabled"] | DEFAULT_MODBUS_ENABLED;
-}
-
-void ConfigManager::setModbusEnabled(bool enabled) {
-  configDoc["modbusEnabled"] = enabled;
-}
-
-unsigned long ConfigManager::getModbusInterval() {
-  return configDoc["modbusInterval"] | DEFAULT_MODBUS_INTERVAL;
-}
-
-void ConfigManager::setModbusInterval(unsigned long interval) {
-  configDoc["modbusInterval"] = interval;
-}
-
-ModbusConfig ConfigManager::getModbusConfig() {
-  ModbusConfig config;
-  config.rxPin = configDoc["modbus"]["rxPin"] | BOARD_RS485_RX;
-  config.txPin = configDoc["modbus"]["txPin"] | BOARD_RS485_TX;
-  config.dePin = configDoc["modbus"]["dePin"] | BOARD_RS485_DE;
-  config.rePin = configDoc["modbus"]["rePin"] | BOARD_RS485_DE;
-  config.baudRate = configDoc["modbus"]["baudRate"] | 9600;
-  config.slaveId = configDoc["modbus"]["slaveId"] | 1;
-  config.writeEnabled = configDoc["modbus"]["writeEnabled"] | true;
-  return config;
-}
-
-void ConfigManager::setModbusConfig(ModbusConfig config) {
-  configDoc["modbus"]["rxPin"] = config.rxPin;
-  configDoc["modbus"]["txPin"] = config.txPin;
-  configDoc["modbus"]["dePin"] = config.dePin;
-  configDoc["modbus"]["rePin"] = config.rePin;
-  configDoc["modbus"]["baudRate"] = config.baudRate;
-  configDoc["modbus"]["slaveId"] = config.slaveId;
-  configDoc["modbus"]["writeEnabled"] = config.writeEnabled;
-}
-
-bool ConfigManager::getModbusWriteEnabled() {
-  return configDoc["modbus"]["writeEnabled"] | true;
-}
-
-void ConfigManager::setModbusWriteEnabled(bool enabled) {
-  configDoc["modbus"]["writeEnabled"] = enabled;
-}
-
-bool ConfigManager::getDeepSleepEnabled() {
-  return configDoc["deepSleepEnabled"] | DEFAULT_DEEP_SLEEP_ENABLED;
-}
-
-void ConfigManager::setDeepSleepEnabled(bool enabled) {
-  configDoc["deepSleepEnabled"] = enabled;
-}
-
-unsigned long ConfigManager::getDeepSleepDuration() {
-  return configDoc["deepSleepDuration"] | DEFAULT_DEEP_SLEEP_DURATION;
-}
-
-void ConfigManager::setDeepSleepDuration(unsigned long duration) {
-  configDoc["deepSleepDuration"] = duration;
-}
-
-SPIConfig ConfigManager::getSPIConfig() {
-  SPIConfig config;
-  config.csPin = configDoc["spi"]["csPin"] | BOARD_MAX31865_CS;
-  config.rtdNominal = configDoc["spi"]["rtdNominal"] | 1000;
-  config.refResistor = configDoc["spi"]["refResistor"] | 4300;
-  config.wires = configDoc["spi"]["wires"] | 4;
-  return config;
-}
-
-void ConfigManager::setSPIConfig(SPIConfig config) {
-  configDoc["spi"]["csPin"] = config.csPin;
-  configDoc["spi"]["rtdNominal"] = config.rtdNominal;
-  configDoc["spi"]["refResistor"] = config.refResistor;
-  configDoc["spi"]["wires"] = config.wires;
-}
-
-String ConfigManager::getOTAPassword() {
-  return configDoc["otaPassword"] | DEFAULT_OTA_PASSWORD;
+int ConfigManager::getModbusSlaves(ModbusSlaveConfig* out, int maxCount) {
+  int n = 0;
+  for (uint8_t i = 0; i < data.slaveCount && n < maxCount; i++) {
+    out[n++] = data.slaves[i];
+  }
+  return n;
 }
 
 void ConfigManager::setOTAPassword(String password) {
-  configDoc["otaPassword"] = password;
+  copyString(data.otaPassword, sizeof(data.otaPassword), password, "OTA password");
 }
 
 String ConfigManager::toJSON() {
+  DynamicJsonDocument doc(CONFIG_JSON_SIZE);
+  doc["deviceSerial"] = (const char*)data.deviceSerial;
+  doc["readingInterval"] = data.readingInterval;
+  doc["uploadInterval"] = data.uploadInterval;
+  doc["apiUrl"] = (const char*)data.apiUrl;
+  doc["apiKey"] = (const char*)data.apiKey;
+  doc["modbusEnabled"] = data.modbusEnabled;
+  doc["carelProtocolEnabled"] = data.carelProtocolEnabled;
+  doc["modbusInterval"] = data.modbusInterval;
+  doc["deepSleepEnabled"] = data.deepSleepEnabled;
+  doc["deepSleepDuration"] = data.deepSleepDuration;
+  doc["otaPassword"] = (const char*)data.otaPassword;
+
+  doc["spi"]["csPin"] = data.spi.csPin;
+  doc["spi"]["rtdNominal"] = data.spi.rtdNominal;
+  doc["spi"]["refResistor"] = data.spi.refResistor;
+  doc["spi"]["wires"] = data.spi.wires;
+
+  doc["modbus"]["rxPin"] = data.modbus.rxPin;
+  doc["modbus"]["txPin"] = data.modbus.txPin;
+  doc["modbus"]["dePin"] = data.modbus.dePin;
+  doc["modbus"]["rePin"] = data.modbus.rePin;
+  doc["modbus"]["baudRate"] = data.modbus.baudRate;
+  doc["modbus"]["framing"] = rs485FramingName(data.modbus.serialConfig);
+  doc["modbus"]["slaveId"] = data.modbus.slaveId;
+  doc["modbus"]["writeEnabled"] = data.modbus.writeEnabled;
+  doc["modbus"]["mode"] = data.modbusSlaveMode ? "slave" : "master";
+  if (data.slaveCount > 0) {
+    JsonArray slaves = doc["modbus"].createNestedArray("slaves");
+    for (uint8_t i = 0; i < data.slaveCount; i++) {
+      JsonObject s = slaves.createNestedObject();
+      s["addr"] = data.slaves[i].addr;
+      s["type"] = (const char*)data.slaves[i].type;
+      s["pollS"] = data.slaves[i].pollS;
+      s["timeoutMs"] = data.slaves[i].timeoutMs;
+    }
+  }
+
   String json;
-  serializeJson(configDoc, json);
+  serializeJson(doc, json);
   return json;
 }
 
 bool ConfigManager::fromJSON(String json) {
-  DeserializationError error = deserializeJson(configDoc, json);
-  return !error;
+  DynamicJsonDocument doc(CONFIG_JSON_SIZE);
+  if (deserializeJson(doc, json)) return false;
+  applyJson(doc);
+  return true;
 }
@@ -17,7 +17,7 @@
 #define DEFAULT_API_URL FIXED_API_URL
 #define DEFAULT_API_KEY ""
 #define DEFAULT_MODBUS_ENABLED false
-// LilyGO: geen Carel op het board; Serial2 init vermijden tenzij expliciet in NVS aangezet.
+// LilyGO: geen Carel op het board; Carel-init vermijden tenzij expliciet in NVS aangezet.
 #if defined(BOARD_LILYGO_T_SIM7670G_S3)
 #define DEFAULT_CAREL_PROTOCOL_ENABLED false
 #else
@@ -34,8 +34,8 @@
 // SPI Configuration for MAX31865
 struct SPIConfig {
   uint8_t csPin;
-  uint8_t rtdNominal;
-  uint8_t refResistor;
+  uint16_t rtdNominal;    // Ω (PT1000: 1000)
+  uint16_t refResistor;   // Ω
   uint8_t wires;
 };
 
@@ -46,17 +46,93 @@ struct ModbusConfig {
   uint8_t dePin;
   uint8_t rePin;
   uint32_t baudRate;
+  uint32_t serialConfig;  // SERIAL_8N1 (default), 8E1, 8O1, 8N2
   uint8_t slaveId;
   bool writeEnabled;
 };
 
-#define CONFIG_JSON_SIZE 2048
+// Extra regelaar op dezelfde RS485-bus (config "modbus.slaves"). De regelaar
+// uit de API-settings is altijd de eerste slave (slot 0).
+struct ModbusSlaveConfig {
+  uint8_t  addr;
+  char     type[24];    // controllerType, bv. "DIXELL_XR60C" (profiel-prefix)
+  uint16_t pollS;       // ondergrens poll-periode; 0 = modbusInterval
+  uint16_t timeoutMs;   // 0 = MODBUS_RX_DEADLINE_MS
+};
+
+#define CONFIG_JSON_SIZE 2048   // enkel nog voor migratie / fromJSON (tijdelijk document)
+
+/**
+ * Config als POD-blob in NVS (key CONFIG_BLOB_KEY): header met magic,
+ * versie, grootte en CRC-32 over de rest. Getters zijn gewone veldreads
+ * (geen JSON-document in RAM, geen heap op de hete paden in loop()).
+ *
+ * Layout: loadBlob() legt een oudere (kortere) blob byte voor byte over de
+ * defaults. Dat werkt enkel als elk bestaand veld op zijn offset blijft:
+ *  - Nieuwe velden enkel achteraan in ConfigData, met CONFIG_BLOB_VERSION + 1.
+ *  - De geneste structs (SPIConfig, ModbusConfig, ModbusSlaveConfig) en
+ *    CONFIG_MODBUS_SLAVES_MAX zijn bevroren: een veld erbij verschuift alles
+ *    erachter. Een nieuw Modbus-veld komt dus als los veld achteraan in
+ *    ConfigData (de static_asserts hieronder bewaken de groottes).
+ *  - Moet een bestaand veld toch wijzigen (type, grootte, volgorde): versie
+ *    ophogen én in loadBlob() de oude versie expliciet omzetten (oude struct
+ *    lezen, velden kopiëren) in plaats van de prefix te kopiëren.
+ * Ontbreekt de blob (of is de CRC fout),
+ * dan migreert load() één keer vanuit de legacy JSON-string (CONFIG_KEY).
+ * Die blijft staan zodat een OTA-rollback zijn config terugvindt.
+ */
+#define CONFIG_BLOB_KEY          "cfgbin"
+#define CONFIG_BLOB_MAGIC        0x31474643UL   // "CFG1"
+#define CONFIG_BLOB_VERSION      1
+#define CONFIG_MODBUS_SLAVES_MAX 4
+
+struct ConfigBlobHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size;        // sizeof(ConfigData) van de schrijvende firmware
+  uint32_t crc;         // CRC-32 over de bytes na de header (tot size)
+};
+
+struct ConfigData {
+  ConfigBlobHeader hdr;
+
+  char     deviceSerial[32];
+  char     apiUrl[128];
+  char     apiKey[96];
+  char     otaPassword[32];
+  uint32_t readingInterval;    // s
+  uint32_t uploadInterval;     // s
+  uint32_t modbusInterval;     // s
+  uint32_t deepSleepDuration;  // s
+  bool     modbusEnabled;
+  bool     carelProtocolEnabled;
+  bool     deepSleepEnabled;
+  bool     modbusSlaveMode;    // modbus.mode == "slave"
+  SPIConfig    spi;
+  ModbusConfig modbus;
+  uint8_t      slaveCount;
+  ModbusSlaveConfig slaves[CONFIG_MODBUS_SLAVES_MAX];
+  // Nieuwe velden hier (zie layout-regels hierboven).
+};
+
+// Blob-layout v1: bevroren (zie hierboven). Faalt dit, dan verschuift een
+// bestaande offset en leest een oude blob verkeerd.
+static_assert(sizeof(SPIConfig) == 8, "SPIConfig is frozen in the config blob");
+static_assert(sizeof(ModbusConfig) == 16, "ModbusConfig is frozen in the config blob");
+static_assert(sizeof(ModbusSlaveConfig) == 30, "ModbusSlaveConfig is frozen in the config blob");
+static_assert(offsetof(ConfigData, slaves) + sizeof(ModbusSlaveConfig) * CONFIG_MODBUS_SLAVES_MAX == 466,
+              "ConfigData v1 prefix changed: append new fields after slaves[]");
 
 class ConfigManager {
 private:
   Preferences preferences;
-  DynamicJsonDocument configDoc{CONFIG_JSON_SIZE};
+  ConfigData data;
   bool loaded;
+
+  bool loadBlob();
+  bool migrateLegacyJson();
+  void applyJson(JsonDocument& doc);
+  static bool copyString(char* dst, size_t cap, const String& value, const char* what);
   
 public:
   ConfigManager();
@@ -68,50 +144,52 @@ public:
   void reset();
   
   // Device settings
-  String getDeviceSerial();
+  String getDeviceSerial() { return String(data.deviceSerial); }
   void setDeviceSerial(String serial);
   
   // Reading settings
-  unsigned long getReadingInterval();
-  void setReadingInterval(unsigned long interval);
+  unsigned long getReadingInterval() const { return data.readingInterval; }
+  void setReadingInterval(unsigned long interval) { data.readingInterval = interval; }
   
   // Upload settings
-  unsigned long getUploadInterval();
-  void setUploadInterval(unsigned long interval);
+  unsigned long getUploadInterval() const { return data.uploadInterval; }
+  void setUploadInterval(unsigned long interval) { data.uploadInterval = interval; }
   String getAPIUrl();
   void setAPIUrl(String url);
-  String getAPIKey();
+  String getAPIKey() { return String(data.apiKey); }
   void setAPIKey(String key);
   
   // Modbus / Carel protocol
-  bool getCarelProtocolEnabled();
-  void setCarelProtocolEnabled(bool enabled);
+  bool getCarelProtocolEnabled() const { return data.carelProtocolEnabled; }
+  void setCarelProtocolEnabled(bool enabled) { data.carelProtocolEnabled = enabled; }
 
   // Modbus settings
-  bool getModbusEnabled();
-  void setModbusEnabled(bool enabled);
-  unsigned long getModbusInterval();
-  void setModbusInterval(unsigned long interval);
-  ModbusConfig getModbusConfig();
-  void setModbusConfig(ModbusConfig config);
-  bool getModbusWriteEnabled();
-  void setModbusWriteEnabled(bool enabled);
+  bool getModbusEnabled() const { return data.modbusEnabled; }
+  void setModbusEnabled(bool enabled) { data.modbusEnabled = enabled; }
+  unsigned long getModbusInterval() const { return data.modbusInterval; }
+  void setModbusInterval(unsigned long interval) { data.modbusInterval = interval; }
+  ModbusConfig getModbusConfig() const { return data.modbus; }
+  void setModbusConfig(ModbusConfig config) { data.modbus = config; }
+  int getModbusSlaves(ModbusSlaveConfig* out, int maxCount);
+  bool getModbusSlaveMode() const { return data.modbusSlaveMode; }  // toestel is zelf Modbus-slave (GBS)
+  bool getModbusWriteEnabled() const { return data.modbus.writeEnabled; }
+  void setModbusWriteEnabled(bool enabled) { data.modbus.writeEnabled = enabled; }
   
   // Power management
-  bool getDeepSleepEnabled();
-  void setDeepSleepEnabled(bool enabled);
-  unsigned long getDeepSleepDuration();
-  void setDeepSleepDuration(unsigned long duration);
+  bool getDeepSleepEnabled() const { return data.deepSleepEnabled; }
+  void setDeepSleepEnabled(bool enabled) { data.deepSleepEnabled = enabled; }
+  unsigned long getDeepSleepDuration() const { return data.deepSleepDuration; }
+  void setDeepSleepDuration(unsigned long duration) { data.deepSleepDuration = duration; }
   
   // SPI configuration
-  SPIConfig getSPIConfig();
-  void setSPIConfig(SPIConfig config);
+  SPIConfig getSPIConfig() const { return data.spi; }
+  void setSPIConfig(SPIConfig config) { data.spi = config; }
   
   // OTA settings
-  String getOTAPassword();
+  String getOTAPassword() { return String(data.otaPassword); }
   void setOTAPassword(String password);
   
-  // Get full config as JSON
+  // Full config als JSON (legacy-formaat; diagnose en import)
   String toJSON();
   bool fromJSON(String json);
 };
@@ -0,0 +1,410 @@
+#include "controller_discovery.h"
+#include "rs485_modbus.h"
+#include "carel_frame.h"
+#include "carel_protocol.h"
+#include "logger.h"
+#include "watchdog_tpl5010.h"
+#include <Preferences.h>
+
+extern Logger logger;
+
+namespace {
+
+const char* kNamespace = "rs485disc";
+
+struct Line {
+  uint32_t baud;
+  uint32_t config;
+};
+
+// Volgorde = hoe vaak we ze in het veld zien (Dixell/Eliwell/Carel default eerst).
+const Line kLines[] = {
+  { 9600,   SERIAL_8N1 },
+  { 19200,  SERIAL_8N1 },
+  { 9600,   SERIAL_8E1 },
+  { 19200,  SERIAL_8E1 },
+  { 9600,   SERIAL_8N2 },
+  { 38400,  SERIAL_8N1 },
+  { 4800,   SERIAL_8N1 },
+  { 38400,  SERIAL_8E1 },
+  { 4800,   SERIAL_8E1 },
+  { 19200,  SERIAL_8N2 },
+  { 2400,   SERIAL_8N1 },
+  { 57600,  SERIAL_8N1 },
+  { 115200, SERIAL_8N1 },
+};
+
+#define MAX_LINES    16
+#define MAX_HOT      6
+
+enum ProbeResult : uint8_t { PROBE_NONE = 0, PROBE_ACTIVITY, PROBE_HIT };
+
+portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+bool        s_requested = false;
+const char* s_reason = "";
+uint8_t     s_hintAddr = 0;      // API-hint van de (aangevraagde) run = cache-sleutel
+uint32_t    s_hintBaud = 0;
+bool        s_ranForHint = false;
+uint8_t     s_ranAddr = 0;
+uint32_t    s_ranBaud = 0;
+bool        s_primarySeen = false;
+
+DiscoveryCandidate s_found[DISCOVERY_MAX_CANDIDATES];
+uint8_t  s_foundCount = 0;
+uint32_t s_probes = 0;
+uint32_t s_runMs = 0;
+bool     s_reportPending = false;
+uint32_t s_runSeq = 0;          // telt runs; ack wist enkel het rapport dat mee was
+uint32_t s_reportSentSeq = 0;
+bool     s_bestApplies = false;  // beste kandidaat respecteert de hint van de run
+
+bool     s_cacheLoaded = false;
+bool     s_cacheValid = false;
+DiscoveryCandidate s_cache;
+uint8_t  s_cacheHintAddr = 0;
+uint32_t s_cacheHintBaud = 0;
+
+// Een expliciete API-slave/baud is de waarheid: discovery mag enkel invullen
+// wat de API openliet, niet overschrijven.
+bool matchesHint(const DiscoveryCandidate& c, uint8_t apiAddr, uint32_t apiBaud) {
+  if (c.protocol != DISCOVERY_MODBUS) return false;
+  return (!apiAddr || c.addr == apiAddr) && (!apiBaud || c.baud == apiBaud);
+}
+
+void loadCache() {
+  if (s_cacheLoaded) return;
+  s_cacheLoaded = true;
+  Preferences prefs;
+  if (!prefs.begin(kNamespace, true)) return;
+  s_cacheValid = prefs.getBool("valid", false);
+  s_cache = {};
+  s_cache.protocol = (DiscoveryProtocol)prefs.getUChar("proto", DISCOVERY_MODBUS);
+  s_cache.baud = prefs.getUInt("baud", 0);
+  s_cache.serialConfig = prefs.getUInt("ser", SERIAL_8N1);
+  s_cache.addr = prefs.getUChar("addr", 0);
+  s_cacheHintAddr = prefs.getUChar("hintA", 0);
+  s_cacheHintBaud = prefs.getUInt("hintB", 0);
+  prefs.end();
+  if (!s_cache.baud || !s_cache.addr) s_cacheValid = false;
+}
+
+void storeCache(const DiscoveryCandidate& c, uint8_t hintAddr, uint32_t hintBaud) {
+  s_cache = c;
+  s_cacheHintAddr = hintAddr;
+  s_cacheHintBaud = hintBaud;
+  s_cacheValid = true;
+  Preferences prefs;
+  if (!prefs.begin(kNamespace, false)) return;
+  prefs.putBool("valid", true);
+  prefs.putUChar("proto", c.protocol);
+  prefs.putUInt("baud", c.baud);
+  prefs.putUInt("ser", c.serialConfig);
+  prefs.putUChar("addr", c.addr);
+  prefs.putUChar("hintA", hintAddr);
+  prefs.putUInt("hintB", hintBaud);
+  prefs.end();
+}
+
+uint16_t quickTimeoutMs(uint32_t baud) {
+  // FC03-antwoord op 1 register = 7 bytes; ReadI-antwoord = 5.
+  return (uint16_t)((7UL * modbusCharTimeUs(baud) + 999) / 1000 + DISCOVERY_TURNAROUND_MS);
+}
+
+uint16_t adaptiveTimeoutMs(uint32_t baud) {
+  // Slaves op één bus antwoorden doorgaans even snel: 2× de traagste gemeten
+  // turnaround volstaat om de rest van het adresbereik te scannen.
+  uint32_t maxUs = 0;
+  for (uint8_t i = 0; i < s_foundCount; i++) {
+    if (s_found[i].baud == baud && s_found[i].latencyUs > maxUs) maxUs = s_found[i].latencyUs;
+  }
+  if (!maxUs) return quickTimeoutMs(baud);
+  uint32_t ms = 2 * maxUs / 1000 + 5;
+  if (ms < 15) ms = 15;
+  if (ms > DISCOVERY_SLOW_TIMEOUT_MS) ms = DISCOVERY_SLOW_TIMEOUT_MS;
+  return (uint16_t)ms;
+}
+
+void addCandidate(DiscoveryProtocol proto, const Line& line, uint8_t addr, bool exception, uint32_t latencyUs) {
+  for (uint8_t i = 0; i < s_foundCount; i++) {
+    const DiscoveryCandidate& c = s_found[i];
+    if (c.protocol == proto && c.addr == addr && c.baud == line.baud && c.serialConfig == line.config) return;
+  }
+  if (s_foundCount >= DISCOVERY_MAX_CANDIDATES) return;
+  DiscoveryCandidate& c = s_found[s_foundCount++];
+  c = {};
+  c.protocol = proto;
+  c.baud = line.baud;
+  c.serialConfig = line.config;
+  c.addr = addr;
+  c.exception = exception;
+  c.latencyUs = latencyUs;
+  logger.info(String("[DISCOVERY] ") + (proto == DISCOVERY_CAREL ? "Carel PJEZ" : "Modbus") + " slave " +
+              addr + " @ " + line.baud + " " + rs485FramingName(line.config) +
+              (exception ? " (exception)" : "") + ", " + String(latencyUs / 1000) + " ms");
+}
+
+ProbeResult probeModbus(RS485Modbus& bus, const Line& line, uint8_t addr, uint16_t timeoutMs) {
+  kickWatchdog();
+  s_probes++;
+  ModbusTxn txn = {};
+  txn.slave = addr;
+  txn.fc = MODBUS_READ_HOLDING_REGISTERS;
+  txn.addr = 0;
+  txn.qty = 1;
+  txn.timeoutMs = timeoutMs;
+  txn.baud = line.baud;
+  txn.serialConfig = line.config;
+  switch (bus.transact(txn)) {
+    case MODBUS_OK:
+    case MODBUS_ERR_EXCEPTION:
+      addCandidate(DISCOVERY_MODBUS, line, addr, txn.status == MODBUS_ERR_EXCEPTION, txn.latencyUs);
+      return PROBE_HIT;
+    case MODBUS_ERR_TIMEOUT:
+    case MODBUS_ERR_BUS:
+      return PROBE_NONE;
+    default:
+      return PROBE_ACTIVITY;  // bytes, maar geen geldig frame: baud/framing bijna goed?
+  }
+}
+
+// Loopt als raw Modbus-transactie: zelfde bus-job, dus ook dezelfde
+// DE-polariteit (die van de transceiver) als CarelProtocol.
+ProbeResult probeCarel(RS485Modbus& bus, uint8_t addr) {
+  kickWatchdog();
+  s_probes++;
+  const Line line = { CAREL_BAUD, SERIAL_8N2 };
+  ModbusTxn txn = {};
+  txn.fc = MODBUS_TXN_RAW;
+  txn.rawLen = (uint8_t)carelBuildRead(txn.raw, addr, CAREL_TEMPERATURE);
+  txn.rawExpect = CAREL_READ_RESPONSE_LEN;
+  txn.timeoutMs = DISCOVERY_SLOW_TIMEOUT_MS;
+  txn.baud = line.baud;
+  txn.serialConfig = line.config;
+  bus.transact(txn);
+  if (txn.rawLen == 0) return PROBE_NONE;
+  // NAK: PJEZ kent de variabele niet, maar antwoordt wel op dit adres.
+  if ((txn.status == MODBUS_OK && carelParseReadResponse(txn.raw, txn.rawLen, nullptr) == CAREL_OK) ||
+      (txn.rawLen == 1 && txn.raw[0] == CAREL_NAK)) {
+    addCandidate(DISCOVERY_CAREL, line, addr, false, txn.latencyUs);
+    return PROBE_HIT;
+  }
+  return PROBE_ACTIVITY;
+}
+
+bool budgetLeft(uint32_t startMs) {
+  return millis() - startMs < DISCOVERY_BUDGET_MS && s_foundCount < DISCOVERY_MAX_CANDIDATES;
+}
+
+void addLine(Line* lines, uint8_t& n, uint32_t baud, uint32_t config) {
+  if (!baud || n >= MAX_LINES) return;
+  for (uint8_t i = 0; i < n; i++) {
+    if (lines[i].baud == baud && lines[i].config == config) return;
+  }
+  lines[n++] = { baud, config };
+}
+
+void addHot(uint8_t* hot, uint8_t& n, uint8_t addr) {
+  if (!addr || addr > DISCOVERY_SCAN_MAX_ADDR || n >= MAX_HOT) return;
+  for (uint8_t i = 0; i < n; i++) {
+    if (hot[i] == addr) return;
+  }
+  hot[n++] = addr;
+}
+
+bool isHot(const uint8_t* hot, uint8_t n, uint8_t addr) {
+  for (uint8_t i = 0; i < n; i++) {
+    if (hot[i] == addr) return true;
+  }
+  return false;
+}
+
+void rank(const ModbusConfig& current) {
+  for (uint8_t i = 0; i < s_foundCount; i++) {
+    DiscoveryCandidate& c = s_found[i];
+    int16_t score = 100;
+    if (c.exception) score -= 20;
+    if (c.protocol == DISCOVERY_MODBUS && c.addr == s_hintAddr) score += 50;
+    if (c.protocol == DISCOVERY_MODBUS && c.addr == current.slaveId) score += 20;
+    if (s_cacheValid && c.protocol == s_cache.protocol && c.addr == s_cache.addr && c.baud == s_cache.baud) {
+      score += 30;
+    }
+    if (c.baud == current.baudRate) score += 10;
+    const uint32_t latPenalty = c.latencyUs / 10000;  // -1 per 10 ms
+    score -= (int16_t)(latPenalty > 30 ? 30 : latPenalty);
+    c.score = score;
+  }
+  // Insertion sort: hoogste score eerst (max DISCOVERY_MAX_CANDIDATES).
+  for (uint8_t i = 1; i < s_foundCount; i++) {
+    const DiscoveryCandidate c = s_found[i];
+    int8_t j = i - 1;
+    while (j >= 0 && s_found[j].score < c.score) {
+      s_found[j + 1] = s_found[j];
+      j--;
+    }
+    s_found[j + 1] = c;
+  }
+}
+
+} // namespace
+
+void controllerDiscoveryRequest(const char* reason, uint8_t apiAddr, uint32_t apiBaud) {
+  portENTER_CRITICAL(&s_mux);
+  const bool done = s_ranForHint && s_ranAddr == apiAddr && s_ranBaud == apiBaud;
+  if (!done && !s_requested) {
+    s_requested = true;
+    s_reason = reason ? reason : "";
+    s_hintAddr = apiAddr;
+    s_hintBaud = apiBaud;
+  }
+  portEXIT_CRITICAL(&s_mux);
+}
+
+void controllerDiscoveryNotePrimary(bool online, bool inBackoff, uint8_t apiAddr, uint32_t apiBaud) {
+  if (online) {
+    s_primarySeen = true;
+    return;
+  }
+  // Enkel als de regelaar sinds boot nooit antwoordde: valt hij later weg,
+  // dan is hij eerder uitgeschakeld dan verkeerd geconfigureerd.
+  if (!s_primarySeen && inBackoff) controllerDiscoveryRequest("regelaar antwoordt niet", apiAddr, apiBaud);
+}
+
+bool controllerDiscoveryPending() {
+  return s_requested;
+}
+
+int controllerDiscoveryRun(RS485Modbus& bus, const ModbusConfig& current) {
+  portENTER_CRITICAL(&s_mux);
+  s_requested = false;
+  s_ranForHint = true;
+  s_ranAddr = s_hintAddr;
+  s_ranBaud = s_hintBaud;
+  portEXIT_CRITICAL(&s_mux);
+
+  loadCache();
+  const uint32_t startMs = millis();
+  s_foundCount = 0;
+  s_probes = 0;
+  logger.info(String("[DISCOVERY] start: ") + s_reason + " (API slave " + s_hintAddr + ", baud " + s_hintBaud + ")");
+
+  Line lines[MAX_LINES];
+  uint8_t lineCount = 0;
+  addLine(lines, lineCount, current.baudRate, current.serialConfig ? current.serialConfig : SERIAL_8N1);
+  if (s_cacheValid && s_cache.protocol == DISCOVERY_MODBUS) addLine(lines, lineCount, s_cache.baud, s_cache.serialConfig);
+  addLine(lines, lineCount, s_hintBaud, SERIAL_8N1);
+  for (const Line& l : kLines) addLine(lines, lineCount, l.baud, l.config);
+
+  uint8_t hot[MAX_HOT];
+  uint8_t hotCount = 0;
+  addHot(hot, hotCount, s_hintAddr);
+  addHot(hot, hotCount, current.slaveId);
+  if (s_cacheValid && s_cache.protocol == DISCOVERY_MODBUS) addHot(hot, hotCount, s_cache.addr);
+  for (uint8_t a = 1; a <= 4; a++) addHot(hot, hotCount, a);
+
+  // 1. Waarschijnlijke adressen op alle lijnen, korte timeout.
+  uint8_t activity[MAX_LINES] = {};
+  int hitLine = -1;
+  for (uint8_t li = 0; li < lineCount && hitLine < 0 && budgetLeft(startMs); li++) {
+    const uint16_t tmo = quickTimeoutMs(lines[li].baud);
+    for (uint8_t h = 0; h < hotCount; h++) {
+      const ProbeResult r = probeModbus(bus, lines[li], hot[h], tmo);
+      if (r == PROBE_HIT) hitLine = li;
+      if (r == PROBE_ACTIVITY) activity[li]++;
+    }
+  }
+
+  // 2. Lijnen met activiteit: trage regelaar of afwijkende turnaround.
+  for (uint8_t li = 0; li < lineCount && hitLine < 0 && budgetLeft(startMs); li++) {
+    if (!activity[li]) continue;
+    for (uint8_t h = 0; h < hotCount; h++) {
+      if (probeModbus(bus, lines[li], hot[h], DISCOVERY_SLOW_TIMEOUT_MS) == PROBE_HIT) hitLine = li;
+    }
+  }
+
+  // 3. Carel-supervisie (enkel als Modbus niets vond: één protocol per segment).
+  bool carelFound = false;
+  for (uint8_t a = 1; a <= DISCOVERY_CAREL_MAX_ADDR && hitLine < 0 && budgetLeft(startMs); a++) {
+    if (probeCarel(bus, a) == PROBE_HIT) carelFound = true;
+  }
+
+  // 4. Volledige adresscan op de gevonden lijn; zonder treffer op de lijnen
+  //    met activiteit en de twee gangbaarste.
+  if (!carelFound) {
+    for (uint8_t li = 0; li < lineCount && budgetLeft(startMs); li++) {
+      const bool scan = hitLine >= 0 ? li == hitLine : (activity[li] || li < 2);
+      if (!scan) continue;
+      for (uint16_t a = 1; a <= DISCOVERY_SCAN_MAX_ADDR && budgetLeft(startMs); a++) {
+        if (isHot(hot, hotCount, (uint8_t)a)) continue;
+        if (probeModbus(bus, lines[li], (uint8_t)a, adaptiveTimeoutMs(lines[li].baud)) == PROBE_HIT && hitLine < 0) {
+          hitLine = li;  // deze lijn afmaken, daarna stoppen
+        }
+      }
+      if (hitLine >= 0) break;
+    }
+  }
+
+  rank(current);
+  s_runMs = millis() - startMs;
+  s_runSeq++;
+  s_reportPending = true;
+  s_bestApplies = s_foundCount && matchesHint(s_found[0], s_ranAddr, s_ranBaud);
+  if (s_foundCount) {
+    storeCache(s_found[0], s_ranAddr, s_ranBaud);
+    logger.info(String("[DISCOVERY] ") + s_foundCount + " kandidaat/kandidaten in " + s_runMs + " ms (" + s_probes +
+                " probes), beste: slave " + s_found[0].addr + " @ " + s_found[0].baud + " " +
+                rs485FramingName(s_found[0].serialConfig));
+    if (s_found[0].protocol == DISCOVERY_CAREL) {
+      // Supervisie = ander protocol: enkel melden.
+      logger.warn("[DISCOVERY] Carel PJEZ op adres " + String(s_found[0].addr) +
+                  " — stel controllerType CAREL_PJEZ in via de app");
+    } else if (!s_bestApplies) {
+      logger.warn("[DISCOVERY] beste kandidaat wijkt af van API-slave/baud: niet overgenomen, enkel gemeld");
+    }
+  } else {
+    logger.warn(String("[DISCOVERY] geen regelaar gevonden (") + s_probes + " probes, " + s_runMs + " ms)");
+  }
+  return s_foundCount;
+}
+
+bool controllerDiscoveryBest(DiscoveryCandidate& out) {
+  if (!s_foundCount || !s_bestApplies) return false;
+  out = s_found[0];
+  return true;
+}
+
+bool controllerDiscoveryCached(uint8_t apiAddr, uint32_t apiBaud, DiscoveryCandidate& out) {
+  loadCache();
+  if (!s_cacheValid || s_cacheHintAddr != apiAddr || s_cacheHintBaud != apiBaud) return false;
+  if (!matchesHint(s_cache, apiAddr, apiBaud)) return false;
+  out = s_cache;
+  return true;
+}
+
+bool writeControllerDiscoveryJson(JsonDocument& doc) {
+  if (!s_reportPending) return false;
+  JsonObject d = doc.createNestedObject("discovery");
+  d["reason"] = s_reason;
+  d["ms"] = s_runMs;
+  d["probes"] = s_probes;
+  d["count"] = s_foundCount;
+  d["applied"] = s_bestApplies;
+  JsonArray found = d.createNestedArray("found");
+  // Top-4: de heartbeat-doc draagt ook deur-, alarm- en slave-statistieken.
+  for (uint8_t i = 0; i < s_foundCount && i < 4; i++) {
+    const DiscoveryCandidate& c = s_found[i];
+    JsonObject o = found.createNestedObject();
+    o["proto"] = c.protocol == DISCOVERY_CAREL ? "carel" : "modbus";
+    o["addr"] = c.addr;
+    o["baud"] = c.baud;
+    o["framing"] = rs485FramingName(c.serialConfig);
+    o["lat_ms"] = c.latencyUs / 1000;
+    o["score"] = c.score;
+  }
+  s_reportSentSeq = s_runSeq;
+  return true;
+}
+
+void controllerDiscoveryAck() {
+  // Een run die intussen klaar is, blijft pending voor de volgende heartbeat.
+  if (s_reportSentSeq == s_runSeq) s_reportPending = false;
+}
@@ -0,0 +1,92 @@
+#ifndef CONTROLLER_DISCOVERY_H
+#define CONTROLLER_DISCOVERY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "config.h"
+
+class RS485Modbus;
+
+/**
+ * Automatische regelaar-discovery op de RS485-bus: als de settings geen
+ * slave/baud meegeven, of de geconfigureerde regelaar sinds boot nog nooit
+ * antwoordde, zoekt modbusTask zelf baud, framing en slave-adres.
+ *
+ *  1. Waarschijnlijke adressen (API/config, cache, 1..4) × alle lijnen
+ *     (baud × framing) met een korte timeout. Elk geldig frame, ook een
+ *     exception, bewijst een slave op dat adres. Een verminkt antwoord
+ *     (CRC/lengte) markeert de lijn als "activiteit".
+ *  2. Lijnen met activiteit opnieuw met een lange timeout.
+ *  3. Carel PJEZ-supervisie (1200 8N2, ReadI temperatuur) op 1..16.
+ *  4. Volledige adresscan op de gevonden lijn (of de lijnen met
+ *     activiteit). De timeout volgt de gemeten antwoordtijd.
+ *
+ * De bus is half-duplex, dus probes lopen sequentieel. App-commando's
+ * (priority) gaan er gewoon tussendoor.
+ *
+ * Kandidaten krijgen een score: geldig antwoord, overeenkomst met API/cache
+ * en latency. De beste komt in NVS, gekoppeld aan de API-hint waarvoor hij
+ * gevonden werd. Bij dezelfde hint (volgende boot of settings-fetch) gebruikt
+ * main.cpp het resultaat meteen, zonder nieuwe scan.
+ *
+ * Overnemen gebeurt enkel voor een Modbus-kandidaat die de hint respecteert:
+ * slave en baud die de API expliciet meegaf, moeten kloppen. Een andere
+ * winnaar gaat alleen mee in het heartbeat-rapport ("applied": false).
+ */
+
+enum DiscoveryProtocol : uint8_t {
+  DISCOVERY_MODBUS = 0,
+  DISCOVERY_CAREL,
+};
+
+struct DiscoveryCandidate {
+  DiscoveryProtocol protocol;
+  uint32_t baud;
+  uint32_t serialConfig;     // SERIAL_8N1/8E1/...
+  uint8_t  addr;
+  bool     exception;        // Modbus: antwoord was een exception (slave bestaat)
+  uint32_t latencyUs;        // einde TX → einde antwoord
+  int16_t  score;
+};
+
+#define DISCOVERY_MAX_CANDIDATES   8
+#define DISCOVERY_SCAN_MAX_ADDR    247
+#define DISCOVERY_CAREL_MAX_ADDR   16
+#define DISCOVERY_TURNAROUND_MS    40     // korte timeout = antwoordframe + dit
+#define DISCOVERY_SLOW_TIMEOUT_MS  250    // lijn met activiteit, Carel
+#define DISCOVERY_BUDGET_MS        (90UL * 1000UL)
+
+/**
+ * Discovery aanvragen (settings-task). apiAddr/apiBaud = wat de API
+ * meegaf (0 = niets): per hint hooguit één run per boot.
+ */
+void controllerDiscoveryRequest(const char* reason, uint8_t apiAddr, uint32_t apiBaud);
+
+/** modbusTask, na elke scheduler-tick: regelaar nooit online + backoff → discovery. */
+void controllerDiscoveryNotePrimary(bool online, bool inBackoff, uint8_t apiAddr, uint32_t apiBaud);
+
+bool controllerDiscoveryPending();
+
+/**
+ * Blokkerende run (modbusTask; kickt de watchdog per probe). current = de
+ * huidige lijn/slave (eerst geprobeerd). Returnt het aantal kandidaten.
+ */
+int controllerDiscoveryRun(RS485Modbus& bus, const ModbusConfig& current);
+
+/** Beste kandidaat van de laatste run, enkel als hij overgenomen mag worden. */
+bool controllerDiscoveryBest(DiscoveryCandidate& out);
+
+/** Gecachet resultaat (NVS) voor deze API-hint dat overgenomen mag worden, of false. */
+bool controllerDiscoveryCached(uint8_t apiAddr, uint32_t apiBaud, DiscoveryCandidate& out);
+
+/**
+ * Heartbeat (eenmalig na een run): "discovery": {reason, ms, probes, count,
+ * applied, found: [{proto, addr, baud, framing, lat_ms, score}] (top-4)}. Blijft
+ * meegaan tot controllerDiscoveryAck(); returnt of het object erin zit.
+ */
+bool writeControllerDiscoveryJson(JsonDocument& doc);
+
+/** Na geslaagde heartbeat met "discovery": rapport als verstuurd markeren. */
+void controllerDiscoveryAck();
+
+#endif /* CONTROLLER_DISCOVERY_H */
@@ -0,0 +1,313 @@
+#include "controller_poll.h"
+#include "rs485_modbus.h"
+#include "logger.h"
+#include <freertos/FreeRTOS.h>
+
+extern Logger logger;
+
+namespace {
+
+struct Slot {
+  uint8_t  addr;                                  // 0 = vrij
+  uint16_t timeoutMs;
+  const ControllerProfile* profile;
+  uint32_t lastPollMs[CONTROLLER_MAX_POINTS];     // per profielpunt; 0 = nog nooit
+  float    value[POINT_COUNT];
+  uint32_t valueMs[POINT_COUNT];                  // 0 = onbekend
+  ControllerSlotStats stats;
+};
+
+portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+Slot s_slots[CONTROLLER_MAX_SLAVES] = {};
+
+const char* const kPointKeys[POINT_COUNT] = {
+  "temp", "setpoint", "evap_temp", "compressor", "defrost", "alarm", "power"
+};
+
+const ControllerProfile& profileOf(const Slot& s) {
+  return s.profile ? *s.profile : genericControllerProfile();
+}
+
+uint8_t readFunctionFor(ControllerSpace space) {
+  switch (space) {
+    case SPACE_INPUT:    return MODBUS_READ_INPUT_REGISTERS;
+    case SPACE_COIL:     return MODBUS_READ_COILS;
+    case SPACE_DISCRETE: return MODBUS_READ_DISCRETE_INPUTS;
+    case SPACE_HOLDING:
+    default:             return MODBUS_READ_HOLDING_REGISTERS;
+  }
+}
+
+void store(Slot& s, ControllerPointId id, float v, uint32_t now) {
+  portENTER_CRITICAL(&s_mux);
+  s.value[id] = v;
+  s.valueMs[id] = now ? now : 1;
+  portEXIT_CRITICAL(&s_mux);
+}
+
+// Eén transactie naar de slave van dit slot, met tellers voor de scheduler.
+ModbusStatus run(RS485Modbus& bus, Slot& s, ModbusTxn& txn) {
+  txn.slave = s.addr;
+  txn.timeoutMs = s.timeoutMs;
+  const ModbusStatus st = bus.transact(txn);
+  portENTER_CRITICAL(&s_mux);
+  s.stats.transactions++;
+  if (st != MODBUS_OK) s.stats.failures++;
+  s.stats.busUs += txn.busUs;
+  portEXIT_CRITICAL(&s_mux);
+  return st;
+}
+
+// Eén blok lezen en alle punten erin decoderen.
+ModbusStatus readBlock(RS485Modbus& bus, Slot& s, const ControllerPollBlock& b, bool priority) {
+  const ControllerProfile& p = profileOf(s);
+  ModbusTxn txn = {};
+  txn.fc = readFunctionFor(b.space);
+  txn.addr = b.start;
+  txn.qty = b.count;
+  txn.priority = priority;
+  const ModbusStatus st = run(bus, s, txn);
+  if (st != MODBUS_OK || txn.regCount < b.count) return st == MODBUS_OK ? MODBUS_ERR_SHORT : st;
+  const uint32_t now = millis();
+  for (uint8_t i = 0; i < p.count; i++) {
+    if (b.pointMask & (1UL << i)) store(s, p.points[i].id, decodeControllerPoint(p.points[i], b, txn.regs), now);
+  }
+  return MODBUS_OK;
+}
+
+} // namespace
+
+void controllerConfigureSlot(uint8_t slot, uint8_t slaveAddr, const String& controllerType, uint16_t timeoutMs) {
+  if (slot >= CONTROLLER_MAX_SLAVES) return;
+  Slot& s = s_slots[slot];
+  const ControllerProfile& p = findControllerProfile(controllerType.c_str());
+  if (&p == s.profile && slaveAddr == s.addr && timeoutMs == s.timeoutMs) return;
+
+  portENTER_CRITICAL(&s_mux);
+  s.addr = slaveAddr;
+  s.timeoutMs = timeoutMs;
+  s.profile = &p;
+  memset(s.lastPollMs, 0, sizeof(s.lastPollMs));
+  memset(s.valueMs, 0, sizeof(s.valueMs));
+  portEXIT_CRITICAL(&s_mux);
+  if (!slaveAddr) return;
+
+  // Volledig plan (alle pollbare punten) loggen: zoveel reads per cyclus.
+  uint32_t all = 0;
+  for (uint8_t i = 0; i < p.count && i < CONTROLLER_MAX_POINTS; i++) {
+    if (p.points[i].pollS) all |= 1UL << i;
+  }
+  ControllerPollBlock blocks[CONTROLLER_MAX_BLOCKS];
+  const int n = planControllerPoll(p, all, blocks, CONTROLLER_MAX_BLOCKS);
+  logger.info(String("[CONTROLLER] slot ") + slot + " slave " + slaveAddr + ": profiel " + p.name +
+              " voor '" + controllerType + "', " + String(p.count) + " punten, " + String(n) +
+              " read(s) per volledige cyclus");
+}
+
+uint8_t controllerSlotAddr(uint8_t slot) {
+  return slot < CONTROLLER_MAX_SLAVES ? s_slots[slot].addr : 0;
+}
+
+int controllerSlotForAddr(uint8_t slaveAddr) {
+  if (!slaveAddr) return -1;
+  for (uint8_t i = 0; i < CONTROLLER_MAX_SLAVES; i++) {
+    if (s_slots[i].addr == slaveAddr) return i;
+  }
+  return -1;
+}
+
+const ControllerProfile& activeControllerProfile(uint8_t slot) {
+  return slot < CONTROLLER_MAX_SLAVES ? profileOf(s_slots[slot]) : genericControllerProfile();
+}
+
+void controllerSlotStats(uint8_t slot, ControllerSlotStats& out) {
+  out = {};
+  if (slot >= CONTROLLER_MAX_SLAVES) return;
+  portENTER_CRITICAL(&s_mux);
+  out = s_slots[slot].stats;
+  portEXIT_CRITICAL(&s_mux);
+}
+
+bool controllerPollCycle(RS485Modbus& bus, uint8_t slot, uint16_t minPeriodS, ControllerCycle& out) {
+  out = {};
+  if (slot >= CONTROLLER_MAX_SLAVES || !s_slots[slot].addr) return false;
+  Slot& s = s_slots[slot];
+  const ControllerProfile& p = profileOf(s);
+  const uint32_t now = millis();
+  uint32_t due = 0;
+  for (uint8_t i = 0; i < p.count && i < CONTROLLER_MAX_POINTS; i++) {
+    const uint16_t pollS = p.points[i].pollS;
+    if (pollS == 0) continue;
+    const uint32_t periodMs = (uint32_t)(pollS > minPeriodS ? pollS : minPeriodS) * 1000UL;
+    if (s.lastPollMs[i] == 0 || (now - s.lastPollMs[i]) >= periodMs) due |= 1UL << i;
+  }
+  if (!due) return false;
+
+  ControllerPollBlock blocks[CONTROLLER_MAX_BLOCKS];
+  const int n = planControllerPoll(p, due, blocks, CONTROLLER_MAX_BLOCKS);
+  for (int b = 0; b < n; b++) {
+    const ModbusStatus st = readBlock(bus, s, blocks[b], false);
+    out.transactions++;
+    // Ook bij fout als gepolld markeren: geen herhaalde reads elke tick.
+    for (uint8_t i = 0; i < p.count; i++) {
+      if (blocks[b].pointMask & (1UL << i)) s.lastPollMs[i] = now ? now : 1;
+    }
+    if (st == MODBUS_OK) {
+      out.ok++;
+    } else if (st == MODBUS_ERR_TIMEOUT) {
+      out.timedOut = true;
+      break;  // slave antwoordt niet: rest van de cyclus is zinloos
+    }
+  }
+  return true;
+}
+
+bool controllerPointValue(ControllerPointId id, float& out, uint32_t* ageMs, uint8_t slot) {
+  if (id >= POINT_COUNT || slot >= CONTROLLER_MAX_SLAVES) return false;
+  portENTER_CRITICAL(&s_mux);
+  const uint32_t t = s_slots[slot].valueMs[id];
+  const float v = s_slots[slot].value[id];
+  portEXIT_CRITICAL(&s_mux);
+  if (t == 0) return false;
+  out = v;
+  if (ageMs) *ageMs = millis() - t;
+  return true;
+}
+
+bool controllerReadPoint(RS485Modbus& bus, ControllerPointId id, float& out, uint8_t slot) {
+  if (slot >= CONTROLLER_MAX_SLAVES) return false;
+  Slot& s = s_slots[slot];
+  int idx = -1;
+  const ControllerPoint* pt = controllerProfilePoint(profileOf(s), id, &idx);
+  if (!pt) return false;
+  ControllerPollBlock b;
+  b.space = pt->space;
+  b.start = pt->addr;
+  b.count = controllerPointWidth(*pt);
+  b.pointMask = 1UL << idx;
+  if (readBlock(bus, s, b, true) != MODBUS_OK) return false;
+  return controllerPointValue(id, out, nullptr, slot);
+}
+
+bool controllerGetPoint(RS485Modbus& bus, ControllerPointId id, ControllerValue& out, uint8_t slot, bool forceBus) {
+  out = {};
+  if (slot >= CONTROLLER_MAX_SLAVES) return false;
+  Slot& s = s_slots[slot];
+  const ControllerPoint* pt = controllerProfilePoint(profileOf(s), id);
+  if (!pt) return false;
+
+  float cached;
+  uint32_t age;
+  const bool have = controllerPointValue(id, cached, &age, slot);
+  if (!forceBus && have && pt->ttlS && age <= (uint32_t)pt->ttlS * 1000UL) {
+    portENTER_CRITICAL(&s_mux);
+    s.stats.cacheHits++;
+    portEXIT_CRITICAL(&s_mux);
+    out.value = cached;
+    out.ageMs = age;
+    out.cached = true;
+    return true;
+  }
+  portENTER_CRITICAL(&s_mux);
+  s.stats.cacheMisses++;
+  portEXIT_CRITICAL(&s_mux);
+
+  if (controllerReadPoint(bus, id, out.value, slot)) return true;
+  if (!have || age > CONTROLLER_STALE_MAX_MS) return false;
+  out.value = cached;
+  out.ageMs = age;
+  out.cached = true;
+  out.stale = true;
+  return true;
+}
+
+ControllerWriteStatus controllerWritePoint(RS485Modbus& bus, ControllerPointId id, float value, uint8_t slot) {
+  if (slot >= CONTROLLER_MAX_SLAVES) return CONTROLLER_WRITE_UNSUPPORTED;
+  Slot& s = s_slots[slot];
+  const ControllerPoint* pt = controllerProfilePoint(profileOf(s), id);
+  if (!pt || !pt->writable) return CONTROLLER_WRITE_UNSUPPORTED;
+  ModbusTxn txn = {};
+  txn.addr = pt->addr;
+  txn.priority = true;
+  if (pt->space == SPACE_COIL) {
+    txn.fc = MODBUS_WRITE_SINGLE_COIL;
+    txn.qty = value != 0.0f ? 0xFF00 : 0x0000;
+  } else if (pt->space == SPACE_HOLDING && pt->type == VALUE_F32) {
+    uint32_t raw;
+    memcpy(&raw, &value, sizeof(raw));
+    txn.fc = MODBUS_WRITE_MULTIPLE_REGISTERS;
+    txn.qty = 2;
+    txn.values[0] = (uint16_t)(raw >> 16);
+    txn.values[1] = (uint16_t)(raw & 0xFFFF);
+  } else if (pt->space == SPACE_HOLDING) {
+    txn.fc = MODBUS_WRITE_SINGLE_REGISTER;
+    txn.qty = encodeControllerPoint(*pt, value);
+  } else {
+    return CONTROLLER_WRITE_UNSUPPORTED;
+  }
+  if (run(bus, s, txn) != MODBUS_OK) return CONTROLLER_WRITE_BUS;
+
+  // Commando's: geen read-back (alarm-bit = status, niet de reset; defrost-
+  // status kan pas later volgen). Cache ongeldig → volgende read van de bus.
+  if (id == POINT_ALARM || id == POINT_DEFROST) {
+    portENTER_CRITICAL(&s_mux);
+    s.valueMs[id] = 0;
+    portEXIT_CRITICAL(&s_mux);
+    return CONTROLLER_WRITE_OK;
+  }
+
+  // Parameters: teruglezen; de cache krijgt wat de regelaar effectief heeft.
+  float readBack;
+  bool match = false;
+  if (controllerReadPoint(bus, id, readBack, slot)) {
+    if (pt->type == VALUE_F32) {
+      match = memcmp(&readBack, &value, sizeof(float)) == 0;
+    } else {
+      match = encodeControllerPoint(*pt, readBack) == encodeControllerPoint(*pt, value);
+    }
+  }
+  if (match) return CONTROLLER_WRITE_OK;
+  portENTER_CRITICAL(&s_mux);
+  s.stats.verifyFailures++;
+  portEXIT_CRITICAL(&s_mux);
+  logger.warn(String("[CONTROLLER] slave ") + s.addr + " " + kPointKeys[id] + "=" + String(value) +
+              " niet bevestigd bij read-back");
+  return CONTROLLER_WRITE_UNVERIFIED;
+}
+
+const char* controllerWriteStatusName(ControllerWriteStatus st) {
+  switch (st) {
+    case CONTROLLER_WRITE_OK:          return "ok";
+    case CONTROLLER_WRITE_UNSUPPORTED: return "Punt niet ondersteund door regelaarprofiel";
+    case CONTROLLER_WRITE_BUS:         return "RS485 write failed";
+    case CONTROLLER_WRITE_UNVERIFIED:  return "RS485 write niet bevestigd (read-back)";
+    default:                           return "?";
+  }
+}
+
+void writeControllerValueJson(JsonDocument& result, const char* key, const ControllerValue& v) {
+  result[key] = v.value;
+  result["age_s"] = v.ageMs / 1000;
+  result["cached"] = v.cached;
+  if (v.stale) result["stale"] = true;
+}
+
+void writeControllersReadingJson(JsonDocument& doc, uint32_t maxAgeMs) {
+  JsonArray arr;
+  for (uint8_t slot = 0; slot < CONTROLLER_MAX_SLAVES; slot++) {
+    if (!s_slots[slot].addr) continue;
+    JsonObject o;
+    for (uint8_t id = 0; id < POINT_COUNT; id++) {
+      float v;
+      uint32_t age;
+      if (!controllerPointValue((ControllerPointId)id, v, &age, slot) || age > maxAgeMs) continue;
+      if (o.isNull()) {
+        if (arr.isNull()) arr = doc.createNestedArray("controllers");
+        o = arr.createNestedObject();
+        o["slave"] = s_slots[slot].addr;
+        o["profile"] = profileOf(s_slots[slot]).id;
+      }
+      o[kPointKeys[id]] = v;
+    }
+  }
+}
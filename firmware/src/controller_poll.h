@@ -0,0 +1,107 @@
+#ifndef CONTROLLER_POLL_H
+#define CONTROLLER_POLL_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "controller_profiles.h"
+
+class RS485Modbus;
+
+/**
+ * Runtime rond controller_profiles, per slave-slot: adres, actief profiel
+ * (uit controllerType), timeout, per punt de laatste poll en de gecachte
+ * waarden. Slot 0 is de regelaar uit de API-settings; extra slots komen uit
+ * config "modbus.slaves" (zie modbus_scheduler). modbus_scheduler roept
+ * controllerPollCycle() op; die plant enkel de punten die aan de beurt zijn
+ * en leest ze met zo weinig mogelijk Modbus-transacties.
+ */
+
+#define CONTROLLER_MAX_SLAVES 4
+
+/** Slot (her)configureren. slaveAddr 0 = slot vrij. Reset de cache bij wissel. */
+void controllerConfigureSlot(uint8_t slot, uint8_t slaveAddr, const String& controllerType,
+                             uint16_t timeoutMs = 0);
+
+uint8_t controllerSlotAddr(uint8_t slot);
+
+/** Slot van een slave-adres, of -1. */
+int controllerSlotForAddr(uint8_t slaveAddr);
+
+const ControllerProfile& activeControllerProfile(uint8_t slot = 0);
+
+/** Tellers per slot (monotoon; modbus_scheduler rekent de deltas). */
+struct ControllerSlotStats {
+  uint32_t transactions;
+  uint32_t failures;
+  uint64_t busUs;
+  uint32_t cacheHits;       // app-reads zonder bus-transactie
+  uint32_t cacheMisses;
+  uint32_t verifyFailures;  // write zonder bevestiging bij read-back
+};
+
+void controllerSlotStats(uint8_t slot, ControllerSlotStats& out);
+
+struct ControllerCycle {
+  int  transactions;    // gebruikte reads
+  int  ok;              // gelukte blokken
+  bool timedOut;        // slave antwoordde niet (rest van de cyclus overgeslagen)
+};
+
+/**
+ * Eén poll-cyclus voor een slot. minPeriodS = ondergrens voor elke
+ * poll-periode. Returnt false als er niets aan de beurt was.
+ */
+bool controllerPollCycle(RS485Modbus& bus, uint8_t slot, uint16_t minPeriodS, ControllerCycle& out);
+
+/** Gecachte waarde van de laatste poll; false als onbekend. */
+bool controllerPointValue(ControllerPointId id, float& out, uint32_t* ageMs = nullptr, uint8_t slot = 0);
+
+/** On-demand read van één punt van de bus (priority); werkt ook de cache bij. */
+bool controllerReadPoint(RS485Modbus& bus, ControllerPointId id, float& out, uint8_t slot = 0);
+
+/** Waarde + herkomst voor app-commando's. */
+struct ControllerValue {
+  float    value;
+  uint32_t ageMs;     // 0 = net van de bus gelezen
+  bool     cached;    // uit de cache (geen bus-transactie)
+  bool     stale;     // bus-read mislukt: laatst gekende waarde (≤ CONTROLLER_STALE_MAX_MS)
+};
+
+#define CONTROLLER_STALE_MAX_MS (10UL * 60UL * 1000UL)
+
+/**
+ * Cache-first read voor het command-pad: binnen de TTL van het punt (ttlS in
+ * het profiel) zonder bus-transactie; anders een priority-read. Mislukt die,
+ * dan de laatst gekende waarde met stale=true. forceBus slaat de cache over.
+ */
+bool controllerGetPoint(RS485Modbus& bus, ControllerPointId id, ControllerValue& out, uint8_t slot = 0,
+                        bool forceBus = false);
+
+enum ControllerWriteStatus : uint8_t {
+  CONTROLLER_WRITE_OK = 0,
+  CONTROLLER_WRITE_UNSUPPORTED,   // punt ontbreekt in het profiel of is niet schrijfbaar
+  CONTROLLER_WRITE_BUS,           // write zelf mislukt (timeout, exception, ...)
+  CONTROLLER_WRITE_UNVERIFIED,    // write OK, maar read-back geeft een andere waarde
+};
+
+/**
+ * Write-through: schrijft een punt volgens het profiel (coil of register, met
+ * schaal; priority), leest parameters (setpoint, power) terug ter controle en
+ * zet de bevestigde waarde in de cache. Commando-punten (defrost, alarm
+ * reset) worden niet teruggelezen: de regelaar voert ze uit en de status
+ * volgt bij de volgende poll.
+ */
+ControllerWriteStatus controllerWritePoint(RS485Modbus& bus, ControllerPointId id, float value, uint8_t slot = 0);
+
+const char* controllerWriteStatusName(ControllerWriteStatus st);
+
+/** Commando-resultaat: "<key>": waarde + age_s / cached / stale. */
+void writeControllerValueJson(JsonDocument& result, const char* key, const ControllerValue& v);
+
+/**
+ * Reading-payload: "controllers": [{slave, profile, temp, setpoint, ...}]
+ * met enkel verse waarden (≤ maxAgeMs), per slave getagd.
+ */
+void writeControllersReadingJson(JsonDocument& doc, uint32_t maxAgeMs);
+
+#endif /* CONTROLLER_POLL_H */
@@ -0,0 +1,166 @@
+#include "controller_profiles.h"
+#include <math.h>
+#include <string.h>
+
+namespace {
+
+// Adressen volgen de register-map die de command-handler in main.cpp al per
+// type gebruikte (temp/setpoint/defrost/alarm), aangevuld met de statusbits
+// die de achtergrond-poll nodig heeft. Afwijkende firmwareversies of modellen:
+// enkel deze tabellen aanpassen (of een nieuw profiel met een langere prefix).
+//
+// Kolommen: id, ruimte, adres, type, schaal, poll (s), cache-TTL (s), schrijfbaar.
+
+// Dixell XR60C/XR70C/XR110C: temperaturen int16 x10, status als coils.
+const ControllerPoint kDixellXr[] = {
+  { POINT_TEMP,       SPACE_HOLDING, 0x0000, VALUE_S16,  10,  10,  15, false },
+  { POINT_SETPOINT,   SPACE_HOLDING, 0x0001, VALUE_S16,  10, 300,  60, true  },
+  { POINT_COMPRESSOR, SPACE_COIL,    0x0000, VALUE_BOOL,  1,  10,  15, false },
+  { POINT_DEFROST,    SPACE_COIL,    0x0001, VALUE_BOOL,  1,  10,  15, true  },
+  { POINT_ALARM,      SPACE_COIL,    0x0003, VALUE_BOOL,  1,  10,  10, true  },
+  { POINT_POWER,      SPACE_HOLDING, 101,    VALUE_U16,   1,   0,   0, true  },
+};
+
+// Eliwell IC900/EWPC: registerblok vanaf 0x0100.
+const ControllerPoint kEliwell[] = {
+  { POINT_TEMP,       SPACE_HOLDING, 0x0100, VALUE_S16,  10,  10,  15, false },
+  { POINT_SETPOINT,   SPACE_HOLDING, 0x0101, VALUE_S16,  10, 300,  60, true  },
+  { POINT_DEFROST,    SPACE_COIL,    0x0000, VALUE_BOOL,  1,  10,  15, true  },
+  { POINT_ALARM,      SPACE_COIL,    0x0001, VALUE_BOOL,  1,  10,  10, true  },
+  { POINT_POWER,      SPACE_HOLDING, 101,    VALUE_U16,   1,   0,   0, true  },
+};
+
+// Carel IR33 (Modbus): analoge waarden 1..2, digitale 2..6 (Carel-telling).
+const ControllerPoint kCarelIr33[] = {
+  { POINT_SETPOINT,   SPACE_HOLDING, 1,      VALUE_S16,  10, 300,  60, true  },
+  { POINT_TEMP,       SPACE_HOLDING, 2,      VALUE_S16,  10,  10,  15, false },
+  { POINT_DEFROST,    SPACE_COIL,    2,      VALUE_BOOL,  1,  10,  15, true  },
+  { POINT_ALARM,      SPACE_COIL,    6,      VALUE_BOOL,  1,  10,  10, true  },
+  { POINT_POWER,      SPACE_HOLDING, 101,    VALUE_U16,   1,   0,   0, true  },
+};
+
+// Generiek: de vroegere vaste layout van modbusTask (holding 0..5, floats)
+// + defrost-register 6.
+const ControllerPoint kGeneric[] = {
+  { POINT_SETPOINT,   SPACE_HOLDING, 0,      VALUE_F32,   1,  30,  60, true  },
+  { POINT_TEMP,       SPACE_HOLDING, 2,      VALUE_F32,   1,  30,  30, false },
+  { POINT_COMPRESSOR, SPACE_HOLDING, 4,      VALUE_BOOL,  1,  30,  30, false },
+  { POINT_ALARM,      SPACE_HOLDING, 5,      VALUE_BOOL,  1,  30,  30, false },
+  { POINT_DEFROST,    SPACE_HOLDING, 6,      VALUE_U16,   1,   0,   0, true  },
+  { POINT_POWER,      SPACE_HOLDING, 101,    VALUE_U16,   1,   0,   0, true  },
+};
+
+#define PROFILE(id, name, table, gap) { id, name, table, (uint8_t)(sizeof(table) / sizeof(table[0])), gap }
+
+const ControllerProfile kProfiles[] = {
+  PROFILE("DIXELL_XR",  "Dixell XR",          kDixellXr,  4),
+  PROFILE("ELIWELL",    "Eliwell IC/EWPC",    kEliwell,   4),
+  PROFILE("CAREL_IR33", "Carel IR33 Modbus",  kCarelIr33, 4),
+};
+
+const ControllerProfile kGenericProfile = PROFILE("MODBUS_GENERIC", "Generiek (legacy layout)", kGeneric, 0);
+
+#undef PROFILE
+
+} // namespace
+
+const ControllerProfile& findControllerProfile(const char* controllerType) {
+  if (controllerType && controllerType[0]) {
+    for (const ControllerProfile& p : kProfiles) {
+      if (strncmp(controllerType, p.id, strlen(p.id)) == 0) return p;
+    }
+  }
+  return kGenericProfile;
+}
+
+const ControllerProfile& genericControllerProfile() {
+  return kGenericProfile;
+}
+
+const ControllerPoint* controllerProfilePoint(const ControllerProfile& p, ControllerPointId id, int* indexOut) {
+  for (uint8_t i = 0; i < p.count; i++) {
+    if (p.points[i].id == id) {
+      if (indexOut) *indexOut = i;
+      return &p.points[i];
+    }
+  }
+  return nullptr;
+}
+
+uint8_t controllerPointWidth(const ControllerPoint& pt) {
+  return pt.type == VALUE_F32 ? 2 : 1;
+}
+
+int planControllerPoll(const ControllerProfile& p, uint32_t dueMask, ControllerPollBlock* out, int maxBlocks) {
+  // Indices van de gevraagde punten, gesorteerd op (ruimte, adres).
+  uint8_t order[CONTROLLER_MAX_POINTS];
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < p.count && i < CONTROLLER_MAX_POINTS; i++) {
+    if (!(dueMask & (1UL << i))) continue;
+    const ControllerPoint& pi = p.points[i];
+    uint8_t j = n++;
+    while (j > 0) {
+      const ControllerPoint& pj = p.points[order[j - 1]];
+      if (pj.space < pi.space || (pj.space == pi.space && pj.addr <= pi.addr)) break;
+      order[j] = order[j - 1];
+      j--;
+    }
+    order[j] = i;
+  }
+
+  int blocks = 0;
+  for (uint8_t k = 0; k < n; k++) {
+    const uint8_t idx = order[k];
+    const ControllerPoint& pt = p.points[idx];
+    const uint32_t end = (uint32_t)pt.addr + controllerPointWidth(pt);
+    if (blocks > 0) {
+      ControllerPollBlock& b = out[blocks - 1];
+      const uint32_t bEnd = (uint32_t)b.start + b.count;
+      if (b.space == pt.space && pt.addr <= bEnd + p.maxGap && end - b.start <= CONTROLLER_BLOCK_MAX) {
+        if (end > bEnd) b.count = (uint16_t)(end - b.start);
+        b.pointMask |= 1UL << idx;
+        continue;
+      }
+    }
+    if (blocks >= maxBlocks) continue;  // past niet meer: volgende cyclus
+    ControllerPollBlock& b = out[blocks++];
+    b.space = pt.space;
+    b.start = pt.addr;
+    b.count = (uint16_t)(end - pt.addr);
+    b.pointMask = 1UL << idx;
+  }
+  return blocks;
+}
+
+float decodeControllerPoint(const ControllerPoint& pt, const ControllerPollBlock& block, const uint16_t* regs) {
+  const uint16_t off = pt.addr - block.start;
+  const uint8_t div = pt.scaleDiv ? pt.scaleDiv : 1;
+  switch (pt.type) {
+    case VALUE_S16:
+      return (float)(int16_t)regs[off] / div;
+    case VALUE_U16:
+      return (float)regs[off] / div;
+    case VALUE_F32: {
+      const uint32_t raw = ((uint32_t)regs[off] << 16) | regs[off + 1];
+      float f;
+      memcpy(&f, &raw, sizeof(f));
+      return f;
+    }
+    case VALUE_BOOL:
+    default:
+      return regs[off] != 0 ? 1.0f : 0.0f;
+  }
+}
+
+uint16_t encodeControllerPoint(const ControllerPoint& pt, float value) {
+  const uint8_t div = pt.scaleDiv ? pt.scaleDiv : 1;
+  switch (pt.type) {
+    case VALUE_S16:
+      return (uint16_t)(int16_t)lroundf(value * div);
+    case VALUE_U16:
+      return (uint16_t)lroundf(value * div);
+    case VALUE_BOOL:
+    default:
+      return value != 0.0f ? 1 : 0;
+  }
+}
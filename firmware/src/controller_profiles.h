@@ -0,0 +1,105 @@
+#ifndef CONTROLLER_PROFILES_H
+#define CONTROLLER_PROFILES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Declaratieve register-maps per regelaartype (Modbus RTU). Een profiel is
+ * een tabel van punten (adres, registerruimte, type, schaal, poll-periode);
+ * een nieuwe regelaar toevoegen is enkel een tabel in controller_profiles.cpp.
+ *
+ * planControllerPoll() voegt alle punten die aan de beurt zijn samen tot zo
+ * weinig mogelijk multi-register reads: aangrenzende (of tot maxGap adressen
+ * uit elkaar liggende) punten in dezelfde registerruimte gaan in één request.
+ * Elke extra transactie kost ~t3.5 + request + turnaround; een paar
+ * tussenliggende registers meelezen is goedkoper.
+ *
+ * Geen Arduino-afhankelijkheden: planner en decoder zijn host-testbaar.
+ */
+
+enum ControllerPointId : uint8_t {
+  POINT_TEMP = 0,       // celtemperatuur (°C)
+  POINT_SETPOINT,       // °C, schrijfbaar
+  POINT_EVAP_TEMP,      // verdampertemperatuur (°C)
+  POINT_COMPRESSOR,     // 0/1
+  POINT_DEFROST,        // 0/1, schrijfbaar (start/stop)
+  POINT_ALARM,          // 0/1; schrijven = alarm reset
+  POINT_POWER,          // 0/1, schrijfbaar (regelaar aan/uit)
+  POINT_COUNT
+};
+
+enum ControllerSpace : uint8_t {
+  SPACE_HOLDING = 0,    // FC03 / FC06 / FC16
+  SPACE_INPUT,          // FC04
+  SPACE_COIL,           // FC01 / FC05
+  SPACE_DISCRETE,       // FC02
+};
+
+enum ControllerValueType : uint8_t {
+  VALUE_S16 = 0,        // int16 / scaleDiv
+  VALUE_U16,            // uint16 / scaleDiv
+  VALUE_F32,            // IEEE 754, 2 registers, hoog woord eerst
+  VALUE_BOOL,           // coil/discrete-bit, of register != 0
+};
+
+struct ControllerPoint {
+  ControllerPointId   id;
+  ControllerSpace     space;
+  uint16_t            addr;
+  ControllerValueType type;
+  uint8_t             scaleDiv;   // 1, 10, 100 (enkel S16/U16)
+  uint16_t            pollS;      // 0 = niet pollen (enkel on-demand/schrijven)
+  uint16_t            ttlS;       // app-reads uit de cache zolang jonger; 0 = altijd van de bus
+  bool                writable;
+};
+
+struct ControllerProfile {
+  const char*            id;        // prefix van controllerType uit de API
+  const char*            name;
+  const ControllerPoint* points;
+  uint8_t                count;
+  uint8_t                maxGap;    // max ongebruikte adressen tussen punten in één read (0 = enkel aangrenzend)
+};
+
+struct ControllerPollBlock {
+  ControllerSpace space;
+  uint16_t        start;
+  uint16_t        count;            // registers of bits
+  uint32_t        pointMask;        // bit i = profile.points[i] zit in dit blok
+};
+
+#define CONTROLLER_MAX_POINTS   32   // pointMask is 32-bit
+#define CONTROLLER_BLOCK_MAX    64   // registers/bits per read (= MODBUS_TXN_MAX_REGS)
+#define CONTROLLER_MAX_BLOCKS   8
+
+/**
+ * Profiel voor een controllerType uit de API (bv. "DIXELL_XR60C"). Onbekend
+ * of leeg → het generieke profiel (oude vaste layout, holding 0..6).
+ */
+const ControllerProfile& findControllerProfile(const char* controllerType);
+
+/** Het generieke (legacy) profiel. */
+const ControllerProfile& genericControllerProfile();
+
+/** Punt met dit id in het profiel, of nullptr. */
+const ControllerPoint* controllerProfilePoint(const ControllerProfile& p, ControllerPointId id,
+                                              int* indexOut = nullptr);
+
+/** Aantal registers/bits dat een punt inneemt. */
+uint8_t controllerPointWidth(const ControllerPoint& pt);
+
+/**
+ * Plant de reads voor de punten in dueMask (bit i = points[i]). Returnt het
+ * aantal blokken in out (max maxBlocks); punten die niet meer passen blijven
+ * voor de volgende cyclus.
+ */
+int planControllerPoll(const ControllerProfile& p, uint32_t dueMask, ControllerPollBlock* out, int maxBlocks);
+
+/** Waarde van een punt uit de gelezen data van zijn blok (regs[0] = block.start). */
+float decodeControllerPoint(const ControllerPoint& pt, const ControllerPollBlock& block, const uint16_t* regs);
+
+/** Ruwe registerwaarde voor schrijven (S16/U16 met schaal; BOOL → 0/1). */
+uint16_t encodeControllerPoint(const ControllerPoint& pt, float value);
+
+#endif /* CONTROLLER_PROFILES_H */
@@ -0,0 +1,206 @@
+#include "crash_log.h"
+#include <esp_system.h>
+#include <esp_heap_caps.h>
+#include <base64.h>
+
+namespace {
+
+constexpr uint32_t kCrashLogMagic = 0xC4A5410C;
+
+struct CrashLogRtc {
+  uint32_t magic;
+  uint32_t magicInv;    // ~magic: willekeurige RAM na power-on valt hier door de mand
+  uint32_t boot;        // boots sinds de ring laatst geldig begon
+  uint32_t head;        // totaal geschreven bytes (index = head % CRASH_LOG_BYTES)
+  char     data[CRASH_LOG_BYTES];
+};
+
+RTC_NOINIT_ATTR CrashLogRtc s_rtc;
+
+char*    s_prev = nullptr;      // tekst van de vorige boot (contigu, oudste eerst)
+size_t   s_prevBytes = 0;
+uint32_t s_prevBoot = 0;
+esp_reset_reason_t s_prevReset = ESP_RST_UNKNOWN;
+
+const char* resetName(esp_reset_reason_t r) {
+  switch (r) {
+    case ESP_RST_POWERON: return "POWERON";
+    case ESP_RST_EXT: return "EXT";
+    case ESP_RST_SW: return "SW";
+    case ESP_RST_PANIC: return "PANIC";
+    case ESP_RST_INT_WDT: return "INT_WDT";
+    case ESP_RST_TASK_WDT: return "TASK_WDT";
+    case ESP_RST_WDT: return "WDT";
+    case ESP_RST_DEEPSLEEP: return "DEEPSLEEP";
+    case ESP_RST_BROWNOUT: return "BROWNOUT";
+    case ESP_RST_SDIO: return "SDIO";
+    default: return "UNKNOWN";
+  }
+}
+
+void* allocLarge(size_t n) {
+  void* p = heap_caps_malloc(n, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  return p ? p : malloc(n);
+}
+
+// Ring → contigu (oudste eerst). Na een wrap begint de buffer midden in een
+// regel: die onvolledige regel valt weg.
+size_t copyRing(uint32_t head, char* out) {
+  if (head <= CRASH_LOG_BYTES) {
+    memcpy(out, s_rtc.data, head);
+    return head;
+  }
+  const size_t start = head % CRASH_LOG_BYTES;
+  memcpy(out, s_rtc.data + start, CRASH_LOG_BYTES - start);
+  memcpy(out + (CRASH_LOG_BYTES - start), s_rtc.data, start);
+  size_t skip = 0;
+  while (skip < CRASH_LOG_BYTES && out[skip] != '\n') skip++;
+  skip = skip < CRASH_LOG_BYTES ? skip + 1 : 0;
+  memmove(out, out + skip, CRASH_LOG_BYTES - skip);
+  return CRASH_LOG_BYTES - skip;
+}
+
+/*
+ * LZSS: per 8 items één vlagbyte (bit i = 1 → match). Match = 2 bytes,
+ * offset-1 (12 bit) | lengte-3 (4 bit): 3..18 bytes tot 4 KB terug.
+ * Eén kandidaat per hash; logtekst (vaste prefixes) haalt zo 2–4x.
+ */
+constexpr size_t   kLzHashSize = 512;
+constexpr uint16_t kLzNone = 0xFFFF;
+uint16_t s_lzHead[kLzHashSize];   // LOG_UPLOAD in het heartbeat-pad (setup/loop), onder httpMutex
+
+inline uint16_t lzHash(const uint8_t* p) {
+  return (uint16_t)(((p[0] << 6) ^ (p[1] << 3) ^ p[2]) & (kLzHashSize - 1));
+}
+
+size_t lzssCompress(const uint8_t* in, size_t n, uint8_t* out) {
+  for (size_t k = 0; k < kLzHashSize; k++) s_lzHead[k] = kLzNone;
+  size_t o = 0;
+  size_t i = 0;
+  while (i < n) {
+    const size_t flagPos = o++;
+    uint8_t flags = 0;
+    for (uint8_t bit = 0; bit < 8 && i < n; bit++) {
+      size_t bestLen = 0;
+      size_t bestOff = 0;
+      if (i + 3 <= n) {
+        const uint16_t h = lzHash(in + i);
+        const uint16_t cand = s_lzHead[h];
+        s_lzHead[h] = (uint16_t)i;
+        if (cand != kLzNone && i - cand <= 4096) {
+          const size_t maxLen = (n - i) < 18 ? (n - i) : 18;
+          size_t len = 0;
+          while (len < maxLen && in[cand + len] == in[i + len]) len++;
+          if (len >= 3) {
+            bestLen = len;
+            bestOff = i - cand;
+          }
+        }
+      }
+      if (bestLen) {
+        flags |= (uint8_t)(1 << bit);
+        out[o++] = (uint8_t)((bestOff - 1) >> 4);
+        out[o++] = (uint8_t)((((bestOff - 1) & 0xF) << 4) | (bestLen - 3));
+        for (size_t k = 1; k < bestLen && i + k + 3 <= n; k++) s_lzHead[lzHash(in + i + k)] = (uint16_t)(i + k);
+        i += bestLen;
+      } else {
+        out[o++] = in[i++];
+      }
+    }
+    out[flagPos] = flags;
+  }
+  return o;
+}
+
+} // namespace
+
+void crashLogBegin() {
+  s_prevReset = esp_reset_reason();
+  const bool valid = s_rtc.magic == kCrashLogMagic && s_rtc.magicInv == ~kCrashLogMagic;
+  if (valid && s_rtc.head > 0 && !s_prev) {
+    s_prev = (char*)allocLarge(CRASH_LOG_BYTES);
+    if (s_prev) {
+      s_prevBytes = copyRing(s_rtc.head, s_prev);
+      s_prevBoot = s_rtc.boot;
+    }
+  }
+  s_rtc.boot = valid ? s_rtc.boot + 1 : 1;
+  s_rtc.head = 0;
+  s_rtc.magic = kCrashLogMagic;
+  s_rtc.magicInv = ~kCrashLogMagic;
+
+  char marker[64];
+  const int n = snprintf(marker, sizeof(marker), "=== boot %lu, reset %s ===\n",
+                         (unsigned long)s_rtc.boot, resetName(s_prevReset));
+  crashLogAppend(marker, (size_t)n);
+}
+
+void crashLogAppend(const char* data, size_t len) {
+  if (s_rtc.magic != kCrashLogMagic) return;  // vóór crashLogBegin()
+  if (len > CRASH_LOG_BYTES) {
+    data += len - CRASH_LOG_BYTES;
+    len = CRASH_LOG_BYTES;
+  }
+  const uint32_t head = s_rtc.head;
+  const size_t pos = head % CRASH_LOG_BYTES;
+  const size_t first = len < CRASH_LOG_BYTES - pos ? len : CRASH_LOG_BYTES - pos;
+  memcpy(s_rtc.data + pos, data, first);
+  memcpy(s_rtc.data, data + first, len - first);
+  // Na een wrap blijft head boven CRASH_LOG_BYTES (copyRing weet zo dat de
+  // ring vol is); nooit terug naar 0 laten lopen.
+  const uint32_t next = head + (uint32_t)len;
+  s_rtc.head = next >= head ? next : CRASH_LOG_BYTES + (next % CRASH_LOG_BYTES);
+}
+
+bool crashLogUploadJson(bool previous, String& out) {
+  const char* text = nullptr;
+  size_t len = 0;
+  char* current = nullptr;
+  if (previous) {
+    text = s_prev;
+    len = s_prevBytes;
+  } else {
+    // Drain-taak schrijft intussen verder: een afgescheurde laatste regel is
+    // hier aanvaardbaar.
+    current = (char*)allocLarge(CRASH_LOG_BYTES);
+    if (current) {
+      len = copyRing(s_rtc.head, current);
+      text = current;
+    }
+  }
+  if (!text || len == 0) {
+    free(current);
+    out = previous ? "{\"error\":\"no previous log\"}" : "{\"error\":\"out of memory\"}";
+    return false;
+  }
+
+  uint8_t* packed = (uint8_t*)allocLarge(len + len / 8 + 1);
+  if (!packed) {
+    free(current);
+    out = "{\"error\":\"out of memory\"}";
+    return false;
+  }
+  const size_t packedLen = lzssCompress((const uint8_t*)text, len, packed);
+  free(current);
+
+  char head[160];
+  snprintf(head, sizeof(head),
+           "{\"which\":\"%s\",\"boot\":%lu,\"reset\":\"%s\",\"raw_bytes\":%u,\"encoding\":\"lzss-base64\",\"data\":\"",
+           previous ? "previous" : "current", (unsigned long)(previous ? s_prevBoot : s_rtc.boot),
+           previous ? resetName(s_prevReset) : "", (unsigned)len);
+  const String b64 = base64::encode(packed, packedLen);
+  free(packed);
+  out = "";
+  out.reserve(strlen(head) + b64.length() + 4);
+  out += head;
+  out += b64;
+  out += "\"}";
+  return true;
+}
+
+void writeCrashLogJson(JsonDocument& doc) {
+  JsonObject o = doc.createNestedObject("crash_log");
+  o["boot"] = s_rtc.boot;
+  o["prev_bytes"] = (uint32_t)s_prevBytes;
+  o["prev_reset"] = resetName(s_prevReset);
+}
@@ -0,0 +1,40 @@
+#ifndef CRASH_LOG_H
+#define CRASH_LOG_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/**
+ * Crash-log: de laatste CRASH_LOG_BYTES logregels (zoals de drain-taak ze
+ * naar Serial schrijft) in een ring in RTC_NOINIT-geheugen. Overleeft
+ * software-, panic- en watchdog-resets; na een EN-reset (TPL5010) meestal
+ * ook, de magic beslist. Na power-on/brownout is de ring leeg.
+ *
+ * Bij boot zet crashLogBegin() de ring van de vorige boot apart (heap,
+ * PSRAM indien aanwezig) en begint een nieuwe. Schrijven gebeurt enkel door
+ * de log-drain-taak, per geschreven regel één memcpy (geen lock, geen
+ * formattering op het producer-pad).
+ *
+ * Remote command LOG_UPLOAD ({ which: "previous" | "current" }) stuurt de
+ * ring LZSS-gecomprimeerd + base64 mee in het resultaat; decoderen met
+ * scripts/crash_log_decode.py.
+ */
+
+#define CRASH_LOG_BYTES  4096   // RTC slow memory (8 KB op de S3, ook door door_events gebruikt)
+
+/** setup(), vóór logger.begin(): vorige ring veiligstellen, nieuwe starten. */
+void crashLogBegin();
+
+/** Drain-taak: geschreven logregel(s) toevoegen. */
+void crashLogAppend(const char* data, size_t len);
+
+/**
+ * LOG_UPLOAD-resultaat: {which, boot, reset, raw_bytes, encoding, data}.
+ * Returns false als er niets te sturen is (out bevat dan {"error":..}).
+ */
+bool crashLogUploadJson(bool previous, String& out);
+
+/** Heartbeat: crash_log {boot, prev_bytes, prev_reset}. */
+void writeCrashLogJson(JsonDocument& doc);
+
+#endif
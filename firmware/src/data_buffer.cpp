@@ -36,6 +36,7 @@ bool DataBuffer::init() {
   if (count > BUFFER_RECOVERY_THRESHOLD || freeEntries < BUFFER_NVS_FREE_MIN) {
     logger.warn(String("Data buffer: recovery-clear (count=") + count +
                 ", nvs_free_entries=" + freeEntries + ")");
+    recoveryCleared = count;
     clear();
   }
 
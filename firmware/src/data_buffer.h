@@ -34,6 +34,10 @@ public:
   void clear();
   bool isFull();
   bool isEmpty();
+
+  // Aantal readings dat init() door de recovery-clear weggooide (0 = geen).
+  // main() legt dit vast in het HACCP-log zodat het verlies aantoonbaar is.
+  int recoveryCleared = 0;
 };
 
 #endif
@@ -0,0 +1,203 @@
+#include "door_analytics.h"
+#include "door_events.h"
+#include "time_utils.h"
+#include "logger.h"
+#include <freertos/FreeRTOS.h>
+
+extern Logger logger;
+extern DoorEventManager doorEventManager;
+
+namespace {
+
+struct DoorIntervalRecord {
+  uint32_t startUnixS;   // 0 als de klok nog niet gesynct was
+  uint32_t durationS;
+  uint16_t opens;
+  uint32_t openS;
+  uint32_t longestS;
+  uint32_t openWhileCompS;
+  uint32_t droppedEvents;  // door rate-limit/volle queue gedropte events
+};
+
+portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Lopend interval (alles in millis()).
+uint32_t s_intervalStartMs = 0;
+uint64_t s_intervalStartUnixMs = 0;
+uint16_t s_opens = 0;
+uint32_t s_openMs = 0;
+uint32_t s_longestMs = 0;
+uint32_t s_openCompMs = 0;
+uint32_t s_droppedAtStart = 0;
+
+bool     s_open = false;
+uint32_t s_openSinceMs = 0;   // begin van de huidige open-periode
+uint32_t s_segStartMs = 0;    // begin van het nog niet opgetelde stuk
+bool     s_compRunning = false;
+
+uint32_t s_ajarDelayMs = DOOR_AJAR_DEFAULT_DELAY_S * 1000UL;
+bool     s_ajar = false;
+
+DoorIntervalRecord s_records[DOOR_ANALYTICS_RECORDS];
+int s_recordCount = 0;
+bool s_backendStores = false;  // backend bevestigde ooit door_stats_stored
+
+// Open-tijd sinds s_segStartMs optellen tot t. Onder s_mux.
+void accumulate(uint32_t t) {
+  if (!s_open) return;
+  const uint32_t d = t - s_segStartMs;
+  s_openMs += d;
+  if (s_compRunning) s_openCompMs += d;
+  s_segStartMs = t;
+}
+
+uint32_t droppedTotal() {
+  return doorEventManager.droppedRate() + doorEventManager.droppedFull();
+}
+
+} // namespace
+
+void initDoorAnalytics(bool doorOpen) {
+  const uint32_t now = millis();
+  portENTER_CRITICAL(&s_mux);
+  s_intervalStartMs = now;
+  s_open = doorOpen;
+  s_openSinceMs = doorOpen ? now : 0;
+  s_segStartMs = now;
+  portEXIT_CRITICAL(&s_mux);
+  s_intervalStartUnixMs = getUnixTimeMs();
+  s_droppedAtStart = droppedTotal();
+}
+
+void doorAnalyticsOnChange(bool open, uint32_t tMs) {
+  portENTER_CRITICAL(&s_mux);
+  if (open && !s_open) {
+    s_open = true;
+    s_opens++;
+    s_openSinceMs = tMs;
+    s_segStartMs = tMs;
+  } else if (!open && s_open) {
+    accumulate(tMs);
+    const uint32_t dur = tMs - s_openSinceMs;
+    if (dur > s_longestMs) s_longestMs = dur;
+    s_open = false;
+    s_openSinceMs = 0;
+  }
+  portEXIT_CRITICAL(&s_mux);
+}
+
+void doorAnalyticsSetCompressor(bool running) {
+  const uint32_t now = millis();
+  portENTER_CRITICAL(&s_mux);
+  if (running != s_compRunning) {
+    accumulate(now);
+    s_compRunning = running;
+  }
+  portEXIT_CRITICAL(&s_mux);
+}
+
+void doorAnalyticsSetAjarDelay(int delaySec) {
+  s_ajarDelayMs = delaySec > 0 ? (uint32_t)delaySec * 1000UL : 0;
+}
+
+void doorAnalyticsService() {
+  const uint32_t now = millis();
+
+  // Lokaal deur-open-alarm (enkel logging; doorAjar() rekent live).
+  const bool ajar = doorAjar();
+  if (ajar != s_ajar) {
+    s_ajar = ajar;
+    if (ajar) {
+      logger.warn("[DOOR] deur staat langer dan " + String(s_ajarDelayMs / 1000) + "s open (alarm)");
+    } else {
+      logger.info("[DOOR] deur-alarm opgeheven");
+    }
+  }
+
+  if ((now - s_intervalStartMs) < DOOR_ANALYTICS_INTERVAL_MS) return;
+
+  DoorIntervalRecord rec;
+  portENTER_CRITICAL(&s_mux);
+  accumulate(now);
+  // Lopende open-periode telt mee als kandidaat voor "langste".
+  uint32_t longest = s_longestMs;
+  if (s_open && (now - s_openSinceMs) > longest) longest = now - s_openSinceMs;
+  rec.durationS = (now - s_intervalStartMs) / 1000;
+  rec.opens = s_opens;
+  rec.openS = s_openMs / 1000;
+  rec.longestS = longest / 1000;
+  rec.openWhileCompS = s_openCompMs / 1000;
+  s_opens = 0;
+  s_openMs = 0;
+  s_longestMs = 0;
+  s_openCompMs = 0;
+  s_intervalStartMs = now;
+  portEXIT_CRITICAL(&s_mux);
+
+  const uint32_t dropped = droppedTotal();
+  rec.startUnixS = (uint32_t)(s_intervalStartUnixMs / 1000);
+  rec.droppedEvents = dropped - s_droppedAtStart;
+  s_droppedAtStart = dropped;
+  s_intervalStartUnixMs = getUnixTimeMs();
+
+  // Vol: oudste record valt weg (heartbeat is al lang niet gelukt).
+  if (s_recordCount == DOOR_ANALYTICS_RECORDS) {
+    memmove(&s_records[0], &s_records[1], sizeof(DoorIntervalRecord) * (DOOR_ANALYTICS_RECORDS - 1));
+    s_recordCount--;
+  }
+  s_records[s_recordCount++] = rec;
+}
+
+bool doorAjar() {
+  // Live berekend (niet via doorAnalyticsService), zodat de alarm-engine in
+  // sensorTask niet afhangt van hoe snel loop() rondgaat.
+  const uint32_t now = millis();
+  portENTER_CRITICAL(&s_mux);
+  const bool ajar = s_open && s_ajarDelayMs > 0 && (now - s_openSinceMs) >= s_ajarDelayMs;
+  portEXIT_CRITICAL(&s_mux);
+  return ajar;
+}
+
+int writeDoorAnalyticsJson(JsonDocument& doc) {
+  doc["door_ajar"] = doorAjar();
+  if (s_recordCount == 0) return 0;
+  JsonArray arr = doc.createNestedArray("door_stats");
+  // Enkel volledig geserialiseerde rijen tellen: bij een volle doc blijven
+  // de rest liggen voor de volgende heartbeat (ack gebruikt deze telling).
+  int sent = 0;
+  for (int i = 0; i < s_recordCount; i++) {
+    const DoorIntervalRecord& r = s_records[i];
+    JsonArray row = arr.createNestedArray();
+    row.add(r.startUnixS);
+    row.add(r.durationS);
+    row.add(r.opens);
+    row.add(r.openS);
+    row.add(r.longestS);
+    row.add(r.openWhileCompS);
+    row.add(r.droppedEvents);
+    if (row.size() != 7) {
+      arr.remove(arr.size() - 1);  // afgekapte rij niet versturen
+      break;
+    }
+    sent++;
+  }
+  return sent;
+}
+
+void doorAnalyticsBackendConfirmed() {
+  s_backendStores = true;
+}
+
+bool doorAnalyticsBackendStores() {
+  return s_backendStores;
+}
+
+void doorAnalyticsAck(int n) {
+  if (n <= 0) return;
+  if (n >= s_recordCount) {
+    s_recordCount = 0;
+    return;
+  }
+  memmove(&s_records[0], &s_records[n], sizeof(DoorIntervalRecord) * (s_recordCount - n));
+  s_recordCount -= n;
+}
@@ -0,0 +1,64 @@
+#ifndef DOOR_ANALYTICS_H
+#define DOOR_ANALYTICS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/**
+ * Deur-analytics op het toestel. Per interval (DOOR_ANALYTICS_INTERVAL_MS):
+ * aantal openingen, totale en langste open-duur en open-tijd terwijl de
+ * compressor draaide. Gevoed vanuit DoorEventManager::completePending() in
+ * loop(), voor elk event in de queue; events die de rate-limit of een volle
+ * queue droppen, staan enkel in "dropped".
+ *
+ * Afgesloten intervallen gaan als compacte records mee in de heartbeat
+ * ("door_stats": [[startUnixS, durS, opens, openS, longestS, compS, dropped], ...])
+ * en worden pas gewist als de backend ze als opgeslagen bevestigt
+ * (DoorStatsInterval + DoorStatsDaily). Vanaf dan voegt loop() bij drukte
+ * losse deur-events samen (DOOR_UPLOAD_COALESCE_MIN).
+ *
+ * Ook lokaal deur-open-alarm: open langer dan deviceDoorAlarmDelaySec →
+ * doorAjar() true (zonder cloud).
+ */
+
+#define DOOR_ANALYTICS_INTERVAL_MS  (5UL * 60UL * 1000UL)
+#define DOOR_ANALYTICS_RECORDS      8
+#define DOOR_AJAR_DEFAULT_DELAY_S   300
+// Vanaf zoveel events in de queue enkel de nieuwste uploaden.
+#define DOOR_UPLOAD_COALESCE_MIN    4
+
+/** Begintoestand (deur open/dicht bij boot). */
+void initDoorAnalytics(bool doorOpen);
+
+/** Vanuit DoorEventManager bij elke gedebouncede wissel (tMs = millis() van de flank). */
+void doorAnalyticsOnChange(bool open, uint32_t tMs);
+
+/** Compressorstatus (Modbus/Carel). Onbekend = niet meegeteld. */
+void doorAnalyticsSetCompressor(bool running);
+
+/** Deur-alarmvertraging uit de device-settings (seconden, 0 = uit). */
+void doorAnalyticsSetAjarDelay(int delaySec);
+
+/** Periodiek (loop): interval afsluiten + ajar-detectie. */
+void doorAnalyticsService();
+
+/** True zolang de deur langer open staat dan de alarmvertraging. */
+bool doorAjar();
+
+/** Heartbeat: "door_stats" (afgesloten records) + "door_ajar". Returnt aantal volledig geserialiseerde records. */
+int writeDoorAnalyticsJson(JsonDocument& doc);
+
+/**
+ * Na de heartbeat-response: de eerste n records wissen, n = wat de backend
+ * als opgeslagen bevestigt ("door_stats_stored", begrensd op wat mee was).
+ */
+void doorAnalyticsAck(int n);
+
+/**
+ * Backend meldt door_stats_stored: records worden bewaard, dus losse
+ * deur-events mogen bij drukte samengevoegd worden (zie loop()).
+ */
+void doorAnalyticsBackendConfirmed();
+bool doorAnalyticsBackendStores();
+
+#endif /* DOOR_ANALYTICS_H */
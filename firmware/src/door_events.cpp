@@ -1,109 +1,415 @@
 #include "door_events.h"
+#include "time_utils.h"
+#include "door_analytics.h"
+#include <WiFi.h>
+#include <Preferences.h>
+#include <esp_system.h>
+
+namespace {
+
+/*
+ * Event-ring in RTC slow memory (niet geïnitialiseerd bij reset). Geldig als
+ * magic/~magic, versie en grootte kloppen én de reset warm was (SW, panic,
+ * WDT, deep sleep); na power-on of brownout is de inhoud willekeurig en
+ * herstellen we uit NVS. Een OTA met een andere layout (DoorEvent, queue-
+ * grootte) geeft een andere size: dan ook uit NVS. Layout wijzigen zonder
+ * dat de grootte verandert → kRtcLogVersion ophogen.
+ */
+constexpr uint32_t kRtcLogMagic = 0xD0051065;
+constexpr uint16_t kRtcLogVersion = 1;
+
+struct DoorRtcLog {
+  uint32_t magic;
+  uint32_t magicInv;     // ~magic
+  uint16_t version;      // kRtcLogVersion
+  uint16_t size;         // sizeof(DoorRtcLog)
+  std::atomic<uint32_t> head;
+  std::atomic<uint32_t> tail;
+  uint32_t lastSeq;
+  bool lastOpen;
+  DoorEvent events[DOOR_EVENT_QUEUE_SIZE];
+};
+
+RTC_NOINIT_ATTR DoorRtcLog s_log;
+static_assert(sizeof(DoorRtcLog) <= 0xFFFF, "DoorRtcLog.size is 16-bit");
+
+const char* const kLogNamespace = "doorlog";
+const char* const kKeyEvents    = "ev";      // blob: DoorEvent[n], oudste eerst
+const char* const kKeySeqEnd    = "seqEnd";  // u32: eerste niet-gereserveerde seq
+const char* const kKeyOpen      = "open";    // bool: laatst gepubliceerde toestand
+
+// Scratch voor NVS-blob (loop-taak; niet op de stack).
+DoorEvent s_flushBuf[DOOR_EVENT_QUEUE_SIZE];
+
+bool rtcLogValid() {
+  return s_log.magic == kRtcLogMagic && s_log.magicInv == ~kRtcLogMagic && s_log.version == kRtcLogVersion &&
+         s_log.size == sizeof(DoorRtcLog);
+}
+
+bool warmReset() {
+  switch (esp_reset_reason()) {
+    case ESP_RST_SW:
+    case ESP_RST_PANIC:
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:
+    case ESP_RST_DEEPSLEEP:
+      return true;
+    default:
+      return false;
+  }
+}
+
+} // namespace
 
 DoorEventManager::DoorEventManager()
-  : queueMutex(xSemaphoreCreateMutex()),
-    lastStableTime(0),
-    lastStableState(false),
-    lastReportedState(false),
-    queueHead(0),
-    queueTail(0),
-    queueCount(0),
-    seqCounter(0),
+  : debounceTimer(nullptr),
+    doorPin(0),
+    doorInverted(false),
+    stateMux(portMUX_INITIALIZER_UNLOCKED),
+    state{false, 0, 0, 0, 0},
+    burstActive(false),
+    burstStartUs(0),
+    burstEdges(0),
+    lastEdges(0),
+    queueHighWater(0),
+    dropFull(0),
+    dropRate(0),
     lastEventMs(0),
-    eventsThisSecond(0) {
+    eventsThisSecond(0),
+    flushedTail(0),
+    nvsEventCount(0),
+    unflushedSinceMs(0),
+    lastFlushMs(0),
+    seqReservedEnd(0),
+    replayed(0),
+    replayFrom("none") {
 }
 
-void DoorEventManager::setInitialState(bool currentDoorOpen) {
-  lastStableState = currentDoorOpen;
-  lastReportedState = currentDoorOpen;
-  lastStableTime = millis();
+bool DoorEventManager::readOpen() const {
+  // INPUT_PULLUP + contact naar GND → LOW = dicht, HIGH = open (tenzij inverted).
+  bool pinHigh = (digitalRead(doorPin) == HIGH);
+  return doorInverted ? !pinHigh : pinHigh;
 }
 
-bool DoorEventManager::poll(bool currentDoorOpen) {
-  unsigned long now = millis();
-  
-  // Debounce: state must be stable for DOOR_DEBOUNCE_MS
-  if (currentDoorOpen != lastStableState) {
-    lastStableTime = now;
-    lastStableState = currentDoorOpen;
-    return false;
+bool DoorEventManager::begin(uint8_t pin, bool inverted) {
+  doorPin = pin;
+  doorInverted = inverted;
+  pinMode(doorPin, INPUT_PULLUP);
+  delay(5);
+
+  restoreLog();
+  {
+    const bool open = readOpen();
+    const uint32_t now = millis();
+    portENTER_CRITICAL(&stateMux);
+    state.open = open;
+    state.seq = s_log.lastSeq;
+    state.lastChangeMs = now;
+    state.openedAtMs = open ? now : 0;
+    portEXIT_CRITICAL(&stateMux);
+
+    // Deur gewisseld terwijl we uit/in reset waren: dat event is niet
+    // waargenomen maar hoort wel in de HACCP-log. Tijdstip = nu (bovengrens).
+    if (strcmp(replayFrom, "none") != 0 && open != s_log.lastOpen) {
+      const uint64_t unixMs = getUnixTimeMs();
+      DoorEvent ev;
+      ev.isOpen = open;
+      ev.uptimeMs = now;
+      ev.timestamp = unixMs ? unixMs : (uint64_t)now;
+      ev.seq = ++state.seq;
+      ev.rssi = 0;
+      s_log.lastSeq = ev.seq;
+      s_log.lastOpen = open;
+      enqueue(ev);
+    }
+    s_log.lastOpen = open;
+    initDoorAnalytics(open);
   }
-  
-  if (now - lastStableTime < DOOR_DEBOUNCE_MS) {
-    return false;
+  reserveSeqBlock(state.seq);
+
+  if (!debounceTimer) {
+    esp_timer_create_args_t args = {};
+    args.callback = &DoorEventManager::onDebounceTimer;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "door_debounce";
+    if (esp_timer_create(&args, &debounceTimer) != ESP_OK) {
+      debounceTimer = nullptr;
+      return false;
+    }
   }
-  
-  // State stable and different from last reported
-  if (currentDoorOpen != lastReportedState) {
-    lastReportedState = currentDoorOpen;
-    return true;
+  attachInterruptArg(digitalPinToInterrupt(doorPin), &DoorEventManager::onEdgeIsr, this, CHANGE);
+  return true;
+}
+
+void DoorEventManager::restoreLog() {
+  const uint32_t depth = s_log.tail.load() - s_log.head.load();
+  if (warmReset() && rtcLogValid() && depth <= DOOR_EVENT_QUEUE_SIZE) {
+    // Ring staat nog intact in RTC; NVS kan achterlopen → bij eerste persist()
+    // alles wat nog in de ring zit opnieuw wegschrijven.
+    replayed = (int)depth;
+    replayFrom = "rtc";
+    // Niet meer aangevuld vóór de reset: uptime hoort bij de vorige boot,
+    // dus millis-fallback (backend herkent die) i.p.v. een foute Unix-tijd.
+    for (uint32_t i = s_log.head.load(); i != s_log.tail.load(); i++) {
+      DoorEvent& ev = s_log.events[i & (DOOR_EVENT_QUEUE_SIZE - 1)];
+      if (ev.timestamp == 0) ev.timestamp = ev.uptimeMs ? ev.uptimeMs : 1;
+    }
+    flushedTail = s_log.head.load();
+    unflushedSinceMs = depth ? 1 : 0;
+    Preferences prefs;
+    if (prefs.begin(kLogNamespace, true)) {
+      nvsEventCount = prefs.getBytesLength(kKeyEvents) / sizeof(DoorEvent);
+      seqReservedEnd = prefs.getUInt(kKeySeqEnd, 0);
+      prefs.end();
+    }
+    return;
   }
-  
-  return false;
+
+  // Koude boot: ring leeg initialiseren en vullen uit NVS.
+  s_log.magic = kRtcLogMagic;
+  s_log.magicInv = ~kRtcLogMagic;
+  s_log.version = kRtcLogVersion;
+  s_log.size = (uint16_t)sizeof(DoorRtcLog);
+  s_log.head.store(0);
+  s_log.tail.store(0);
+  s_log.lastSeq = 0;
+  s_log.lastOpen = false;
+  replayFrom = "none";
+
+  Preferences prefs;
+  if (!prefs.begin(kLogNamespace, true)) return;
+  seqReservedEnd = prefs.getUInt(kKeySeqEnd, 0);
+  // Alles onder seqEnd kan al uitgedeeld zijn vóór de reset: verder vanaf daar.
+  s_log.lastSeq = seqReservedEnd;
+  if (prefs.isKey(kKeyOpen)) {
+    s_log.lastOpen = prefs.getBool(kKeyOpen, false);
+    replayFrom = "nvs";
+  }
+  size_t len = prefs.getBytesLength(kKeyEvents);
+  if (len > 0 && (len % sizeof(DoorEvent)) == 0 && len <= sizeof(s_log.events)) {
+    uint32_t n = prefs.getBytes(kKeyEvents, s_log.events, len) / sizeof(DoorEvent);
+    s_log.tail.store(n);
+    nvsEventCount = n;
+    replayed = (int)n;
+    if (n > 0 && s_log.events[n - 1].seq > s_log.lastSeq) s_log.lastSeq = s_log.events[n - 1].seq;
+  }
+  prefs.end();
+  flushedTail = s_log.tail.load();
 }
 
-void DoorEventManager::enqueue(const DoorEvent& ev) {
-  if (!queueMutex) return;
-  if (xSemaphoreTake(queueMutex, pdMS_TO_TICKS(50)) != pdTRUE) return;
-  if (queueCount >= DOOR_EVENT_QUEUE_SIZE) {
-    xSemaphoreGive(queueMutex);
+void DoorEventManager::reserveSeqBlock(uint32_t fromSeq) {
+  Preferences prefs;
+  if (!prefs.begin(kLogNamespace, false)) return;
+  seqReservedEnd = fromSeq + DOOR_SEQ_BLOCK;
+  prefs.putUInt(kKeySeqEnd, seqReservedEnd);
+  prefs.end();
+}
+
+void DoorEventManager::persist() {
+  completePending();  // nooit onaangevulde events naar NVS
+  const uint32_t now = millis();
+
+  // Seq-blok tijdig verlengen (één NVS-write per DOOR_SEQ_BLOCK events). Zo
+  // hergebruikt een koude boot nooit een seq: de backend ontdubbelt op
+  // (deviceId, seq) en zou een hergebruikte seq als duplicaat weggooien.
+  const uint32_t seq = getSeq();
+  if (seq + DOOR_SEQ_BLOCK / 4 >= seqReservedEnd) {
+    reserveSeqBlock(seq);
+  }
+
+  const uint32_t head = s_log.head.load(std::memory_order_acquire);
+  const uint32_t tail = s_log.tail.load(std::memory_order_acquire);
+  // Events die al geüpload (gepopt) zijn vóór een flush hoeven nooit naar flash.
+  if ((int32_t)(head - flushedTail) > 0) flushedTail = head;
+  const uint32_t unflushed = tail - flushedTail;
+
+  if (unflushed == 0) {
+    unflushedSinceMs = 0;
+    // Lazy ack: de NVS-blob mag ge-ackte events bevatten (replay = duplicaat,
+    // backend idempotent). Pas na een stille periode leegmaken.
+    if (nvsEventCount == 0 || head != tail || (now - lastFlushMs) < DOOR_LOG_FLUSH_MS) return;
+  } else {
+    if (unflushedSinceMs == 0) unflushedSinceMs = now ? now : 1;
+    if (unflushed < DOOR_LOG_FLUSH_EVENTS && (now - unflushedSinceMs) < DOOR_LOG_FLUSH_MS) return;
+  }
+
+  // Snapshot van alle niet-ge-ackte events [head, tail): die slots worden door
+  // de producer niet aangeraakt zolang head niet opschuift (enkel wij doen dat).
+  uint32_t n = 0;
+  for (uint32_t i = head; i != tail; i++) {
+    s_flushBuf[n++] = s_log.events[i & (DOOR_EVENT_QUEUE_SIZE - 1)];
+  }
+  Preferences prefs;
+  if (!prefs.begin(kLogNamespace, false)) return;
+  if (n > 0) {
+    prefs.putBytes(kKeyEvents, s_flushBuf, n * sizeof(DoorEvent));
+  } else {
+    prefs.remove(kKeyEvents);
+  }
+  prefs.putBool(kKeyOpen, s_log.lastOpen);
+  prefs.end();
+
+  flushedTail = tail;
+  nvsEventCount = n;
+  unflushedSinceMs = 0;
+  lastFlushMs = now;
+}
+
+DoorSnapshot DoorEventManager::snapshot() const {
+  portENTER_CRITICAL(&stateMux);
+  DoorSnapshot snap = state;
+  portEXIT_CRITICAL(&stateMux);
+  return snap;
+}
+
+uint32_t DoorEventManager::openDurationMs() const {
+  DoorSnapshot snap = snapshot();
+  if (!snap.open || !snap.openedAtMs) return 0;
+  return millis() - snap.openedAtMs;
+}
+
+void IRAM_ATTR DoorEventManager::onEdgeIsr(void* arg) {
+  DoorEventManager* self = static_cast<DoorEventManager*>(arg);
+  if (!self->burstActive) {
+    self->burstActive = true;
+    self->burstStartUs = esp_timer_get_time();
+    self->burstEdges = 0;
+  }
+  self->burstEdges = self->burstEdges + 1;
+  // Elke flank schuift het debounce-venster op: pas DOOR_DEBOUNCE_MS na de
+  // laatste flank wordt het niveau beoordeeld. start/stop zijn ISR-safe.
+  esp_timer_stop(self->debounceTimer);
+  esp_timer_start_once(self->debounceTimer, (uint64_t)DOOR_DEBOUNCE_MS * 1000ULL);
+}
+
+void DoorEventManager::onDebounceTimer(void* arg) {
+  DoorEventManager* self = static_cast<DoorEventManager*>(arg);
+  const int64_t edgeUs = self->burstStartUs;
+  const uint16_t edges = self->burstEdges;
+  self->burstActive = false;
+
+  const bool open = self->readOpen();
+  // Tijdstip van de eerste flank; callback loopt DOOR_DEBOUNCE_MS (+ jitter) later.
+  const uint32_t edgeMs = (uint32_t)(edgeUs / 1000);
+
+  uint32_t seq;
+  portENTER_CRITICAL(&self->stateMux);
+  if (open == self->state.open) {  // bounce terug naar zelfde toestand
+    portEXIT_CRITICAL(&self->stateMux);
     return;
   }
+  seq = ++self->state.seq;
+  s_log.lastSeq = seq;
+  s_log.lastOpen = open;
+  self->state.open = open;
+  self->state.lastChangeMs = edgeMs;
+  if (open) {
+    self->state.openedAtMs = edgeMs ? edgeMs : 1;
+  } else {
+    self->state.lastOpenDurationMs = self->state.openedAtMs ? (edgeMs - self->state.openedAtMs) : 0;
+    self->state.openedAtMs = 0;
+  }
+  portEXIT_CRITICAL(&self->stateMux);
+  self->lastEdges = edges;
+
+  // Gedeelde esp_timer-taak: enkel tijdstip + enqueue. Unix-tijd, RSSI en
+  // analytics vult loop() aan (completePending()).
+  DoorEvent ev;
+  ev.isOpen = open;
+  ev.uptimeMs = edgeMs;
+  ev.timestamp = 0;  // 0 = nog aan te vullen
+  ev.seq = seq;
+  ev.rssi = 0;
+  self->enqueue(ev);
+}
+
+void DoorEventManager::completePending() {
+  const uint32_t head = s_log.head.load(std::memory_order_acquire);
+  const uint32_t tail = s_log.tail.load(std::memory_order_acquire);
+  // [head, tail) is van de consumer: de producer schrijft enkel op tail.
+  for (uint32_t i = head; i != tail; i++) {
+    DoorEvent& ev = s_log.events[i & (DOOR_EVENT_QUEUE_SIZE - 1)];
+    if (ev.timestamp != 0) continue;
+    const uint64_t unixMs = getUnixTimeMs();
+    const uint32_t ageMs = millis() - (uint32_t)ev.uptimeMs;
+    ev.timestamp = unixMs ? (unixMs - ageMs) : (uint64_t)ev.uptimeMs;  // Unix ms of millis fallback
+    if (ev.timestamp == 0) ev.timestamp = 1;
+    ev.rssi = WiFi.isConnected() ? WiFi.RSSI() : 0;
+    // Events die de rate-limit of een volle queue droppen, tellen hier niet
+    // mee (zie droppedRate/droppedFull); de analytics-toestand herstelt zich
+    // bij de volgende wissel.
+    doorAnalyticsOnChange(ev.isOpen, (uint32_t)ev.uptimeMs);
+  }
+}
+
+static_assert((DOOR_EVENT_QUEUE_SIZE & (DOOR_EVENT_QUEUE_SIZE - 1)) == 0,
+              "DOOR_EVENT_QUEUE_SIZE moet een macht van 2 zijn");
+static constexpr uint32_t kQueueMask = DOOR_EVENT_QUEUE_SIZE - 1;
 
+bool DoorEventManager::enqueue(const DoorEvent& ev) {
   unsigned long now = millis();
   if (lastEventMs == 0 || (now - lastEventMs) >= 1000) {
     lastEventMs = now;
     eventsThisSecond = 0;
   }
   if (eventsThisSecond >= DOOR_MAX_EVENTS_PER_SECOND) {
-    xSemaphoreGive(queueMutex);
-    return;
+    dropRate.fetch_add(1, std::memory_order_relaxed);
+    return false;
   }
 
+  const uint32_t tail = s_log.tail.load(std::memory_order_relaxed);
+  const uint32_t head = s_log.head.load(std::memory_order_acquire);
+  if (tail - head >= DOOR_EVENT_QUEUE_SIZE) {
+    dropFull.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
   eventsThisSecond++;
 
-  queue[queueTail] = ev;
-  queueTail = (queueTail + 1) % DOOR_EVENT_QUEUE_SIZE;
-  queueCount++;
-  xSemaphoreGive(queueMutex);
+  s_log.events[tail & kQueueMask] = ev;
+  s_log.tail.store(tail + 1, std::memory_order_release);
+
+  const uint32_t depth = tail + 1 - head;
+  if (depth > queueHighWater.load(std::memory_order_relaxed)) {
+    queueHighWater.store(depth, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+bool DoorEventManager::peek(DoorEvent& out) const {
+  const uint32_t head = s_log.head.load(std::memory_order_relaxed);
+  if (head == s_log.tail.load(std::memory_order_acquire)) return false;
+  out = s_log.events[head & kQueueMask];
+  return true;
+}
+
+void DoorEventManager::pop() {
+  const uint32_t head = s_log.head.load(std::memory_order_relaxed);
+  if (head == s_log.tail.load(std::memory_order_acquire)) return;
+  s_log.head.store(head + 1, std::memory_order_release);
 }
 
 bool DoorEventManager::dequeue(DoorEvent& out) {
-  if (!queueMutex || xSemaphoreTake(queueMutex, pdMS_TO_TICKS(50)) != pdTRUE) return false;
-  if (queueCount == 0) {
-    xSemaphoreGive(queueMutex);
-    return false;
-  }
-  out = queue[queueHead];
-  queueHead = (queueHead + 1) % DOOR_EVENT_QUEUE_SIZE;
-  queueCount--;
-  xSemaphoreGive(queueMutex);
+  if (!peek(out)) return false;
+  pop();
   return true;
 }
 
-bool DoorEventManager::hasPending() {
-  if (!queueMutex || xSemaphoreTake(queueMutex, pdMS_TO_TICKS(10)) != pdTRUE) return false;
-  bool r = queueCount > 0;
-  xSemaphoreGive(queueMutex);
-  return r;
+bool DoorEventManager::hasPending() const {
+  return getQueueCount() > 0;
 }
 
-int DoorEventManager::getQueueCount() {
-  if (!queueMutex || xSemaphoreTake(queueMutex, pdMS_TO_TICKS(10)) != pdTRUE) return 0;
-  int r = queueCount;
-  xSemaphoreGive(queueMutex);
-  return r;
+int DoorEventManager::getQueueCount() const {
+  const uint32_t tail = s_log.tail.load(std::memory_order_acquire);
+  const uint32_t head = s_log.head.load(std::memory_order_acquire);
+  return (int)(tail - head);
 }
 
 int DoorEventManager::dequeueMany(DoorEvent* out, int maxCount) {
-  if (!queueMutex || xSemaphoreTake(queueMutex, pdMS_TO_TICKS(50)) != pdTRUE) return 0;
   int n = 0;
-  while (n < maxCount && queueCount > 0) {
-    out[n] = queue[queueHead];
-    queueHead = (queueHead + 1) % DOOR_EVENT_QUEUE_SIZE;
-    queueCount--;
+  while (n < maxCount && dequeue(out[n])) {
     n++;
   }
-  xSemaphoreGive(queueMutex);
   return n;
 }
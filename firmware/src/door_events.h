@@ -4,11 +4,25 @@
 #include <Arduino.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <esp_timer.h>
+#include <atomic>
+#include "board_pins.h"
+
+#define PIN_DOOR BOARD_DOOR_PIN
+
+// Deur: INPUT_PULLUP. Schakelaar gesloten (pin→GND) = LOW = deur dicht. Schakelaar open = HIGH = deur open.
+// Als bij jou de melding verkeerd om staat: zet PIN_DOOR_INVERTED op 1.
+#define PIN_DOOR_INVERTED 0  // 0 = LOW=dicht HIGH=open; 1 = omgekeerd
 
 #define DOOR_DEBOUNCE_MS 30
-#define DOOR_EVENT_QUEUE_SIZE 32
+#define DOOR_EVENT_QUEUE_SIZE 32   // macht van 2 (index = teller & mask)
 #define DOOR_MAX_EVENTS_PER_SECOND 5
 
+// Persistente deur-log (zie DoorEventManager::persist()).
+#define DOOR_LOG_FLUSH_EVENTS 8       // flush naar NVS vanaf zoveel niet-ge-ackte events
+#define DOOR_LOG_FLUSH_MS     30000   // ... of als het oudste zo lang wacht
+#define DOOR_SEQ_BLOCK        64      // seq-nummers per NVS-reservatie
+
 struct DoorEvent {
   bool isOpen;           // true = OPEN, false = CLOSED
   uint64_t timestamp;    // Unix ms (UTC) if NTP synced; else millis() – backend detecteert fallback
@@ -17,45 +31,129 @@ struct DoorEvent {
   unsigned long uptimeMs;
 };
 
+// Eén consistente momentopname van de deur voor alle consumers (heartbeat,
+// readings, logging). Alle velden worden samen bijgewerkt bij een event.
+struct DoorSnapshot {
+  bool     open;
+  uint32_t seq;                 // seq van het laatste event (0 = nog geen)
+  uint32_t openedAtMs;          // millis() van openen, 0 als dicht
+  uint32_t lastChangeMs;        // millis() van de laatste wissel (of begin())
+  uint32_t lastOpenDurationMs;  // duur van de laatst afgesloten open-periode
+};
+
+/*
+ * Enige eigenaar van de deur: GPIO, debounce, open-duur, events en status.
+ *
+ * Deurflanken komen binnen via een GPIO CHANGE-interrupt. De ISR noteert het
+ * tijdstip van de eerste flank van een burst (esp_timer_get_time) en (her)start
+ * een one-shot esp_timer van DOOR_DEBOUNCE_MS. Pas als de pin zo lang stil is,
+ * leest de timer-callback het niveau en zet bij een echte toestandswissel een
+ * DoorEvent in de queue — met het tijdstip van de flank, niet van de callback.
+ * Deurlatency hangt zo niet meer af van hoe druk sensorTask of loop() zijn.
+ */
 class DoorEventManager {
 public:
   DoorEventManager();
   
-  // Sync met huidige hardware-state bij boot (voorkomt spurious event)
-  void setInitialState(bool currentDoorOpen);
+  // GPIO configureren, persistente log herstellen (RTC bij warme reset,
+  // anders NVS) en replayen in de queue, begintoestand syncen (voorkomt
+  // spurious event bij boot) en interrupt + debounce-timer activeren.
+  // Aanroepen na NVS-init, vóór de upload-loop start.
+  bool begin(uint8_t pin, bool inverted);
+  
+  // Consumer-kant onderhoud (roep in loop aan): schrijft niet-ge-ackte events
+  // gebundeld naar NVS en reserveert tijdig een nieuw seq-blok. Doet enkel
+  // flash-writes als er events zijn die nog niet geüpload werden.
+  void persist();
+  
+  // Herstel bij boot: aantal events teruggezet in de queue en bron ("rtc"/"nvs").
+  int replayedOnBoot() const { return replayed; }
+  const char* replaySource() const { return replayFrom; }
+  
+  // Consistente momentopname (onder spinlock gekopieerd).
+  DoorSnapshot snapshot() const;
+  
+  // Laatst gepubliceerde (gedebouncede) toestand.
+  bool isOpen() const { return snapshot().open; }
   
-  // Debounced read: returns true if state changed (after debounce)
-  bool poll(bool currentDoorOpen);
+  // 0 als dicht, anders ms sinds openen.
+  uint32_t openDurationMs() const;
   
-  // Queue event for offline flush (when WiFi down)
-  void enqueue(const DoorEvent& ev);
+  // Ruwe GPIO (1=HIGH, 0=LOW) voor debug; niet gedebounced.
+  bool rawPinHigh() const { return digitalRead(doorPin) == HIGH; }
   
-  // Get next event from queue (FIFO), returns false if empty
+  // Aantal ruwe flanken in de laatst gepubliceerde burst (diagnose van bouncing).
+  uint16_t lastBurstEdges() const { return lastEdges; }
+  
+  /*
+   * Event-queue: lock-free single-producer/single-consumer ring.
+   * Producer = debounce-timer (esp_timer-taak, enkel uptime), consumer = loop(). Geen mutex,
+   * geen timeouts; een volle queue of rate-limit telt als drop i.p.v. stil
+   * te verdwijnen. De ring zelf staat in RTC_NOINIT-geheugen en overleeft zo
+   * watchdog-, panic-, OTA- en software-resets; NVS dekt koude boots.
+   */
+  
+  // Producer. Returns false als het event gedropt werd (vol of rate-limit).
+  bool enqueue(const DoorEvent& ev);
+  
+  // Consumer (loop): Unix-tijd, RSSI en analytics aanvullen voor events die
+  // de debounce-callback enkel met uptime in de queue zette. Vóór peek().
+  void completePending();
+
+  // Consumer: oudste event bekijken zonder te verwijderen / verwijderen na ack.
+  bool peek(DoorEvent& out) const;
+  void pop();
+  
+  // Consumer: peek + pop in één.
   bool dequeue(DoorEvent& out);
   
   // Dequeue multiple events into array, max N. Returns count.
   int dequeueMany(DoorEvent* out, int maxCount);
   
-  bool hasPending();
-  int getQueueCount();
+  bool hasPending() const;
+  int getQueueCount() const;
   
-  uint32_t getNextSeq() { return ++seqCounter; }
-  uint32_t getSeq() const { return seqCounter; }
+  uint32_t droppedFull() const { return dropFull.load(std::memory_order_relaxed); }
+  uint32_t droppedRate() const { return dropRate.load(std::memory_order_relaxed); }
+  uint32_t highWater() const { return queueHighWater.load(std::memory_order_relaxed); }
+  
+  uint32_t getSeq() const { return snapshot().seq; }
 
 private:
-  SemaphoreHandle_t queueMutex;
-  unsigned long lastStableTime;
-  bool lastStableState;
-  bool lastReportedState;
+  static void IRAM_ATTR onEdgeIsr(void* arg);
+  static void onDebounceTimer(void* arg);
+  bool readOpen() const;
+
+  esp_timer_handle_t debounceTimer;
+  uint8_t doorPin;
+  bool doorInverted;
+  mutable portMUX_TYPE stateMux;
+  DoorSnapshot state;
+  volatile bool burstActive;
+  volatile int64_t burstStartUs;
+  volatile uint16_t burstEdges;
+  uint16_t lastEdges;
   
-  DoorEvent queue[DOOR_EVENT_QUEUE_SIZE];
-  int queueHead;
-  int queueTail;
-  int queueCount;
+  void restoreLog();
+  void reserveSeqBlock(uint32_t fromSeq);
+
+  // Ring (events + head/tail) zit in RTC-geheugen, zie door_events.cpp.
+  std::atomic<uint32_t> queueHighWater;
+  std::atomic<uint32_t> dropFull;
+  std::atomic<uint32_t> dropRate;
   
-  uint32_t seqCounter;
+  // Rate-limit: enkel door de producer gebruikt.
   unsigned long lastEventMs;
   int eventsThisSecond;
+  
+  // Persistentie: enkel door de consumer gebruikt.
+  uint32_t flushedTail;         // ring-positie t/m waar NVS bijgewerkt is
+  uint32_t nvsEventCount;       // events in de laatste NVS-blob (incl. al ge-ackte)
+  uint32_t unflushedSinceMs;    // 0 = niets te flushen
+  uint32_t lastFlushMs;
+  uint32_t seqReservedEnd;      // seq's < dit zijn gereserveerd in NVS
+  int replayed;
+  const char* replayFrom;
 };
 
 #endif
@@ -0,0 +1,231 @@
+#include "haccp_log.h"
+#include "sensors_pt1000.h"
+#include "time_utils.h"
+#include "logger.h"
+#include <SPIFFS.h>
+#include <esp_system.h>
+#include <mbedtls/sha256.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+extern Logger logger;
+
+static_assert(sizeof(HaccpRecord) == 32, "HaccpRecord moet 32 bytes blijven (on-flash formaat)");
+static_assert(PT1000_COUNT * PT1000_BINARY_BYTES_PER_CHANNEL <= HACCP_PAYLOAD_BYTES,
+              "HACCP payload te klein voor de kanaaltabel");
+
+namespace {
+
+const uint32_t kMagic = 0x31504348;  // "HCP1"
+const uint16_t kVersion = 1;
+
+struct __attribute__((packed)) SegmentHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t recordSize;
+  uint32_t firstSeq;
+  uint8_t  prevDigest[32];   // keten-kop vóór het eerste record van dit segment
+};
+
+QueueHandle_t s_queue = nullptr;
+uint8_t  s_head[32] = {};    // digest van het laatste record
+uint32_t s_nextSeq = 0;
+uint32_t s_fileBytes = 0;
+uint32_t s_dropped = 0;      // queue vol (sensorTask blokkeert nooit)
+
+// Hash-tijd per record (exponentieel gemiddelde, µs) + piek.
+uint32_t s_hashAvgUs = 0;
+uint32_t s_hashMaxUs = 0;
+
+uint32_t s_lastAnchorMs = 0;
+uint32_t s_anchorSeq = UINT32_MAX;   // laatst geankerde seq (UINT32_MAX = nooit)
+
+void chain(uint8_t digest[32], const HaccpRecord& rec) {
+  uint8_t buf[32 + sizeof(HaccpRecord)];
+  memcpy(buf, digest, 32);
+  memcpy(buf + 32, &rec, sizeof(HaccpRecord));
+  mbedtls_sha256_ret(buf, sizeof(buf), digest, 0);
+}
+
+bool startSegment() {
+  File f = SPIFFS.open(HACCP_LOG_PATH, FILE_WRITE);
+  if (!f) return false;
+  SegmentHeader h;
+  h.magic = kMagic;
+  h.version = kVersion;
+  h.recordSize = sizeof(HaccpRecord);
+  h.firstSeq = s_nextSeq;
+  memcpy(h.prevDigest, s_head, 32);
+  const bool ok = f.write((const uint8_t*)&h, sizeof(h)) == sizeof(h);
+  f.close();
+  s_fileBytes = ok ? sizeof(h) : 0;
+  return ok;
+}
+
+// Huidig segment naar HACCP_LOG_OLD_PATH; vorige .old valt weg (die
+// readings zijn dan al lang geüpload en geankerd).
+bool rotate() {
+  if (SPIFFS.exists(HACCP_LOG_OLD_PATH)) SPIFFS.remove(HACCP_LOG_OLD_PATH);
+  if (SPIFFS.exists(HACCP_LOG_PATH)) SPIFFS.rename(HACCP_LOG_PATH, HACCP_LOG_OLD_PATH);
+  return startSegment();
+}
+
+// Bestaand segment inlezen en keten herberekenen. False = onbruikbaar.
+bool replaySegment(uint32_t& records, uint32_t& hashUs) {
+  File f = SPIFFS.open(HACCP_LOG_PATH, FILE_READ);
+  if (!f) return false;
+  SegmentHeader h;
+  const size_t size = f.size();
+  if (f.read((uint8_t*)&h, sizeof(h)) != sizeof(h) || h.magic != kMagic ||
+      h.recordSize != sizeof(HaccpRecord)) {
+    f.close();
+    return false;
+  }
+  memcpy(s_head, h.prevDigest, 32);
+  s_nextSeq = h.firstSeq;
+  records = 0;
+  HaccpRecord rec;
+  const uint32_t t0 = micros();
+  while (f.read((uint8_t*)&rec, sizeof(rec)) == sizeof(rec)) {
+    if (rec.seq != s_nextSeq) {
+      logger.warn("[HACCP] seq-sprong in log: verwacht " + String(s_nextSeq) + ", gelezen " + String(rec.seq));
+    }
+    chain(s_head, rec);
+    s_nextSeq = rec.seq + 1;
+    records++;
+  }
+  hashUs = micros() - t0;
+  f.close();
+  s_fileBytes = sizeof(h) + records * sizeof(HaccpRecord);
+  // Half record achteraan (stroomonderbreking tijdens schrijven): segment
+  // afsluiten zodat nieuwe records niet verschoven staan.
+  return s_fileBytes == size;
+}
+
+void benchmark() {
+  // 4 KB × 8 hashen: doorvoer van de SHA-accelerator via mbedtls.
+  static uint8_t block[4096];
+  uint8_t out[32];
+  const uint32_t t0 = micros();
+  for (int i = 0; i < 8; i++) mbedtls_sha256_ret(block, sizeof(block), out, 0);
+  const uint32_t dt = micros() - t0;
+  const uint32_t kbps = dt ? (uint32_t)((32ULL * 1000000ULL) / dt) : 0;
+  HaccpRecord rec = {};
+  uint8_t d[32] = {};
+  const uint32_t t1 = micros();
+  chain(d, rec);
+  logger.info("[HACCP] SHA-256: " + String(kbps) + " KB/s, " + String(micros() - t1) + " us/record");
+}
+
+void append(HaccpRecord& rec) {
+  if (s_fileBytes + sizeof(HaccpRecord) > HACCP_LOG_MAX_BYTES) {
+    if (!rotate()) {
+      logger.error("[HACCP] rotatie mislukt");
+      return;
+    }
+  }
+  rec.seq = s_nextSeq;
+  uint8_t next[32];
+  memcpy(next, s_head, 32);
+  const uint32_t t0 = micros();
+  chain(next, rec);
+  const uint32_t dt = micros() - t0;
+  s_hashAvgUs = s_hashAvgUs ? (s_hashAvgUs * 7 + dt) / 8 : dt;
+  if (dt > s_hashMaxUs) s_hashMaxUs = dt;
+
+  File f = SPIFFS.open(HACCP_LOG_PATH, FILE_APPEND);
+  if (!f || f.write((const uint8_t*)&rec, sizeof(rec)) != sizeof(rec)) {
+    // Kop niet opschuiven: het record staat niet in het log.
+    if (f) f.close();
+    logger.error("[HACCP] schrijven mislukt (seq=" + String(rec.seq) + ")");
+    return;
+  }
+  f.close();
+  memcpy(s_head, next, 32);
+  s_nextSeq++;
+  s_fileBytes += sizeof(rec);
+}
+
+void fillCommon(HaccpRecord& rec, HaccpKind kind) {
+  memset(&rec, 0, sizeof(rec));
+  rec.unixS = (uint32_t)(getUnixTimeMs() / 1000);
+  rec.uptimeS = millis() / 1000;
+  rec.kind = kind;
+}
+
+} // namespace
+
+bool initHaccpLog() {
+  s_queue = xQueueCreate(HACCP_QUEUE_DEPTH, sizeof(HaccpRecord));
+  if (!s_queue) return false;
+
+  benchmark();
+
+  uint32_t records = 0, hashUs = 0;
+  bool chainReset = false;
+  if (!SPIFFS.exists(HACCP_LOG_PATH)) {
+    if (!startSegment()) return false;
+  } else if (!replaySegment(records, hashUs)) {
+    if (s_fileBytes == 0) {
+      // Header onleesbaar: keten kan niet verder, nieuw begin + marker.
+      memset(s_head, 0, sizeof(s_head));
+      s_nextSeq = 0;
+      chainReset = true;
+    }
+    logger.warn("[HACCP] segment beschadigd of onvolledig — nieuw segment");
+    if (!rotate()) return false;
+  }
+  logger.info("[HACCP] keten hersteld: " + String(records) + " record(s) in " + String(hashUs / 1000) +
+              " ms, volgende seq=" + String(s_nextSeq));
+
+  if (chainReset) haccpLogEvent(HACCP_KIND_CHAIN_RESET, 0);
+  haccpLogEvent(HACCP_KIND_BOOT, (uint32_t)esp_reset_reason());
+  return true;
+}
+
+void haccpLogReading(uint8_t alarms, bool doorOpen, bool onMains) {
+  if (!s_queue) return;
+  HaccpRecord rec;
+  fillCommon(rec, HACCP_KIND_READING);
+  rec.alarms = alarms;
+  rec.flags = (doorOpen ? 0x01 : 0) | (onMains ? 0x02 : 0);
+  rec.len = (uint8_t)encodeSensorsBinary(rec.payload, sizeof(rec.payload));
+  if (xQueueSend(s_queue, &rec, 0) != pdTRUE) s_dropped++;
+}
+
+void haccpLogEvent(HaccpKind kind, uint32_t arg) {
+  if (!s_queue) return;
+  HaccpRecord rec;
+  fillCommon(rec, kind);
+  memcpy(rec.payload, &arg, sizeof(arg));
+  rec.len = sizeof(arg);
+  if (xQueueSend(s_queue, &rec, 0) != pdTRUE) s_dropped++;
+}
+
+void haccpLogService() {
+  if (!s_queue) return;
+  HaccpRecord rec;
+  while (xQueueReceive(s_queue, &rec, 0) == pdTRUE) append(rec);
+}
+
+bool writeHaccpAnchorJson(JsonDocument& doc) {
+  doc["haccp_hash_us"] = s_hashAvgUs;
+  doc["haccp_hash_max_us"] = s_hashMaxUs;
+  doc["haccp_dropped"] = s_dropped;
+  if (!s_queue || s_nextSeq == 0) return false;
+  const uint32_t lastSeq = s_nextSeq - 1;
+  const bool due = s_anchorSeq == UINT32_MAX ||
+                   (lastSeq != s_anchorSeq && (millis() - s_lastAnchorMs) >= HACCP_ANCHOR_INTERVAL_MS);
+  if (!due) return false;
+
+  char hex[65];
+  for (int i = 0; i < 32; i++) snprintf(&hex[i * 2], 3, "%02x", s_head[i]);
+  doc["haccp_seq"] = lastSeq;
+  doc["haccp_head"] = hex;  // ArduinoJson kopieert char[]
+  return true;
+}
+
+void haccpAnchorAck(uint32_t seq) {
+  s_anchorSeq = seq;
+  s_lastAnchorMs = millis();
+}
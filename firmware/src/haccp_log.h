@@ -0,0 +1,73 @@
+#ifndef HACCP_LOG_H
+#define HACCP_LOG_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/**
+ * Append-only HACCP-temperatuurlog op SPIFFS met SHA-256 hash-keten.
+ *
+ * Elke meting (ook ongeldige: fout zit in de payload) en elk relevant
+ * systeemevent (boot, recovery-clear van dataBuffer) wordt een vast record
+ * van 32 bytes. Keten: d[n] = SHA256(d[n-1] || record[n]), d[-1] = 32 nullen.
+ * Elk segmentbestand begint met een header met de digest van het vorige
+ * segment, zodat ook na rotatie (HACCP_LOG_MAX_BYTES) verifieerbaar blijft.
+ *
+ * De keten-kop (seq + digest) gaat periodiek als anchor mee in de heartbeat:
+ * de backend kan dan met de al geüploade readings aantonen dat er niets
+ * ontbreekt of gewijzigd is, zonder het log opnieuw te uploaden.
+ *
+ * sensorTask zet records enkel in een queue (geen SPIFFS/hash op het
+ * meetpad); haccpLogService() in loop() hasht (mbedtls → SHA-accelerator
+ * van de ESP32-S3) en schrijft. Doorvoer wordt bij boot gemeten en de
+ * hash-tijd per record gaat mee in de heartbeat.
+ */
+
+#define HACCP_LOG_PATH            "/haccp.log"
+#define HACCP_LOG_OLD_PATH        "/haccp.old"
+#define HACCP_LOG_MAX_BYTES       (128UL * 1024UL)
+#define HACCP_QUEUE_DEPTH         8
+#define HACCP_PAYLOAD_BYTES       16
+#define HACCP_ANCHOR_INTERVAL_MS  (15UL * 60UL * 1000UL)
+
+enum HaccpKind : uint8_t {
+  HACCP_KIND_READING      = 0,  // payload = encodeSensorsBinary()
+  HACCP_KIND_BOOT         = 1,  // payload = uint32 esp_reset_reason()
+  HACCP_KIND_BUFFER_CLEAR = 2,  // payload = uint32 gewiste readings
+  HACCP_KIND_CHAIN_RESET  = 3,  // vorig segment onleesbaar; keten herstart
+};
+
+struct __attribute__((packed)) HaccpRecord {
+  uint32_t seq;
+  uint32_t unixS;     // 0 als de klok nog niet gesynct was
+  uint32_t uptimeS;
+  uint8_t  kind;      // HaccpKind
+  uint8_t  alarms;    // activeAlarmMask()
+  uint8_t  flags;     // bit0 deur open, bit1 netvoeding
+  uint8_t  len;       // geldige bytes in payload
+  uint8_t  payload[HACCP_PAYLOAD_BYTES];
+};
+
+/** Na SPIFFS.begin(): keten herberekenen uit het log + hash-benchmark. */
+bool initHaccpLog();
+
+/** sensorTask, na sampleSensors(): meting in de queue (niet-blokkerend). */
+void haccpLogReading(uint8_t alarms, bool doorOpen, bool onMains);
+
+/** Systeemevent met 32-bit argument (niet-blokkerend). */
+void haccpLogEvent(HaccpKind kind, uint32_t arg);
+
+/** loop(): queue hashen en naar SPIFFS schrijven. */
+void haccpLogService();
+
+/**
+ * Heartbeat: anchor (haccp_seq, haccp_head) als die aan de beurt is, plus
+ * haccp_hash_us en haccp_dropped. Returnt true als de anchor meeging; hij
+ * gaat elke heartbeat opnieuw mee tot haccpAnchorAck().
+ */
+bool writeHaccpAnchorJson(JsonDocument& doc);
+
+/** Backend bevestigt "haccp_anchor_stored" == seq: anchor staat extern. */
+void haccpAnchorAck(uint32_t seq);
+
+#endif /* HACCP_LOG_H */
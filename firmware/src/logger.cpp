@@ -1,26 +1,37 @@
 #include "logger.h"
+#include "crash_log.h"
 #include <freertos/FreeRTOS.h>
-#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <stdarg.h>
 
 namespace {
-SemaphoreHandle_t s_logMutex = nullptr;
-}
 
-Logger::Logger() : level(LOG_INFO), serialEnabled(true) {
-  if (!s_logMutex) {
-    s_logMutex = xSemaphoreCreateMutex();
-  }
-}
+enum SlotState : uint8_t {
+  SLOT_EMPTY = 0,
+  SLOT_WRITING,
+  SLOT_READY,
+};
 
-void Logger::setLevel(LogLevel level) {
-  this->level = level;
-}
+struct LogSlot {
+  uint8_t  state;
+  uint8_t  level;
+  uint8_t  tag;
+  uint8_t  binary;      // tokenized record (LOG_TOKENIZED)
+  uint16_t len;
+  uint32_t ms;
+  char     text[LOG_SLOT_TEXT];
+};
 
-void Logger::enableSerial(bool enable) {
-  serialEnabled = enable;
-}
+static_assert((LOG_RING_SLOTS & (LOG_RING_SLOTS - 1)) == 0, "LOG_RING_SLOTS moet een macht van 2 zijn");
 
-String Logger::getLevelString(LogLevel level) {
+LogSlot  s_ring[LOG_RING_SLOTS];
+uint32_t s_head = 0;         // volgende te claimen slot (producers, CAS)
+uint32_t s_tail = 0;         // volgende te drainen slot (enkel drain-taak)
+uint32_t s_dropped = 0;
+uint16_t s_highWater = 0;
+TaskHandle_t s_drainTask = nullptr;
+
+const char* levelString(uint8_t level) {
   switch (level) {
     case LOG_DEBUG: return "DEBUG";
     case LOG_INFO: return "INFO";
@@ -30,58 +41,265 @@ String Logger::getLevelString(LogLevel level) {
   }
 }
 
-void Logger::printLog(LogLevel logLevel, String message) {
-  if (logLevel < level) {
-    return;
+// Slot claimen zonder lock. Het slot op de kop moet leeg zijn (de drain-taak
+// is er voorbij), anders is de ring vol en vallen we meteen terug.
+LogSlot* claimSlot() {
+  uint32_t head = __atomic_load_n(&s_head, __ATOMIC_RELAXED);
+  while (true) {
+    LogSlot* slot = &s_ring[head & (LOG_RING_SLOTS - 1)];
+    if (__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) != SLOT_EMPTY ||
+        head - __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE) >= LOG_RING_SLOTS) {
+      __atomic_fetch_add(&s_dropped, 1, __ATOMIC_RELAXED);
+      return nullptr;
+    }
+    if (__atomic_compare_exchange_n(&s_head, &head, head + 1, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+      slot->state = SLOT_WRITING;
+      const uint16_t used = (uint16_t)(head + 1 - __atomic_load_n(&s_tail, __ATOMIC_RELAXED));
+      if (used > s_highWater) s_highWater = used;  // statistiek: race onschadelijk
+      return slot;
+    }
+    // CAS verloren: head bevat nu de nieuwe kop, opnieuw proberen.
   }
-  if (!serialEnabled) {
-    return;
+}
+
+void publish(LogSlot* slot, LogLevel level, int len, bool binary = false, uint8_t tag = 0) {
+  slot->level = (uint8_t)level;
+  slot->tag = tag;
+  slot->binary = binary ? 1 : 0;
+  slot->ms = millis();
+  slot->len = (uint16_t)(len < 0 ? 0 : (len >= LOG_SLOT_TEXT ? LOG_SLOT_TEXT - 1 : len));
+  __atomic_store_n(&slot->state, SLOT_READY, __ATOMIC_RELEASE);
+  if (s_drainTask) xTaskNotifyGive(s_drainTask);
+}
+
+const char kBase64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// "$<base64>\r\n" van [level | tag << 2][varint ms][payload].
+size_t encodeTokenLine(const LogSlot* slot, char* out) {
+  uint8_t frame[LOG_SLOT_TEXT + 8];
+  size_t n = 0;
+  frame[n++] = (uint8_t)((slot->level & 0x3) | (slot->tag << 2));
+  uint32_t ms = slot->ms;
+  while (ms >= 0x80) { frame[n++] = (uint8_t)(ms | 0x80); ms >>= 7; }
+  frame[n++] = (uint8_t)ms;
+  memcpy(frame + n, slot->text, slot->len);
+  n += slot->len;
+
+  size_t o = 0;
+  out[o++] = '$';
+  for (size_t i = 0; i < n; i += 3) {
+    const uint32_t v = (uint32_t)frame[i] << 16 | (i + 1 < n ? (uint32_t)frame[i + 1] << 8 : 0) |
+                       (i + 2 < n ? frame[i + 2] : 0);
+    out[o++] = kBase64[(v >> 18) & 0x3F];
+    out[o++] = kBase64[(v >> 12) & 0x3F];
+    out[o++] = i + 1 < n ? kBase64[(v >> 6) & 0x3F] : '=';
+    out[o++] = i + 2 < n ? kBase64[v & 0x3F] : '=';
   }
-  if (s_logMutex && xSemaphoreTake(s_logMutex, pdMS_TO_TICKS(200)) != pdTRUE) {
+  out[o++] = '\r';
+  out[o++] = '\n';
+  return o;
+}
+
+static_assert(((LOG_SLOT_TEXT + 8 + 2) / 3) * 4 + 4 >= 24 + LOG_SLOT_TEXT + 2, "drain-buffer te klein voor een tekstregel");
+
+void drainTask(void*) {
+  uint32_t reportedDropped = 0;
+  char line[((LOG_SLOT_TEXT + 8 + 2) / 3) * 4 + 4];
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+    while (true) {
+      LogSlot* slot = &s_ring[s_tail & (LOG_RING_SLOTS - 1)];
+      // In volgorde van claimen: een slot dat nog geschreven wordt, houdt de
+      // rest even op (de producer is bezig met vsnprintf).
+      if (__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) != SLOT_READY) break;
+      // Volledige regel in één buffer: één Serial.write en één memcpy naar de crash-log.
+      size_t n;
+      if (slot->binary) {
+        n = encodeTokenLine(slot, line);
+      } else {
+        n = (size_t)snprintf(line, sizeof(line), "[%08lu] [%s] ", (unsigned long)slot->ms, levelString(slot->level));
+        memcpy(line + n, slot->text, slot->len);
+        n += slot->len;
+        line[n++] = '\r';
+        line[n++] = '\n';
+      }
+      Serial.write((const uint8_t*)line, n);
+      crashLogAppend(line, n);
+      __atomic_store_n(&slot->state, SLOT_EMPTY, __ATOMIC_RELEASE);
+      __atomic_store_n(&s_tail, s_tail + 1, __ATOMIC_RELEASE);
+    }
+    const uint32_t dropped = __atomic_load_n(&s_dropped, __ATOMIC_RELAXED);
+    if (dropped != reportedDropped) {
+      const int n = snprintf(line, sizeof(line), "[%08lu] [WARN] [LOG] %lu berichten verloren (ring vol)\r\n",
+                             (unsigned long)millis(), (unsigned long)(dropped - reportedDropped));
+      Serial.write((const uint8_t*)line, n);
+      crashLogAppend(line, n);
+      reportedDropped = dropped;
+    }
+  }
+}
+
+const char* const kTagNames[LOG_TAG_COUNT] = { "APP", "SENSOR", "Modbus", "SIM7670", "VBUS", "POWER", "NET" };
+
+} // namespace
+
+const char* logTagName(LogTag tag) {
+  return tag < LOG_TAG_COUNT ? kTagNames[tag] : "?";
+}
+
+uint32_t logTagMaskFromNames(const char* names) {
+  if (!names || !*names || strcasecmp(names, "ALL") == 0) return LOG_TAG_MASK_ALL;
+  uint32_t mask = 0;
+  const char* p = names;
+  while (*p) {
+    const char* end = strchr(p, ',');
+    const size_t len = end ? (size_t)(end - p) : strlen(p);
+    for (uint8_t t = 0; t < LOG_TAG_COUNT; t++) {
+      if (strlen(kTagNames[t]) == len && strncasecmp(p, kTagNames[t], len) == 0) mask |= 1UL << t;
+    }
+    if (!end) break;
+    p = end + 1;
+  }
+  return mask;
+}
+
+Logger::Logger() : level(LOG_INFO), serialEnabled(true), tagMask(LOG_TAG_MASK_ALL) {
+}
+
+void Logger::begin() {
+  if (s_drainTask) return;
+  // Lage prio: sensing/netwerk gaan altijd voor; de ring vangt pieken op.
+  xTaskCreatePinnedToCore(drainTask, "LogDrain", 3072, nullptr, 1, &s_drainTask, 0);
+}
+
+void Logger::setLevel(LogLevel level) {
+  this->level = level;
+}
+
+void Logger::enableSerial(bool enable) {
+  serialEnabled = enable;
+}
+
+void Logger::printLog(LogLevel logLevel, const String& message) {
+  if (!enabled(logLevel)) {
     return;
   }
-  unsigned long timestamp = millis();
-  String levelStr = getLevelString(logLevel);
-  char tsBuf[14];
-  snprintf(tsBuf, sizeof(tsBuf), "[%08lu]", timestamp);
-  Serial.print(tsBuf);
-  Serial.print(" [");
-  Serial.print(levelStr);
-  Serial.print("] ");
-  Serial.println(message);
-  if (s_logMutex) {
-    xSemaphoreGive(s_logMutex);
+  LogSlot* slot = claimSlot();
+  if (!slot) return;
+  const size_t len = message.length() < LOG_SLOT_TEXT - 1 ? message.length() : LOG_SLOT_TEXT - 1;
+  memcpy(slot->text, message.c_str(), len);
+  slot->text[len] = '\0';
+  publish(slot, logLevel, (int)len);
+}
+
+void Logger::vlogf(LogLevel logLevel, const char* fmt, va_list args) {
+  if (!enabled(logLevel)) {
+    return;
   }
+  LogSlot* slot = claimSlot();
+  if (!slot) return;
+  // Formatteren pas na de level-check, rechtstreeks in het slot.
+  publish(slot, logLevel, vsnprintf(slot->text, LOG_SLOT_TEXT, fmt, args));
 }
 
-void Logger::debug(String message) {
+void Logger::debug(const String& message) {
   printLog(LOG_DEBUG, message);
 }
 
-void Logger::info(String message) {
+void Logger::info(const String& message) {
   printLog(LOG_INFO, message);
 }
 
-void Logger::warn(String message) {
+void Logger::warn(const String& message) {
   printLog(LOG_WARN, message);
 }
 
-void Logger::error(String message) {
+void Logger::error(const String& message) {
   printLog(LOG_ERROR, message);
 }
 
-void Logger::debug(String tag, String message) {
-  debug("[" + tag + "] " + message);
+namespace {
+void tagged(Logger& l, LogLevel level, const String& tag, const String& message) {
+  l.logf(level, "[%s] %s", tag.c_str(), message.c_str());
+}
+} // namespace
+
+void Logger::debug(const String& tag, const String& message) {
+  tagged(*this, LOG_DEBUG, tag, message);
+}
+
+void Logger::info(const String& tag, const String& message) {
+  tagged(*this, LOG_INFO, tag, message);
+}
+
+void Logger::warn(const String& tag, const String& message) {
+  tagged(*this, LOG_WARN, tag, message);
+}
+
+void Logger::error(const String& tag, const String& message) {
+  tagged(*this, LOG_ERROR, tag, message);
+}
+
+void Logger::logf(LogLevel logLevel, const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  vlogf(logLevel, fmt, args);
+  va_end(args);
+}
+
+#define LOGGER_PRINTF_BODY(lvl)   \
+  va_list args;                   \
+  va_start(args, fmt);            \
+  vlogf(lvl, fmt, args);          \
+  va_end(args)
+
+void Logger::debugf(const char* fmt, ...) {
+  LOGGER_PRINTF_BODY(LOG_DEBUG);
+}
+
+void Logger::infof(const char* fmt, ...) {
+  LOGGER_PRINTF_BODY(LOG_INFO);
+}
+
+void Logger::warnf(const char* fmt, ...) {
+  LOGGER_PRINTF_BODY(LOG_WARN);
+}
+
+void Logger::errorf(const char* fmt, ...) {
+  LOGGER_PRINTF_BODY(LOG_ERROR);
+}
+
+void Logger::logTag(LogLevel logLevel, LogTag tag, const char* fmt, ...) {
+  LogSlot* slot = claimSlot();
+  if (!slot) return;
+  int off = 0;
+  if (tag != LOG_TAG_APP) {
+    off = snprintf(slot->text, LOG_SLOT_TEXT, "[%s] ", logTagName(tag));
+    if (off < 0 || off >= LOG_SLOT_TEXT) off = 0;
+  }
+  va_list args;
+  va_start(args, fmt);
+  const int n = vsnprintf(slot->text + off, LOG_SLOT_TEXT - off, fmt, args);
+  va_end(args);
+  publish(slot, logLevel, n < 0 ? off : off + n);
+}
+
+void* Logger::tokenClaim(uint8_t*& buf, size_t& cap) {
+  LogSlot* slot = claimSlot();
+  if (!slot) return nullptr;
+  buf = (uint8_t*)slot->text;
+  cap = LOG_SLOT_TEXT - 1;
+  return slot;
 }
 
-void Logger::info(String tag, String message) {
-  info("[" + tag + "] " + message);
+void Logger::tokenPublish(void* slot, LogLevel logLevel, LogTag tag, size_t len) {
+  publish(static_cast<LogSlot*>(slot), logLevel, (int)len, true, (uint8_t)tag);
 }
 
-void Logger::warn(String tag, String message) {
-  warn("[" + tag + "] " + message);
+uint32_t Logger::dropped() const {
+  return __atomic_load_n(&s_dropped, __ATOMIC_RELAXED);
 }
 
-void Logger::error(String tag, String message) {
-  error("[" + tag + "] " + message);
+uint16_t Logger::highWater() const {
+  return s_highWater;
 }
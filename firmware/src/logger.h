@@ -2,6 +2,8 @@
 #define LOGGER_H
 
 #include <Arduino.h>
+#include <string.h>
+#include <type_traits>
 
 enum LogLevel {
   LOG_DEBUG = 0,
@@ -10,29 +12,193 @@ enum LogLevel {
   LOG_ERROR = 3
 };
 
+/**
+ * Asynchrone logger: producers (elke taak) claimen lock-free een slot in een
+ * ring (CAS op de kop), formatteren er rechtstreeks in en markeren het slot
+ * klaar. Eén drain-taak met lage prio schrijft naar Serial (USB-CDC). Een
+ * volle ring blokkeert nooit: het bericht telt als dropped.
+ *
+ * Het level wordt vóór elke formattering gecontroleerd: debugf() onder het
+ * actieve level kost enkel een vergelijking. De String-API blijft voor
+ * bestaande code; voor hete paden debugf/infof/... (printf, geen heap).
+ */
+#define LOG_RING_SLOTS   32      // macht van 2
+#define LOG_SLOT_TEXT    160     // langer wordt afgekapt
+
+/**
+ * Compile-time level (build flag -DLOG_COMPILE_LEVEL=n, 0=DEBUG .. 3=ERROR).
+ * LOG_D/LOG_I/LOG_W/LOG_E onder dit level worden volledig weggecompileerd:
+ * ook de argumenten worden niet geëvalueerd. Debug-builds: alles (0).
+ */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 0
+#endif
+
+/**
+ * Module-tags voor de macro's. Runtime-masker (setTagMask, remote command
+ * LOG_CONFIG) filtert DEBUG/INFO per module; WARN/ERROR passeren altijd.
+ * LOG_TAG_APP krijgt geen prefix.
+ */
+enum LogTag : uint8_t {
+  LOG_TAG_APP = 0,
+  LOG_TAG_SENSOR,
+  LOG_TAG_MODBUS,
+  LOG_TAG_SIM7670,
+  LOG_TAG_VBUS,
+  LOG_TAG_POWER,
+  LOG_TAG_NET,
+  LOG_TAG_COUNT
+};
+
+#define LOG_TAG_MASK_ALL  ((1UL << LOG_TAG_COUNT) - 1)
+
+const char* logTagName(LogTag tag);
+/** "SENSOR,MODBUS" of "ALL" → masker; onbekende namen worden genegeerd. */
+uint32_t logTagMaskFromNames(const char* names);
+
 class Logger {
 private:
   LogLevel level;
   bool serialEnabled;
-  
-  void printLog(LogLevel level, String message);
-  String getLevelString(LogLevel level);
-  
+  uint32_t tagMask;
+
+  void printLog(LogLevel level, const String& message);
+  void vlogf(LogLevel level, const char* fmt, va_list args);
+
 public:
   Logger();
-  
+
+  /** Drain-taak starten (setup(), na Serial.begin). Tot dan vult de ring. */
+  void begin();
   void setLevel(LogLevel level);
   void enableSerial(bool enable);
-  
-  void debug(String message);
-  void info(String message);
-  void warn(String message);
-  void error(String message);
-  
-  void debug(String tag, String message);
-  void info(String tag, String message);
-  void warn(String tag, String message);
-  void error(String tag, String message);
+  bool enabled(LogLevel l) const { return serialEnabled && l >= level; }
+  LogLevel getLevel() const { return level; }
+  void setTagMask(uint32_t mask) { tagMask = mask; }
+  uint32_t getTagMask() const { return tagMask; }
+  bool tagEnabled(LogTag tag, LogLevel l) const {
+    return enabled(l) && (l >= LOG_WARN || (tagMask & (1UL << tag)));
+  }
+
+  void debug(const String& message);
+  void info(const String& message);
+  void warn(const String& message);
+  void error(const String& message);
+
+  void debug(const String& tag, const String& message);
+  void info(const String& tag, const String& message);
+  void warn(const String& tag, const String& message);
+  void error(const String& tag, const String& message);
+
+  void logf(LogLevel level, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+  void debugf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+  void infof(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+  void warnf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+  void errorf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+  /** Voor de LOG_*-macro's: "[TAG] " + printf; filtert zelf niet opnieuw. */
+  void logTag(LogLevel level, LogTag tag, const char* fmt, ...) __attribute__((format(printf, 4, 5)));
+
+  /** Tokenized: slot claimen (buf/cap = payload) en publiceren; zie LogTokenWriter. */
+  void* tokenClaim(uint8_t*& buf, size_t& cap);
+  void tokenPublish(void* slot, LogLevel level, LogTag tag, size_t len);
+
+  /** Berichten verloren door een volle ring (sinds boot). */
+  uint32_t dropped() const;
+  /** Hoogste bezetting van de ring (slots). */
+  uint16_t highWater() const;
+};
+
+extern Logger logger;
+
+/**
+ * Tokenized logging (build flag -DLOG_TOKENIZED=1). LOG_* zendt dan geen
+ * tekst maar het token van de format-string (FNV-1a 32, compile-time; de
+ * string zelf komt niet in flash) plus de argumenten binair: integers als
+ * zigzag-varint, float/double als float32, strings met lengtebyte (max 32).
+ * De drain-taak schrijft per record één regel "$<base64>" met
+ * [level | tag << 2][varint ms][token LE][args]. Decoderen op de host:
+ * scripts/log_detokenize.py (token-tabel uit de LOG_*-aanroepen in src/).
+ * Tekstlogs (logger.info(...)) blijven gewoon tekst op dezelfde poort.
+ */
+#ifndef LOG_TOKENIZED
+#define LOG_TOKENIZED 0
+#endif
+
+#define LOG_TOKEN_STR_MAX  32
+
+constexpr uint32_t logTokenHash(const char* s, uint32_t h = 2166136261UL) {
+  return *s ? logTokenHash(s + 1, (uint32_t)((h ^ (uint8_t)*s) * 16777619ULL)) : h;
+}
+
+class LogTokenWriter {
+public:
+  LogTokenWriter(uint8_t* buf, size_t cap) : buf(buf), cap(cap), n(0) {}
+
+  void put(uint8_t b) { if (n < cap) buf[n++] = b; }
+  void varint(uint64_t v) {
+    while (v >= 0x80) { put((uint8_t)(v | 0x80)); v >>= 7; }
+    put((uint8_t)v);
+  }
+  void sint(int64_t v) { varint(((uint64_t)v << 1) ^ (uint64_t)(v >> 63)); }
+
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type add(T v) {
+    sint((int64_t)v);
+  }
+  void add(double v) {
+    const float f = (float)v;
+    uint8_t b[4];
+    memcpy(b, &f, 4);
+    for (uint8_t i = 0; i < 4; i++) put(b[i]);
+  }
+  void add(const char* s) {
+    const size_t len = s ? strlen(s) : 0;
+    const uint8_t keep = (uint8_t)(len > LOG_TOKEN_STR_MAX ? LOG_TOKEN_STR_MAX : len);
+    put((uint8_t)(keep | (len > keep ? 0x80 : 0)));  // bit 7: afgekapt
+    for (uint8_t i = 0; i < keep; i++) put((uint8_t)s[i]);
+  }
+  void add(const void* p) { varint((uintptr_t)p); }
+
+  size_t size() const { return n; }
+
+private:
+  uint8_t* buf;
+  size_t cap;
+  size_t n;
 };
 
+template <typename... Args>
+void logTokenEmit(LogLevel level, LogTag tag, uint32_t token, Args... args) {
+  uint8_t* buf;
+  size_t cap;
+  void* slot = logger.tokenClaim(buf, cap);
+  if (!slot) return;
+  LogTokenWriter w(buf, cap);
+  for (uint8_t i = 0; i < 4; i++) w.put((uint8_t)(token >> (8 * i)));
+  const int expand[] = { 0, (w.add(args), 0)... };
+  (void)expand;
+  logger.tokenPublish(slot, level, tag, w.size());
+}
+
+#if LOG_TOKENIZED
+#define LOG_AT(lvl, tag, fmt, ...)                                                                  \
+  do {                                                                                              \
+    if ((int)(lvl) >= LOG_COMPILE_LEVEL && logger.tagEnabled(tag, lvl)) {                           \
+      logTokenEmit(lvl, tag, std::integral_constant<uint32_t, logTokenHash(fmt)>::value, ##__VA_ARGS__); \
+    }                                                                                               \
+  } while (0)
+#else
+#define LOG_AT(lvl, tag, fmt, ...)                                         \
+  do {                                                                     \
+    if ((int)(lvl) >= LOG_COMPILE_LEVEL && logger.tagEnabled(tag, lvl)) {  \
+      logger.logTag(lvl, tag, fmt, ##__VA_ARGS__);                         \
+    }                                                                      \
+  } while (0)
+#endif
+
+#define LOG_D(tag, fmt, ...) LOG_AT(LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+#define LOG_I(tag, fmt, ...) LOG_AT(LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#define LOG_W(tag, fmt, ...) LOG_AT(LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define LOG_E(tag, fmt, ...) LOG_AT(LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+
 #endif
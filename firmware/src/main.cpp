@@ -19,9 +19,13 @@
 #include "logger.h"
 #include "provisioning.h"
 #include "reset_button.h"
-#include "sensors.h"
 #include "sensors_pt1000.h"
+#include "sensor_calibration.h"
 #include "rs485_modbus.h"
+#include "controller_poll.h"
+#include "modbus_scheduler.h"
+#include "controller_discovery.h"
+#include "modbus_slave.h"
 #include "carel_protocol.h"
 #include "data_buffer.h"
 #include "wifi_manager.h"
@@ -29,7 +33,11 @@
 #include "battery_monitor.h"
 #include "power_monitor.h"
 #include "door_events.h"
-#include "door_contact.h"
+#include "door_analytics.h"
+#include "alarm_engine.h"
+#include "upload_priority.h"
+#include "haccp_log.h"
+#include "crash_log.h"
 #include "boot_state.h"
 #include "time_utils.h"
 #include "ota_update.h"
@@ -47,7 +55,6 @@ ProvisioningManager provisioning;
 // Single-button reset: BOOT knop (GPIO 0) 3 seconden vasthouden = factory reset
 // (RESET-knop op ESP32 DevKit is niet aan GPIO gekoppeld – alleen BOOT werkt)
 ResetButtonHandler resetButton(DEFAULT_BOOT_PIN, DEFAULT_RESET_PIN, BOOT_WINDOW_MS, RESET_HOLD_TIME_MS);
-Sensors sensors;
 // MAX31865 (PT1000) wordt nu beheerd door sensors_pt1000.* op carrier-PCB:
 // 2× sensor op gedeelde SPI, RREF = 4020 Ω, 2-wire, 50 Hz filter.
 static bool max31865Initialized = false;  // true als minstens 1 sensor OK bij init
@@ -68,13 +75,6 @@ TaskHandle_t modbusTaskHandle = NULL;
 TaskHandle_t uploadTaskHandle = NULL;
 TaskHandle_t commandTaskHandle = NULL;
 
-// Cross-task signal: zet sensorTask op true wanneer een gebeurtenis (bv.
-// USB-C in/uitgetrokken) een directe heartbeat + upload vereist. loop()
-// consumeert de flag en reset lastApiHeartbeat/lastUpload zodat de UI
-// binnen ~1 reading-cyclus reageert i.p.v. 30 s. unsigned long writes zijn
-// atomair op de ESP32-S3 (32-bit), dus geen mutex nodig.
-volatile bool g_forceImmediateSync = false;
-
 // Carrier: loop() is enige plek voor zware HTTPS-bursts; commandTask slaat poll
 // over zolang dit true is (voorkomt ieee80211_scan/timeout door parallel HTTP).
 #if defined(BOARD_LILYGO_T_SIM7670G_S3)
@@ -96,22 +96,8 @@ struct SensorReading {
   bool valid;
 };
 
-// Modbus data structure
-struct ModbusData {
-  float setpoint;
-  float currentTemp;
-  bool compressorStatus;
-  bool alarmStatus;
-  uint32_t timestamp;
-  bool valid;
-};
-
 // Door events: debounced, immediate POST, offline queue
 
-// Defrost: Carel PZD2S0P001 – booleans vaak bij 2-5, register 6 soms. Zie README.
-#define DEFROST_REG_ADDR  0x0006  // Holding register (F06)
-#define DEFROST_COIL_ADDR 0x0002  // Coil (F05) – Carel booleans start bij 2
-
 // Controller type from API (override config when set)
 static String controllerTypeFromApi = "";
 static unsigned long g_systemReadyMs = 0;
@@ -126,6 +112,7 @@ void commandTask(void *parameter);
 void setupWiFi();
 void setupOTA();
 void deepSleepIfNeeded();
+static void persistDiscoveryResult();
 
 // Serienummer voor deviceId: provisioning (ColdMonitor-setup) heeft voorrang, anders config
 static String getEffectiveDeviceSerial() {
@@ -161,6 +148,8 @@ void setup() {
   initWatchdog();
 
   Serial.begin(115200);
+  crashLogBegin();  // log van de vorige boot (RTC) veiligstellen vóór er nieuwe regels komen
+  logger.begin();  // drain-taak: logging schrijft vanaf hier asynchroon
   delay(1000);
   kickWatchdog();
 
@@ -186,6 +175,12 @@ void setup() {
   kickWatchdog();
   logger.info("SPIFFS initialized");
 
+  // HACCP-log: keten herberekenen uit SPIFFS vóór de eerste meting.
+  if (!initHaccpLog()) {
+    logger.error("HACCP-log init mislukt — metingen worden niet geketend");
+  }
+  kickWatchdog();
+
   // Initialize Provisioning Manager (NVS open)
   if (!provisioning.begin()) {
     logger.error("CRITICAL: Provisioning manager initialization failed!");
@@ -282,9 +277,24 @@ void setup() {
   // openen ná MAX31865 gaf TLSF heap-asserts op ESP32-S3.
   dataBuffer.init();
   logger.info("Data buffer initialized (offline queue)");
+  if (dataBuffer.recoveryCleared > 0) {
+    haccpLogEvent(HACCP_KIND_BUFFER_CLEAR, (uint32_t)dataBuffer.recoveryCleared);
+  }
   
   // ADC/deur vóór WiFi: setupWiFi() gebruikt battery/power voor API-handshake
-  sensors.init();
+  // Deur: één service (DoorEventManager) voor GPIO, debounce, open-duur,
+  // events en status; GPIO-interrupt + esp_timer-debounce, geen polling.
+  if (doorEventManager.begin(PIN_DOOR, PIN_DOOR_INVERTED)) {
+    logger.info("Deur init: " + String(doorEventManager.isOpen() ? "OPEN" : "DICHT") +
+                " (GPIO" + String(PIN_DOOR) + ", interrupt)");
+    if (doorEventManager.replayedOnBoot() > 0) {
+      logger.info("Deur-log: " + String(doorEventManager.replayedOnBoot()) +
+                  " event(s) hersteld uit " + doorEventManager.replaySource() +
+                  ", seq vanaf " + String(doorEventManager.getSeq()));
+    }
+  } else {
+    logger.error("Deur: debounce-timer aanmaken mislukt — geen deur-events");
+  }
   logger.info("Sensors (door) initialized");
   batteryMonitor.init();
   powerMonitor.init();
@@ -295,6 +305,10 @@ void setup() {
   // in setup().
   kickWatchdog();
 
+  // Veldkalibratie uit NVS vóór de eerste meting (ook met DIAG_SKIP_PT1000:
+  // lazy reads in sensorTask gebruiken dezelfde coëfficiënten).
+  loadSensorCalibration();
+
 #ifndef DIAG_SKIP_PT1000
   // PT1000 × 2 op gedeelde SPI; moet uit de heap zijn vóór WiFi-geheugen claimt.
   max31865Initialized = initSensors();
@@ -304,10 +318,13 @@ void setup() {
 #endif
   kickWatchdog();
   initRelay();
-  initDoor();
+  // Na initRelay(): actieve alarmen uit NVS; het relais volgt pas bij de
+  // eerste alarmEngineEvaluate() (sensorTask).
+  initAlarmEngine();
   // RS485 (MAX3485) op carrier v1.1: TX=GPIO38, RX=GPIO39, DE=GPIO40 (U7).
-  // DE wordt LOW gezet (ontvanger actief). Een latere Modbus-init mag
-  // Serial1 opnieuw configureren.
+  // DE actief-hoog, LOW = ontvanger actief. Modbus/Carel-init adopteren deze
+  // bus (pins in config moeten overeenkomen); baud en framing zet elke job
+  // zelf.
   initRS485(9600);
   initExternalPowerSense();
   // SIM7670G modem opstarten zodat we via AT+CBC de batterijspanning kunnen
@@ -341,26 +358,41 @@ void setup() {
   }
 
   
-  // Initialize RS485: Carel PJEZ (supervisie) OF Modbus RTU
-  // LilyGO: NVS kan nog carelProtocolEnabled:true hebben; Serial2/Carel hoort niet op het
+  // Initialize RS485: Carel PJEZ (supervisie) EN/OF Modbus RTU op dezelfde
+  // bus (rs485_bus serialiseert beide en schakelt per job de framing om).
+  // LilyGO: NVS kan nog carelProtocolEnabled:true hebben; Carel hoort niet op het
   // standaard board en droeg bij aan heap/crash — forceer uit op deze build.
 #if defined(BOARD_LILYGO_T_SIM7670G_S3)
   const bool carelMode = false;
 #else
   bool carelMode = config.getCarelProtocolEnabled();
 #endif
-  if (carelMode) {
-    ModbusConfig mcfg = config.getModbusConfig();
-    if (carel.init(mcfg.rxPin, mcfg.txPin, mcfg.dePin)) {
-      logger.info("RS485/Carel PJEZ protocol initialized (1200 8N2)");
-    } else {
-      logger.error("Carel protocol init failed!");
+  if (config.getModbusSlaveMode()) {
+    // Gateway: het toestel is zelf slave voor een GBS/BMS; geen regelaar-poll.
+    if (!initModbusSlave(config.getModbusConfig())) {
+      logger.error("RS485/Modbus slave-mode init failed!");
     }
-  } else if (config.getModbusEnabled()) {
-    if (modbus.init(config.getModbusConfig())) {
-      logger.info("RS485/Modbus initialized");
-    } else {
-      logger.error("RS485/Modbus initialization failed!");
+  } else {
+    if (carelMode) {
+      ModbusConfig mcfg = config.getModbusConfig();
+      if (carel.init(mcfg.rxPin, mcfg.txPin, mcfg.dePin)) {
+        logger.info("RS485/Carel PJEZ protocol initialized (1200 8N2)");
+      } else {
+        logger.error("Carel protocol init failed!");
+      }
+    }
+    if (config.getModbusEnabled()) {
+      const ModbusConfig mcfg = config.getModbusConfig();
+      if (modbus.init(mcfg)) {
+        logger.info("RS485/Modbus initialized");
+      } else {
+        logger.error("RS485/Modbus initialization failed!");
+      }
+      // Slot 0 = regelaar uit de settings (profiel volgt bij de eerste fetch),
+      // extra regelaars op dezelfde bus uit config "modbus.slaves".
+      modbusSchedulerSetPrimary(mcfg.slaveId, controllerTypeFromApi);
+      ModbusSlaveConfig extra[CONTROLLER_MAX_SLAVES - 1];
+      modbusSchedulerSetExtraSlaves(extra, config.getModbusSlaves(extra, CONTROLLER_MAX_SLAVES - 1));
     }
   }
   
@@ -383,11 +415,12 @@ void setup() {
     1
   );
   
-#if !defined(BOARD_LILYGO_T_SIM7670G_S3)
-  // Op carrier: geen achtergrond-Modbus-poll. Dixell is optioneel; periodieke
-  // reads veroorzaakten TASK_WDT-resets (IDLE0) en reboot-loops. RS485 werkt
-  // enkel on-demand via commandTask (app-commando's).
-  if (config.getModbusEnabled() && !carelMode) {
+  // Achtergrond-poll ook op de carrier: de oude busy-poll RX (vTaskDelay(1)
+  // per byte, tot 350 ms) gaf daar TASK_WDT-resets (IDLE0). De bus-worker
+  // slaapt nu op UART-events, dus wachten op een (afwezige) regelaar kost
+  // geen CPU meer. Een slave die niet antwoordt krijgt backoff in modbus_scheduler.
+  // Carel-requests delen de bus via dezelfde queue.
+  if (config.getModbusEnabled() && !modbusSlaveActive()) {
     xTaskCreatePinnedToCore(
       modbusTask,
       "ModbusTask",
@@ -398,11 +431,6 @@ void setup() {
       1
     );
   }
-#else
-  if (config.getModbusEnabled() && !carelMode) {
-    logger.info("Modbus: achtergrond-poll uit (carrier) — alleen via app-commando");
-  }
-#endif
   
 #if !defined(BOARD_LILYGO_T_SIM7670G_S3)
   xTaskCreatePinnedToCore(
@@ -453,7 +481,6 @@ void setup() {
 
 void loop() {
   kickWatchdog();
-  updateDoor();
 
 #if defined(BOARD_LILYGO_T_SIM7670G_S3)
   // Eerste 8 s na System Ready: geen HTTP/WiFi-API in loop (uploads,
@@ -479,6 +506,9 @@ void loop() {
     return;
   }
   
+  // Discovery-resultaat van modbusTask: config/NVS enkel vanuit loop().
+  persistDiscoveryResult();
+
   // Main loop handles system-level tasks (alle HTTP hier: zelfde core als WiFi → voorkomt Invalid mbox)
   static unsigned long lastHeartbeat = 0;
   static unsigned long lastApiHeartbeat = 0;
@@ -496,13 +526,11 @@ void loop() {
   
   unsigned long now = millis();
 
-  // Force-sync flag van sensorTask: bv. USB-C in/uitgetrokken. Reset
-  // heartbeat- en upload-timers zodat loop() ze ditzelfde rondje aftrapt.
-  if (g_forceImmediateSync) {
-    g_forceImmediateSync = false;
+  // Dringende wissel in sensorTask (alarm, USB-C): heartbeat ditzelfde rondje.
+  // De reading zelf gaat via de urgent-lane hieronder, los van lastUpload.
+  if (uploadPriorityHeartbeatDue()) {
     lastApiHeartbeat = 0;
-    lastUpload       = 0;
-    logger.info("[POWER] force immediate sync (heartbeat + upload)");
+    logger.info("[URGENT] heartbeat geforceerd");
   }
 
   // USB-detectie (indien USB_ADC geconfigureerd)
@@ -519,16 +547,15 @@ void loop() {
     int vbusMv  = analogReadMilliVolts(PIN_VBUS_DETECT);
     int vbusNow = (vbusMv >= 700) ? 1 : 0;
     if (vbusNow != vbusBoolLast) {
-      logger.info(String("[VBUS] GPIO") + PIN_VBUS_DETECT + " -> " +
-                  (vbusNow ? "HIGH (USB-C aanwezig)" : "LOW (USB-C weg)") +
-                  " (" + vbusMv + " mV)");
+      LOG_I(LOG_TAG_VBUS, "GPIO%d -> %s (%d mV)", PIN_VBUS_DETECT,
+            vbusNow ? "HIGH (USB-C aanwezig)" : "LOW (USB-C weg)", vbusMv);
       vbusBoolLast = vbusNow;
     }
+    // Periodiek enkel op debug-level; in de release-build weggecompileerd.
     if (now - vbusLastPeriodic >= 5000) {
       vbusLastPeriodic = now;
-      logger.info(String("[VBUS] periodic GPIO") + PIN_VBUS_DETECT +
-                  " adc=" + vbusMv + "mV bool=" + vbusNow +
-                  " isUsbConnected()=" + (powerMonitor.isUsbConnected() ? "1" : "0"));
+      LOG_D(LOG_TAG_VBUS, "periodic GPIO%d adc=%dmV bool=%d isUsbConnected()=%d", PIN_VBUS_DETECT, vbusMv, vbusNow,
+            powerMonitor.isUsbConnected() ? 1 : 0);
     }
   }
   
@@ -596,22 +623,33 @@ void loop() {
   // oude NVS kan nog carelProtocolEnabled:true hebben.)
 #if !defined(BOARD_LILYGO_T_SIM7670G_S3)
   static bool carelTestDone = false;
+  // Eén async batch (temperatuur + defrost params) op de bus-queue: loop()
+  // blokkeert niet, het resultaat wordt vanuit de bus-worker gelogd.
+  static CarelRequest carelTest = {};
   if (!carelTestDone && now > 8000 && config.getCarelProtocolEnabled()) {
     carelTestDone = true;
     logger.info("=== CAREL CONNECTIETEST ===");
-    float t = carel.readTemperature();
-    if (!isnan(t)) {
-      logger.info("Carel OK: temperatuur = " + String(t) + " °C");
-    } else {
-      logger.warn("Carel FOUT: geen antwoord. Check A/B bekabeling (probeer groen/wit omwisselen).");
-    }
-    int ty, iv, du;
-    if (carel.readDefrostParams(ty, iv, du)) {
-      logger.info("Carel OK: type=" + String(ty) + " interval=" + String(iv) + "h duur=" + String(du) + "min");
-    } else {
-      logger.warn("Carel FOUT: defrost params niet leesbaar.");
+    static const uint16_t kVars[4] = { CAREL_TEMPERATURE, CAREL_DEFROST_TYPE, CAREL_DEFROST_INTV, CAREL_DEFROST_DUR };
+    carelTest.count = 4;
+    for (uint8_t i = 0; i < 4; i++) {
+      carelTest.items[i].op = CAREL_REQ_READ_I;
+      carelTest.items[i].var = kVars[i];
     }
-    logger.info("=== EINDE CONNECTIETEST ===");
+    carelTest.callback = [](CarelRequest& req, void*) {
+      if (req.items[0].status == CAREL_OK) {
+        logger.info("Carel OK: temperatuur = " + String(req.items[0].value / 10.0f) + " °C");
+      } else {
+        logger.warn("Carel FOUT: geen antwoord. Check A/B bekabeling (probeer groen/wit omwisselen).");
+      }
+      if (req.okCount == 4) {
+        logger.info("Carel OK: type=" + String(req.items[1].value) + " interval=" + String(req.items[2].value) +
+                    "h duur=" + String(req.items[3].value) + "min");
+      } else {
+        logger.warn("Carel FOUT: defrost params niet leesbaar.");
+      }
+      logger.info("=== EINDE CONNECTIETEST (" + String(req.busUs / 1000) + " ms) ===");
+    };
+    if (!carel.submit(&carelTest)) logger.warn("Carel FOUT: bus-queue vol of Carel niet geïnitialiseerd.");
   }
 #endif
 
@@ -676,32 +714,53 @@ void loop() {
         deviceMinTemp = mt;
         deviceMaxTemp = Mx;
         deviceDoorAlarmDelaySec = dd;
+        doorAnalyticsSetAjarDelay(deviceDoorAlarmDelaySec);
+        alarmEngineSetThresholds(deviceMinTemp, deviceMaxTemp);
         if (ctrlType.length() > 0) {
           controllerTypeFromApi = ctrlType;
           controllerSlaveAddrFromApi = ctrlSlave;
           controllerBaudRateFromApi = ctrlBaud;
 
           // Auto-enable RS485 zodra de webapp een regelaar configureert.
-          // Het Carel-supervisieprotocol is op carrier v1.1 niet meer actief
-          // (Serial2 is voorbehouden voor de SIM7670G-modem), dus elke
+          // Het Carel-supervisieprotocol is op carrier v1.1 niet actief
+          // (forceert carelMode uit, zie setup()), dus elke
           // controller_type uit de API behandelen we als Modbus RTU.
           // Default-config (modbusEnabled=false) zou anders het hele
           // command-task-poll-loop overslaan en commando's blijven hangen
           // op PENDING.
           bool wantCarel  = (controllerTypeFromApi.indexOf("CAREL_PJEZ") >= 0);
-          bool wantModbus = !wantCarel;
+          // In slave-mode is de bus van de GBS: geen master-stack starten.
+          bool wantModbus = !wantCarel && !modbusSlaveActive();
           if (wantModbus) {
             ModbusConfig mcfg = config.getModbusConfig();
             int newBaud  = ctrlBaud  > 0 ? ctrlBaud  : (int)mcfg.baudRate;
             int newSlave = ctrlSlave > 0 ? ctrlSlave : (int)mcfg.slaveId;
+            uint32_t newFraming = mcfg.serialConfig;
+            // Discovery vond eerder voor exact deze settings een regelaar die
+            // de API-slave/baud respecteert: dat resultaat wint (vult enkel
+            // aan wat de API openliet, of framing). Geen slave of baud in de
+            // settings en nog niets gecachet → zelf zoeken.
+            DiscoveryCandidate disc;
+            const uint8_t apiSlave = ctrlSlave > 0 ? (uint8_t)ctrlSlave : 0;
+            const uint32_t apiBaud = ctrlBaud > 0 ? (uint32_t)ctrlBaud : 0;
+            if (controllerDiscoveryCached(apiSlave, apiBaud, disc) && disc.protocol == DISCOVERY_MODBUS) {
+              newBaud = (int)disc.baud;
+              newSlave = disc.addr;
+              newFraming = disc.serialConfig;
+            } else if (!apiSlave || !apiBaud) {
+              controllerDiscoveryRequest("settings zonder slave/baud", apiSlave, apiBaud);
+            }
             bool changed = ((uint32_t)newBaud != mcfg.baudRate) ||
-                           ((uint8_t)newSlave != mcfg.slaveId);
+                           ((uint8_t)newSlave != mcfg.slaveId) ||
+                           (newFraming != mcfg.serialConfig);
             mcfg.baudRate = newBaud;
             mcfg.slaveId  = newSlave;
+            mcfg.serialConfig = newFraming;
             if (changed) {
               config.setModbusConfig(mcfg);
               config.save();
             }
+            modbusSchedulerSetPrimary((uint8_t)newSlave, controllerTypeFromApi);
             if (!config.getModbusEnabled()) {
               config.setModbusEnabled(true);
               config.save();
@@ -760,7 +819,7 @@ void loop() {
       }
     }
 #else
-    logger.debug(String("Voeding: ") + (powerMonitor.isUsbConnected() ? "externe VBUS aanwezig" : "batterij/onbekend"));
+    LOG_D(LOG_TAG_POWER, "Voeding: %s", powerMonitor.isUsbConnected() ? "externe VBUS aanwezig" : "batterij/onbekend");
 #endif
 
     lastBatteryCheck = now;
@@ -768,33 +827,56 @@ void loop() {
   
   // Uploads (alle HTTP in loop = zelfde core als WiFi, voorkomt Invalid mbox crash)
   if (WiFi.isConnected() && provisioning.hasAPICredentials()) {
-    // DEUR EVENTS – single upload (batch endpoint gaf 500; single werkt stabiel)
-    static DoorEvent retryEv;
-    static bool hasRetry = false;
-    if (hasRetry) {
-      const char* st = retryEv.isOpen ? "OPEN" : "CLOSED";
+    // URGENT-LANE eerst: alarm-/voedingswissels gaan vóór deur-events en de
+    // bulk-backlog, zonder uploadInterval of UPLOAD_BATCH. Eén per ronde;
+    // loop() komt binnen ~100 ms terug zolang er iets pending is.
+    String urgent;
+    bool urgentSettleOk = true;
+#if defined(BOARD_LILYGO_T_SIM7670G_S3)
+    urgentSettleOk = (g_systemReadyMs == 0) || ((now - g_systemReadyMs) >= 8000);
+#endif
+    if (urgentSettleOk && uploadPriorityPeek(urgent)) {
 #if defined(BOARD_LILYGO_T_SIM7670G_S3)
       carrierHttpSessionBegin();
 #endif
-      if (apiClient.uploadDoorEvent(st, retryEv.seq, retryEv.timestamp, retryEv.rssi, retryEv.uptimeMs)) {
-        hasRetry = false;
-        logger.info("Deur-event retry OK");
+      if (apiClient.uploadReading(urgent)) {
+        uploadPriorityPop(true);
+      } else {
+        const int code = apiClient.lastReadingHttpCode;
+        if (code >= 400 && code < 500) {
+          logger.warn(String("[URGENT] upload 4xx (") + code + ") — drop reading: " + urgent);
+          uploadPriorityPop(false);
+        } else {
+          logger.warn("[URGENT] upload mislukt, retry over " + String(URGENT_RETRY_MS / 1000) + "s");
+          uploadPriorityFailed();
+        }
       }
     }
-    if (!hasRetry && doorEventManager.hasPending()) {
-      DoorEvent ev;
-      if (doorEventManager.dequeue(ev)) {
-        const char* st = ev.isOpen ? "OPEN" : "CLOSED";
+
+    // DEUR EVENTS – single upload (batch endpoint gaf 500; single werkt stabiel).
+    // peek → upload → pop: een mislukte upload blijft vooraan in de queue staan
+    // en wordt de volgende ronde opnieuw geprobeerd (seq blijft gelijk, backend
+    // is idempotent op (deviceId, seq)).
+    DoorEvent ev;
+    doorEventManager.completePending();
+    // Drukte (levering): enkel de nieuwste toestand uploaden. De flanken
+    // ertussen zitten al in de door-analytics (completePending) en gaan als
+    // door_stats mee met de heartbeat — enkel zodra de backend die opslaat.
+    const int doorQueued = doorEventManager.getQueueCount();
+    if (doorQueued >= DOOR_UPLOAD_COALESCE_MIN && doorAnalyticsBackendStores()) {
+      for (int i = 0; i < doorQueued - 1; i++) doorEventManager.pop();
+      logger.info("Deur: " + String(doorQueued - 1) + " event(s) samengevoegd (in door_stats)");
+    }
+    if (doorEventManager.peek(ev)) {
+      const char* st = ev.isOpen ? "OPEN" : "CLOSED";
 #if defined(BOARD_LILYGO_T_SIM7670G_S3)
-        carrierHttpSessionBegin();
+      carrierHttpSessionBegin();
 #endif
-        if (apiClient.uploadDoorEvent(st, ev.seq, ev.timestamp, ev.rssi, ev.uptimeMs)) {
-          logger.info("Deur-event verstuurd");
-        } else {
-          retryEv = ev;
-          hasRetry = true;
-          logger.warn("Deur-event upload mislukt, retry later");
-        }
+      if (apiClient.uploadDoorEvent(st, ev.seq, ev.timestamp, ev.rssi, ev.uptimeMs)) {
+        doorEventManager.pop();
+        logger.info("Deur-event verstuurd (seq=" + String(ev.seq) + ")");
+      } else {
+        logger.warn("Deur-event upload mislukt, retry later");
       }
     }
     int count = dataBuffer.getCount();
@@ -805,6 +887,8 @@ void loop() {
       shouldUpload = false;
     }
 #endif
+    // Bulk wacht zolang de urgent-lane niet leeg is.
+    if (uploadPriorityPending() > 0) shouldUpload = false;
     if (shouldUpload && count > 0) {
 #if defined(BOARD_LILYGO_T_SIM7670G_S3)
       carrierHttpSessionBegin();
@@ -827,7 +911,7 @@ void loop() {
         String data = dataBuffer.get(i);
         if (apiClient.uploadReading(data)) {
           uploaded++;
-          logger.debug("Uploaded: " + data);
+          LOG_D(LOG_TAG_NET, "Uploaded: %s", data.c_str());
         } else {
           int code = apiClient.lastReadingHttpCode;
           // 4xx = backend wijst de payload zelf permanent af (bv. validatie).
@@ -880,15 +964,18 @@ void loop() {
     deepSleepIfNeeded();
   }
   
+    // Niet-ge-uploade deur-events gebundeld naar NVS (koude-boot backup).
+    doorEventManager.persist();
+    doorAnalyticsService();
+    haccpLogService();
     kickWatchdog();
-    delay(doorEventManager.hasPending() ? 10 : 100);
+    delay((doorEventManager.hasPending() || uploadPriorityPending() > 0) ? 10 : 100);
 }
 
 void sensorTask(void *parameter) {
   logger.info("Sensor task started");
   
   unsigned long lastReading = 0;
-  unsigned long lastDoorCheck = 0;
   unsigned long interval = config.getReadingInterval() * 1000; // ms
   static float lastKnownTemp = 0.0f;
   static bool hasValidReading = false;
@@ -896,16 +983,6 @@ void sensorTask(void *parameter) {
   while (true) {
     unsigned long now = millis();
     
-    // Eerste run: sync deur-state met hardware (voorkomt spurious event)
-    static bool doorInitDone = false;
-    if (!doorInitDone) {
-      doorInitDone = true;
-      delay(100);  // Korte stabilisatie na boot
-      bool initDoor = sensors.readDoorOnly();
-      doorEventManager.setInitialState(initDoor);
-      logger.info("Deur init: " + String(initDoor ? "OPEN" : "DICHT") + " (GPIO" + String(PIN_DOOR) + ")");
-    }
-
     // --- Instant USB-C / VBUS edge-detect -----------------------------------
     // Detecteer USB-C in/uit binnen ~500 ms (powerMonitor.update() interval) en
     // forceer dan onmiddellijk een nieuwe full-reading zodat de backend/UI niet
@@ -925,84 +1002,68 @@ void sensorTask(void *parameter) {
                             : "ontkoppeld — op batterij"));
         usbPrev = usbNow;
         // 1) Forceer een nieuwe full-reading op de eerstvolgende cyclus.
-        // 2) Zet de cross-task flag zodat loop() onmiddellijk een heartbeat
-        //    afvuurt + alle gebufferde readings uploadt. Doel: het alarm in
-        //    de webapp verschijnt binnen seconden in plaats van pas bij de
-        //    volgende reading/upload-interval (~30 s).
+        // 2) Markeer die reading als dringend: loop() vuurt meteen een
+        //    heartbeat af en uploadt de reading via de urgent-lane, vóór de
+        //    bulk-backlog. Doel: het alarm in de webapp verschijnt binnen
+        //    seconden in plaats van pas bij de volgende upload-interval.
         lastReading = 0;
-        g_forceImmediateSync = true;
+        requestUrgentSync(URGENT_POWER);
       }
     }
 
-    // Deur elke 15 ms pollen. Debounced state-change (stabiel ≥30 ms) gaat
-    // meteen in de event-queue én wordt direct gelogd (zie 'Deur OPEN/DICHT').
-    // Extra: we loggen ook elke RAW pin-transitie onmiddellijk, zodat je in de
-    // seriële monitor real-time ziet dat de reed schakelt, ook tijdens bouncing.
-    if (now - lastDoorCheck >= 15) {
-      bool doorOpen = sensors.readDoorOnly();
-      static bool prevRaw = doorOpen;
-      static bool prevRawInit = false;
-      if (!prevRawInit) { prevRaw = doorOpen; prevRawInit = true; }
-      if (doorOpen != prevRaw) {
-        logger.info(String("Deur ") + (doorOpen ? "OPEN" : "DICHT") +
-                    " (raw, GPIO" + String(PIN_DOOR) + ")");
-        prevRaw = doorOpen;
-      }
-      if (doorEventManager.poll(doorOpen)) {
-        DoorEvent ev;
-        ev.isOpen = doorOpen;
-        ev.timestamp = getUnixTimeMs() ? getUnixTimeMs() : (uint64_t)now;  // Unix ms of millis fallback
-        ev.seq = doorEventManager.getNextSeq();
-        ev.rssi = WiFi.isConnected() ? WiFi.RSSI() : 0;
-        ev.uptimeMs = now;
-        doorEventManager.enqueue(ev);
-        logger.info("Deur " + String(doorOpen ? "OPEN" : "DICHT") + " (seq=" + String(ev.seq) + ") – event in queue");
+    // Deur-events ontstaan in de interrupt/debounce-timer (DoorEventManager);
+    // hier enkel loggen wat er intussen gepubliceerd is. Loggen kan niet vanuit
+    // de ISR en hoort niet in de esp_timer-taak.
+    {
+      static uint32_t lastLoggedSeq = 0;
+      DoorSnapshot door = doorEventManager.snapshot();
+      if (door.seq != lastLoggedSeq) {
+        String line = "Deur " + String(door.open ? "OPEN" : "DICHT");
+        if (!door.open) line += " na " + String(door.lastOpenDurationMs / 1000) + "s";
+        line += " (seq=" + String(door.seq) + ", " + String(doorEventManager.lastBurstEdges()) +
+                " flank(en)) – event in queue";
+        logger.info(line);
+        lastLoggedSeq = door.seq;
       }
-      lastDoorCheck = now;
     }
-    
+
+    // Lokale alarmen op gecachte waarden; bij een wissel meteen een reading
+    // via de urgent-lane (zelfde pad als de USB-transitie hierboven).
+    if (alarmEngineEvaluate()) {
+      lastReading = 0;
+      requestUrgentSync(URGENT_ALARM);
+    }
+    // Slave-mode: register-image uit dezelfde caches (geen SPI per request).
+    if (modbusSlaveActive()) modbusSlaveUpdateImage();
+
     // Volledige sensorread op interval (temp via MAX31865, deur)
     if (now - lastReading >= interval) {
-      SensorData data = sensors.read();
-
-      // PT1000 #1 = RUIMTE (koelcel-ambient, primaire temperatuur)
-      // We hangen niet langer aan `max31865Initialized` van bij boot:
-      // sensorOk() bekijkt elke read of de chip nu een geldige meting geeft.
-      // Hierdoor kan een sensor die ná boot wordt aangesloten (of een chip die
-      // eerder niet bereikbaar was) automatisch in de upload verschijnen
-      // zonder reboot.
-      float   roomTemp  = readRoomTempC();
-      uint8_t roomFlt   = roomSensorFault();
-      bool    roomOk    = roomSensorOk() && !isnan(roomTemp);
-
-      // PT1000 #2 = VERDAMPER (evaporator-coil, diagnose/defrost)
-      float   evapTemp  = readEvaporatorTempC();
-      uint8_t evapFlt   = evaporatorFault();
-      bool    evapOk    = evaporatorSensorOk() && !isnan(evapTemp);
-
-      if (roomOk) {
-        data.temperature = roomTemp;
-        data.valid = true;
+      const DoorSnapshot door = doorEventManager.snapshot();
+      float temperature = 0.0f;
+      bool  valid = false;
+
+      // Alle PT1000-kanalen uit de kanaaltabel meten; de ruimte-voeler is
+      // de primaire temperatuur. We hangen niet langer aan
+      // `max31865Initialized` van bij boot: sensorOk() bekijkt elke read of
+      // de chip nu een geldige meting geeft. Hierdoor kan een sensor die ná
+      // boot wordt aangesloten automatisch in de upload verschijnen zonder
+      // reboot.
+      sampleSensors();
+      // HACCP: elke meting (ook met fout) geketend; enkel queue, hash + SPIFFS in loop().
+      haccpLogReading(activeAlarmMask(), door.open, powerMonitor.isUsbConnected());
+      const int8_t primaryIdx = sensorIndexForRole(SENSOR_ROLE_ROOM);
+      const bool   primaryOk  = primaryIdx >= 0 && sensorOk((uint8_t)primaryIdx);
+
+      if (primaryOk) {
+        temperature = getCachedTempC((uint8_t)primaryIdx);
+        valid = true;
       }
 
-      // Gecombineerde log: tonen welke voeler wel/niet werkt.
-      String logLine = "MAX31865 | ruimte=";
-      logLine += roomOk ? (String(roomTemp, 2) + "°C")
-                        : ("--- (fault=0x" + String(roomFlt, HEX) + ")");
-      logLine += " | verdamper=";
-      logLine += evapOk ? (String(evapTemp, 2) + "°C")
-                        : ("--- (fault=0x" + String(evapFlt, HEX) + ")");
-      logLine += " | Deur: ";
-      logLine += data.doorOpen ? "OPEN" : "dicht";
-      if (roomOk) {
-        logger.info(logLine);
-      } else {
-        logLine += " (pin=" + String(data.doorPinHigh ? 1 : 0) + ")";
-        logger.warn(logLine);
-      }
+      // Tonen welke voeler wel/niet werkt.
+      logSensorsSummary(primaryOk, door.open, doorEventManager.rawPinHigh());
 
-      if (data.valid) {
-        lastKnownTemp = data.temperature;
+      if (valid) {
+        lastKnownTemp = temperature;
         hasValidReading = true;
 
         batteryMonitor.update();
@@ -1019,17 +1080,16 @@ void sensorTask(void *parameter) {
         (void)vUsb;  /* Op carrier digitaal gemeten; analog-drempel niet van toepassing. */
         bool charging = usbConnected && (batPct > 0) && (batPct < 100);
 
-        DynamicJsonDocument doc(512);
+        DynamicJsonDocument doc(1024);  // + per-slave regelaarwaarden
         doc["deviceId"] = getEffectiveDeviceSerial();
-        doc["temperature"] = round(data.temperature * 10) / 10.0;  // ruimte, 1 decimaal
-        // Verdamper-voeler: enkel meesturen als geldig; bij fout null.
-        if (evapOk) {
-          doc["evaporatorTemp"] = round(evapTemp * 10) / 10.0;
-        } else {
-          doc["evaporatorTemp"] = (const char*)nullptr;  // JSON null
-        }
-        doc["evaporatorFault"] = evapFlt;
-        doc["doorStatus"] = data.doorOpen;
+        // Per kanaal readingKey (ruimte = "temperature", 1 decimaal) + faultKey;
+        // ongeldige voelers als JSON null.
+        writeSensorsReadingJson(doc);
+        doc["calVersion"] = sensorCalVersion();
+        doc["alarms"] = activeAlarmMask();
+        // Regelaarwaarden per slave; enkel wat de laatste 10 min gepolld is.
+        writeControllersReadingJson(doc, 10UL * 60UL * 1000UL);
+        doc["doorStatus"] = door.open;
         /* Carrier: VBUS_DETECT is digitaal, dus powerStatus is altijd geldig. */
         doc["powerStatus"] = usbConnected;
         // batteryLevel: -1 = sentinel "nog geen geldige meting" (modem niet
@@ -1048,57 +1108,96 @@ void sensorTask(void *parameter) {
 
         String jsonData;
         serializeJson(doc, jsonData);
-        dataBuffer.add(jsonData);
-        
-        logger.debug("Reading buffered");
+        if (uploadPriorityTakeReading(jsonData)) {
+          LOG_D(LOG_TAG_NET, "Reading in urgent-lane");
+        } else {
+          dataBuffer.add(jsonData);
+          LOG_D(LOG_TAG_NET, "Reading buffered");
+        }
       } else {
-        logger.warn(String("No valid sensor reading! Deur: ") + (data.doorOpen ? "OPEN" : "dicht") + " (pin=" + String(data.doorPinHigh ? 1 : 0) + ")");
+        // Geen reading (bv. SENSOR_FAULT): de geforceerde heartbeat meldt het alarm.
+        uploadPriorityNoReading();
+        logger.warn(String("No valid sensor reading! Deur: ") + (door.open ? "OPEN" : "dicht") + " (pin=" + String(doorEventManager.rawPinHigh() ? 1 : 0) + ")");
       }
       
       lastReading = now;
     }
     
-    vTaskDelay(pdMS_TO_TICKS(50));
+    // Geen deur-polling meer: deze taak hoeft enkel USB-flanken (~500 ms)
+    // en de readingInterval te volgen.
+    vTaskDelay(pdMS_TO_TICKS(200));
+  }
+}
+
+// Discovery-resultaat voor de config: modbusTask zet het klaar, loop() (die
+// ook de settings schrijft) bewaart het. ConfigManager is niet thread-safe.
+static portMUX_TYPE s_discoveryMux = portMUX_INITIALIZER_UNLOCKED;
+static bool s_discoveryCfgPending = false;
+static DiscoveryCandidate s_discoveryCfg;
+
+// loop(): klaargezet discovery-resultaat in config (NVS) zetten.
+static void persistDiscoveryResult() {
+  portENTER_CRITICAL(&s_discoveryMux);
+  const bool pending = s_discoveryCfgPending;
+  const DiscoveryCandidate best = s_discoveryCfg;
+  s_discoveryCfgPending = false;
+  portEXIT_CRITICAL(&s_discoveryMux);
+  if (!pending) return;
+  ModbusConfig mcfg = config.getModbusConfig();
+  if (mcfg.baudRate != best.baud || mcfg.serialConfig != best.serialConfig || mcfg.slaveId != best.addr) {
+    mcfg.baudRate = best.baud;
+    mcfg.serialConfig = best.serialConfig;
+    mcfg.slaveId = best.addr;
+    config.setModbusConfig(mcfg);
+    config.save();
   }
 }
 
+// modbusTask: beste discovery-kandidaat overnemen in lijn en scheduler; de
+// config volgt via loop(). Enkel kandidaten die de API-hint respecteren
+// (controllerDiscoveryBest), de rest staat alleen in het heartbeat-rapport.
+static void applyDiscoveryResult() {
+  DiscoveryCandidate best;
+  if (!controllerDiscoveryBest(best)) return;
+  portENTER_CRITICAL(&s_discoveryMux);
+  s_discoveryCfg = best;
+  s_discoveryCfgPending = true;
+  portEXIT_CRITICAL(&s_discoveryMux);
+  modbus.setLine(best.baud, best.serialConfig);
+  modbusSchedulerSetPrimary(best.addr, controllerTypeFromApi);
+  modbusSchedulerForceProbe(0);
+}
+
 void modbusTask(void *parameter) {
   logger.info("Modbus task started (regelaar optioneel — geen hang bij afwezigheid)");
   
-  ModbusData modbusData;
-  unsigned long lastRead = 0;
-  unsigned long interval = config.getModbusInterval() * 1000;
-  unsigned long lastPauseLog = 0;
-  
+  // Elke tick pollt de scheduler per slave enkel de profielpunten die aan de
+  // beurt zijn (poll-periode per punt, minstens modbusInterval), met zo
+  // weinig mogelijk multi-register reads; slaves zonder antwoord krijgen
+  // backoff. App-commando's gaan er als priority-transactie tussendoor.
   while (true) {
-    unsigned long now = millis();
     kickWatchdog();
     
-    if (now - lastRead >= interval && config.getModbusEnabled()) {
-      lastRead = now;
-      if (!modbusBackgroundPollAllowed()) {
-        if (lastPauseLog == 0 || (now - lastPauseLog) > 60000) {
-          logger.debug("[Modbus] achtergrond-poll overgeslagen (geen regelaar gedetecteerd)");
-          lastPauseLog = now;
+    if (config.getModbusEnabled() && controllerDiscoveryPending() && modbus.isInitialized()) {
+      if (controllerDiscoveryRun(modbus, config.getModbusConfig()) > 0) applyDiscoveryResult();
+    }
+
+    if (config.getModbusEnabled()) {
+      const int reads = modbusSchedulerService(modbus, (uint16_t)config.getModbusInterval());
+      controllerDiscoveryNotePrimary(modbusSchedulerSlaveOnline(0), modbusSchedulerSlaveInBackoff(0),
+                                     (uint8_t)controllerSlaveAddrFromApi, (uint32_t)controllerBaudRateFromApi);
+      if (reads > 0) {
+        float comp, temp, sp;
+        if (controllerPointValue(POINT_COMPRESSOR, comp)) {
+          doorAnalyticsSetCompressor(comp != 0.0f);
         }
-      } else {
-        lastPauseLog = 0;
-        if (modbus.readHoldingRegisters(0, 10)) {
-          modbusData.setpoint = modbus.getFloat(0);
-          modbusData.currentTemp = modbus.getFloat(2);
-          modbusData.compressorStatus = modbus.getBool(4);
-          modbusData.alarmStatus = modbus.getBool(5);
-          modbusData.timestamp = now;
-          modbusData.valid = true;
-          logger.debug("Modbus data read: Setpoint=" + String(modbusData.setpoint) +
-                      ", Temp=" + String(modbusData.currentTemp));
-        } else {
-          modbusData.valid = false;
+        if (controllerPointValue(POINT_TEMP, temp) && controllerPointValue(POINT_SETPOINT, sp)) {
+          LOG_D(LOG_TAG_MODBUS, "data read (%d read(s)): Setpoint=%.2f, Temp=%.2f", (int)reads, sp, temp);
         }
       }
     }
     
-    vTaskDelay(pdMS_TO_TICKS(500));
+    vTaskDelay(pdMS_TO_TICKS(1000));
   }
 }
 
@@ -1251,7 +1350,9 @@ void commandTask(void *parameter) {
               useCarel = (controllerTypeFromApi.indexOf("CAREL_PJEZ") >= 0);
             }
 
-            if (useCarel) {
+            if (modbusSlaveActive()) {
+              result["error"] = "RS485 staat in slave-mode (GBS-gateway): geen regelaar-commando's";
+            } else if (useCarel) {
               // Carel PJEZ supervisie protocol
               if (commandType == "DEFROST_START") {
                 logger.info("Carel: DEFROST_START");
@@ -1307,8 +1408,6 @@ void commandTask(void *parameter) {
                 result["error"] = "Unknown command type";
               }
             } else {
-              // Regelaar kan ontbreken: forceer één RS485-poging voor dit commando.
-              modbusForceProbe();
               if (!modbus.isInitialized()) {
                 ModbusConfig mcfg = config.getModbusConfig();
                 if (controllerBaudRateFromApi > 0) {
@@ -1319,49 +1418,58 @@ void commandTask(void *parameter) {
                 }
                 modbus.init(mcfg);
               }
-              // Modbus RTU – adressen per controller type (Dixell 0x0000, Eliwell 0x0100, Carel IR33 reg 1/2)
-              uint16_t tempAddr = 0x0000, setpointAddr = 0x0001, defrostCoil = 0x0001, alarmCoil = 0x0003;
-              if (controllerTypeFromApi.indexOf("ELIWELL") >= 0) {
-                tempAddr = 0x0100; setpointAddr = 0x0101; defrostCoil = 0x0000; alarmCoil = 0x0001;
-              } else if (controllerTypeFromApi.indexOf("CAREL_IR33") >= 0) {
-                tempAddr = 2; setpointAddr = 1; defrostCoil = DEFROST_COIL_ADDR; alarmCoil = 6;
+              // Modbus RTU – adressen, types en schaal uit het regelaarprofiel
+              // (controller_profiles.cpp) van de doel-slave: parameter "slave"
+              // of, zonder parameter, de regelaar uit de settings (slot 0).
+              if (!controllerSlotAddr(0)) {
+                modbusSchedulerSetPrimary(config.getModbusConfig().slaveId, controllerTypeFromApi);
               }
-              if (commandType == "DEFROST_START") {
+              const uint8_t reqSlave = parametersDoc["slave"] | 0;
+              const int cmdSlot = reqSlave ? controllerSlotForAddr(reqSlave) : 0;
+              const uint8_t slot = cmdSlot >= 0 ? (uint8_t)cmdSlot : 0;
+              if (cmdSlot >= 0) {
+                result["slave"] = controllerSlotAddr(slot);
+                // Regelaar kan ontbreken: forceer één nieuwe poging voor dit commando.
+                modbusSchedulerForceProbe(slot);
+              }
+              // Reads komen uit de register-cache zolang binnen de TTL van het
+              // punt; "fresh": true dwingt een bus-read af.
+              const bool fresh = parametersDoc["fresh"] | false;
+              if (cmdSlot < 0) {
+                // Onbekende slave: niet stil op de primaire regelaar uitvoeren.
+                logger.warn("Modbus: " + commandType + " voor onbekende slave " + String(reqSlave));
+                result["slave"] = reqSlave;
+                result["error"] = "Unknown slave";
+              } else if (commandType == "DEFROST_START") {
                 logger.info("Executing DEFROST_START command...");
                 modbus.setDefrostDebug(true);
-                if (modbus.writeSingleRegister(DEFROST_REG_ADDR, 1)) {
-                  success = true;
-                  result["status"] = "defrost_started";
-                } else if (modbus.writeSingleCoil(defrostCoil, true)) {
-                  success = true;
-                  result["status"] = "defrost_started";
-                } else if (modbus.writeSingleCoil(DEFROST_REG_ADDR, true)) {
+                // Enkel het profielpunt van de doel-slave: geen blinde
+                // fallback-writes naar vaste adressen op de primaire regelaar.
+                const ControllerWriteStatus ws = controllerWritePoint(modbus, POINT_DEFROST, 1, slot);
+                if (ws == CONTROLLER_WRITE_OK) {
                   success = true;
                   result["status"] = "defrost_started";
                 } else {
-                  result["error"] = "RS485 write failed. Zie Serial Monitor.";
+                  result["error"] = controllerWriteStatusName(ws);
                 }
                 modbus.setDefrostDebug(false);
               } else if (commandType == "DEFROST_STOP") {
-                if (modbus.writeSingleRegister(DEFROST_REG_ADDR, 0) || modbus.writeSingleCoil(defrostCoil, false)) {
+                const ControllerWriteStatus ws = controllerWritePoint(modbus, POINT_DEFROST, 0, slot);
+                if (ws == CONTROLLER_WRITE_OK) {
                   success = true;
                   result["status"] = "defrost_stopped";
                 } else {
-                  result["error"] = "RS485 write failed";
+                  result["error"] = controllerWriteStatusName(ws);
                 }
               } else if (commandType == "READ_TEMPERATURE") {
                 logger.info("Modbus: READ_TEMPERATURE (Dixell/regelaar optioneel)");
                 modbus.setDefrostDebug(true);
-                if (modbus.readInputRegisters(tempAddr, 2)) {
-                  float temp = modbus.getFloat(0);
-                  success = true;
-                  result["temperature"] = temp;
-                  logger.info("Modbus temp: " + String(temp) + " °C");
-                } else if (modbus.readHoldingRegisters(tempAddr, 2)) {
-                  float temp = modbus.getFloat(0);
+                ControllerValue temp;
+                if (controllerGetPoint(modbus, POINT_TEMP, temp, slot, fresh)) {
                   success = true;
-                  result["temperature"] = temp;
-                  logger.info("Modbus temp: " + String(temp) + " °C");
+                  writeControllerValueJson(result, "temperature", temp);
+                  logger.info("Modbus temp: " + String(temp.value) + " °C" +
+                              (temp.cached ? " (cache, " + String(temp.ageMs / 1000) + " s)" : String("")));
                 } else {
                   const char* err =
                       "Geen regelaar bereikbaar op RS485 (niet aangesloten of verkeerd adres/baud)";
@@ -1370,51 +1478,52 @@ void commandTask(void *parameter) {
                 }
                 modbus.setDefrostDebug(false);
               } else if (commandType == "READ_SETPOINT") {
-                if (modbus.readHoldingRegisters(setpointAddr, 2)) {
-                  float sp = modbus.getFloat(0);
+                ControllerValue sp;
+                if (controllerGetPoint(modbus, POINT_SETPOINT, sp, slot, fresh)) {
                   success = true;
-                  result["setpoint"] = sp;
+                  writeControllerValueJson(result, "setpoint", sp);
                 } else {
                   result["error"] = "Geen regelaar bereikbaar op RS485 (niet aangesloten of verkeerd adres/baud)";
                 }
               } else if (commandType == "READ_ALARM_STATUS") {
-                if (modbus.readHoldingRegisters(6, 2)) {
-                  uint16_t v = modbus.getRegister(0);
-                  success = true;
-                  result["alarm"] = (v != 0);
-                } else if (modbus.readHoldingRegisters(alarmCoil, 1)) {
+                ControllerValue alarm;
+                if (controllerGetPoint(modbus, POINT_ALARM, alarm, slot, fresh)) {
                   success = true;
-                  result["alarm"] = (modbus.getRegister(0) != 0);
+                  writeControllerValueJson(result, "alarm", alarm);
+                  result["alarm"] = (alarm.value != 0.0f);
                 } else {
                   result["error"] = "Geen regelaar bereikbaar op RS485 (niet aangesloten of verkeerd adres/baud)";
                 }
               } else if (commandType == "SET_SETPOINT") {
-                int val = parametersDoc["value"] | parametersDoc["temperature"] | -999;
+                float val = parametersDoc["value"] | parametersDoc["temperature"] | -999.0f;
                 if (val > -500) {
-                  uint16_t regVal = (uint16_t)(val * 10);  // Veel regelaars: x10
-                  if (modbus.writeSingleRegister(setpointAddr, regVal)) {
+                  // Schaal (x10 bij de meeste regelaars) zit in het profiel.
+                  const ControllerWriteStatus ws = controllerWritePoint(modbus, POINT_SETPOINT, val, slot);
+                  if (ws == CONTROLLER_WRITE_OK) {
                     success = true;
                     result["status"] = "ok";
                   } else {
-                    result["error"] = "RS485 write failed";
+                    result["error"] = controllerWriteStatusName(ws);
                   }
                 } else {
                   result["error"] = "Missing value parameter";
                 }
               } else if (commandType == "ALARM_RESET") {
-                if (modbus.writeSingleCoil(alarmCoil, true)) {
+                const ControllerWriteStatus ws = controllerWritePoint(modbus, POINT_ALARM, 1, slot);
+                if (ws == CONTROLLER_WRITE_OK) {
                   success = true;
                   result["status"] = "ok";
                 } else {
-                  result["error"] = "RS485 write failed";
+                  result["error"] = controllerWriteStatusName(ws);
                 }
               } else if (commandType == "POWER_ON_OFF") {
                 int val = parametersDoc["value"] | 1;
-                if (modbus.writeSingleRegister(101, val)) {
+                const ControllerWriteStatus ws = controllerWritePoint(modbus, POINT_POWER, val, slot);
+                if (ws == CONTROLLER_WRITE_OK) {
                   success = true;
                   result["status"] = "ok";
                 } else {
-                  result["error"] = "RS485 write failed";
+                  result["error"] = controllerWriteStatusName(ws);
                 }
               } else {
                 logger.warn("Unknown command type: " + commandType);
@@ -1424,33 +1533,8 @@ void commandTask(void *parameter) {
 
             // Report command completion
             if (ESP.getFreeHeap() > 5000) {
-              DynamicJsonDocument resultDoc(512);
-              if (result.containsKey("status")) {
-                resultDoc["status"] = result["status"].as<String>();
-              }
-              if (result.containsKey("temperature")) {
-                resultDoc["temperature"] = result["temperature"].as<float>();
-              }
-              if (result.containsKey("defrostType")) {
-                resultDoc["defrostType"] = result["defrostType"].as<int>();
-              }
-              if (result.containsKey("defrostInterval")) {
-                resultDoc["defrostInterval"] = result["defrostInterval"].as<int>();
-              }
-              if (result.containsKey("defrostDuration")) {
-                resultDoc["defrostDuration"] = result["defrostDuration"].as<int>();
-              }
-              if (result.containsKey("setpoint")) {
-                resultDoc["setpoint"] = result["setpoint"].as<float>();
-              }
-              if (result.containsKey("alarm")) {
-                resultDoc["alarm"] = result["alarm"].as<bool>();
-              }
-              if (result.containsKey("error")) {
-                resultDoc["error"] = result["error"].as<String>();
-              }
-              
-              bool reported = apiClient.completeCommand(commandId, success, resultDoc);
+              // result ongewijzigd doorsturen: ook age_s/cached/stale, slave, relay_state.
+              bool reported = apiClient.completeCommand(commandId, success, result);
               if (reported) {
                 logger.info("Command completion reported to backend");
               } else {
@@ -1464,7 +1548,8 @@ void commandTask(void *parameter) {
             resumeSoftwareWatchdog();
 #endif
           } else if (isDuplicate) {
-            logger.debug("Skipping duplicate command: " + commandId + " (executed " + String((now - lastCommandTime) / 1000) + "s ago)");
+            LOG_D(LOG_TAG_APP, "Skipping duplicate command: %s (executed %lus ago)", commandId.c_str(),
+                  (unsigned long)((now - lastCommandTime) / 1000));
           }
         }
 #if defined(BOARD_LILYGO_T_SIM7670G_S3)
@@ -0,0 +1,157 @@
+#include "modbus_rtu.h"
+
+uint16_t modbusCrc16(const uint8_t* data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (uint8_t j = 0; j < 8; j++) {
+      if (crc & 0x0001) {
+        crc = (crc >> 1) ^ 0xA001;
+      } else {
+        crc >>= 1;
+      }
+    }
+  }
+  return crc;
+}
+
+namespace {
+
+void appendCrc(uint8_t* frame, size_t len) {
+  const uint16_t crc = modbusCrc16(frame, len);
+  frame[len] = crc & 0xFF;
+  frame[len + 1] = (crc >> 8) & 0xFF;
+}
+
+} // namespace
+
+size_t modbusBuildRequest(uint8_t* out, uint8_t slave, uint8_t fc, uint16_t addr, uint16_t qtyOrValue) {
+  out[0] = slave;
+  out[1] = fc;
+  out[2] = (addr >> 8) & 0xFF;
+  out[3] = addr & 0xFF;
+  out[4] = (qtyOrValue >> 8) & 0xFF;
+  out[5] = qtyOrValue & 0xFF;
+  appendCrc(out, 6);
+  return 8;
+}
+
+size_t modbusBuildWriteMultiple(uint8_t* out, size_t cap, uint8_t slave, uint16_t addr,
+                                const uint16_t* values, uint16_t qty) {
+  const size_t len = 9 + (size_t)qty * 2;
+  if (qty == 0 || qty > 123 || len > cap) return 0;  // 123 = max voor FC16
+  out[0] = slave;
+  out[1] = MODBUS_WRITE_MULTIPLE_REGISTERS;
+  out[2] = (addr >> 8) & 0xFF;
+  out[3] = addr & 0xFF;
+  out[4] = (qty >> 8) & 0xFF;
+  out[5] = qty & 0xFF;
+  out[6] = (uint8_t)(qty * 2);
+  for (uint16_t i = 0; i < qty; i++) {
+    out[7 + i * 2] = (values[i] >> 8) & 0xFF;
+    out[8 + i * 2] = values[i] & 0xFF;
+  }
+  appendCrc(out, 7 + (size_t)qty * 2);
+  return len;
+}
+
+size_t modbusExpectedResponseLength(uint8_t fc, uint16_t qty) {
+  switch (fc) {
+    case MODBUS_READ_COILS:
+    case MODBUS_READ_DISCRETE_INPUTS:
+      return 5 + (qty + 7) / 8;
+    case MODBUS_READ_HOLDING_REGISTERS:
+    case MODBUS_READ_INPUT_REGISTERS:
+      return 5 + (size_t)qty * 2;
+    case MODBUS_WRITE_SINGLE_COIL:
+    case MODBUS_WRITE_SINGLE_REGISTER:
+    case MODBUS_WRITE_MULTIPLE_COILS:
+    case MODBUS_WRITE_MULTIPLE_REGISTERS:
+      return 8;  // echo van adres + waarde/hoeveelheid
+    default:
+      return 0;
+  }
+}
+
+ModbusStatus modbusParseResponse(const uint8_t* frame, size_t len, uint8_t slave, uint8_t fc,
+                                 uint16_t qty, uint8_t* exceptionOut) {
+  if (len == 0) return MODBUS_ERR_TIMEOUT;
+  if (len < 5) return MODBUS_ERR_SHORT;
+  if (frame[0] != slave) return MODBUS_ERR_SLAVE;
+  if (frame[1] == (fc | 0x80)) {
+    // CRC eerst: een verminkt frame is geen geldige exception.
+    if (modbusCrc16(frame, 3) != (uint16_t)(frame[3] | (frame[4] << 8))) return MODBUS_ERR_CRC;
+    if (exceptionOut) *exceptionOut = frame[2];
+    return MODBUS_ERR_EXCEPTION;
+  }
+  if (frame[1] != fc) return MODBUS_ERR_FUNCTION;
+
+  const size_t expected = modbusExpectedResponseLength(fc, qty);
+  if (expected != 0 && len < expected) return MODBUS_ERR_SHORT;
+  const size_t used = expected != 0 ? expected : len;
+  if (modbusCrc16(frame, used - 2) != (uint16_t)(frame[used - 2] | (frame[used - 1] << 8))) {
+    return MODBUS_ERR_CRC;
+  }
+  if (fc <= MODBUS_READ_INPUT_REGISTERS && frame[2] != used - 5) return MODBUS_ERR_LENGTH;
+  return MODBUS_OK;
+}
+
+uint16_t modbusExtractRegisters(const uint8_t* frame, size_t len, uint16_t* out, uint16_t maxOut) {
+  if (len < 5) return 0;
+  uint16_t n = frame[2] / 2;
+  if (n > maxOut) n = maxOut;
+  for (uint16_t i = 0; i < n; i++) {
+    out[i] = (uint16_t)((frame[3 + i * 2] << 8) | frame[4 + i * 2]);
+  }
+  return n;
+}
+
+uint16_t modbusExtractBits(const uint8_t* frame, size_t len, uint16_t qty, bool* out, uint16_t maxOut) {
+  if (len < 5) return 0;
+  uint16_t n = qty;
+  if (n > (uint16_t)(frame[2] * 8)) n = frame[2] * 8;
+  if (n > maxOut) n = maxOut;
+  for (uint16_t i = 0; i < n; i++) {
+    out[i] = (frame[3 + i / 8] >> (i % 8)) & 0x01;
+  }
+  return n;
+}
+
+uint32_t modbusCharTimeUs(uint32_t baud) {
+  return baud ? (11UL * 1000000UL + baud - 1) / baud : 0;
+}
+
+uint32_t modbusT15Us(uint32_t baud) {
+  if (baud > 19200) return 750;
+  return (modbusCharTimeUs(baud) * 3 + 1) / 2;
+}
+
+uint32_t modbusT35Us(uint32_t baud) {
+  if (baud > 19200) return 1750;
+  return (modbusCharTimeUs(baud) * 7 + 1) / 2;
+}
+
+const char* modbusStatusName(ModbusStatus st) {
+  switch (st) {
+    case MODBUS_OK:            return "ok";
+    case MODBUS_ERR_TIMEOUT:   return "timeout";
+    case MODBUS_ERR_SHORT:     return "kort frame";
+    case MODBUS_ERR_SLAVE:     return "ander slave-adres";
+    case MODBUS_ERR_FUNCTION:  return "function code";
+    case MODBUS_ERR_EXCEPTION: return "exception";
+    case MODBUS_ERR_CRC:       return "CRC";
+    case MODBUS_ERR_LENGTH:    return "lengte";
+    case MODBUS_ERR_BUS:       return "bus";
+    default:                   return "?";
+  }
+}
+
+const char* modbusExceptionName(uint8_t code) {
+  switch (code) {
+    case MODBUS_EXCEPTION_ILLEGAL_FUNCTION:      return "illegal function";
+    case MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS:  return "illegal data address";
+    case MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE:    return "illegal data value";
+    case MODBUS_EXCEPTION_SLAVE_DEVICE_FAILURE:  return "slave device failure";
+    default:                                     return "?";
+  }
+}
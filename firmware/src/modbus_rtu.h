@@ -0,0 +1,86 @@
+#ifndef MODBUS_RTU_H
+#define MODBUS_RTU_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Modbus RTU framing zonder I/O: CRC, request-opbouw, response-validatie en
+ * frame-timing per baudrate. Geen Arduino-afhankelijkheden, zodat RS485Modbus
+ * (master) en latere lagen dezelfde codec delen.
+ */
+
+// Modbus RTU function codes
+#define MODBUS_READ_COILS           0x01
+#define MODBUS_READ_DISCRETE_INPUTS 0x02
+#define MODBUS_READ_HOLDING_REGISTERS 0x03
+#define MODBUS_READ_INPUT_REGISTERS 0x04
+#define MODBUS_WRITE_SINGLE_COIL    0x05
+#define MODBUS_WRITE_SINGLE_REGISTER 0x06
+#define MODBUS_WRITE_MULTIPLE_COILS 0x0F
+#define MODBUS_WRITE_MULTIPLE_REGISTERS 0x10
+
+// Modbus exception codes
+#define MODBUS_EXCEPTION_ILLEGAL_FUNCTION 0x01
+#define MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS 0x02
+#define MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE 0x03
+#define MODBUS_EXCEPTION_SLAVE_DEVICE_FAILURE 0x04
+
+#define MODBUS_RTU_MAX_FRAME 256
+#define MODBUS_RTU_MAX_REGS  125   // FC03/04: max registers per request (spec)
+#define MODBUS_RTU_MAX_BITS  2000  // FC01/02: max coils/inputs per request (spec)
+
+#define MODBUS_RX_DEADLINE_MS 350  // max wachttijd op antwoord (geen regelaar = snel fail)
+
+enum ModbusStatus : uint8_t {
+  MODBUS_OK = 0,
+  MODBUS_ERR_TIMEOUT,       // geen byte binnen de deadline
+  MODBUS_ERR_SHORT,         // frame korter dan verwacht
+  MODBUS_ERR_SLAVE,         // antwoord van ander slave-adres
+  MODBUS_ERR_FUNCTION,      // onverwachte function code
+  MODBUS_ERR_EXCEPTION,     // slave stuurde exception (code apart)
+  MODBUS_ERR_CRC,
+  MODBUS_ERR_LENGTH,        // byte count / echo klopt niet met request
+  MODBUS_ERR_BUS,           // niet geïnitialiseerd of queue vol
+};
+
+uint16_t modbusCrc16(const uint8_t* data, size_t len);
+
+/** FC01..06: slave, fc, adres, hoeveelheid of waarde. Returnt 8 (framelengte). */
+size_t modbusBuildRequest(uint8_t* out, uint8_t slave, uint8_t fc, uint16_t addr, uint16_t qtyOrValue);
+
+/** FC16: max MODBUS_RTU_MAX_REGS registers. Returnt framelengte of 0. */
+size_t modbusBuildWriteMultiple(uint8_t* out, size_t cap, uint8_t slave, uint16_t addr,
+                                const uint16_t* values, uint16_t qty);
+
+/**
+ * Verwachte lengte van een normaal antwoord (incl. CRC) op dit request;
+ * exception-antwoorden zijn altijd 5 bytes. 0 = onbekende function code.
+ */
+size_t modbusExpectedResponseLength(uint8_t fc, uint16_t qty);
+
+/**
+ * Valideert een volledig antwoordframe: slave, function code, exception,
+ * lengte en CRC. Bij MODBUS_ERR_EXCEPTION staat de code in *exceptionOut.
+ */
+ModbusStatus modbusParseResponse(const uint8_t* frame, size_t len, uint8_t slave, uint8_t fc,
+                                 uint16_t qty, uint8_t* exceptionOut);
+
+/** FC03/04: registers (big-endian) uit een gevalideerd frame. Returnt aantal. */
+uint16_t modbusExtractRegisters(const uint8_t* frame, size_t len, uint16_t* out, uint16_t maxOut);
+
+/** FC01/02: bits uit een gevalideerd frame, LSB eerst per byte. Returnt aantal. */
+uint16_t modbusExtractBits(const uint8_t* frame, size_t len, uint16_t qty, bool* out, uint16_t maxOut);
+
+/**
+ * Frame-timing (µs) voor 11-bit karakters (8N1 + start/stop of 8N2/8E1).
+ * Boven 19200 baud gelden de vaste waarden uit de spec (750 / 1750 µs).
+ */
+uint32_t modbusCharTimeUs(uint32_t baud);
+uint32_t modbusT15Us(uint32_t baud);
+uint32_t modbusT35Us(uint32_t baud);
+
+const char* modbusStatusName(ModbusStatus st);
+const char* modbusExceptionName(uint8_t code);
+
+#endif /* MODBUS_RTU_H */
@@ -0,0 +1,151 @@
+#include "modbus_scheduler.h"
+#include "logger.h"
+
+extern Logger logger;
+
+namespace {
+
+struct SlotSched {
+  uint16_t pollS;
+  uint8_t  failStreak;
+  bool     online;
+  uint32_t backoffMs;         // huidige backoff (0 = geen)
+  uint32_t backoffUntilMs;
+  // Utilisatie-venster (sinds de vorige geslaagde heartbeat); sent = stand
+  // in de laatst opgebouwde heartbeat, pas bij de ack wordt dat reported.
+  ControllerSlotStats reported;
+  ControllerSlotStats sent;
+  bool     sentValid;
+};
+
+SlotSched s_sched[CONTROLLER_MAX_SLAVES] = {};
+uint32_t s_windowStartMs = 0;
+uint32_t s_sentWindowEndMs = 0;
+
+void resetSlot(uint8_t slot, uint16_t pollS) {
+  SlotSched& s = s_sched[slot];
+  s.pollS = pollS;
+  s.failStreak = 0;
+  s.online = false;
+  s.backoffMs = 0;
+  s.backoffUntilMs = 0;
+  s.sentValid = false;
+}
+
+bool inBackoff(const SlotSched& s, uint32_t now) {
+  return s.backoffMs && (int32_t)(s.backoffUntilMs - now) > 0;
+}
+
+void onCycle(uint8_t slot, const ControllerCycle& c, uint32_t now) {
+  SlotSched& s = s_sched[slot];
+  if (c.ok > 0 || !c.timedOut) {
+    if (s.backoffMs) logger.info(String("[Modbus] slave ") + controllerSlotAddr(slot) + " antwoordt weer");
+    s.failStreak = 0;
+    s.backoffMs = 0;
+    s.online = c.ok > 0;
+    return;
+  }
+  s.online = false;
+  if (++s.failStreak < MODBUS_SCHED_FAIL_LIMIT) return;
+  s.failStreak = 0;
+  s.backoffMs = s.backoffMs ? s.backoffMs * 2 : MODBUS_SCHED_BACKOFF_MIN_MS;
+  if (s.backoffMs > MODBUS_SCHED_BACKOFF_MAX_MS) s.backoffMs = MODBUS_SCHED_BACKOFF_MAX_MS;
+  s.backoffUntilMs = now + s.backoffMs;
+  logger.info(String("[Modbus] slave ") + controllerSlotAddr(slot) + " antwoordt niet — poll " +
+              String(s.backoffMs / 1000) + " s gepauzeerd");
+}
+
+} // namespace
+
+void modbusSchedulerSetPrimary(uint8_t slaveAddr, const String& controllerType) {
+  if (controllerSlotAddr(0) != slaveAddr) resetSlot(0, 0);
+  controllerConfigureSlot(0, slaveAddr, controllerType);
+}
+
+void modbusSchedulerSetExtraSlaves(const ModbusSlaveConfig* slaves, int count) {
+  for (uint8_t slot = 1; slot < CONTROLLER_MAX_SLAVES; slot++) {
+    const int i = slot - 1;
+    if (i < count && slaves[i].addr != controllerSlotAddr(0)) {
+      if (controllerSlotAddr(slot) != slaves[i].addr) resetSlot(slot, slaves[i].pollS);
+      s_sched[slot].pollS = slaves[i].pollS;
+      controllerConfigureSlot(slot, slaves[i].addr, String(slaves[i].type), slaves[i].timeoutMs);
+    } else {
+      resetSlot(slot, 0);
+      controllerConfigureSlot(slot, 0, String());
+    }
+  }
+}
+
+int modbusSchedulerService(RS485Modbus& bus, uint16_t minPeriodS) {
+  const uint32_t now = millis();
+  if (s_windowStartMs == 0) s_windowStartMs = now ? now : 1;
+  int transactions = 0;
+  for (uint8_t slot = 0; slot < CONTROLLER_MAX_SLAVES; slot++) {
+    if (!controllerSlotAddr(slot) || inBackoff(s_sched[slot], now)) continue;
+    const uint16_t period = s_sched[slot].pollS > minPeriodS ? s_sched[slot].pollS : minPeriodS;
+    ControllerCycle c;
+    if (!controllerPollCycle(bus, slot, period, c)) continue;
+    transactions += c.transactions;
+    onCycle(slot, c, millis());
+  }
+  return transactions;
+}
+
+void modbusSchedulerForceProbe(uint8_t slot) {
+  if (slot >= CONTROLLER_MAX_SLAVES) return;
+  s_sched[slot].failStreak = 0;
+  s_sched[slot].backoffMs = 0;
+}
+
+bool modbusSchedulerSlaveOnline(uint8_t slot) {
+  return slot < CONTROLLER_MAX_SLAVES && s_sched[slot].online;
+}
+
+bool modbusSchedulerSlaveInBackoff(uint8_t slot) {
+  return slot < CONTROLLER_MAX_SLAVES && inBackoff(s_sched[slot], millis());
+}
+
+void writeModbusSchedulerJson(JsonDocument& doc) {
+  const uint32_t now = millis();
+  const uint32_t windowMs = s_windowStartMs ? now - s_windowStartMs : 0;
+  uint64_t totalBusUs = 0;
+  JsonArray arr;
+  for (uint8_t slot = 0; slot < CONTROLLER_MAX_SLAVES; slot++) {
+    if (!controllerSlotAddr(slot)) continue;
+    SlotSched& s = s_sched[slot];
+    ControllerSlotStats st;
+    controllerSlotStats(slot, st);
+    const uint64_t busUs = st.busUs - s.reported.busUs;
+    totalBusUs += busUs;
+
+    if (arr.isNull()) arr = doc.createNestedArray("modbus_slaves");
+    JsonObject o = arr.createNestedObject();
+    o["slave"]     = controllerSlotAddr(slot);
+    o["profile"]   = activeControllerProfile(slot).id;
+    o["online"]    = s.online;
+    o["txn"]       = st.transactions - s.reported.transactions;
+    o["fail"]      = st.failures - s.reported.failures;
+    o["backoff_s"] = inBackoff(s, now) ? (s.backoffUntilMs - now) / 1000 : 0;
+    o["cache_hit"] = st.cacheHits - s.reported.cacheHits;
+    o["cache_miss"] = st.cacheMisses - s.reported.cacheMisses;
+    if (st.verifyFailures != s.reported.verifyFailures) {
+      o["verify_fail"] = st.verifyFailures - s.reported.verifyFailures;
+    }
+    if (windowMs) o["util_pct"] = (float)busUs / 10.0f / windowMs;
+    s.sent = st;
+    s.sentValid = true;
+  }
+  if (windowMs && !arr.isNull()) doc["modbus_util_pct"] = (float)totalBusUs / 10.0f / windowMs;
+  s_sentWindowEndMs = now ? now : 1;
+}
+
+void modbusSchedulerAck() {
+  if (!s_sentWindowEndMs) return;
+  for (uint8_t slot = 0; slot < CONTROLLER_MAX_SLAVES; slot++) {
+    SlotSched& s = s_sched[slot];
+    if (s.sentValid) s.reported = s.sent;
+    s.sentValid = false;
+  }
+  s_windowStartMs = s_sentWindowEndMs;
+  s_sentWindowEndMs = 0;
+}
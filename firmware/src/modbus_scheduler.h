@@ -0,0 +1,60 @@
+#ifndef MODBUS_SCHEDULER_H
+#define MODBUS_SCHEDULER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "config.h"
+#include "controller_poll.h"
+
+class RS485Modbus;
+
+/**
+ * Bus-scheduler voor meerdere regelaars op één RS485-segment. Per slave een
+ * eigen poll-periode, timeout en backoff: een afwezige of defecte regelaar
+ * wordt na MODBUS_SCHED_FAIL_LIMIT cycli met timeout steeds minder vaak
+ * geprobeerd (30 s → 5 min), zonder de andere slaves te vertragen.
+ *
+ * App-commando's lopen niet via de scheduler maar rechtstreeks als priority-
+ * transactie (vooraan in de worker-queue); ze wachten hooguit op de lopende
+ * read. Bus-bezetting per slave (ook commando's) komt uit de txn-tellers van
+ * controller_poll.
+ */
+
+#define MODBUS_SCHED_FAIL_LIMIT     3
+#define MODBUS_SCHED_BACKOFF_MIN_MS (30UL * 1000UL)
+#define MODBUS_SCHED_BACKOFF_MAX_MS (5UL * 60UL * 1000UL)
+
+/** Slot 0: regelaar uit de API-settings (adres + controllerType). */
+void modbusSchedulerSetPrimary(uint8_t slaveAddr, const String& controllerType);
+
+/** Slots 1..: extra slaves uit config "modbus.slaves". */
+void modbusSchedulerSetExtraSlaves(const ModbusSlaveConfig* slaves, int count);
+
+/**
+ * Eén scheduler-tick (modbusTask, ~1 s): elke slave die niet in backoff zit
+ * krijgt een poll-cyclus met de punten die aan de beurt zijn. minPeriodS =
+ * config modbusInterval (ondergrens voor alle slaves). Returnt het aantal
+ * gebruikte transacties.
+ */
+int modbusSchedulerService(RS485Modbus& bus, uint16_t minPeriodS);
+
+/** Backoff van een slot wissen (app-commando forceert een nieuwe poging). */
+void modbusSchedulerForceProbe(uint8_t slot);
+
+/** true als het slot de laatste cyclus antwoordde. */
+bool modbusSchedulerSlaveOnline(uint8_t slot);
+
+/** true als het slot na herhaalde timeouts in backoff zit. */
+bool modbusSchedulerSlaveInBackoff(uint8_t slot);
+
+/**
+ * Heartbeat: "modbus_slaves": [{slave, profile, online, txn, fail,
+ * backoff_s, cache_hit, cache_miss, util_pct}] + "modbus_util_pct" (hele
+ * bus) sinds de vorige geslaagde heartbeat.
+ */
+void writeModbusSchedulerJson(JsonDocument& doc);
+
+/** Na geslaagde heartbeat: het verstuurde venster afsluiten. */
+void modbusSchedulerAck();
+
+#endif /* MODBUS_SCHEDULER_H */
@@ -0,0 +1,175 @@
+#include "modbus_slave.h"
+#include "modbus_rtu.h"
+#include "rs485_modbus.h"
+#include "sensors_pt1000.h"
+#include "door_events.h"
+#include "door_analytics.h"
+#include "alarm_engine.h"
+#include "relay_control.h"
+#include "vbus_external.h"
+#include "logger.h"
+#include <freertos/FreeRTOS.h>
+
+extern Logger logger;
+extern DoorEventManager doorEventManager;
+
+namespace {
+
+portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+uint16_t s_image[MBS_REG_COUNT] = {};
+uint32_t s_imageMs = 0;
+
+HardwareSerial* s_serial = nullptr;
+uint8_t  s_addr = 0;
+uint8_t  s_dePin = 0;
+uint8_t  s_rePin = 0;
+bool     s_deActiveLow = false;  // polariteit van de bus-transceiver
+uint32_t s_t15Us = 0;
+uint32_t s_t35Us = 0;
+bool     s_active = false;
+
+// Enkel vanuit de UART-eventtaak (één callback tegelijk): statisch i.p.v.
+// op de kleine stack van die taak.
+uint8_t  s_req[MODBUS_RTU_MAX_FRAME];
+uint8_t  s_resp[MODBUS_RTU_MAX_FRAME];
+uint16_t s_regs[MBS_REG_COUNT];
+
+volatile uint32_t s_requests = 0;
+volatile uint32_t s_responses = 0;
+volatile uint32_t s_exceptions = 0;
+volatile uint32_t s_ignored = 0;
+volatile uint32_t s_maxTurnaroundUs = 0;
+
+void setTransmit(bool tx) {
+  const uint8_t level = (tx != s_deActiveLow) ? HIGH : LOW;
+  digitalWrite(s_dePin, level);
+  if (s_rePin != s_dePin) digitalWrite(s_rePin, level);
+}
+
+// onReceive-callback: enkel bij RX-timeout (≥ t1.5 stilte = einde frame).
+void onFrame() {
+  const uint32_t rxEndUs = micros();
+  size_t n = 0;
+  while (s_serial->available() && n < sizeof(s_req)) s_req[n++] = (uint8_t)s_serial->read();
+  while (s_serial->available()) (void)s_serial->read();  // te lang: weggooien
+  if (n == 0) return;
+  s_requests++;
+
+  // Snapshot + uptime/leeftijd op het moment van antwoorden.
+  portENTER_CRITICAL(&s_mux);
+  memcpy(s_regs, s_image, sizeof(s_regs));
+  const uint32_t imageMs = s_imageMs;
+  portEXIT_CRITICAL(&s_mux);
+  const uint32_t now = millis();
+  const uint32_t uptimeS = now / 1000;
+  const uint32_t ageS = imageMs ? (now - imageMs) / 1000 : 0xFFFF;
+  s_regs[MBS_REG_UPTIME_HI] = (uint16_t)(uptimeS >> 16);
+  s_regs[MBS_REG_UPTIME_LO] = (uint16_t)(uptimeS & 0xFFFF);
+  s_regs[MBS_REG_SNAPSHOT_AGE] = (uint16_t)(ageS > 0xFFFF ? 0xFFFF : ageS);
+
+  ModbusSlaveOutcome outcome;
+  const size_t len = modbusSlaveHandle(s_req, n, s_addr, s_regs, MBS_REG_COUNT, s_resp, sizeof(s_resp), &outcome);
+  if (len == 0) {
+    s_ignored++;
+    return;
+  }
+
+  // De RX-timeout kwam na t1.5; tot t3.5 aanvullen vóór we de lijn nemen.
+  const uint32_t gapUs = s_t35Us > s_t15Us ? s_t35Us - s_t15Us : 0;
+  const uint32_t spent = micros() - rxEndUs;
+  if (spent < gapUs) delayMicroseconds(gapUs - spent);
+  const uint32_t turnaround = micros() - rxEndUs + s_t15Us;
+  if (turnaround > s_maxTurnaroundUs) s_maxTurnaroundUs = turnaround;
+
+  setTransmit(true);
+  s_serial->write(s_resp, len);
+  s_serial->flush();
+  setTransmit(false);
+  if (outcome == MBS_EXCEPTION) {
+    s_exceptions++;
+  } else {
+    s_responses++;
+  }
+}
+
+} // namespace
+
+bool initModbusSlave(const ModbusConfig& cfg) {
+  if (cfg.slaveId < 1 || cfg.slaveId > 247) {
+    logger.error("[MBS] ongeldig slave-adres " + String(cfg.slaveId));
+    return false;
+  }
+  // Zelfde UART als master-mode (Serial1; UART2 = modem) op alle boards:
+  // de RS485-pins horen bij de gedeelde bus. rs485BusInit() claimt hem (of
+  // controleert pins/polariteit als initRS485() hem al startte); in
+  // slave-mode komen er geen bus-jobs, dus nemen we de UART over (onReceive
+  // hieronder). Enkel herstarten als baud of framing verschilt.
+  if (!rs485BusInit(cfg.rxPin, cfg.txPin, cfg.dePin, cfg.rePin)) return false;
+  s_addr = cfg.slaveId;
+  s_dePin = cfg.dePin;
+  s_rePin = cfg.rePin;
+  s_deActiveLow = rs485BusDeActiveLow();
+  setTransmit(false);
+
+  s_serial = &Serial1;
+  if (rs485BusActiveBaud() != cfg.baudRate || cfg.serialConfig != SERIAL_8N1) {
+    Serial1.begin(cfg.baudRate, cfg.serialConfig, cfg.rxPin, cfg.txPin);
+  }
+
+  s_t15Us = modbusT15Us(cfg.baudRate);
+  s_t35Us = modbusT35Us(cfg.baudRate);
+  const uint32_t charUs = modbusCharTimeUs(cfg.baudRate);
+  uint8_t toutSymbols = charUs ? (uint8_t)((s_t15Us + charUs - 1) / charUs) : 2;
+  if (toutSymbols < 1) toutSymbols = 1;
+  s_serial->setRxTimeout(toutSymbols);
+
+  modbusSlaveUpdateImage();
+  s_serial->onReceive(onFrame, true);
+  s_active = true;
+  logger.info("[MBS] Modbus slave-mode: adres " + String(s_addr) + " @ " + String(cfg.baudRate) +
+              " baud, " + String(MBS_REG_COUNT) + " registers (map v" + String(MBS_MAP_VERSION) + ")");
+  return true;
+}
+
+bool modbusSlaveActive() {
+  return s_active;
+}
+
+void modbusSlaveUpdateImage() {
+  uint16_t img[MBS_REG_COUNT] = {};
+  img[MBS_REG_VERSION] = MBS_MAP_VERSION;
+
+  uint16_t status = 0;
+  if (doorEventManager.snapshot().open) status |= MBS_STATUS_DOOR_OPEN;
+  if (getRelayState())                  status |= MBS_STATUS_RELAY;
+  if (doorAjar())                       status |= MBS_STATUS_DOOR_AJAR;
+  if (isExternalPowerPresent())         status |= MBS_STATUS_EXT_POWER;
+
+  const uint8_t channels = sensorChannelCount() < MBS_MAX_CHANNELS ? sensorChannelCount() : MBS_MAX_CHANNELS;
+  img[MBS_REG_CHANNEL_COUNT] = channels;
+  for (uint8_t i = 0; i < channels; i++) {
+    uint16_t* ch = &img[MBS_REG_CHANNEL_BASE + MBS_REGS_PER_CHANNEL * i];
+    const float t = getCachedTempC(i);
+    ch[0] = (sensorOk(i) && !isnan(t)) ? (uint16_t)(int16_t)lroundf(t * 100.0f) : MBS_TEMP_INVALID;
+    ch[1] = sensorFaultClass(i);
+    ch[2] = sensorChannel(i).role;
+    ch[3] = getCachedFault(i);
+    if (ch[1] != SENSOR_FAULT_NONE) status |= MBS_STATUS_SENSOR_FAULT;
+  }
+  img[MBS_REG_STATUS] = status;
+  img[MBS_REG_ALARMS] = activeAlarmMask();
+
+  portENTER_CRITICAL(&s_mux);
+  memcpy(s_image, img, sizeof(s_image));
+  s_imageMs = millis();
+  portEXIT_CRITICAL(&s_mux);
+}
+
+void writeModbusSlaveJson(JsonDocument& doc) {
+  if (!s_active) return;
+  doc["mbs_req"]           = s_requests;
+  doc["mbs_resp"]          = s_responses;
+  doc["mbs_exc"]           = s_exceptions;
+  doc["mbs_ignored"]       = s_ignored;
+  doc["mbs_turnaround_us"] = s_maxTurnaroundUs;
+}
@@ -0,0 +1,30 @@
+#ifndef MODBUS_SLAVE_H
+#define MODBUS_SLAVE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "config.h"
+#include "modbus_slave_map.h"
+
+/**
+ * Slave/gateway-mode (config modbus.mode = "slave"): het toestel antwoordt
+ * zelf als Modbus-slave (adres modbus.slaveId) zodat een GBS/BMS
+ * temperaturen, deur, relais en alarmen over RS485 leest. Exclusief met
+ * master-mode: beide gebruiken dezelfde UART en transceiver.
+ *
+ * Event-gedreven: de UART-driver meldt via onReceive() een RX-timeout na
+ * t1.5 stilte (einde frame); de callback (UART-eventtaak) handelt het frame
+ * af op een register-image en antwoordt na t3.5. Geen SPI of sensor-I/O
+ * per request: sensorTask ververst het image via modbusSlaveUpdateImage().
+ */
+
+bool initModbusSlave(const ModbusConfig& cfg);
+bool modbusSlaveActive();
+
+/** Register-image opnieuw vullen uit de caches (sensorTask, na een meting). */
+void modbusSlaveUpdateImage();
+
+/** Heartbeat: mbs_req, mbs_resp, mbs_exc, mbs_ignored, mbs_turnaround_us (max). */
+void writeModbusSlaveJson(JsonDocument& doc);
+
+#endif /* MODBUS_SLAVE_H */
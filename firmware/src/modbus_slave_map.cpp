@@ -0,0 +1,84 @@
+#include "modbus_slave_map.h"
+
+namespace {
+
+size_t finish(uint8_t* resp, size_t len) {
+  const uint16_t crc = modbusCrc16(resp, len);
+  resp[len] = crc & 0xFF;
+  resp[len + 1] = (crc >> 8) & 0xFF;
+  return len + 2;
+}
+
+size_t exception(uint8_t* resp, uint8_t addr, uint8_t fc, uint8_t code, ModbusSlaveOutcome* outcome) {
+  if (outcome) *outcome = MBS_EXCEPTION;
+  resp[0] = addr;
+  resp[1] = fc | 0x80;
+  resp[2] = code;
+  return finish(resp, 3);
+}
+
+bool bitAt(const uint16_t* regs, uint16_t regCount, uint16_t bit) {
+  if (bit < 16) return regCount > MBS_REG_STATUS && ((regs[MBS_REG_STATUS] >> bit) & 1);
+  return regCount > MBS_REG_ALARMS && ((regs[MBS_REG_ALARMS] >> (bit - 16)) & 1);
+}
+
+} // namespace
+
+size_t modbusSlaveHandle(const uint8_t* req, size_t len, uint8_t myAddr,
+                         const uint16_t* regs, uint16_t regCount,
+                         uint8_t* resp, size_t cap, ModbusSlaveOutcome* outcome) {
+  if (outcome) *outcome = MBS_IGNORED;
+  // Elke request die we ondersteunen is 8 bytes; langere frames (FC15/16)
+  // krijgen na CRC-check een exception.
+  if (len < 8 || cap < MODBUS_RTU_MAX_FRAME) return 0;
+  if (modbusCrc16(req, len - 2) != (uint16_t)(req[len - 2] | (req[len - 1] << 8))) return 0;
+  const uint8_t addr = req[0];
+  if (addr != myAddr) return 0;  // ook broadcast (0): reads vragen een antwoord
+
+  const uint8_t fc = req[1];
+  const uint16_t start = (uint16_t)((req[2] << 8) | req[3]);
+  const uint16_t qty = (uint16_t)((req[4] << 8) | req[5]);
+
+  switch (fc) {
+    case MODBUS_READ_HOLDING_REGISTERS:
+    case MODBUS_READ_INPUT_REGISTERS: {
+      if (qty == 0 || qty > MODBUS_RTU_MAX_REGS) {
+        return exception(resp, addr, fc, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, outcome);
+      }
+      if ((uint32_t)start + qty > regCount) {
+        return exception(resp, addr, fc, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS, outcome);
+      }
+      resp[0] = addr;
+      resp[1] = fc;
+      resp[2] = (uint8_t)(qty * 2);
+      for (uint16_t i = 0; i < qty; i++) {
+        resp[3 + i * 2] = (regs[start + i] >> 8) & 0xFF;
+        resp[4 + i * 2] = regs[start + i] & 0xFF;
+      }
+      if (outcome) *outcome = MBS_RESPONDED;
+      return finish(resp, 3 + (size_t)qty * 2);
+    }
+    case MODBUS_READ_COILS:
+    case MODBUS_READ_DISCRETE_INPUTS: {
+      if (qty == 0 || qty > MODBUS_RTU_MAX_BITS) {
+        return exception(resp, addr, fc, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE, outcome);
+      }
+      if ((uint32_t)start + qty > MBS_BIT_COUNT) {
+        return exception(resp, addr, fc, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS, outcome);
+      }
+      const uint8_t bytes = (uint8_t)((qty + 7) / 8);
+      resp[0] = addr;
+      resp[1] = fc;
+      resp[2] = bytes;
+      for (uint8_t b = 0; b < bytes; b++) resp[3 + b] = 0;
+      for (uint16_t i = 0; i < qty; i++) {
+        if (bitAt(regs, regCount, start + i)) resp[3 + i / 8] |= (uint8_t)(1 << (i % 8));
+      }
+      if (outcome) *outcome = MBS_RESPONDED;
+      return finish(resp, 3 + bytes);
+    }
+    default:
+      // Gateway is read-only: writes en onbekende functies.
+      return exception(resp, addr, fc, MODBUS_EXCEPTION_ILLEGAL_FUNCTION, outcome);
+  }
+}
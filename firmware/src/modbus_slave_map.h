@@ -0,0 +1,68 @@
+#ifndef MODBUS_SLAVE_MAP_H
+#define MODBUS_SLAVE_MAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "modbus_rtu.h"
+
+/**
+ * Register-map en request-handler voor slave/gateway-mode: een GBS/BMS leest
+ * onze metingen via Modbus RTU (FC01/02/03/04). Read-only: schrijven geeft
+ * exception 01. De handler werkt enkel op een register-image (snapshot van
+ * de cache), dus nooit SPI of I/O per request.
+ *
+ * Holding (FC03) en input registers (FC04) geven dezelfde map:
+ *   0        map-versie (MBS_MAP_VERSION)
+ *   1        status-bits (MBS_STATUS_*)
+ *   2        actieve alarmen (bitmask, zie alarm_engine AlarmId)
+ *   3..4     uptime in s (hoog woord eerst)
+ *   5        leeftijd van de sensor-snapshot in s (verzadigt op 0xFFFF)
+ *   6        aantal PT1000-kanalen
+ *   10+4·i   kanaal i: temperatuur int16 in 0.01 °C (MBS_TEMP_INVALID = geen),
+ *            foutklasse, rol, laatste MAX31865-faultcode
+ *
+ * Coils (FC01) en discrete inputs (FC02): bit 0..15 = status-register,
+ * bit 16..23 = alarm-register.
+ *
+ * Geen Arduino-afhankelijkheden: host-testbaar (zie firmware/sim).
+ */
+
+#define MBS_MAP_VERSION          1
+
+#define MBS_REG_VERSION          0
+#define MBS_REG_STATUS           1
+#define MBS_REG_ALARMS           2
+#define MBS_REG_UPTIME_HI        3
+#define MBS_REG_UPTIME_LO        4
+#define MBS_REG_SNAPSHOT_AGE     5
+#define MBS_REG_CHANNEL_COUNT    6
+#define MBS_REG_CHANNEL_BASE     10
+#define MBS_REGS_PER_CHANNEL     4
+#define MBS_MAX_CHANNELS         4
+#define MBS_REG_COUNT            (MBS_REG_CHANNEL_BASE + MBS_REGS_PER_CHANNEL * MBS_MAX_CHANNELS)
+
+#define MBS_BIT_COUNT            24
+
+#define MBS_STATUS_DOOR_OPEN     (1u << 0)
+#define MBS_STATUS_RELAY         (1u << 1)
+#define MBS_STATUS_DOOR_AJAR     (1u << 2)
+#define MBS_STATUS_EXT_POWER     (1u << 3)
+#define MBS_STATUS_SENSOR_FAULT  (1u << 4)
+
+#define MBS_TEMP_INVALID         0x8000
+
+enum ModbusSlaveOutcome : uint8_t {
+  MBS_IGNORED = 0,      // te kort, CRC-fout, ander adres of broadcast: geen antwoord
+  MBS_RESPONDED,        // normaal antwoord
+  MBS_EXCEPTION,        // exception-antwoord
+};
+
+/**
+ * Eén request-frame afhandelen. Returnt de lengte van het antwoord in resp
+ * (0 = niet antwoorden); *outcome zegt waarom.
+ */
+size_t modbusSlaveHandle(const uint8_t* req, size_t len, uint8_t myAddr,
+                         const uint16_t* regs, uint16_t regCount,
+                         uint8_t* resp, size_t cap, ModbusSlaveOutcome* outcome = nullptr);
+
+#endif /* MODBUS_SLAVE_MAP_H */
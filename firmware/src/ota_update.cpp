@@ -19,7 +19,7 @@ void OTAUpdate::configure(String password) {
   ArduinoOTA.onEnd([]() { logger.info("OTA update finished"); });
   ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
     int percent = (progress / (total / 100));
-    logger.debug("OTA progress: " + String(percent) + "%");
+    LOG_D(LOG_TAG_NET, "OTA progress: %d%%", percent);
   });
   ArduinoOTA.onError([](ota_error_t error) {
     String errorMsg = "OTA error: ";
@@ -119,9 +119,8 @@ void PowerMonitor::update() {
     }
     lastUpdate = now;
     if (usbConnected != wasConnected) {
-      logger.info(String(BOARD_POWER_MONITOR_LOG_NAME) +
-                  (usbConnected ? ": aangesloten" : ": weg / niet gedetecteerd") +
-                  " (GPIO" + String(USB_ADC_PIN) + "=" + String(usbVoltage, 2) + "V)");
+      LOG_I(LOG_TAG_POWER, "%s%s (GPIO%d=%.2fV)", BOARD_POWER_MONITOR_LOG_NAME,
+            usbConnected ? ": aangesloten" : ": weg / niet gedetecteerd", (int)USB_ADC_PIN, usbVoltage);
     }
   }
 #endif
@@ -0,0 +1,413 @@
+#include "rs485_bus.h"
+#include "rs485_modbus.h"
+#include "modbus_rtu.h"
+#include "pins_carrier.h"
+#include "logger.h"
+#include <HardwareSerial.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <driver/uart.h>
+
+extern Logger logger;
+
+namespace {
+
+// Serial1 op alle boards: UART2 (Serial2) is de modem-UART (SIM7670G).
+HardwareSerial* s_serial = nullptr;
+const uart_port_t kPort = UART_NUM_1;
+uint8_t  s_rxPin = 0;
+uint8_t  s_txPin = 0;
+uint8_t  s_dePin = 0;
+uint8_t  s_rePin = 0;
+bool     s_deActiveLow = false;
+bool     s_ready = false;
+
+QueueHandle_t s_queue = nullptr;
+// Wachtgrenzen: som van boundMs per queue-deel + de lopende job. Een
+// geannuleerde job (rs485BusAwait) blijft in de queue tot de worker hem
+// overslaat.
+portMUX_TYPE s_jobMux = portMUX_INITIALIZER_UNLOCKED;
+uint32_t s_nextJobId = 1;
+uint32_t s_queuedMs = 0;
+uint32_t s_queuedPriorityMs = 0;
+uint32_t s_runningId = 0;
+uint32_t s_runningBoundMs = 0;
+uint32_t s_doneId = 0;
+uint32_t s_cancelled[RS485_BUS_QUEUE_DEPTH] = {};
+uint8_t  s_cancelledCount = 0;
+// Gegeven vanuit de UART-eventtaak (onReceive): bij RX-timeout (pauze van
+// ≥ t1.5 op de lijn) of zodra de RX-FIFO de nog verwachte bytes bevat
+// (drempel per receive gezet); de worker slaapt hierop.
+SemaphoreHandle_t s_rxEvent = nullptr;
+// RX-FIFO is 128 bytes; IDF-standaarddrempel als het antwoord onbekend is.
+constexpr size_t kRxFullMax = 120;
+
+uint32_t s_lineBaud = 0;
+uint32_t s_lineConfig = 0;
+uint32_t s_charUs = 0;
+uint32_t s_t35Us = 0;
+uint32_t s_lastBusUs = 0;
+
+// Bezetting sinds de vorige heartbeat.
+portMUX_TYPE s_statsMux = portMUX_INITIALIZER_UNLOCKED;
+uint64_t s_busyUs[RS485_OWNER_COUNT] = {};
+uint32_t s_jobs = 0;
+uint32_t s_waitMaxUs = 0;
+UBaseType_t s_queueHw = 0;
+uint32_t s_windowStartMs = 0;
+
+void setDe(bool transmit) {
+  const uint8_t level = (transmit != s_deActiveLow) ? HIGH : LOW;
+  digitalWrite(s_dePin, level);
+  if (s_rePin != s_dePin) digitalWrite(s_rePin, level);
+}
+
+// Onder s_jobMux.
+bool takeCancelled(uint32_t id) {
+  for (uint8_t i = 0; i < s_cancelledCount; i++) {
+    if (s_cancelled[i] != id) continue;
+    s_cancelled[i] = s_cancelled[--s_cancelledCount];
+    return true;
+  }
+  return false;
+}
+
+void workerTask(void*) {
+  RS485Job job;
+  while (true) {
+    if (xQueueReceive(s_queue, &job, portMAX_DELAY) != pdTRUE || !job.run) continue;
+    portENTER_CRITICAL(&s_jobMux);
+    uint32_t& queuedMs = job.priority ? s_queuedPriorityMs : s_queuedMs;
+    queuedMs -= job.boundMs < queuedMs ? job.boundMs : queuedMs;
+    const bool cancelled = takeCancelled(job.id);
+    if (!cancelled) {
+      s_runningId = job.id;
+      s_runningBoundMs = job.boundMs;
+    }
+    portEXIT_CRITICAL(&s_jobMux);
+    if (cancelled) continue;  // wachter gaf op: arg bestaat niet meer
+    const uint32_t startUs = micros();
+    const uint32_t waitUs = startUs - job.queuedUs;
+    job.run(job.arg);
+    const uint32_t busyUs = micros() - startUs;
+    portENTER_CRITICAL(&s_jobMux);
+    s_runningId = 0;
+    s_runningBoundMs = 0;
+    s_doneId = job.id;
+    portEXIT_CRITICAL(&s_jobMux);
+    portENTER_CRITICAL(&s_statsMux);
+    s_busyUs[job.owner < RS485_OWNER_COUNT ? job.owner : RS485_OWNER_MODBUS] += busyUs;
+    s_jobs++;
+    if (waitUs > s_waitMaxUs) s_waitMaxUs = waitUs;
+    portEXIT_CRITICAL(&s_statsMux);
+    if (job.waiter) xTaskNotifyGive(job.waiter);
+  }
+}
+
+} // namespace
+
+bool rs485BusInit(uint8_t rxPin, uint8_t txPin, uint8_t dePin, uint8_t rePin, bool deActiveLow) {
+  if (s_ready) {
+    if (rxPin != s_rxPin || txPin != s_txPin || dePin != s_dePin || rePin != s_rePin ||
+        deActiveLow != s_deActiveLow) {
+      logger.error("[RS485] bus al actief op RX=" + String(s_rxPin) + " TX=" + String(s_txPin) + " DE=" +
+                   String(s_dePin) + (s_deActiveLow ? " actief-laag" : "") + "; gevraagd RX=" + String(rxPin) +
+                   " TX=" + String(txPin) + " DE=" + String(dePin) + (deActiveLow ? " actief-laag" : "") +
+                   ": pins/polariteit in config nakijken");
+      return false;
+    }
+    return true;
+  }
+  s_rxPin = rxPin;
+  s_txPin = txPin;
+  s_dePin = dePin;
+  s_rePin = rePin;
+  s_deActiveLow = deActiveLow;
+  pinMode(s_dePin, OUTPUT);
+  pinMode(s_rePin, OUTPUT);
+  setDe(false);  // ontvangstmodus
+
+  s_serial = &Serial1;
+  s_serial->begin(9600, SERIAL_8N1, rxPin, txPin);
+  s_lineBaud = 0;
+  rs485BusUseLine(9600, SERIAL_8N1);
+
+  if (!s_rxEvent) s_rxEvent = xSemaphoreCreateBinary();
+  s_serial->onReceive([]() {
+    if (s_rxEvent) xSemaphoreGive(s_rxEvent);
+  }, false);
+
+  if (!s_queue) {
+    s_queue = xQueueCreate(RS485_BUS_QUEUE_DEPTH, sizeof(RS485Job));
+    // Prio boven sensor/modbusTask: een job wordt meteen afgewerkt zodra de
+    // bus vrij is; wachten gebeurt op semaphores (geen CPU).
+    xTaskCreatePinnedToCore(workerTask, "RS485Bus", 4096, nullptr, 3, nullptr, 1);
+  }
+  s_lastBusUs = micros();
+  s_ready = true;
+  logger.info("[RS485] bus ready (Serial1, RX=" + String(rxPin) + " TX=" + String(txPin) + " DE=" + String(dePin) +
+              (deActiveLow ? " actief-laag" : "") + ")");
+  return true;
+}
+
+bool rs485BusReady() {
+  return s_ready;
+}
+
+bool rs485BusDeActiveLow() {
+  return s_deActiveLow;
+}
+
+bool rs485BusSubmit(const RS485Job& job, RS485Ticket* ticket) {
+  if (!s_ready || !s_queue || !job.run) return false;
+  RS485Job j = job;
+  j.queuedUs = micros();
+  // Vóór deze job: de lopende, de priority-jobs en (zelf geen priority) de
+  // rest van de queue. Elk is begrensd door zijn eigen boundMs.
+  portENTER_CRITICAL(&s_jobMux);
+  j.id = s_nextJobId++;
+  if (!s_nextJobId) s_nextJobId = 1;
+  const uint32_t aheadMs = s_runningBoundMs + s_queuedPriorityMs + (j.priority ? 0 : s_queuedMs);
+  (j.priority ? s_queuedPriorityMs : s_queuedMs) += j.boundMs;
+  portEXIT_CRITICAL(&s_jobMux);
+  const bool ok = (j.priority ? xQueueSendToFront(s_queue, &j, 0) : xQueueSend(s_queue, &j, 0)) == pdTRUE;
+  if (ok) {
+    const UBaseType_t depth = uxQueueMessagesWaiting(s_queue);
+    if (depth > s_queueHw) s_queueHw = depth;
+    if (ticket) {
+      ticket->id = j.id;
+      ticket->waitMs = aheadMs + j.boundMs + RS485_BUS_SLACK_MS;
+    }
+  } else {
+    portENTER_CRITICAL(&s_jobMux);
+    uint32_t& queuedMs = j.priority ? s_queuedPriorityMs : s_queuedMs;
+    queuedMs -= j.boundMs < queuedMs ? j.boundMs : queuedMs;
+    portEXIT_CRITICAL(&s_jobMux);
+  }
+  return ok;
+}
+
+bool rs485BusAwait(const RS485Ticket& ticket) {
+  if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ticket.waitMs))) return true;
+
+  enum { QUEUED, RUNNING, DONE } state;
+  uint32_t boundMs = 0;
+  portENTER_CRITICAL(&s_jobMux);
+  if (s_runningId == ticket.id) {
+    state = RUNNING;
+    boundMs = s_runningBoundMs;
+  } else if (s_doneId == ticket.id) {
+    state = DONE;
+  } else if (s_cancelledCount < RS485_BUS_QUEUE_DEPTH) {
+    state = QUEUED;
+    s_cancelled[s_cancelledCount++] = ticket.id;
+  } else {
+    state = RUNNING;  // kan niet annuleren: de worker zal hem nog draaien
+    boundMs = ticket.waitMs;
+  }
+  portEXIT_CRITICAL(&s_jobMux);
+
+  if (state == DONE) return true;  // notificatie volgt; de volgende wachter wist ze
+  if (state == QUEUED) {
+    // Net klaar tussen de timeout en de check: dan is de notificatie er al.
+    if (!ulTaskNotifyTake(pdTRUE, 0)) {
+      logger.warn("[RS485] job " + String(ticket.id) + " na " + String(ticket.waitMs) +
+                  " ms nog in de queue: geannuleerd");
+      return false;
+    }
+    portENTER_CRITICAL(&s_jobMux);
+    takeCancelled(ticket.id);
+    portEXIT_CRITICAL(&s_jobMux);
+    return true;
+  }
+  // Loopt al: run() schrijft nog in arg, dus uitwachten. Normaal binnen
+  // boundMs; daarna is de job zijn eigen deadlines voorbij.
+  while (!ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(boundMs ? boundMs : RS485_BUS_SLACK_MS))) {
+    logger.error("[RS485] job " + String(ticket.id) + " overschrijdt zijn bovengrens van " + String(boundMs) +
+                 " ms");
+  }
+  return true;
+}
+
+bool rs485BusRun(RS485Owner owner, bool priority, RS485JobFn run, void* arg, uint32_t boundMs) {
+  RS485Job job = {};
+  job.owner = owner;
+  job.priority = priority;
+  job.run = run;
+  job.arg = arg;
+  job.boundMs = boundMs;
+  job.waiter = xTaskGetCurrentTaskHandle();
+  ulTaskNotifyTake(pdTRUE, 0);  // oude notificatie wissen
+  RS485Ticket ticket;
+  if (!rs485BusSubmit(job, &ticket)) return false;
+  return rs485BusAwait(ticket);
+}
+
+void rs485BusUseLine(uint32_t baud, uint32_t serialConfig) {
+  if (!s_serial || !baud) return;
+  if (!serialConfig) serialConfig = SERIAL_8N1;
+  if (baud == s_lineBaud && serialConfig == s_lineConfig) return;
+  // SERIAL_xxx codeert pariteit (bit 0-1), woordlengte (2-3) en stopbits
+  // (4-5) in dezelfde waarden als de IDF-enums: omschakelen zonder
+  // uart_driver_delete/install. Een tweede Serial1.begin() liet de
+  // TG1-interrupt-watchdog panieken terwijl de modem op UART2 RX pompt.
+  if (baud != s_lineBaud) s_serial->updateBaudRate(baud);
+  uart_set_parity(kPort, (uart_parity_t)(serialConfig & 0x3));
+  uart_set_word_length(kPort, (uart_word_length_t)((serialConfig >> 2) & 0x3));
+  uart_set_stop_bits(kPort, (uart_stop_bits_t)((serialConfig >> 4) & 0x3));
+  s_lineBaud = baud;
+  s_lineConfig = serialConfig;
+
+  // De UART-hardware meldt een RX-timeout na t1.5 stilte: een korter frame
+  // (exception) of een te lange pauze midden in een frame. Een volledig
+  // frame eindigt op de verwachte lengte (rs485BusReceive).
+  s_charUs = modbusCharTimeUs(baud);
+  s_t35Us = modbusT35Us(baud);
+  const uint32_t t15Us = modbusT15Us(baud);
+  uint8_t toutSymbols = s_charUs ? (uint8_t)((t15Us + s_charUs - 1) / s_charUs) : 2;
+  if (toutSymbols < 1) toutSymbols = 1;
+  s_serial->setRxTimeout(toutSymbols);
+}
+
+uint32_t rs485BusCharTimeUs() {
+  return s_charUs;
+}
+
+uint32_t rs485BusT35Us() {
+  return s_t35Us;
+}
+
+void rs485BusWaitIdle(uint32_t gapUs) {
+  const uint32_t idle = micros() - s_lastBusUs;
+  if (idle >= gapUs) return;
+  const uint32_t waitUs = gapUs - idle;
+  if (waitUs >= 1000) {
+    vTaskDelay(pdMS_TO_TICKS((waitUs + 999) / 1000));
+  } else {
+    delayMicroseconds(waitUs);
+  }
+}
+
+uint32_t rs485BusTransmit(const uint8_t* frame, size_t len, uint32_t holdUs) {
+  // Oude bytes en events weggooien.
+  while (s_serial->available()) (void)s_serial->read();
+  xSemaphoreTake(s_rxEvent, 0);
+
+  setDe(true);
+  s_serial->write(frame, len);
+  s_serial->flush();  // wacht (driver-semaphore) tot het laatste bit buiten is
+  if (holdUs >= 1000) vTaskDelay(pdMS_TO_TICKS(holdUs / 1000));
+  if (holdUs % 1000) delayMicroseconds(holdUs % 1000);
+  setDe(false);
+  s_lastBusUs = micros();
+  return s_lastBusUs;
+}
+
+size_t rs485BusReceive(uint8_t* buf, size_t cap, size_t expected, uint32_t timeoutMs, bool modbusException,
+                       uint8_t* gapsOut) {
+  size_t n = 0;
+  uint8_t gaps = 0;
+  const uint32_t deadline = millis() + timeoutMs;
+
+  // Geen polling: de worker slaapt tot de UART meldt dat de nog verwachte
+  // bytes in de FIFO staan (FIFO-full-drempel = rest van het antwoord), of
+  // een RX-timeout (pauze ≥ t1.5). Zo wacht een volledig antwoord niet nog
+  // eens t1.5 (bij Carel 1200 baud ~14 ms per item). Timeout met een
+  // onvolledig frame = te lange pauze midden in het frame; we wachten
+  // tolerant verder (checksum beslist).
+  while (n < cap) {
+    const int32_t remaining = (int32_t)(deadline - millis());
+    if (remaining <= 0) break;
+    const size_t rest = expected > n ? expected - n : 0;
+    uart_set_rx_full_threshold(kPort, (int)(rest && rest <= kRxFullMax ? rest : kRxFullMax));
+    if (xSemaphoreTake(s_rxEvent, pdMS_TO_TICKS(remaining)) != pdTRUE) break;
+    const size_t before = n;
+    while (s_serial->available() && n < cap) buf[n++] = (uint8_t)s_serial->read();
+    if (n == before) continue;
+    s_lastBusUs = micros();
+    if (modbusException && n >= 5 && (buf[1] & 0x80)) break;  // exception-frame is altijd 5 bytes
+    if (expected != 0 && n >= expected) break;
+    gaps++;
+  }
+  // Bytes die net vóór de deadline binnenkwamen (event nog onderweg).
+  while (s_serial->available() && n < cap) buf[n++] = (uint8_t)s_serial->read();
+  if (gapsOut) *gapsOut = gaps;
+  return n;
+}
+
+uint32_t rs485BusLastActivityUs() {
+  return s_lastBusUs;
+}
+
+uint32_t rs485BusActiveBaud() {
+  return s_lineBaud;
+}
+
+void writeRS485BusJson(JsonDocument& doc) {
+  const uint32_t now = millis();
+  if (s_windowStartMs == 0) {
+    s_windowStartMs = now ? now : 1;
+    return;
+  }
+  const uint32_t windowMs = now - s_windowStartMs;
+  portENTER_CRITICAL(&s_statsMux);
+  const uint64_t modbusUs = s_busyUs[RS485_OWNER_MODBUS];
+  const uint64_t carelUs = s_busyUs[RS485_OWNER_CAREL];
+  const uint32_t jobs = s_jobs;
+  const uint32_t waitMaxUs = s_waitMaxUs;
+  for (uint8_t i = 0; i < RS485_OWNER_COUNT; i++) s_busyUs[i] = 0;
+  s_jobs = 0;
+  s_waitMaxUs = 0;
+  portEXIT_CRITICAL(&s_statsMux);
+  const UBaseType_t queueHw = s_queueHw;
+  s_queueHw = 0;
+  s_windowStartMs = now ? now : 1;
+  if (!s_ready || !windowMs) return;
+
+  JsonObject o = doc.createNestedObject("rs485");
+  o["util_pct"]    = (float)(modbusUs + carelUs) / 10.0f / windowMs;
+  o["modbus_pct"]  = (float)modbusUs / 10.0f / windowMs;
+  o["carel_pct"]   = (float)carelUs / 10.0f / windowMs;
+  o["jobs"]        = jobs;
+  o["wait_max_ms"] = waitMaxUs / 1000;
+  o["queue_hw"]    = queueHw;
+}
+
+/* -------------------------- Carrier-API (free) ------------------------- */
+
+void initRS485(uint32_t baud) {
+  if (rs485BusReady()) return;
+  rs485BusInit(PIN_RS485_RX, PIN_RS485_TX, PIN_RS485_DE, PIN_RS485_DE);
+  rs485BusUseLine(baud, SERIAL_8N1);  // worker nog idle: veilig buiten een job
+}
+
+void rs485TxEnable(bool en) {
+  setDe(en);
+}
+
+namespace {
+struct Framing {
+  const char* name;
+  uint32_t    config;
+};
+const Framing kFramings[] = {
+  { "8N1", SERIAL_8N1 },
+  { "8E1", SERIAL_8E1 },
+  { "8O1", SERIAL_8O1 },
+  { "8N2", SERIAL_8N2 },
+};
+} // namespace
+
+const char* rs485FramingName(uint32_t serialConfig) {
+  for (const Framing& f : kFramings) {
+    if (f.config == serialConfig) return f.name;
+  }
+  return "8N1";
+}
+
+uint32_t rs485FramingFromName(const char* name) {
+  for (const Framing& f : kFramings) {
+    if (name && strcmp(name, f.name) == 0) return f.config;
+  }
+  return SERIAL_8N1;
+}
@@ -0,0 +1,135 @@
+#ifndef RS485_BUS_H
+#define RS485_BUS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/**
+ * RS485-bus-arbiter: één module bezit de UART (Serial1; UART2 blijft vrij
+ * voor de SIM7670G-modem) en de DE/RE-pin. Modbus RTU (RS485Modbus) en
+ * Carel PJEZ (CarelProtocol) sturen jobs naar één priority-queue; één
+ * worker-taak voert ze na elkaar uit. Per job schakelt de worker baud en
+ * framing om (IDF-calls, geen driver-herinstallatie), zodat beide
+ * protocollen één segment delen zonder conflicten of init-kosten.
+ *
+ * Een job is een functie die in de worker loopt en de primitieven hieronder
+ * gebruikt (lijn kiezen, stilte afwachten, zenden, ontvangen). Het protocol
+ * houdt zijn eigen frames en resultaat bij in arg.
+ *
+ * Bezetting (looptijd van jobs) en wachttijd in de queue worden per
+ * protocol geteld; zie writeRS485BusJson().
+ */
+
+#define RS485_BUS_QUEUE_DEPTH  12
+#define RS485_BUS_SLACK_MS     20     // scheduling/lijnomschakeling bovenop de job-bovengrenzen
+
+enum RS485Owner : uint8_t {
+  RS485_OWNER_MODBUS = 0,
+  RS485_OWNER_CAREL,
+  RS485_OWNER_COUNT
+};
+
+typedef void (*RS485JobFn)(void* arg);
+
+struct RS485Job {
+  RS485Owner   owner;
+  bool         priority;    // app-commando: vooraan in de queue
+  RS485JobFn   run;         // loopt in de bus-worker
+  void*        arg;
+  uint32_t     boundMs;     // bovengrens looptijd van run() (eigen deadlines)
+  TaskHandle_t waiter;      // intern (rs485BusRun)
+  uint32_t     queuedUs;    // intern
+  uint32_t     id;          // intern
+};
+
+/** Van rs485BusSubmit, voor rs485BusAwait. */
+struct RS485Ticket {
+  uint32_t id;
+  uint32_t waitMs;          // jobs vóór hem in de queue + lopende job + eigen boundMs
+};
+
+/**
+ * Pins + UART claimen en de worker starten. Idempotent: een tweede aanroep
+ * (ander protocol) met dezelfde pins en polariteit adopteert de bestaande
+ * UART; iets anders → logger.error en false (de UART wordt niet opnieuw
+ * gepind). deActiveLow is een eigenschap van de ene transceiver (DE laag =
+ * zenden), dus voor alle jobs dezelfde.
+ */
+bool rs485BusInit(uint8_t rxPin, uint8_t txPin, uint8_t dePin, uint8_t rePin, bool deActiveLow = false);
+bool rs485BusReady();
+/** DE-polariteit van de transceiver (voor wie de UART overneemt, bv. slave-mode). */
+bool rs485BusDeActiveLow();
+
+/**
+ * Async: job (by value) in de queue; arg moet blijven bestaan tot run() liep.
+ * ticket (optioneel) = id + wachtgrens voor rs485BusAwait.
+ */
+bool rs485BusSubmit(const RS485Job& job, RS485Ticket* ticket = nullptr);
+
+/**
+ * Wachten (zonder CPU) op de task-notificatie van een eigen job, hooguit
+ * ticket.waitMs. Staat hij dan nog in de queue: geannuleerd (de worker slaat
+ * hem over) en false. Loopt hij al, dan wachten we hem uit: run() schrijft
+ * nog in arg en is zelf begrensd door boundMs (overschrijden = logger.error).
+ */
+bool rs485BusAwait(const RS485Ticket& ticket);
+
+/** Blokkerend (zonder CPU) tot de worker de job heeft uitgevoerd; false bij timeout (zie rs485BusAwait). */
+bool rs485BusRun(RS485Owner owner, bool priority, RS485JobFn run, void* arg, uint32_t boundMs);
+
+/* ---- Primitieven: enkel binnen een job (worker-context) ------------------ */
+
+/** Baud + framing (SERIAL_8N1/8E1/8N2...) voor deze job; zet ook t1.5/t3.5. */
+void rs485BusUseLine(uint32_t baud, uint32_t serialConfig);
+uint32_t rs485BusCharTimeUs();
+uint32_t rs485BusT35Us();
+
+/** Wacht tot de lijn gapUs stil is sinds de laatste activiteit. */
+void rs485BusWaitIdle(uint32_t gapUs);
+
+/**
+ * RX leegmaken, DE aan, frame zenden, wachten tot het laatste bit buiten
+ * is (flush) en DE holdUs later los. holdUs > 0 enkel voor transceivers
+ * met trage omschakeling: bytes in dat venster gaan verloren. Returnt
+ * micros() van het einde van de TX.
+ */
+uint32_t rs485BusTransmit(const uint8_t* frame, size_t len, uint32_t holdUs = 0);
+
+/**
+ * Event-gedreven ontvangst. Het frame is klaar zodra expected bytes binnen
+ * zijn (RX-FIFO-drempel = nog verwachte bytes), bij een Modbus-exception
+ * (modbusException, 5 bytes) of op de deadline (ms na TX-einde). Er wordt
+ * niet op een t3.5-stilte gewacht: de lengte is bekend. De UART RX-timeout
+ * (t1.5) wekt de worker enkel voor een korter frame (exception) of een
+ * pauze midden in het frame (gapsOut). De t3.5 tussen frames wacht de
+ * volgende zender zelf af (rs485BusWaitIdle).
+ */
+size_t rs485BusReceive(uint8_t* buf, size_t cap, size_t expected, uint32_t timeoutMs, bool modbusException,
+                       uint8_t* gapsOut = nullptr);
+
+/** micros() van de laatste byte op de lijn (TX-einde of RX). */
+uint32_t rs485BusLastActivityUs();
+
+/** Huidige baud (slave-mode adopteert de UART). */
+uint32_t rs485BusActiveBaud();
+
+/**
+ * Heartbeat: "rs485": {util_pct, modbus_pct, carel_pct, jobs, wait_max_ms,
+ * queue_hw} sinds de vorige heartbeat.
+ */
+void writeRS485BusJson(JsonDocument& doc);
+
+/* ----------------------------------------------------------------------- *
+ * Carrier-API (spec): free-function init op Serial1 + PIN_RS485_*. Start de
+ * gedeelde bus; RS485Modbus en CarelProtocol adopteren hem.
+ * ----------------------------------------------------------------------- */
+void initRS485(uint32_t baud = 9600);
+void rs485TxEnable(bool en);
+
+/** "8N1", "8E1", "8O1", "8N2" ↔ SERIAL_xxx (config "modbus.framing"). */
+const char* rs485FramingName(uint32_t serialConfig);
+uint32_t rs485FramingFromName(const char* name);
+
+#endif /* RS485_BUS_H */
@@ -1,103 +1,11 @@
 #include "rs485_modbus.h"
-#include "pins_carrier.h"
 #include "logger.h"
 #include "watchdog_tpl5010.h"
-#include <freertos/FreeRTOS.h>
-#include <freertos/semphr.h>
 
 extern Logger logger;
 
-// Max wachttijd op Modbus-antwoord (regelaar niet aangesloten = snel fail).
-static constexpr unsigned long MODBUS_RX_DEADLINE_MS   = 350;
-static constexpr unsigned long MODBUS_RX_INTERBYTE_MS  = 40;
-
-static SemaphoreHandle_t s_busMutex = nullptr;
-
-namespace {
-int s_failStreak = 0;
-unsigned long s_pausedUntil = 0;
-bool s_lastOk = false;
-constexpr int FAIL_LIMIT = 3;
-constexpr unsigned long PAUSE_MS = 5UL * 60UL * 1000UL;
-
-void onModbusResult(bool ok) {
-  s_lastOk = ok;
-  if (ok) {
-    s_failStreak = 0;
-    s_pausedUntil = 0;
-    return;
-  }
-  if (++s_failStreak >= FAIL_LIMIT) {
-    s_failStreak = 0;
-    s_pausedUntil = millis() + PAUSE_MS;
-    logger.info("[Modbus] geen regelaar — achtergrond-polling 5 min gepauzeerd");
-  }
-}
-
-struct BusLock {
-  bool held = false;
-  BusLock() {
-    if (s_busMutex) {
-      held = (xSemaphoreTake(s_busMutex, pdMS_TO_TICKS(3000)) == pdTRUE);
-    } else {
-      held = true;
-    }
-  }
-  ~BusLock() {
-    if (held && s_busMutex) {
-      xSemaphoreGive(s_busMutex);
-    }
-  }
-  explicit operator bool() const { return held; }
-};
-
-void drainRx(HardwareSerial* serial) {
-  if (!serial) return;
-  while (serial->available()) {
-    (void)serial->read();
-  }
-}
-} // namespace
-
-bool modbusBackgroundPollAllowed() {
-  return millis() >= s_pausedUntil;
-}
-
-void modbusForceProbe() {
-  s_pausedUntil = 0;
-  s_failStreak = 0;
-}
-
-bool modbusControllerLikelyPresent() {
-  return s_lastOk;
-}
-
-/* -------------------------- Carrier-API (free) ------------------------- */
-namespace {
-bool     s_carrierInitialized = false;
-uint32_t s_carrierBaud        = 0;
-} // namespace
-
-uint32_t carrierRS485ActiveBaud() { return s_carrierBaud; }
-
-void initRS485(uint32_t baud) {
-  if (!s_busMutex) {
-    s_busMutex = xSemaphoreCreateMutex();
-  }
-  if (s_carrierInitialized) return;
-  pinMode(PIN_RS485_DE, OUTPUT);
-  digitalWrite(PIN_RS485_DE, LOW);  // default: RX-mode
-  Serial1.begin(baud, SERIAL_8N1, PIN_RS485_RX, PIN_RS485_TX);
-  s_carrierInitialized = true;
-  s_carrierBaud        = baud;
-  logger.info("[RS485] ready @ " + String(baud) + " 8N1");
-}
-
-void rs485TxEnable(bool en) {
-  digitalWrite(PIN_RS485_DE, en ? HIGH : LOW);
-}
-
-RS485Modbus::RS485Modbus() : serial(nullptr), initialized(false), dePin(0), rePin(0), responseLength(0), defrostDebug(false) {
+RS485Modbus::RS485Modbus()
+    : initialized(false), responseLength(0), defrostDebug(false) {
 }
 
 String RS485Modbus::bytesToHex(uint8_t* data, uint8_t len) {
@@ -111,319 +19,256 @@ String RS485Modbus::bytesToHex(uint8_t* data, uint8_t len) {
 }
 
 RS485Modbus::~RS485Modbus() {
-#if !defined(BOARD_LILYGO_T_SIM7670G_S3)
-  // Op carrier v1.1 wijzen we naar de globale `Serial1`. Die mag NOOIT
-  // worden geheap-deleted (segfault). Op andere boards gebruiken we een
-  // dynamisch nieuwe HardwareSerial(2)-instantie.
-  if (serial) {
-    delete serial;
-  }
-#endif
 }
 
 bool RS485Modbus::init(ModbusConfig cfg) {
+  if (!cfg.serialConfig) cfg.serialConfig = SERIAL_8N1;
   config = cfg;
-  dePin = cfg.dePin;
-  rePin = cfg.rePin;
-
-  // Initialize RS485 driver/receiver enable pins
-  pinMode(dePin, OUTPUT);
-  pinMode(rePin, OUTPUT);
-  setTransmitMode(false);
-
-#if defined(BOARD_LILYGO_T_SIM7670G_S3)
-  // Carrier v1.1: de MAX3485 hangt aan UART1 (Serial1). UART2 (Serial2) is
-  // gereserveerd voor de SIM7670G-modem (zie sim7670_battery.cpp). Als we
-  // hier `new HardwareSerial(2)` zouden doen, herclaimen we UART2 op de
-  // RS485-pinnen en valt de modem-link weg.
-  //
-  // Belangrijk: initRS485() heeft Serial1 al opgestart op de juiste pinnen
-  // tijdens setup(). Een tweede `Serial1.begin()` met dezelfde baud triggert
-  // hier een driver-uninstall/install in arduino-esp32, en in combinatie met
-  // de modem die op UART2 al RX-bytes binnen pompt, blijken interrupts lang
-  // genoeg geblokkeerd om de TG1-interrupt-watchdog te laten panieken
-  // (resetreden TG1WDT_SYS_RST). We re-initialiseren Serial1 dus enkel als
-  // de baud écht moet veranderen; in alle andere gevallen adopteren we de
-  // bestaande UART-driver gewoon.
-  serial = &Serial1;
-  if (s_carrierBaud != cfg.baudRate) {
-    Serial1.begin(cfg.baudRate, SERIAL_8N1, cfg.rxPin, cfg.txPin);
-    s_carrierBaud = cfg.baudRate;
-  }
-#else
-  // Klassieke ESP32-DevKit / SimShield-pad: dedicated UART2.
-  if (!serial) {
-    serial = new HardwareSerial(2);
-  }
-  serial->begin(cfg.baudRate, SERIAL_8N1, cfg.rxPin, cfg.txPin);
-#endif
 
-  delay(100);
+  // De UART (Serial1; UART2 = modem) en DE/RE zijn van de gedeelde bus. Op
+  // carrier v1.1 heeft initRS485() hem in setup() al gestart: adopteren,
+  // geen tweede Serial1.begin() (driver-herinstallatie terwijl de modem op
+  // UART2 RX pompt liet de TG1-interrupt-watchdog panieken). Baud en framing
+  // volgen per transactie (rs485BusUseLine).
+  if (!rs485BusInit(cfg.rxPin, cfg.txPin, cfg.dePin, cfg.rePin)) return false;
 
   initialized = true;
   logger.info("RS485/Modbus initialized");
-  logger.info("Baud: " + String(cfg.baudRate) + ", Slave ID: " + String(cfg.slaveId));
+  logger.info("Baud: " + String(cfg.baudRate) + " " + rs485FramingName(cfg.serialConfig) + ", Slave ID: " +
+              String(cfg.slaveId) + ", t1.5=" + String(modbusT15Us(cfg.baudRate)) + "us t3.5=" +
+              String(modbusT35Us(cfg.baudRate)) + "us");
 
   return true;
 }
 
-void RS485Modbus::setTransmitMode(bool transmit) {
-  digitalWrite(dePin, transmit ? HIGH : LOW);
-  digitalWrite(rePin, transmit ? HIGH : LOW);
+void RS485Modbus::setLine(uint32_t baud, uint32_t serialConfig) {
+  config.baudRate = baud;
+  config.serialConfig = serialConfig ? serialConfig : SERIAL_8N1;
 }
 
-uint16_t RS485Modbus::calculateCRC(uint8_t* data, uint8_t length) {
-  uint16_t crc = 0xFFFF;
-  
-  for (uint8_t i = 0; i < length; i++) {
-    crc ^= data[i];
-    for (uint8_t j = 0; j < 8; j++) {
-      if (crc & 0x0001) {
-        crc = (crc >> 1) ^ 0xA001;
-      } else {
-        crc >>= 1;
-      }
-    }
-  }
-  
-  return crc;
+void RS485Modbus::runJob(void* arg) {
+  ModbusTxn* txn = static_cast<ModbusTxn*>(arg);
+  const uint32_t startUs = micros();
+  txn->status = txn->engine->execute(*txn);
+  txn->busUs = micros() - startUs;
+  // Waiter na de callback: transact() mag de txn (op zijn stack) pas
+  // vrijgeven als de worker er niets meer mee doet.
+  const TaskHandle_t waiter = txn->waiter;
+  if (txn->callback) txn->callback(*txn, txn->ctx);
+  if (waiter) xTaskNotifyGive(waiter);
 }
 
-bool RS485Modbus::sendRequest(uint8_t functionCode, uint16_t startAddress, uint16_t quantity) {
-  if (!initialized || !serial) {
-    return false;
-  }
-  
-  uint8_t request[8];
-  request[0] = config.slaveId;
-  request[1] = functionCode;
-  request[2] = (startAddress >> 8) & 0xFF;
-  request[3] = startAddress & 0xFF;
-  request[4] = (quantity >> 8) & 0xFF;
-  request[5] = quantity & 0xFF;
-  
-  uint16_t crc = calculateCRC(request, 6);
-  request[6] = crc & 0xFF;
-  request[7] = (crc >> 8) & 0xFF;
-  
-  if (defrostDebug) {
-    logger.info("[Modbus TX] " + String(functionCode, HEX) + " @ " + String(startAddress) + " | " + bytesToHex(request, 8));
+// t3.5 + request + antwoord-deadline, naar boven afgerond op ms.
+uint32_t RS485Modbus::jobBoundMs(const ModbusTxn& txn) const {
+  const uint32_t baud = txn.baud ? txn.baud : config.baudRate;
+  size_t txBytes = 8;
+  if (txn.fc == MODBUS_WRITE_MULTIPLE_REGISTERS) txBytes = 9 + 2 * (size_t)txn.qty;
+  else if (txn.fc == MODBUS_TXN_RAW) txBytes = txn.rawLen;
+  const uint32_t lineUs = modbusT35Us(baud) + (uint32_t)txBytes * modbusCharTimeUs(baud);
+  return (txn.timeoutMs ? txn.timeoutMs : MODBUS_RX_DEADLINE_MS) + (lineUs + 999) / 1000;
+}
+
+bool RS485Modbus::enqueue(ModbusTxn* txn, RS485Ticket* ticket) {
+  if (!txn || !initialized) return false;
+  txn->engine = this;
+  RS485Job job = {};
+  job.owner = RS485_OWNER_MODBUS;
+  job.priority = txn->priority;
+  job.run = runJob;
+  job.arg = txn;
+  job.boundMs = jobBoundMs(*txn);
+  return rs485BusSubmit(job, ticket);
+}
+
+bool RS485Modbus::submit(ModbusTxn* txn) {
+  return enqueue(txn, nullptr);
+}
+
+ModbusStatus RS485Modbus::transact(ModbusTxn& txn) {
+  txn.waiter = xTaskGetCurrentTaskHandle();
+  ulTaskNotifyTake(pdTRUE, 0);  // oude notificatie wissen
+  RS485Ticket ticket;
+  if (!enqueue(&txn, &ticket)) {
+    txn.status = MODBUS_ERR_BUS;
+    return txn.status;
   }
-  drainRx(serial);
-  setTransmitMode(true);
-  delay(1);
-  
-  for (uint8_t i = 0; i < 8; i++) {
-    serial->write(request[i]);
+  // Begrensd: queue vóór de txn + jobBoundMs. Nog niet gestart → geannuleerd.
+  if (!rs485BusAwait(ticket)) {
+    txn.status = MODBUS_ERR_TIMEOUT;
+    txn.regCount = 0;
   }
-  
-  serial->flush();
-  delay(1);
-  setTransmitMode(false);
-  
-  return true;
+  return txn.status;
 }
 
-bool RS485Modbus::receiveResponse(uint8_t expectedFunctionCode, uint16_t expectedBytes) {
-  (void)expectedBytes;
-  if (!initialized || !serial) {
-    return false;
+ModbusStatus RS485Modbus::execute(ModbusTxn& txn) {
+  txn.regCount = 0;
+  txn.exception = 0;
+  txn.latencyUs = 0;
+  txn.busUs = 0;
+  if (!initialized) return MODBUS_ERR_BUS;
+
+  const uint8_t slave = txn.slave ? txn.slave : config.slaveId;
+  uint8_t frame[MODBUS_RTU_MAX_FRAME];
+  size_t len = 0;
+  switch (txn.fc) {
+    case MODBUS_READ_COILS:
+    case MODBUS_READ_DISCRETE_INPUTS:
+    case MODBUS_READ_HOLDING_REGISTERS:
+    case MODBUS_READ_INPUT_REGISTERS:
+      if (txn.qty == 0 || txn.qty > MODBUS_TXN_MAX_REGS) return MODBUS_ERR_LENGTH;
+      len = modbusBuildRequest(frame, slave, txn.fc, txn.addr, txn.qty);
+      break;
+    case MODBUS_WRITE_SINGLE_COIL:
+    case MODBUS_WRITE_SINGLE_REGISTER:
+      len = modbusBuildRequest(frame, slave, txn.fc, txn.addr, txn.qty);
+      break;
+    case MODBUS_WRITE_MULTIPLE_REGISTERS:
+      len = modbusBuildWriteMultiple(frame, sizeof(frame), slave, txn.addr, txn.values,
+                                     txn.qty > MODBUS_TXN_MAX_REGS ? 0 : txn.qty);
+      if (len == 0) return MODBUS_ERR_LENGTH;
+      break;
+    case MODBUS_TXN_RAW:
+      if (txn.rawLen == 0 || txn.rawLen > MODBUS_TXN_RAW_MAX || txn.rawExpect > MODBUS_TXN_RAW_MAX) {
+        return MODBUS_ERR_LENGTH;
+      }
+      len = txn.rawLen;
+      memcpy(frame, txn.raw, len);
+      break;
+    default:
+      return MODBUS_ERR_FUNCTION;
   }
-  
-  const unsigned long deadline = millis() + MODBUS_RX_DEADLINE_MS;
-  uint8_t buffer[256];
-  uint8_t index = 0;
-  unsigned long lastByteMs = 0;
-  
+
   if (defrostDebug) {
-    logger.info("[Modbus] Wachten op antwoord (max " + String(MODBUS_RX_DEADLINE_MS) + " ms)...");
+    logger.info("[Modbus TX] FC" + String(txn.fc, HEX) + " @ " + String(txn.addr) + " | " +
+                bytesToHex(frame, (uint8_t)len));
   }
-  
-  // Harde deadline: nooit eindeloos wachten bij ruis of geen regelaar. Oude code
-  // verlengde timeout bij elke byte → kon CPU 0 minutenlang blokkeren.
-  while (millis() < deadline && index < 256) {
-    if (serial->available()) {
-      buffer[index++] = serial->read();
-      lastByteMs = millis();
-    } else if (index > 0 && (millis() - lastByteMs) >= MODBUS_RX_INTERBYTE_MS) {
-      break;
-    }
-    vTaskDelay(1);
-    kickWatchdog();
-  }
-  
+
+  // Lijninstelling van deze transactie (discovery/Carel-probe), dan t3.5
+  // stilte vóór een nieuw frame (ook na een Carel-job op dezelfde bus).
+  const uint32_t lineBaud = txn.baud ? txn.baud : config.baudRate;
+  rs485BusUseLine(lineBaud, txn.serialConfig ? txn.serialConfig : config.serialConfig);
+  rs485BusWaitIdle(rs485BusT35Us());
+  const uint32_t txEndUs = rs485BusTransmit(frame, len);
+
+  const bool raw = txn.fc == MODBUS_TXN_RAW;
+  // Broadcast: geen antwoord.
+  if (slave == 0 && !raw) return MODBUS_OK;
+
+  const size_t expected = raw ? txn.rawExpect : modbusExpectedResponseLength(txn.fc, txn.qty);
+  uint8_t rx[MODBUS_RTU_MAX_FRAME];
+  uint8_t gaps = 0;
+  const size_t n = rs485BusReceive(rx, sizeof(rx), expected, txn.timeoutMs ? txn.timeoutMs : MODBUS_RX_DEADLINE_MS,
+                                   !raw, &gaps);
+  txn.latencyUs = rs485BusLastActivityUs() - txEndUs;
+
   if (defrostDebug) {
-    if (index == 0) {
+    if (n == 0) {
       logger.info("[Modbus RX] TIMEOUT: geen bytes ontvangen");
-      logger.info("  -> Controleer: A+ B- aangesloten? Slave ID=" + String(config.slaveId) + " op regelaar? Baud=" + String(config.baudRate) + "?");
-      return false;
-    }
-    logger.info("[Modbus RX] " + String(index) + " bytes: " + bytesToHex(buffer, index));
-  }
-  
-  if (index < 5) {
-    if (defrostDebug) logger.info("[Modbus RX] Te kort antwoord (<5 bytes)");
-    return false; // Minimum response length
-  }
-  
-  // Check slave ID
-  if (buffer[0] != config.slaveId) {
-    if (defrostDebug) {
-      logger.info("[Modbus RX] Fout: slave ID in antwoord (" + String(buffer[0]) + ") != verwacht (" + String(config.slaveId) + ")");
+      logger.info("  -> Controleer: A+ B- aangesloten? Slave ID=" + String(slave) + " op regelaar? Baud=" + String(lineBaud) + "?");
     } else {
-      return false;
+      logger.info("[Modbus RX] " + String(n) + " bytes in " + String(txn.latencyUs) + " us" +
+                  (gaps ? " (" + String(gaps) + "x pauze > t1.5)" : String("")) + ": " +
+                  bytesToHex(rx, (uint8_t)(n > 255 ? 255 : n)));
     }
-    return false;
   }
-  
-  // Check function code
-  if (buffer[1] & 0x80) {
-    // Exception response
-    const char* exc = "?";
-    if (buffer[2] == 0x01) exc = "illegal function";
-    else if (buffer[2] == 0x02) exc = "illegal data address";
-    else if (buffer[2] == 0x03) exc = "illegal data value";
-    else if (buffer[2] == 0x04) exc = "slave device failure";
-    logger.warn("Modbus exception 0x" + String(buffer[2], HEX) + ": " + String(exc));
-    if (defrostDebug) logger.info("  -> Adres niet ondersteund door regelaar?");
-    return false;
-  }
-  
-  if (buffer[1] != expectedFunctionCode) {
-    if (defrostDebug) logger.info("[Modbus RX] Fout: function code " + String(buffer[1], HEX) + " != verwacht " + String(expectedFunctionCode, HEX));
-    return false;
-  }
-  
-  // Verify CRC
-  uint16_t receivedCRC = (buffer[index - 1] << 8) | buffer[index - 2];
-  uint16_t calculatedCRC = calculateCRC(buffer, index - 2);
-  
-  if (receivedCRC != calculatedCRC) {
-    logger.warn("Modbus CRC error");
-    if (defrostDebug) logger.info("  -> Elektrische storing of noise op RS485-lijn?");
-    return false;
+
+  if (raw) {
+    // Geen codec: de aanroeper valideert (bv. Carel-checksum).
+    txn.rawLen = (uint8_t)(n < MODBUS_TXN_RAW_MAX ? n : MODBUS_TXN_RAW_MAX);
+    memcpy(txn.raw, rx, txn.rawLen);
+    if (n == 0) return MODBUS_ERR_TIMEOUT;
+    return n < expected ? MODBUS_ERR_SHORT : MODBUS_OK;
   }
-  
-  // Extract data (for read responses)
-  responseLength = buffer[2] / 2; // Number of registers (2 bytes each)
-  for (uint8_t i = 0; i < responseLength && i < 64; i++) {
-    responseBuffer[i] = (buffer[3 + i * 2] << 8) | buffer[4 + i * 2];
+
+  const ModbusStatus st = modbusParseResponse(rx, n, slave, txn.fc, txn.qty, &txn.exception);
+  switch (st) {
+    case MODBUS_OK:
+      break;
+    case MODBUS_ERR_EXCEPTION:
+      logger.warn("Modbus exception 0x" + String(txn.exception, HEX) + ": " + String(modbusExceptionName(txn.exception)));
+      if (defrostDebug) logger.info("  -> Adres niet ondersteund door regelaar?");
+      return st;
+    case MODBUS_ERR_CRC:
+      logger.warn("Modbus CRC error");
+      if (defrostDebug) logger.info("  -> Elektrische storing of noise op RS485-lijn?");
+      return st;
+    default:
+      if (defrostDebug && n > 0) logger.info(String("[Modbus RX] Fout: ") + modbusStatusName(st));
+      return st;
+  }
+
+  if (txn.fc == MODBUS_READ_COILS || txn.fc == MODBUS_READ_DISCRETE_INPUTS) {
+    bool bits[MODBUS_TXN_MAX_REGS];
+    txn.regCount = modbusExtractBits(rx, n, txn.qty, bits, MODBUS_TXN_MAX_REGS);
+    for (uint16_t i = 0; i < txn.regCount; i++) txn.regs[i] = bits[i] ? 1 : 0;
+  } else if (txn.fc == MODBUS_READ_HOLDING_REGISTERS || txn.fc == MODBUS_READ_INPUT_REGISTERS) {
+    txn.regCount = modbusExtractRegisters(rx, n, txn.regs, MODBUS_TXN_MAX_REGS);
   }
-  
   if (defrostDebug) logger.info("[Modbus RX] OK");
+  return MODBUS_OK;
+}
+
+bool RS485Modbus::runRead(uint8_t fc, uint16_t startAddress, uint16_t quantity) {
+  ModbusTxn txn = {};
+  txn.fc = fc;
+  txn.addr = startAddress;
+  txn.qty = quantity;
+  txn.priority = true;
+  if (transact(txn) != MODBUS_OK) return false;
+  responseLength = (uint8_t)txn.regCount;
+  memcpy(responseBuffer, txn.regs, sizeof(uint16_t) * txn.regCount);
   return true;
 }
 
+bool RS485Modbus::runWrite(uint8_t fc, uint16_t address, uint16_t value) {
+  ModbusTxn txn = {};
+  txn.fc = fc;
+  txn.addr = address;
+  txn.qty = value;
+  txn.priority = true;
+  return transact(txn) == MODBUS_OK;
+}
+
 bool RS485Modbus::readHoldingRegisters(uint16_t startAddress, uint16_t quantity) {
-  BusLock lock;
-  if (!lock) return false;
-  bool ok = false;
-  if (sendRequest(MODBUS_READ_HOLDING_REGISTERS, startAddress, quantity)) {
-    vTaskDelay(pdMS_TO_TICKS(5));
-    ok = receiveResponse(MODBUS_READ_HOLDING_REGISTERS, quantity * 2);
-  }
-  onModbusResult(ok);
-  return ok;
+  return runRead(MODBUS_READ_HOLDING_REGISTERS, startAddress, quantity);
 }
 
 bool RS485Modbus::readInputRegisters(uint16_t startAddress, uint16_t quantity) {
-  BusLock lock;
-  if (!lock) return false;
-  bool ok = false;
-  if (sendRequest(MODBUS_READ_INPUT_REGISTERS, startAddress, quantity)) {
-    vTaskDelay(pdMS_TO_TICKS(5));
-    ok = receiveResponse(MODBUS_READ_INPUT_REGISTERS, quantity * 2);
-  }
-  onModbusResult(ok);
-  return ok;
+  return runRead(MODBUS_READ_INPUT_REGISTERS, startAddress, quantity);
 }
 
 bool RS485Modbus::readCoils(uint16_t startAddress, uint16_t quantity) {
-  // Similar implementation for coils
-  return false;
+  return runRead(MODBUS_READ_COILS, startAddress, quantity);
 }
 
 bool RS485Modbus::readDiscreteInputs(uint16_t startAddress, uint16_t quantity) {
-  // Similar implementation for discrete inputs
-  return false;
+  return runRead(MODBUS_READ_DISCRETE_INPUTS, startAddress, quantity);
 }
 
 bool RS485Modbus::writeSingleRegister(uint16_t address, uint16_t value) {
-  BusLock lock;
-  if (!lock || !initialized || !serial) {
-    return false;
-  }
-  
-  uint8_t request[8];
-  request[0] = config.slaveId;
-  request[1] = MODBUS_WRITE_SINGLE_REGISTER;
-  request[2] = (address >> 8) & 0xFF;
-  request[3] = address & 0xFF;
-  request[4] = (value >> 8) & 0xFF;
-  request[5] = value & 0xFF;
-  
-  uint16_t crc = calculateCRC(request, 6);
-  request[6] = crc & 0xFF;
-  request[7] = (crc >> 8) & 0xFF;
-  
   if (defrostDebug) {
-    logger.info("[Modbus TX] FC06 WriteRegister addr=" + String(address) + " val=" + String(value) + " | " + bytesToHex(request, 8));
-  }
-  drainRx(serial);
-  setTransmitMode(true);
-  delay(1);
-  
-  for (uint8_t i = 0; i < 8; i++) {
-    serial->write(request[i]);
+    logger.info("[Modbus] FC06 WriteRegister addr=" + String(address) + " val=" + String(value));
   }
-  
-  serial->flush();
-  delay(1);
-  setTransmitMode(false);
-  
-  vTaskDelay(pdMS_TO_TICKS(5));
-  
-  bool ok = receiveResponse(MODBUS_WRITE_SINGLE_REGISTER, 4);
-  onModbusResult(ok);
-  return ok;
+  return runWrite(MODBUS_WRITE_SINGLE_REGISTER, address, value);
 }
 
 bool RS485Modbus::writeMultipleRegisters(uint16_t startAddress, uint16_t* values, uint16_t quantity) {
-  // Implementation for multiple register write
-  return false;
+  if (!values || quantity == 0 || quantity > MODBUS_TXN_MAX_REGS) return false;
+  ModbusTxn txn = {};
+  txn.fc = MODBUS_WRITE_MULTIPLE_REGISTERS;
+  txn.addr = startAddress;
+  txn.qty = quantity;
+  txn.priority = true;
+  memcpy(txn.values, values, sizeof(uint16_t) * quantity);
+  return transact(txn) == MODBUS_OK;
 }
 
 bool RS485Modbus::writeSingleCoil(uint16_t address, bool value) {
-  BusLock lock;
-  if (!lock || !initialized || !serial) {
-    return false;
-  }
-  // Modbus FC 0x05: value 0xFF00 = ON, 0x0000 = OFF
-  uint16_t coilValue = value ? 0xFF00 : 0x0000;
-  uint8_t request[8];
-  request[0] = config.slaveId;
-  request[1] = MODBUS_WRITE_SINGLE_COIL;
-  request[2] = (address >> 8) & 0xFF;
-  request[3] = address & 0xFF;
-  request[4] = (coilValue >> 8) & 0xFF;
-  request[5] = coilValue & 0xFF;
-  uint16_t crc = calculateCRC(request, 6);
-  request[6] = crc & 0xFF;
-  request[7] = (crc >> 8) & 0xFF;
   if (defrostDebug) {
-    logger.info("[Modbus TX] FC05 WriteCoil addr=" + String(address) + " val=" + String(value ? "ON" : "OFF") + " | " + bytesToHex(request, 8));
+    logger.info("[Modbus] FC05 WriteCoil addr=" + String(address) + " val=" + String(value ? "ON" : "OFF"));
   }
-  drainRx(serial);
-  setTransmitMode(true);
-  delay(1);
-  for (uint8_t i = 0; i < 8; i++) serial->write(request[i]);
-  serial->flush();
-  delay(1);
-  setTransmitMode(false);
-  vTaskDelay(pdMS_TO_TICKS(5));
-  bool ok = receiveResponse(MODBUS_WRITE_SINGLE_COIL, 4);
-  onModbusResult(ok);
-  return ok;
+  // Modbus FC 0x05: value 0xFF00 = ON, 0x0000 = OFF
+  return runWrite(MODBUS_WRITE_SINGLE_COIL, address, value ? 0xFF00 : 0x0000);
 }
 
 bool RS485Modbus::writeMultipleCoils(uint16_t startAddress, bool* values, uint16_t quantity) {
@@ -2,42 +2,72 @@
 #define RS485_MODBUS_H
 
 #include <Arduino.h>
-#include <HardwareSerial.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include "config.h"
+#include "modbus_rtu.h"
+#include "rs485_bus.h"
 
-// Modbus RTU function codes
-#define MODBUS_READ_COILS           0x01
-#define MODBUS_READ_DISCRETE_INPUTS 0x02
-#define MODBUS_READ_HOLDING_REGISTERS 0x03
-#define MODBUS_READ_INPUT_REGISTERS 0x04
-#define MODBUS_WRITE_SINGLE_COIL    0x05
-#define MODBUS_WRITE_SINGLE_REGISTER 0x06
-#define MODBUS_WRITE_MULTIPLE_COILS 0x0F
-#define MODBUS_WRITE_MULTIPLE_REGISTERS 0x10
+// Transactie-engine: elke transactie is een job op de gedeelde RS485-bus
+// (rs485_bus): de bus-worker kiest de lijn, wacht t3.5 stilte, zendt en
+// ontvangt event-gedreven tot de verwachte lengte (zie rs485BusReceive).
+// Carel-jobs lopen via dezelfde queue.
+#define MODBUS_TXN_MAX_REGS      64     // registers/bits per transactie (= responseBuffer)
+#define MODBUS_TXN_RAW           0x00   // fc: ruw frame (geen Modbus-codec), bv. Carel-probe
+#define MODBUS_TXN_RAW_MAX       16
 
-// Modbus exception codes
-#define MODBUS_EXCEPTION_ILLEGAL_FUNCTION 0x01
-#define MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS 0x02
-#define MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE 0x03
-#define MODBUS_EXCEPTION_SLAVE_DEVICE_FAILURE 0x04
+struct ModbusTxn;
+class RS485Modbus;
+typedef void (*ModbusCallback)(ModbusTxn& txn, void* ctx);
+
+struct ModbusTxn {
+  // Request
+  uint8_t  slave;       // 0 = slave-ID uit ModbusConfig
+  uint8_t  fc;
+  uint16_t addr;
+  uint16_t qty;         // registers/bits; bij FC05/06 de waarde
+  uint16_t values[MODBUS_TXN_MAX_REGS];  // FC16-data
+  uint16_t timeoutMs;   // 0 = MODBUS_RX_DEADLINE_MS (per slave instelbaar)
+  bool     priority;    // app-commando: vooraan in de queue, vóór achtergrond-polls
+  uint32_t baud;        // 0 = lijninstelling uit ModbusConfig (discovery probeert andere)
+  uint32_t serialConfig;  // SERIAL_8N1/8E1/...; 0 = uit ModbusConfig
+  // MODBUS_TXN_RAW: raw[0..rawLen) wordt verstuurd; na afloop staat het
+  // antwoord in raw/rawLen. Klaar na rawExpect bytes (of deadline).
+  uint8_t  raw[MODBUS_TXN_RAW_MAX];
+  uint8_t  rawLen;
+  uint8_t  rawExpect;
+
+  // Resultaat (gezet door de worker vóór callback/notify)
+  ModbusStatus status;
+  uint8_t  exception;
+  uint16_t regs[MODBUS_TXN_MAX_REGS];    // FC01/02: één bit per element (0/1)
+  uint16_t regCount;
+  uint32_t latencyUs;   // einde TX → einde RX-frame
+  uint32_t busUs;       // bezettingstijd van de bus (t3.5 + TX + wachten op antwoord)
+
+  // Afhandeling: callback (async, vanuit de worker) en/of wachtende taak.
+  ModbusCallback callback;
+  void*    ctx;
+  TaskHandle_t waiter;
+  RS485Modbus* engine;  // intern (submit)
+};
 
 class RS485Modbus {
 private:
-  HardwareSerial* serial;
   ModbusConfig config;
-  uint8_t dePin;
-  uint8_t rePin;
   bool initialized;
   
   uint16_t responseBuffer[64];
   uint8_t responseLength;
   bool defrostDebug;  // extra logging voor ontdooiing-diagnostiek
   
-  void setTransmitMode(bool transmit);
   static String bytesToHex(uint8_t* data, uint8_t len);
-  uint16_t calculateCRC(uint8_t* data, uint8_t length);
-  bool sendRequest(uint8_t functionCode, uint16_t startAddress, uint16_t quantity);
-  bool receiveResponse(uint8_t expectedFunctionCode, uint16_t expectedBytes);
+  static void runJob(void* arg);  // bus-worker: execute + callback/notify
+  uint32_t jobBoundMs(const ModbusTxn& txn) const;
+  bool enqueue(ModbusTxn* txn, RS485Ticket* ticket);
+  ModbusStatus execute(ModbusTxn& txn);
+  bool runRead(uint8_t fc, uint16_t startAddress, uint16_t quantity);
+  bool runWrite(uint8_t fc, uint16_t address, uint16_t value);
   
 public:
   RS485Modbus();
@@ -45,8 +75,22 @@ public:
   
   bool init(ModbusConfig config);
   bool isInitialized() const { return initialized; }
+  /** Standaard lijninstelling (na discovery); de bus schakelt bij de volgende transactie om. */
+  void setLine(uint32_t baud, uint32_t serialConfig);
+  uint32_t baudRate() const { return config.baudRate; }
+  uint32_t serialConfig() const { return config.serialConfig; }
   void setDefrostDebug(bool enable) { defrostDebug = enable; }
   
+  // Transactie-API. submit(): async, txn moet blijven bestaan tot de callback
+  // (vanuit de worker-taak) is gelopen. transact(): "future" — blokkeert de
+  // aanroepende taak (zonder CPU) tot de worker klaar is, hooguit de queue
+  // vóór de txn + zijn eigen bovengrens (t3.5 + TX + antwoord-deadline);
+  // anders MODBUS_ERR_TIMEOUT. txn.priority zet de transactie vooraan: een
+  // app-commando wacht hooguit op de lopende read.
+  bool submit(ModbusTxn* txn);
+  ModbusStatus transact(ModbusTxn& txn);
+  
+  // Blokkerende wrappers (slave uit ModbusConfig, priority): command-pad.
   // Read functions
   bool readHoldingRegisters(uint16_t startAddress, uint16_t quantity);
   bool readInputRegisters(uint16_t startAddress, uint16_t quantity);
@@ -67,19 +111,7 @@ public:
   uint16_t getUInt16(uint8_t index);
 };
 
-/* ----------------------------------------------------------------------- *
- * Carrier-API (spec): eenvoudige free-function init op Serial1 + DE-pin.
- * Coexistent met RS485Modbus; niet tegelijk gebruiken met die klasse, anders
- * claimen beide Serial1. Full Modbus-framing volgt in een latere taak.
- * ----------------------------------------------------------------------- */
-void initRS485(uint32_t baud = 9600);
-void rs485TxEnable(bool en);
-uint32_t carrierRS485ActiveBaud();
-
-// Regelaar (Dixell e.d.) is optioneel: achtergrond-polls stoppen na herhaalde
-// timeouts; app-commando's forceren één nieuwe poging.
-bool modbusBackgroundPollAllowed();
-void modbusForceProbe();
-bool modbusControllerLikelyPresent();
+// Regelaars zijn optioneel: backoff na herhaalde timeouts zit per slave in
+// modbus_scheduler.
 
 #endif
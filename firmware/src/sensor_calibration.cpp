@@ -0,0 +1,173 @@
+#include "sensor_calibration.h"
+#include "sensors_pt1000.h"
+#include "logger.h"
+#include <Preferences.h>
+
+extern Logger logger;
+
+namespace {
+
+const char* const kNamespace  = "sensorcal";
+const char* const kVersionKey = "ver";
+
+// Eén NVS-blob per kanaal ("ch0", "ch1", ...). Het eerste referentiepunt
+// wordt mee bewaard zodat een reboot tussen punt 1 en 2 de fit niet breekt.
+struct CalRecord {
+  float   gain;
+  float   offsetOhm;
+  uint8_t points;       // 0 = nominaal, 1 = offset-only, 2 = gain + offset
+  float   p1RefC;
+  float   p1MeasOhm;
+};
+
+CalRecord s_cal[PT1000_COUNT];
+uint32_t  s_version = 0;
+
+void keyFor(uint8_t idx, char* buf, size_t len) {
+  snprintf(buf, len, "ch%u", (unsigned)idx);
+}
+
+CalRecord nominal() {
+  return CalRecord{ 1.0f, 0.0f, 0, 0.0f, 0.0f };
+}
+
+// IEC 60751: verwachte weerstand bij refC.
+float expectedOhm(const Pt1000Channel& ch, float t) {
+  const float a = 3.9083e-3f, b = -5.775e-7f, c = -4.183e-12f;
+  float r = 1.0f + a * t + b * t * t;
+  if (t < 0) r += c * (t - 100.0f) * t * t * t;
+  return ch.rnominalOhm * r;
+}
+
+// Eerst NVS, dan pas RAM: bij een mislukte write blijven s_cal en
+// s_version (en dus de actieve coëfficiënten) ongewijzigd.
+bool persist(uint8_t idx, const CalRecord& rec) {
+  Preferences prefs;
+  if (!prefs.begin(kNamespace, false)) {
+    logger.error("[CAL] NVS open mislukt");
+    return false;
+  }
+  char key[8];
+  keyFor(idx, key, sizeof(key));
+  const uint32_t version = s_version + 1;
+  bool ok = prefs.putBytes(key, &rec, sizeof(CalRecord)) == sizeof(CalRecord);
+  ok = ok && prefs.putUInt(kVersionKey, version) > 0;
+  prefs.end();
+  if (ok) {
+    s_cal[idx] = rec;
+    s_version = version;
+  }
+  return ok;
+}
+
+void describe(uint8_t idx, String& out) {
+  const CalRecord& c = s_cal[idx];
+  out = String("{\"channel\":\"") + sensorChannel(idx).name +
+        "\",\"gain\":" + String(c.gain, 6) +
+        ",\"offsetOhm\":" + String(c.offsetOhm, 3) +
+        ",\"points\":" + c.points +
+        ",\"calVersion\":" + s_version + "}";
+}
+
+} // namespace
+
+void loadSensorCalibration() {
+  for (uint8_t i = 0; i < PT1000_COUNT; i++) s_cal[i] = nominal();
+
+  Preferences prefs;
+  if (prefs.begin(kNamespace, true)) {
+    s_version = prefs.getUInt(kVersionKey, 0);
+    for (uint8_t i = 0; i < PT1000_COUNT; i++) {
+      char key[8];
+      keyFor(i, key, sizeof(key));
+      CalRecord rec;
+      if (prefs.getBytesLength(key) == sizeof(CalRecord) &&
+          prefs.getBytes(key, &rec, sizeof(rec)) == sizeof(rec)) {
+        s_cal[i] = rec;
+      }
+    }
+    prefs.end();
+  }
+
+  for (uint8_t i = 0; i < PT1000_COUNT; i++) {
+    applySensorCalibration(i, s_cal[i].gain, s_cal[i].offsetOhm);
+    if (s_cal[i].points > 0) {
+      logger.info(String("[CAL] ") + sensorChannel(i).name + ": gain=" + String(s_cal[i].gain, 5) +
+                  " offset=" + String(s_cal[i].offsetOhm, 2) + "Ω (v" + s_version + ")");
+    }
+  }
+}
+
+uint32_t sensorCalVersion() {
+  return s_version;
+}
+
+bool captureCalibrationPoint(uint8_t idx, float refC, String& resultJson) {
+  if (idx >= PT1000_COUNT) {
+    resultJson = "{\"error\":\"invalid channel\"}";
+    return false;
+  }
+  if (isnan(refC) || refC < -200.0f || refC > 200.0f) {
+    resultJson = "{\"error\":\"refC out of range\"}";
+    return false;
+  }
+  const uint16_t raw = getCachedRtdRaw(idx);
+  if (raw == 0) {
+    resultJson = "{\"error\":\"no valid reading\"}";
+    return false;
+  }
+
+  const Pt1000Channel& ch = sensorChannel(idx);
+  const float measOhm = ((float)raw * ch.rrefOhm) / 32768.0f;  // ongekalibreerd
+  const float trueOhm = expectedOhm(ch, refC);
+
+  CalRecord next = s_cal[idx];
+  if (next.points == 0 || fabsf(refC - next.p1RefC) < SENSOR_CAL_MIN_SPAN_C) {
+    // Eerste punt (of zelfde referentie opnieuw): enkel offset.
+    next.gain      = 1.0f;
+    next.offsetOhm = trueOhm - measOhm;
+    next.points    = 1;
+    next.p1RefC    = refC;
+    next.p1MeasOhm = measOhm;
+  } else {
+    const float trueP1 = expectedOhm(ch, next.p1RefC);
+    next.gain      = (trueOhm - trueP1) / (measOhm - next.p1MeasOhm);
+    next.offsetOhm = trueP1 - next.gain * next.p1MeasOhm;
+    next.points    = 2;
+  }
+
+  if (isnan(next.gain) || fabsf(next.gain - 1.0f) > SENSOR_CAL_MAX_GAIN_DEV ||
+      fabsf(next.offsetOhm) > SENSOR_CAL_MAX_OFFSET) {
+    resultJson = String("{\"error\":\"fit out of bounds\",\"gain\":") + String(next.gain, 6) +
+                 ",\"offsetOhm\":" + String(next.offsetOhm, 3) + "}";
+    logger.warn("[CAL] " + String(ch.name) + ": fit verworpen (gain=" + String(next.gain, 5) +
+                " offset=" + String(next.offsetOhm, 2) + "Ω)");
+    return false;
+  }
+
+  if (!persist(idx, next)) {
+    resultJson = "{\"error\":\"nvs write failed\"}";
+    return false;
+  }
+  applySensorCalibration(idx, next.gain, next.offsetOhm);
+  logger.info("[CAL] " + String(ch.name) + ": punt " + next.points + " @ " + String(refC, 2) +
+              "°C → gain=" + String(next.gain, 5) + " offset=" + String(next.offsetOhm, 2) +
+              "Ω (v" + s_version + ")");
+  describe(idx, resultJson);
+  return true;
+}
+
+bool resetSensorCalibration(uint8_t idx, String& resultJson) {
+  if (idx >= PT1000_COUNT) {
+    resultJson = "{\"error\":\"invalid channel\"}";
+    return false;
+  }
+  if (!persist(idx, nominal())) {
+    resultJson = "{\"error\":\"nvs write failed\"}";
+    return false;
+  }
+  applySensorCalibration(idx, 1.0f, 0.0f);
+  logger.info("[CAL] " + String(sensorChannel(idx).name) + ": reset naar nominaal (v" + s_version + ")");
+  describe(idx, resultJson);
+  return true;
+}
@@ -0,0 +1,45 @@
+#ifndef SENSOR_CALIBRATION_H
+#define SENSOR_CALIBRATION_H
+
+#include <Arduino.h>
+
+/**
+ * Twee-punts veldkalibratie voor de PT1000-kanalen, bewaard in NVS
+ * (namespace "sensorcal"). Per kanaal gain + offset (Ω) op de gemeten
+ * weerstand; een negatieve offset compenseert de leidingweerstand van lange
+ * 2-wire kabels naar vriescellen.
+ *
+ * Workflow (remote command SENSOR_CAL):
+ *   1. voeler in referentie (ijsbad 0 °C) → action "point", refC 0
+ *      → offset-only kalibratie (leidingweerstand) is meteen actief
+ *   2. optioneel tweede referentie (bv. -18 °C in referentiebad)
+ *      → action "point", refC -18 → gain + offset
+ *   "reset" zet een kanaal terug op nominaal (gain 1, offset 0).
+ *
+ * Een punt neemt de laatste geldige ruwe meting uit de sensorcache: geen SPI
+ * vanuit de HTTP-taak. calVersion stijgt bij elke wijziging en gaat mee in
+ * elke reading zodat de backend weet met welke coëfficiënten gemeten is.
+ */
+
+#define SENSOR_CAL_MIN_SPAN_C   5.0f   // minimaal verschil tussen twee refpunten
+#define SENSOR_CAL_MAX_GAIN_DEV 0.10f  // |gain - 1| limiet
+#define SENSOR_CAL_MAX_OFFSET   100.0f // |offset| limiet (Ω)
+
+/** Laadt coëfficiënten uit NVS en past ze toe. Aanroepen vóór initSensors(). */
+void loadSensorCalibration();
+
+/** Monotone versie van de actieve kalibratieset (0 = nominaal, nooit gekalibreerd). */
+uint32_t sensorCalVersion();
+
+/**
+ * Referentiepunt vastleggen voor kanaal idx bij refC. Bij het eerste punt
+ * offset-only, bij het tweede gain + offset. Persisteert meteen.
+ * resultJson krijgt {"channel","gain","offsetOhm","points","calVersion"} of
+ * {"error":...}. Returnt false bij fout.
+ */
+bool captureCalibrationPoint(uint8_t idx, float refC, String& resultJson);
+
+/** Kanaal terug naar nominaal en persisteren. */
+bool resetSensorCalibration(uint8_t idx, String& resultJson);
+
+#endif /* SENSOR_CALIBRATION_H */
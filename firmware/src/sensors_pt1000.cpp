@@ -9,16 +9,56 @@ extern Logger logger;
 
 namespace {
 
+struct Pt1000BusPins {
+  uint8_t sck;
+  uint8_t mosi;
+  uint8_t miso;
+};
+
+// Index = PT1000_BUS_*.
+const Pt1000BusPins s_buses[] = {
+    { PIN_SPI_SCK, PIN_SPI_MOSI, PIN_SPI_MISO },  // PT1000_BUS_CARRIER
+};
+
+#define PT1000_DESCRIPTOR(name, rkey, fkey, bus, cs, role, rref, rnom, ms) \
+  { name, rkey, fkey, bus, cs, role, rref, rnom, ms },
+const Pt1000Channel s_channels[PT1000_COUNT] = {
+    PT1000_CHANNEL_TABLE(PT1000_DESCRIPTOR)
+};
+#undef PT1000_DESCRIPTOR
+
+#define PT1000_DEVICE(name, rkey, fkey, bus, cs, ...) \
+  Adafruit_MAX31865(cs, s_buses[bus].mosi, s_buses[bus].miso, s_buses[bus].sck),
 Adafruit_MAX31865 s_sensors[PT1000_COUNT] = {
-    Adafruit_MAX31865(PIN_MAX31865_CS1, PIN_SPI_MOSI, PIN_SPI_MISO, PIN_SPI_SCK),
-    Adafruit_MAX31865(PIN_MAX31865_CS2, PIN_SPI_MOSI, PIN_SPI_MISO, PIN_SPI_SCK),
+    PT1000_CHANNEL_TABLE(PT1000_DEVICE)
 };
+#undef PT1000_DEVICE
+
+struct ChannelState {
+  bool             initOk       = false;  // begin() gedaan op een aanwezige chip
+  uint8_t          lastFault    = 0;      // faultcode van de bevestigde klasse
+  float            lastTempC    = NAN;
+  uint32_t         lastSampleMs = 0;
 
-const uint8_t s_csPins[PT1000_COUNT] = { PIN_MAX31865_CS1, PIN_MAX31865_CS2 };
+  SensorFaultClass faultClass   = SENSOR_FAULT_NONE;   // bevestigd
+  SensorFaultClass pendingClass = SENSOR_FAULT_NONE;   // in debounce
+  uint8_t          pendingCount = 0;
+  uint8_t          history      = 0;                   // bit (1 << klasse)
+  uint16_t         faultCount   = 0;
 
-bool     s_initOk[PT1000_COUNT] = {false, false};
-uint8_t  s_lastFault[PT1000_COUNT] = {0, 0};
-float    s_lastTempC[PT1000_COUNT] = {NAN, NAN};
+  uint32_t         retryAtMs    = 0;
+  uint32_t         retryDelayMs = PT1000_RETRY_MIN_MS;
+
+  // Veldkalibratie (R_echt = gain · R_gemeten + offset). Gain, RREF/R0 en
+  // offset zitten samen in twee fixed-point coëfficiënten; zie updateCoefficients().
+  uint16_t         lastRtdRaw   = 0;
+  float            calGain      = 1.0f;
+  float            calOffsetOhm = 0.0f;
+  int64_t          mulQ32       = 0;   // 0 = nog niet berekend
+  int64_t          addQ32       = 0;
+};
+
+ChannelState s_state[PT1000_COUNT];
 SemaphoreHandle_t s_spiMutex = nullptr;
 
 inline bool validIdx(uint8_t idx) { return idx < PT1000_COUNT; }
@@ -44,7 +84,7 @@ struct SpiLock {
 // uberhaupt iets terugstuurt (en wat) op alle 8 registers. Mode 1 (CPOL=0,
 // CPHA=1): clock idle low, data sampled on falling edge — dit is de SPI-mode
 // die de MAX31865 vereist.
-uint8_t maxReadReg(uint8_t cs, uint8_t reg) {
+uint8_t maxReadReg(const Pt1000BusPins& bus, uint8_t cs, uint8_t reg) {
   // Schrijf-bit (MSB) op 0 voor read, low-7 = adres.
   uint8_t tx = reg & 0x7F;
   digitalWrite(cs, LOW);
@@ -52,22 +92,22 @@ uint8_t maxReadReg(uint8_t cs, uint8_t reg) {
 
   // Address byte uitsturen (MSB-first).
   for (int b = 7; b >= 0; b--) {
-    digitalWrite(PIN_SPI_SCK, LOW);
-    digitalWrite(PIN_SPI_MOSI, ((tx >> b) & 1) ? HIGH : LOW);
+    digitalWrite(bus.sck, LOW);
+    digitalWrite(bus.mosi, ((tx >> b) & 1) ? HIGH : LOW);
     delayMicroseconds(2);
-    digitalWrite(PIN_SPI_SCK, HIGH);
+    digitalWrite(bus.sck, HIGH);
     delayMicroseconds(2);
   }
-  digitalWrite(PIN_SPI_SCK, LOW);
+  digitalWrite(bus.sck, LOW);
 
   // Data-byte inlezen: bit gesampled op falling edge (mode 1).
   uint8_t rx = 0;
   for (int b = 7; b >= 0; b--) {
-    digitalWrite(PIN_SPI_SCK, HIGH);
+    digitalWrite(bus.sck, HIGH);
     delayMicroseconds(2);
-    digitalWrite(PIN_SPI_SCK, LOW);
+    digitalWrite(bus.sck, LOW);
     delayMicroseconds(1);
-    if (digitalRead(PIN_SPI_MISO)) rx |= (1 << b);
+    if (digitalRead(bus.miso)) rx |= (1 << b);
     delayMicroseconds(1);
   }
 
@@ -77,18 +117,19 @@ uint8_t maxReadReg(uint8_t cs, uint8_t reg) {
 }
 
 void dumpAllRegisters(uint8_t idx) {
-  uint8_t cs = s_csPins[idx];
+  const Pt1000BusPins& bus = s_buses[s_channels[idx].bus];
+  uint8_t cs = s_channels[idx].csPin;
   // Bit-bang vereist dat de pinnen als output staan. Adafruit_MAX31865 heeft
   // ze al geïnitialiseerd in begin(), maar we forceren ze hier voor de zekerheid.
   pinMode(cs,            OUTPUT); digitalWrite(cs,            HIGH);
-  pinMode(PIN_SPI_SCK,   OUTPUT); digitalWrite(PIN_SPI_SCK,   LOW);
-  pinMode(PIN_SPI_MOSI,  OUTPUT); digitalWrite(PIN_SPI_MOSI,  LOW);
-  pinMode(PIN_SPI_MISO,  INPUT);
+  pinMode(bus.sck,       OUTPUT); digitalWrite(bus.sck,       LOW);
+  pinMode(bus.mosi,      OUTPUT); digitalWrite(bus.mosi,      LOW);
+  pinMode(bus.miso,      INPUT);
 
   String line = String("[SENSOR] #") + (idx + 1) + " regs(raw): ";
   uint8_t allZero = 0, allOne = 0;
   for (uint8_t r = 0; r < 8; r++) {
-    uint8_t v = maxReadReg(cs, r);
+    uint8_t v = maxReadReg(bus, cs, r);
     if (v == 0x00) allZero++;
     if (v == 0xFF) allOne++;
     char buf[8];
@@ -101,7 +142,7 @@ void dumpAllRegisters(uint8_t idx) {
     logger.warn(String("[SENSOR] #") + (idx + 1) +
                 " -> ALLE registers 0x00. Chip antwoordt niet. "
                 "Check 3V3 op MAX31865-VDD, CS-pin (GPIO" + cs +
-                ") en MISO (GPIO" + PIN_SPI_MISO + ").");
+                ") en MISO (GPIO" + bus.miso + ").");
   } else if (allOne == 8) {
     logger.warn(String("[SENSOR] #") + (idx + 1) +
                 " -> ALLE registers 0xFF. MISO is high-floating; chip "
@@ -113,11 +154,104 @@ void dumpAllRegisters(uint8_t idx) {
   }
 }
 
+// -- Fixed-point RTD → °C ---------------------------------------------------------
+// R/R0 (Q16) volgens Callendar-Van Dusen (IEC 60751) van -200 tot +200 °C in
+// stappen van 10 °C. Lineaire interpolatie ertussen: max. fout < 0.005 °C.
+constexpr int16_t  kTableMinC  = -200;
+constexpr int16_t  kTableStepC = 10;
+constexpr uint32_t kRatioQ16[] = {
+    12137,  14959,  17758,  20536,  23294,  26033,  28755,  31460,  34151,
+    36827,  39489,  42139,  44778,  47405,  50022,  52630,  55228,  57817,
+    60398,  62971,  65536,  68094,  70644,  73186,  75721,  78248,  80768,
+    83280,  85785,  88282,  90771,  93253,  95727,  98194,  100653, 103105,
+    105549, 107985, 110414, 112835, 115249,
+};
+constexpr size_t kRatioCount = sizeof(kRatioQ16) / sizeof(kRatioQ16[0]);
+
+// R/R0 in Q16 = (raw · mulQ32 + addQ32) >> 16, met
+//   mulQ32 = gain · RREF / (32768 · R0) · 2^32
+//   addQ32 = offset / R0 · 2^32
+// Kalibratie kost zo niets extra per meting: het blijft één mul + add.
+void updateCoefficients(uint8_t idx) {
+  ChannelState& st = s_state[idx];
+  const Pt1000Channel& ch = s_channels[idx];
+  const double q32 = 4294967296.0;
+  st.mulQ32 = (int64_t)llround((double)st.calGain * ch.rrefOhm / (32768.0 * ch.rnominalOhm) * q32);
+  st.addQ32 = (int64_t)llround((double)st.calOffsetOhm / ch.rnominalOhm * q32);
+}
+
+// Centi-°C, of INT32_MIN als de weerstand buiten de tabel valt.
+int32_t rtdRawToCentiC(const ChannelState& st, uint16_t rtdRaw) {
+  const int64_t ratio = ((int64_t)rtdRaw * st.mulQ32 + st.addQ32) >> 16;
+  if (ratio < (int64_t)kRatioQ16[0] || ratio > (int64_t)kRatioQ16[kRatioCount - 1]) {
+    return INT32_MIN;
+  }
+  size_t lo = 0, hi = kRatioCount - 1;
+  while (hi - lo > 1) {
+    const size_t mid = (lo + hi) / 2;
+    if ((int64_t)kRatioQ16[mid] <= ratio) lo = mid; else hi = mid;
+  }
+  const int32_t span = (int32_t)(kRatioQ16[hi] - kRatioQ16[lo]);
+  const int32_t frac = (int32_t)(ratio - kRatioQ16[lo]);
+  return (kTableMinC + (int32_t)lo * kTableStepC) * 100 + (frac * kTableStepC * 100) / span;
+}
+
+float rtdRawToCelsius(const ChannelState& st, uint16_t rtdRaw) {
+  const int32_t centi = rtdRawToCentiC(st, rtdRaw);
+  return centi == INT32_MIN ? NAN : centi / 100.0f;
+}
+
+// Config-register (0x00) via bit-bang. Na begin()+enable50Hz staat bit 0 altijd;
+// 0x00 (MISO laag) of 0xFF (MISO zwevend) betekent dat er geen chip antwoordt.
+bool chipAbsent(uint8_t idx) {
+  const uint8_t cfg = maxReadReg(s_buses[s_channels[idx].bus], s_channels[idx].csPin, 0x00);
+  return cfg == 0x00 || cfg == 0xFF;
+}
+
+// Eén observatie → foutklasse. De config-read (extra SPI) gebeurt enkel bij
+// een verdachte RTD-waarde (0x0000 / 0x7FFF), niet op gezonde reads.
+SensorFaultClass classifyReading(uint8_t idx, uint8_t fault, uint16_t rtdRaw, float t) {
+  if (fault == 0xFF) return SENSOR_FAULT_NO_CHIP;
+  if (fault & MAX31865_FAULT_OVUV) return SENSOR_FAULT_OVUV;
+  if (fault & (MAX31865_FAULT_HIGHTHRESH | MAX31865_FAULT_REFINLOW |
+               MAX31865_FAULT_REFINHIGH | MAX31865_FAULT_RTDINLOW)) {
+    return SENSOR_FAULT_OPEN;
+  }
+  if (fault & MAX31865_FAULT_LOWTHRESH) return SENSOR_FAULT_SHORT;
+  if (rtdRaw == 0x0000 || rtdRaw >= 0x7FFF) {
+    if (chipAbsent(idx)) return SENSOR_FAULT_NO_CHIP;
+    return rtdRaw == 0 ? SENSOR_FAULT_SHORT : SENSOR_FAULT_OPEN;
+  }
+  if (isnan(t) || t <= -200.0f || t >= 200.0f) return SENSOR_FAULT_RANGE;
+  return SENSOR_FAULT_NONE;
+}
+
+void scheduleRetry(ChannelState& st, uint32_t now) {
+  st.retryAtMs = now + st.retryDelayMs;
+  st.retryDelayMs = min<uint32_t>(st.retryDelayMs * 2, PT1000_RETRY_MAX_MS);
+}
+
+void confirmClass(uint8_t idx, SensorFaultClass cls, uint8_t fault, uint16_t rtdRaw) {
+  ChannelState& st = s_state[idx];
+  st.faultClass   = cls;
+  st.lastFault    = fault;
+  st.pendingClass = cls;
+  st.pendingCount = 0;
+  st.history     |= (uint8_t)(1u << cls);
+  st.faultCount++;
+  const float rrtd = ((float)rtdRaw * s_channels[idx].rrefOhm) / 32768.0f;
+  logger.warn(String("[SENSOR] #") + (idx + 1) + " (" + s_channels[idx].name + ") " +
+              sensorFaultClassName(cls) + " fault=0x" + String(fault, HEX) +
+              " RTDraw=0x" + String(rtdRaw, HEX) + " Rrtd≈" + String(rrtd, 1) + "Ω");
+}
+
 } // namespace
 
 bool initSensors() {
   int okCount = 0;
   for (uint8_t i = 0; i < PT1000_COUNT; i++) {
+    const Pt1000Channel& ch = s_channels[i];
+    ChannelState& st = s_state[i];
     s_sensors[i].begin(MAX31865_2WIRE);
     // 50 Hz notch voor EU-net (onderdrukt mains-inductie op 2-wire leidingen).
     s_sensors[i].enable50Hz(true);
@@ -135,31 +269,43 @@ bool initSensors() {
     // Rrtd  ≈ 1000 Ω  → PT1000 rond 0 °C.
     // Rrtd  ≈ 100 Ω   → PT100 (dan is RREF op PCB waarsch. 430 Ω i.p.v. 4020 Ω).
     uint16_t rtdRaw = s_sensors[i].readRTD();
-    float    rrtd   = ((float)rtdRaw * PT1000_RREF_OHM) / 32768.0f;
+    float    rrtd   = ((float)rtdRaw * ch.rrefOhm) / 32768.0f;
 
-    float t = s_sensors[i].temperature(PT1000_RNOMINAL_OHM, PT1000_RREF_OHM);
+    updateCoefficients(i);
+    st.lastRtdRaw = rtdRaw;
+    float t = rtdRawToCelsius(st, rtdRaw);
     uint8_t fault = s_sensors[i].readFault();
     if (fault) s_sensors[i].clearFault();
 
-    logger.info(String("[SENSOR] #") + (i + 1) +
-                " diag: CS=GPIO" + (i == 0 ? PIN_MAX31865_CS1 : PIN_MAX31865_CS2) +
+    logger.info(String("[SENSOR] #") + (i + 1) + " (" + ch.name + ")" +
+                " diag: CS=GPIO" + ch.csPin +
                 " RTDraw=0x" + String(rtdRaw, HEX) +
                 " (" + rtdRaw + ") Rrtd≈" + String(rrtd, 1) + "Ω" +
                 " fault=0x" + String(fault, HEX));
 
-    bool ok = (fault == 0) && !isnan(t) && t > -200.0f && t < 200.0f;
-    s_initOk[i]    = ok;
-    s_lastFault[i] = fault;
-    s_lastTempC[i] = ok ? t : NAN;
+    // Bij boot geen debounce: de eerste observatie is meteen de toestand.
+    SensorFaultClass cls = classifyReading(i, fault, rtdRaw, t);
+    st.initOk       = (cls != SENSOR_FAULT_NO_CHIP);
+    st.faultClass   = cls;
+    st.pendingClass = cls;
+    st.lastFault    = fault;
+    st.lastTempC    = (cls == SENSOR_FAULT_NONE) ? t : NAN;
+    if (cls != SENSOR_FAULT_NONE) {
+      st.history |= (uint8_t)(1u << cls);
+      st.faultCount++;
+    }
 
-    if (ok) {
+    if (cls == SENSOR_FAULT_NONE) {
       logger.info("[SENSOR] #" + String(i + 1) + " OK (" + String(t, 1) + "°C)");
       okCount++;
-    } else if (fault != 0) {
-      logger.warn("[SENSOR] #" + String(i + 1) + " FAULT (0x" + String(fault, HEX) + ")");
-    } else {
+    } else if (cls == SENSOR_FAULT_NO_CHIP || cls == SENSOR_FAULT_RANGE) {
       // Chip reageert niet of PT1000 niet bedraad (readings buiten bereik, fault=0).
-      logger.warn("[SENSOR] #" + String(i + 1) + " NOT DETECTED (check wiring / RREF)");
+      logger.warn("[SENSOR] #" + String(i + 1) + " NOT DETECTED (" +
+                  sensorFaultClassName(cls) + ", check wiring / RREF)");
+      if (cls == SENSOR_FAULT_NO_CHIP) scheduleRetry(st, millis());
+    } else {
+      logger.warn("[SENSOR] #" + String(i + 1) + " FAULT " + sensorFaultClassName(cls) +
+                  " (0x" + String(fault, HEX) + ")");
     }
   }
   return okCount > 0;
@@ -167,81 +313,239 @@ bool initSensors() {
 
 float getCachedTempC(uint8_t idx) {
   if (!validIdx(idx)) return NAN;
-  return s_lastTempC[idx];
+  return s_state[idx].lastTempC;
 }
 
 uint8_t getCachedFault(uint8_t idx) {
   if (!validIdx(idx)) return 0xFF;
-  return s_lastFault[idx];
+  return s_state[idx].lastFault;
 }
 
 float readSensor(uint8_t idx) {
   if (!validIdx(idx)) return NAN;
+  ChannelState& st = s_state[idx];
+  const Pt1000Channel& ch = s_channels[idx];
+  const uint32_t now = millis();
+
+  // Ontbrekende chip: niet elke cyclus begin() + conversie proberen, maar met
+  // exponentiële backoff (5 s → 5 min). Zodra de chip er is (hot-plug, CS-trace
+  // hersteld) gaat hij automatisch mee draaien zonder reboot.
+  const bool retrying = (st.faultClass == SENSOR_FAULT_NO_CHIP) || !st.initOk;
+  if (retrying && (int32_t)(now - st.retryAtMs) < 0) {
+    return NAN;
+  }
+
   SpiLock lock;
-  if (!lock) return s_lastTempC[idx];
-
-  // Lazy re-init: als de sensor op dit moment niet als OK staat, proberen we
-  // begin()+enable50Hz opnieuw. Bij boot kan een chip onbereikbaar zijn (bv.
-  // verdamper-voeler nog niet aangesloten, of CS-trace nog niet doorverbonden);
-  // zodra dat hardware-issue opgelost is willen we dat de chip automatisch
-  // mee gaat draaien zonder dat de gebruiker moet rebooten. We doen dit enkel
-  // wanneer s_initOk[idx] false is, dus een gezonde sensor heeft hier geen
-  // overhead. Op een nog steeds dode chip kosten begin()+enable50Hz ~5 ms,
-  // wat binnen de readingInterval ruim past.
-  if (!s_initOk[idx]) {
+  if (!lock) return st.lastTempC;
+
+  if (retrying) {
     s_sensors[idx].begin(MAX31865_2WIRE);
     s_sensors[idx].enable50Hz(true);
     delay(5);
   }
 
-  // Diagnose ook op reguliere reads, zodat we kunnen zien of een sensor die
-  // tijdens init niet "OK" was, intussen wél plausibele data geeft (bv. na
-  // hot-plug van een probe). Niet te spammy: we loggen enkel als hij niet-OK
-  // is, of als het resultaat buiten de redelijke range valt.
+  // Eén conversie + één fault-read per cyclus; de temperatuur rekenen we zelf
+  // (fixed-point, gekalibreerd) uit de ruwe waarde — geen tweede readRTD()
+  // via temperature().
+  if (st.mulQ32 == 0) updateCoefficients(idx);
   uint16_t rtdRaw = s_sensors[idx].readRTD();
-  float    rrtd   = ((float)rtdRaw * PT1000_RREF_OHM) / 32768.0f;
-
-  float t = s_sensors[idx].temperature(PT1000_RNOMINAL_OHM, PT1000_RREF_OHM);
-  uint8_t fault = s_sensors[idx].readFault();
-  if (fault) {
-    s_sensors[idx].clearFault();
-    s_lastFault[idx] = fault;
-    s_lastTempC[idx] = NAN;
-    logger.warn(String("[SENSOR] #") + (idx + 1) +
-                " read fault=0x" + String(fault, HEX) +
-                " RTDraw=0x" + String(rtdRaw, HEX) +
-                " Rrtd≈" + String(rrtd, 1) + "Ω");
-    return NAN;
+  float    t      = rtdRawToCelsius(st, rtdRaw);
+  uint8_t  fault  = s_sensors[idx].readFault();
+  if (fault) s_sensors[idx].clearFault();
+
+  SensorFaultClass obs = classifyReading(idx, fault, rtdRaw, t);
+  st.lastRtdRaw = (obs == SENSOR_FAULT_NONE) ? rtdRaw : 0;
+
+  if (obs != SENSOR_FAULT_NO_CHIP) {
+    st.initOk = true;
+    st.retryDelayMs = PT1000_RETRY_MIN_MS;
   }
-  if (isnan(t) || t <= -200.0f || t >= 200.0f) {
-    s_lastTempC[idx] = NAN;
-    logger.warn(String("[SENSOR] #") + (idx + 1) +
-                " read out-of-range: RTDraw=0x" + String(rtdRaw, HEX) +
-                " Rrtd≈" + String(rrtd, 1) + "Ω t=" + String(t, 2) + "°C");
-    return NAN;
+
+  if (obs == SENSOR_FAULT_NONE) {
+    if (st.faultClass != SENSOR_FAULT_NONE) {
+      LOG_I(LOG_TAG_SENSOR, "#%u (%s) nu geldig na %s: RTDraw=0x%x t=%.2f°C", (unsigned)(idx + 1), ch.name,
+            sensorFaultClassName(st.faultClass), (unsigned)rtdRaw, t);
+    }
+    st.faultClass   = SENSOR_FAULT_NONE;
+    st.pendingClass = SENSOR_FAULT_NONE;
+    st.pendingCount = 0;
+    st.lastFault    = 0;
+    st.lastTempC    = t;
+    return t;
   }
-  s_lastFault[idx] = 0;
-  s_lastTempC[idx] = t;
-  if (!s_initOk[idx]) {
-    logger.info(String("[SENSOR] #") + (idx + 1) +
-                " nu geldig: RTDraw=0x" + String(rtdRaw, HEX) +
-                " Rrtd≈" + String(rrtd, 1) + "Ω t=" + String(t, 2) + "°C");
-    s_initOk[idx] = true;
+
+  // Ongeldige meting: temperatuur meteen weg, klasse pas na debounce melden.
+  st.lastTempC = NAN;
+  if (obs == st.faultClass) {
+    st.pendingClass = obs;
+    st.pendingCount = 0;
+  } else {
+    if (obs == st.pendingClass) {
+      st.pendingCount++;
+    } else {
+      st.pendingClass = obs;
+      st.pendingCount = 1;
+    }
+    if (st.pendingCount >= PT1000_FAULT_DEBOUNCE_CYCLES) {
+      confirmClass(idx, obs, fault, rtdRaw);
+    }
   }
-  return t;
+  // Backoff pas zodra NO_CHIP bevestigd is (of al was): tijdens de debounce
+  // gewoon elke cyclus opnieuw meten, anders verdubbelt de delay dubbel.
+  if (obs == SENSOR_FAULT_NO_CHIP && st.faultClass == SENSOR_FAULT_NO_CHIP) {
+    scheduleRetry(st, now);
+  }
+  return NAN;
 }
 
 uint8_t sensorFault(uint8_t idx) {
   if (!validIdx(idx)) return 0xFF;
-  SpiLock lock;
-  if (!lock) return s_lastFault[idx];
-  uint8_t f = s_sensors[idx].readFault();
-  if (f) s_sensors[idx].clearFault();
-  s_lastFault[idx] = f;
-  return f;
+  return s_state[idx].lastFault;
 }
 
 bool sensorOk(uint8_t idx) {
   if (!validIdx(idx)) return false;
-  return s_initOk[idx] && !isnan(s_lastTempC[idx]);
+  return s_state[idx].faultClass == SENSOR_FAULT_NONE && !isnan(s_state[idx].lastTempC);
+}
+
+SensorFaultClass sensorFaultClass(uint8_t idx) {
+  if (!validIdx(idx)) return SENSOR_FAULT_NO_CHIP;
+  return s_state[idx].faultClass;
+}
+
+uint8_t sensorFaultHistory(uint8_t idx) {
+  if (!validIdx(idx)) return 0;
+  return s_state[idx].history;
+}
+
+uint16_t sensorFaultCount(uint8_t idx) {
+  if (!validIdx(idx)) return 0;
+  return s_state[idx].faultCount;
+}
+
+uint16_t getCachedRtdRaw(uint8_t idx) {
+  if (!validIdx(idx)) return 0;
+  return s_state[idx].lastRtdRaw;
+}
+
+void applySensorCalibration(uint8_t idx, float gain, float offsetOhm) {
+  if (!validIdx(idx)) return;
+  // Onder de SPI-lock: readSensor() gebruikt de coëfficiënten binnen dezelfde lock.
+  SpiLock lock;
+  ChannelState& st = s_state[idx];
+  st.calGain      = gain;
+  st.calOffsetOhm = offsetOhm;
+  updateCoefficients(idx);
+}
+
+const char* sensorFaultClassName(SensorFaultClass c) {
+  switch (c) {
+    case SENSOR_FAULT_NONE:    return "OK";
+    case SENSOR_FAULT_OPEN:    return "OPEN";
+    case SENSOR_FAULT_SHORT:   return "SHORT";
+    case SENSOR_FAULT_OVUV:    return "OVUV";
+    case SENSOR_FAULT_NO_CHIP: return "NO_CHIP";
+    case SENSOR_FAULT_RANGE:   return "RANGE";
+  }
+  return "?";
+}
+
+const Pt1000Channel& sensorChannel(uint8_t idx) {
+  return s_channels[validIdx(idx) ? idx : 0];
+}
+
+int8_t sensorIndexForRole(SensorRole role) {
+  for (uint8_t i = 0; i < PT1000_COUNT; i++) {
+    if (s_channels[i].role == role) return (int8_t)i;
+  }
+  return -1;
+}
+
+uint8_t sampleSensors(bool force) {
+  uint8_t sampled = 0;
+  for (uint8_t i = 0; i < PT1000_COUNT; i++) {
+    ChannelState& st = s_state[i];
+    const uint32_t every = s_channels[i].sampleIntervalMs;
+    const uint32_t now = millis();
+    if (!force && every > 0 && st.lastSampleMs != 0 && (now - st.lastSampleMs) < every) {
+      continue;
+    }
+    readSensor(i);
+    st.lastSampleMs = now ? now : 1;
+    sampled++;
+  }
+  return sampled;
+}
+
+void logSensorsSummary(bool primaryOk, bool doorOpen, bool doorPinHigh) {
+  // Eén record per kanaal met vaste format-string: tokenized builds sturen
+  // enkel token + args, geen String-opbouw per meting.
+  for (uint8_t i = 0; i < PT1000_COUNT; i++) {
+    if (sensorOk(i)) {
+      LOG_I(LOG_TAG_SENSOR, "MAX31865 %s=%.2f°C", s_channels[i].name, s_state[i].lastTempC);
+    } else {
+      LOG_W(LOG_TAG_SENSOR, "MAX31865 %s=--- (%s, fault=0x%02x)", s_channels[i].name,
+            sensorFaultClassName(s_state[i].faultClass), (unsigned)s_state[i].lastFault);
+    }
+  }
+  if (primaryOk) {
+    LOG_I(LOG_TAG_SENSOR, "Deur: %s", doorOpen ? "OPEN" : "dicht");
+  } else {
+    LOG_W(LOG_TAG_SENSOR, "Deur: %s (pin=%d)", doorOpen ? "OPEN" : "dicht", doorPinHigh ? 1 : 0);
+  }
+}
+
+void writeSensorsReadingJson(JsonDocument& doc) {
+  for (uint8_t i = 0; i < PT1000_COUNT; i++) {
+    const Pt1000Channel& ch = s_channels[i];
+    // Keys zijn literals uit de kanaaltabel → ArduinoJson bewaart enkel de pointer.
+    if (sensorOk(i)) {
+      doc[ch.readingKey] = round(s_state[i].lastTempC * 10.0f) / 10.0f;
+    } else {
+      doc[ch.readingKey] = (const char*)nullptr;  // JSON null
+    }
+    doc[ch.faultKey] = s_state[i].lastFault;
+  }
+}
+
+void writeSensorsHeartbeatJson(JsonDocument& doc) {
+  for (uint8_t i = 0; i < PT1000_COUNT; i++) {
+    const Pt1000Channel& ch = s_channels[i];
+    const float t = getCachedTempC(i);
+    const uint8_t f = getCachedFault(i);
+    // String-keys worden door ArduinoJson gekopieerd (niet-literal).
+    const String numbered = String("sensor_") + (i + 1);
+    const String named = String(ch.name);
+    if (isnan(t)) {
+      doc[numbered + "_temp"] = (const char*)nullptr;
+      doc[named + "_temp"]    = (const char*)nullptr;
+    } else {
+      doc[numbered + "_temp"] = t;
+      doc[named + "_temp"]    = t;
+    }
+    doc[numbered + "_fault"] = f;
+    doc[named + "_fault"]    = f;
+    doc[named + "_fault_class"]   = sensorFaultClassName(s_state[i].faultClass);
+    doc[named + "_fault_history"] = s_state[i].history;
+    doc[named + "_fault_count"]   = s_state[i].faultCount;
+  }
+}
+
+size_t encodeSensorsBinary(uint8_t* out, size_t cap) {
+  const size_t need = 1 + (size_t)PT1000_COUNT * PT1000_BINARY_BYTES_PER_CHANNEL;
+  if (!out || cap < need) return 0;
+  size_t n = 0;
+  out[n++] = PT1000_COUNT;
+  for (uint8_t i = 0; i < PT1000_COUNT; i++) {
+    int16_t centi = PT1000_BINARY_TEMP_INVALID;
+    if (sensorOk(i)) {
+      const float c = roundf(s_state[i].lastTempC * 100.0f);
+      if (c > (float)INT16_MIN && c <= (float)INT16_MAX) centi = (int16_t)c;
+    }
+    out[n++] = (uint8_t)s_channels[i].role;
+    out[n++] = s_state[i].lastFault;
+    out[n++] = (uint8_t)(centi & 0xFF);
+    out[n++] = (uint8_t)(((uint16_t)centi >> 8) & 0xFF);
+  }
+  return n;
 }
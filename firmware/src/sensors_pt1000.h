@@ -2,11 +2,15 @@
 #define SENSORS_PT1000_H
 
 #include <Arduino.h>
+#include <ArduinoJson.h>
+#include "pins_carrier.h"
 
 /**
- * Twee MAX31865 (PT1000, 2-wire, ATP+T package) op gedeelde SPI.
- * CS-pinnen uit pins_carrier.h.
- * RREF = 4020Ω (carrier v1.1), RNOMINAL = 1000Ω, 50Hz notch-filter.
+ * PT1000-voelers via MAX31865 (2-wire, ATP+T package), beheerd als register
+ * van kanalen. Elk kanaal is één regel in PT1000_CHANNEL_TABLE; acquisitie,
+ * caching, logging en JSON/binaire encoding itereren over die tabel. Een
+ * extra voeler (tweede verdamper, productkern) toevoegen = één regel hier,
+ * geen code in sensorTask of heartbeat.
  *
  * Rolverdeling op carrier v1.1 (fysieke screw-terminals):
  *   idx 0 (CS1, PT1000_1) → RUIMTE-voeler (koelcel-ambient)
@@ -15,35 +19,144 @@
  *                            → diagnose, defrost-logica, ijsvorming
  */
 
-#define PT1000_COUNT          2
 #define PT1000_RREF_OHM       4020.0f
 #define PT1000_RNOMINAL_OHM   1000.0f
 
-#define PT1000_IDX_ROOM        0
-#define PT1000_IDX_EVAPORATOR  1
+/* SPI-bussen. Carrier v1.1 heeft er één: gedeelde software-SPI (mode 1). */
+#define PT1000_BUS_CARRIER    0
 
-/** Init beide sensoren. Returnt true als minstens één OK is. */
+enum SensorRole : uint8_t {
+  SENSOR_ROLE_ROOM       = 0,  // koelcel-ambient, primaire temperatuur
+  SENSOR_ROLE_EVAPORATOR = 1,  // verdamper-coil
+  SENSOR_ROLE_PRODUCT    = 2,  // productkern-voeler
+  SENSOR_ROLE_AUX        = 3,  // overige (bv. tweede verdamper)
+};
+
+/*
+ * Kanaaltabel. Kolommen:
+ *   name        heartbeat-prefix ("<name>_temp", "<name>_fault") en logregel
+ *   readingKey  JSON-veld in /readings voor de temperatuur
+ *   faultKey    JSON-veld in /readings voor de faultcode
+ *   bus         SPI-bus (PT1000_BUS_*)
+ *   cs          chip-select GPIO
+ *   role        SensorRole
+ *   rref/rnom   referentie- en nominale weerstand (Ω)
+ *   sampleMs    minimale tijd tussen metingen; 0 = elke readingcyclus
+ */
+#define PT1000_CHANNEL_TABLE(X)                                                   \
+  X("room",       "temperature",    "roomFault",       PT1000_BUS_CARRIER,        \
+    PIN_MAX31865_CS1, SENSOR_ROLE_ROOM,       PT1000_RREF_OHM, PT1000_RNOMINAL_OHM, 0) \
+  X("evaporator", "evaporatorTemp", "evaporatorFault", PT1000_BUS_CARRIER,        \
+    PIN_MAX31865_CS2, SENSOR_ROLE_EVAPORATOR, PT1000_RREF_OHM, PT1000_RNOMINAL_OHM, 0)
+
+#define PT1000_COUNT_ONE(...) + 1
+#define PT1000_COUNT (0 PT1000_CHANNEL_TABLE(PT1000_COUNT_ONE))
+
+struct Pt1000Channel {
+  const char* name;
+  const char* readingKey;
+  const char* faultKey;
+  uint8_t     bus;
+  uint8_t     csPin;
+  SensorRole  role;
+  float       rrefOhm;
+  float       rnominalOhm;
+  uint32_t    sampleIntervalMs;
+};
+
+/*
+ * Gedebouncede foutklassen per kanaal. Een nieuwe klasse wordt pas gemeld na
+ * PT1000_FAULT_DEBOUNCE_CYCLES opeenvolgende gelijke observaties; herstel
+ * (geldige meting) is onmiddellijk. Elke bevestigde klasse wordt gelatcht in
+ * sensorFaultHistory() als bit (1 << klasse).
+ */
+enum SensorFaultClass : uint8_t {
+  SENSOR_FAULT_NONE    = 0,
+  SENSOR_FAULT_OPEN    = 1,  // RTD/FORCE-lijn open of high-threshold (0x80/0x20/0x10/0x08)
+  SENSOR_FAULT_SHORT   = 2,  // RTD kortgesloten of low-threshold (0x40)
+  SENSOR_FAULT_OVUV    = 3,  // over-/onderspanning op een ingang (0x04)
+  SENSOR_FAULT_NO_CHIP = 4,  // MAX31865 antwoordt niet (config-reg 0x00/0xFF)
+  SENSOR_FAULT_RANGE   = 5,  // meting buiten -200..200 °C zonder faultbit
+};
+
+#define PT1000_FAULT_DEBOUNCE_CYCLES 2
+
+/* Backoff voor begin()-retries op een ontbrekende chip (NO_CHIP). */
+#define PT1000_RETRY_MIN_MS   5000UL
+#define PT1000_RETRY_MAX_MS 300000UL
+
+/** Bytes per kanaal in encodeSensorsBinary(): role, fault, int16 LE centi-°C. */
+#define PT1000_BINARY_BYTES_PER_CHANNEL 4
+#define PT1000_BINARY_TEMP_INVALID      INT16_MIN
+
+/** Init alle kanalen. Returnt true als minstens één OK is. */
 bool initSensors();
 
-/** Temperatuur in °C voor idx=0 of 1. NAN bij fault of init-fail. */
+/** Aantal kanalen en hun (compile-time) descriptor. */
+constexpr uint8_t sensorChannelCount() { return PT1000_COUNT; }
+const Pt1000Channel& sensorChannel(uint8_t idx);
+
+/** Eerste kanaal met deze rol, of -1. */
+int8_t sensorIndexForRole(SensorRole role);
+
+/**
+ * Meet alle kanalen waarvan de sample-interval verstreken is (of allemaal bij
+ * force). Resultaten komen in de cache; returnt het aantal gemeten kanalen.
+ */
+uint8_t sampleSensors(bool force = false);
+
+/**
+ * Eén meting voor één kanaal: één RTD-conversie + één fault-read (SPI), werkt
+ * de fault-state machine bij. NAN bij fault. Op een ontbrekende chip gebeurt
+ * er enkel SPI-verkeer als de retry-backoff verstreken is.
+ */
 float readSensor(uint8_t idx);
 
-/** MAX31865-faultcode (0 = ok). Roept readFault() aan en wist daarna. */
+/** Laatste bevestigde MAX31865-faultcode (0 = ok). Uit de cache, geen SPI. */
 uint8_t sensorFault(uint8_t idx);
 
-/** True als sensor tijdens init OK was én laatste read geldig was. */
+/** True als de bevestigde foutklasse NONE is én de laatste read geldig was. */
 bool sensorOk(uint8_t idx);
 
-/* ---- Semantische aliassen (zelfde onderliggende chips, leesbaarder) ---- */
-inline float   readRoomTempC()       { return readSensor(PT1000_IDX_ROOM); }
-inline float   readEvaporatorTempC() { return readSensor(PT1000_IDX_EVAPORATOR); }
-inline uint8_t roomSensorFault()     { return sensorFault(PT1000_IDX_ROOM); }
-inline uint8_t evaporatorFault()     { return sensorFault(PT1000_IDX_EVAPORATOR); }
-inline bool    roomSensorOk()        { return sensorOk(PT1000_IDX_ROOM); }
-inline bool    evaporatorSensorOk()  { return sensorOk(PT1000_IDX_EVAPORATOR); }
+/** Bevestigde (gedebouncede) foutklasse, latched history en aantal overgangen. */
+SensorFaultClass sensorFaultClass(uint8_t idx);
+uint8_t          sensorFaultHistory(uint8_t idx);
+uint16_t         sensorFaultCount(uint8_t idx);
+const char*      sensorFaultClassName(SensorFaultClass c);
 
 /** Laatste geldige meting (geen SPI) — veilig tijdens HTTP/WiFi op andere taken. */
 float   getCachedTempC(uint8_t idx);
 uint8_t getCachedFault(uint8_t idx);
 
+/** Ruwe 15-bit RTD-waarde van de laatste geldige meting (0 = geen). Geen SPI. */
+uint16_t getCachedRtdRaw(uint8_t idx);
+
+/**
+ * Veldkalibratie toepassen: R_echt = gain · R_gemeten + offsetOhm (offset < 0
+ * compenseert 2-wire leidingweerstand). Wordt in de fixed-point coëfficiënten
+ * gevouwen; geen extra kost per meting. Persistentie: sensor_calibration.
+ */
+void applySensorCalibration(uint8_t idx, float gain, float offsetOhm);
+
+/**
+ * Meting loggen uit de cache (geen SPI): per kanaal "MAX31865 <name>=.." en
+ * de deurstatus; WARN (met pin) als de primaire voeler ongeldig is.
+ */
+void logSensorsSummary(bool primaryOk, bool doorOpen, bool doorPinHigh);
+
+/** Reading-payload: per kanaal readingKey (1 decimaal of null) + faultKey. */
+void writeSensorsReadingJson(JsonDocument& doc);
+
+/**
+ * Heartbeat-payload: sensor_<n>_temp/_fault + <name>_temp/_fault per kanaal,
+ * plus <name>_fault_class/_fault_history/_fault_count.
+ */
+void writeSensorsHeartbeatJson(JsonDocument& doc);
+
+/**
+ * Compacte binaire snapshot: [count] + per kanaal PT1000_BINARY_BYTES_PER_CHANNEL.
+ * Returnt geschreven bytes, of 0 als cap te klein is.
+ */
+size_t encodeSensorsBinary(uint8_t* out, size_t cap);
+
 #endif /* SENSORS_PT1000_H */
@@ -168,7 +168,7 @@ void update() {
 
   String resp;
   if (!sendAndExpectOk("AT+CBC", AT_TIMEOUT_MS, &resp)) {
-    logger.debug("[SIM7670] AT+CBC zonder OK-respons");
+    LOG_D(LOG_TAG_SIM7670, "AT+CBC zonder OK-respons");
     return;
   }
   int mv = -1;
@@ -181,7 +181,7 @@ void update() {
   }
   s_voltageMv  = mv;
   s_percentage = voltageToPct(mv);
-  logger.info(String("[SIM7670] batterij = ") + (mv / 1000.0f) + " V (" + s_percentage + " %)");
+  LOG_I(LOG_TAG_SIM7670, "batterij = %.2f V (%d %%)", mv / 1000.0f, (int)s_percentage);
 }
 
 bool isReady()       { return s_state == State::READY && s_voltageMv > 0; }
@@ -0,0 +1,170 @@
+#include "upload_priority.h"
+#include "logger.h"
+#include <freertos/FreeRTOS.h>
+
+extern Logger logger;
+
+namespace {
+
+struct UrgentSlot {
+  uint32_t requestMs;   // millis() van requestUrgentSync()
+  uint8_t  reasons;
+  char     json[URGENT_LANE_JSON_MAX];
+};
+
+portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Single producer (sensorTask) / single consumer (loop): de producer schrijft
+// enkel de slot op tail, de consumer leest enkel die op head. Indices onder s_mux.
+UrgentSlot s_slots[URGENT_LANE_SLOTS];
+uint8_t  s_head = 0;
+uint8_t  s_count = 0;
+
+uint32_t s_requestMs = 0;        // 0 = geen open aanvraag
+uint8_t  s_requestReasons = 0;
+bool     s_heartbeatDue = false;
+uint32_t s_retryAtMs = 0;        // 0 = geen backoff
+
+uint32_t s_sent = 0;
+uint32_t s_overflow = 0;
+
+// Latency-ring (enkel loop()).
+uint32_t s_latency[URGENT_LATENCY_SAMPLES];
+uint8_t  s_latencyCount = 0;
+uint8_t  s_latencyNext = 0;
+
+uint32_t percentile(const uint32_t* sorted, uint8_t n, uint8_t pct) {
+  // Nearest-rank: ceil(pct/100 * n) - 1
+  uint16_t rank = (uint16_t)((pct * n + 99) / 100);
+  if (rank == 0) rank = 1;
+  return sorted[rank - 1];
+}
+
+} // namespace
+
+void requestUrgentSync(uint8_t reasons) {
+  const uint32_t now = millis();
+  portENTER_CRITICAL(&s_mux);
+  // Oudste tijdstip behouden: meerdere wissels vóór de volgende reading
+  // tellen als één levering, gemeten vanaf de eerste.
+  if (s_requestMs == 0) s_requestMs = now ? now : 1;
+  s_requestReasons |= reasons;
+  s_heartbeatDue = true;
+  portEXIT_CRITICAL(&s_mux);
+}
+
+bool uploadPriorityTakeReading(const String& json) {
+  portENTER_CRITICAL(&s_mux);
+  const uint32_t reqMs = s_requestMs;
+  const uint8_t reasons = s_requestReasons;
+  const bool full = s_count >= URGENT_LANE_SLOTS;
+  const uint8_t tail = (uint8_t)((s_head + s_count) % URGENT_LANE_SLOTS);
+  if (reqMs != 0) {
+    s_requestMs = 0;
+    s_requestReasons = 0;
+  }
+  portEXIT_CRITICAL(&s_mux);
+
+  if (reqMs == 0) return false;
+  if (full || json.length() >= URGENT_LANE_JSON_MAX) {
+    // Niet verloren: gaat als gewone reading mee met de bulk-upload.
+    s_overflow++;
+    logger.warn("[URGENT] lane vol of reading te groot — via dataBuffer");
+    return false;
+  }
+
+  UrgentSlot& slot = s_slots[tail];
+  slot.requestMs = reqMs;
+  slot.reasons = reasons;
+  memcpy(slot.json, json.c_str(), json.length() + 1);
+
+  portENTER_CRITICAL(&s_mux);
+  s_count++;
+  portEXIT_CRITICAL(&s_mux);
+  return true;
+}
+
+void uploadPriorityNoReading() {
+  portENTER_CRITICAL(&s_mux);
+  s_requestMs = 0;
+  s_requestReasons = 0;
+  portEXIT_CRITICAL(&s_mux);
+}
+
+bool uploadPriorityHeartbeatDue() {
+  portENTER_CRITICAL(&s_mux);
+  const bool due = s_heartbeatDue;
+  s_heartbeatDue = false;
+  portEXIT_CRITICAL(&s_mux);
+  return due;
+}
+
+bool uploadPriorityPeek(String& out) {
+  if (s_retryAtMs != 0 && (int32_t)(millis() - s_retryAtMs) < 0) return false;
+  portENTER_CRITICAL(&s_mux);
+  const bool empty = s_count == 0;
+  const uint8_t head = s_head;
+  portEXIT_CRITICAL(&s_mux);
+  if (empty) return false;
+  out = s_slots[head].json;
+  return true;
+}
+
+void uploadPriorityPop(bool delivered) {
+  portENTER_CRITICAL(&s_mux);
+  if (s_count == 0) {
+    portEXIT_CRITICAL(&s_mux);
+    return;
+  }
+  const UrgentSlot& slot = s_slots[s_head];
+  const uint32_t reqMs = slot.requestMs;
+  const uint8_t reasons = slot.reasons;
+  s_head = (uint8_t)((s_head + 1) % URGENT_LANE_SLOTS);
+  s_count--;
+  portEXIT_CRITICAL(&s_mux);
+
+  s_retryAtMs = 0;
+  if (!delivered) return;
+  const uint32_t latency = millis() - reqMs;
+  s_latency[s_latencyNext] = latency;
+  s_latencyNext = (uint8_t)((s_latencyNext + 1) % URGENT_LATENCY_SAMPLES);
+  if (s_latencyCount < URGENT_LATENCY_SAMPLES) s_latencyCount++;
+  s_sent++;
+  logger.info("[URGENT] reading geleverd in " + String(latency) + " ms (reden=0x" +
+              String(reasons, HEX) + ")");
+}
+
+void uploadPriorityFailed() {
+  s_retryAtMs = millis() + URGENT_RETRY_MS;
+  if (s_retryAtMs == 0) s_retryAtMs = 1;
+}
+
+int uploadPriorityPending() {
+  portENTER_CRITICAL(&s_mux);
+  const int n = s_count;
+  portEXIT_CRITICAL(&s_mux);
+  return n;
+}
+
+void writeUploadPriorityJson(JsonDocument& doc) {
+  doc["urgent_pending"]  = uploadPriorityPending();
+  doc["urgent_sent"]     = s_sent;
+  doc["urgent_overflow"] = s_overflow;
+  if (s_latencyCount == 0) return;
+
+  uint32_t sorted[URGENT_LATENCY_SAMPLES];
+  const uint8_t n = s_latencyCount;
+  memcpy(sorted, s_latency, sizeof(uint32_t) * n);
+  // Insertion sort: max 32 elementen.
+  for (uint8_t i = 1; i < n; i++) {
+    const uint32_t v = sorted[i];
+    int8_t j = (int8_t)(i - 1);
+    while (j >= 0 && sorted[j] > v) {
+      sorted[j + 1] = sorted[j];
+      j--;
+    }
+    sorted[j + 1] = v;
+  }
+  doc["urgent_p50_ms"] = percentile(sorted, n, 50);
+  doc["urgent_p99_ms"] = percentile(sorted, n, 99);
+}
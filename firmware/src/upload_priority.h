@@ -0,0 +1,64 @@
+#ifndef UPLOAD_PRIORITY_H
+#define UPLOAD_PRIORITY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/**
+ * Prioriteits-lane voor dringende readings (alarmwissel, USB-C/netvoeding weg,
+ * sensorfout, deur te lang open). Vervangt de losse g_forceImmediateSync-flag.
+ *
+ *   sensorTask:  requestUrgentSync(reden)  → volgende reading gaat via
+ *                uploadPriorityTakeReading() in de urgent-lane i.p.v. dataBuffer
+ *   loop():      uploadPriorityHeartbeatDue() → heartbeat meteen
+ *                urgent-lane eerst legen (peek → upload → pop), zonder
+ *                uploadInterval en zonder UPLOAD_BATCH-cap; de bulk-backlog
+ *                in dataBuffer wacht tot de lane leeg is.
+ *
+ * De HTTP-cooldown in APIClient blijft gelden (WiFi-stack), dus de latency is
+ * begrensd door één lopende HTTP-call + cooldown, niet door getUploadInterval().
+ *
+ * Latency = millis() van de aanvraag tot geslaagde upload; p50/p99 over de
+ * laatste URGENT_LATENCY_SAMPLES leveringen gaan mee in de heartbeat.
+ */
+
+#define URGENT_LANE_SLOTS       4
+#define URGENT_LANE_JSON_MAX    512
+#define URGENT_RETRY_MS         5000UL   // na mislukte urgent-upload
+#define URGENT_LATENCY_SAMPLES  32
+
+enum UrgentReason : uint8_t {
+  URGENT_ALARM = 1 << 0,   // alarm-engine wissel (temp, deur, sensorfout)
+  URGENT_POWER = 1 << 1,   // USB-C/netvoeding in of uit
+};
+
+/** Vanuit elke taak: volgende reading dringend + heartbeat meteen. */
+void requestUrgentSync(uint8_t reasons);
+
+/**
+ * sensorTask, na het serialiseren van een reading. True = in de urgent-lane
+ * gezet (aanroeper buffert niet meer); false = gewoon naar dataBuffer.
+ */
+bool uploadPriorityTakeReading(const String& json);
+
+/** sensorTask: aangevraagde reading kon niet gemaakt worden (heartbeat dekt het). */
+void uploadPriorityNoReading();
+
+/** loop(): true (en gewist) als er een heartbeat geforceerd moet worden. */
+bool uploadPriorityHeartbeatDue();
+
+/** loop(): oudste urgent-reading (false als leeg of in retry-backoff). */
+bool uploadPriorityPeek(String& out);
+
+/** loop(): na geslaagde (of 4xx-gedropte) upload; delivered = latency meetellen. */
+void uploadPriorityPop(bool delivered);
+
+/** loop(): transient fout; volgende poging na URGENT_RETRY_MS. */
+void uploadPriorityFailed();
+
+int uploadPriorityPending();
+
+/** Heartbeat: urgent_pending, urgent_sent, urgent_overflow, urgent_p50_ms, urgent_p99_ms. */
+void writeUploadPriorityJson(JsonDocument& doc);
+
+#endif /* UPLOAD_PRIORITY_H */
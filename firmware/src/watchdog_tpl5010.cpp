@@ -162,7 +162,7 @@ void suspendSoftwareWatchdog() {
   esp_err_t err = esp_task_wdt_delete(s_loopTask);
   if (err == ESP_OK) {
     s_sw_initialized = false;   // markeer als "tijdelijk af"
-    logger.debug("[WATCHDOG] SW-WDT gepauzeerd (loop-task vrijgesteld)");
+    LOG_D(LOG_TAG_APP, "[WATCHDOG] SW-WDT gepauzeerd (loop-task vrijgesteld)");
   } else if (err != ESP_ERR_NOT_FOUND) {
     logger.warn(String("[WATCHDOG] SW-WDT suspend error=") + err);
   }
@@ -175,7 +175,7 @@ void resumeSoftwareWatchdog() {
   if (err == ESP_OK) {
     s_sw_initialized = true;
     esp_task_wdt_reset();        // eerste reset meteen zodat we niet per ongeluk met een oude "missed"-timer starten
-    logger.debug("[WATCHDOG] SW-WDT hervat");
+    LOG_D(LOG_TAG_APP, "[WATCHDOG] SW-WDT hervat");
   } else {
     logger.warn(String("[WATCHDOG] SW-WDT resume error=") + err);
   }